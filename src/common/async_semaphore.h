@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Common {
+
+/// Semaphore for coroutines. Waiters suspend instead of blocking their thread and are served in
+/// the order they arrived, so a waiter asking for many units isn't starved by smaller ones
+class AsyncSemaphore {
+public:
+    explicit AsyncSemaphore(std::size_t count_) : count{count_}, capacity{count_} {}
+
+    AsyncSemaphore(const AsyncSemaphore&) = delete;
+    AsyncSemaphore& operator=(const AsyncSemaphore&) = delete;
+
+    class Awaiter {
+    public:
+        Awaiter(AsyncSemaphore& semaphore_, std::size_t units_)
+            : semaphore{semaphore_}, units{units_} {}
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        /// Resumes right away if the units are available
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::scoped_lock lock{semaphore.mutex};
+            if (semaphore.waiters.empty() && semaphore.count >= units) {
+                semaphore.count -= units;
+                return false;
+            }
+            semaphore.waiters.push_back({handle, units});
+            return true;
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        AsyncSemaphore& semaphore;
+        std::size_t units;
+    };
+
+    /// Waits until units are available, more than the capacity waits for all of them
+    Awaiter Acquire(std::size_t units = 1) {
+        return Awaiter{*this, std::min(units, capacity)};
+    }
+
+    /// Returns units and resumes the waiters they satisfy on the calling thread
+    void Release(std::size_t units = 1) {
+        std::vector<std::coroutine_handle<>> ready{};
+        {
+            std::scoped_lock lock{mutex};
+            count += units;
+            while (!waiters.empty() && count >= waiters.front().units) {
+                count -= waiters.front().units;
+                ready.push_back(waiters.front().handle);
+                waiters.pop_front();
+            }
+        }
+        for (const std::coroutine_handle<> handle : ready) {
+            handle.resume();
+        }
+    }
+
+    std::size_t GetCapacity() const {
+        return capacity;
+    }
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        std::size_t units;
+    };
+
+    std::mutex mutex;
+    std::size_t count;
+    const std::size_t capacity;
+    std::deque<Waiter> waiters{};
+};
+
+} // namespace Common
@@ -0,0 +1,213 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Common {
+
+/// Coroutine returning T. It starts when awaited and resumes the awaiting coroutine once it
+/// finishes, on whatever thread it finished. Await into a variable instead of inside an if
+/// condition, gcc 12 never resumes the latter once it suspended
+template <typename T>
+class [[nodiscard]] Task {
+    static_assert(!std::is_void_v<T>, "Tasks must return a value");
+
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept {
+            return handle.promise().continuation;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        Task get_return_object() {
+            return Task{Handle::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept {
+            return {};
+        }
+        FinalAwaiter final_suspend() const noexcept {
+            return {};
+        }
+        void return_value(T result) {
+            value = std::move(result);
+        }
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+        std::optional<T> value{};
+        std::exception_ptr exception{};
+        std::coroutine_handle<> continuation{std::noop_coroutine()};
+    };
+
+    Task(Task&& other) noexcept : handle{std::exchange(other.handle, {})} {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume() {
+        promise_type& promise = handle.promise();
+        if (promise.exception) {
+            std::rethrow_exception(promise.exception);
+        }
+        return std::move(*promise.value);
+    }
+
+private:
+    explicit Task(Handle handle_) : handle{handle_} {}
+
+    Handle handle;
+};
+
+namespace Detail {
+
+/// Coroutine that starts right away and frees itself when done
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() const noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() const noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+};
+
+template <typename T>
+DetachedTask SignalWhenDone(Task<T> task, std::promise<T> result) {
+    try {
+        result.set_value(co_await task);
+    } catch (...) {
+        result.set_exception(std::current_exception());
+    }
+}
+
+template <typename T>
+struct WhenAllState {
+    // One extra count keeps the awaiting coroutine from resuming before every task started
+    std::atomic<std::size_t> pending{};
+    std::coroutine_handle<> continuation{};
+    std::vector<std::optional<T>> results{};
+    std::exception_ptr exception{};
+    std::atomic_flag has_exception{};
+};
+
+template <typename T>
+DetachedTask RunWhenAllTask(Task<T> task, WhenAllState<T>& state, std::size_t index) {
+    try {
+        state.results[index] = co_await task;
+    } catch (...) {
+        if (!state.has_exception.test_and_set()) {
+            state.exception = std::current_exception();
+        }
+    }
+    if (--state.pending == 0) {
+        state.continuation.resume();
+    }
+}
+
+template <typename T>
+struct WhenAllAwaiter {
+    std::vector<Task<T>>& tasks;
+    WhenAllState<T>& state;
+
+    bool await_ready() const noexcept {
+        return tasks.empty();
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+        state.continuation = awaiting;
+        for (std::size_t i = 0; i < tasks.size(); ++i) {
+            RunWhenAllTask(std::move(tasks[i]), state, i);
+        }
+        // Resumes right away if every task already finished
+        return --state.pending != 0;
+    }
+
+    void await_resume() const noexcept {}
+};
+
+} // namespace Detail
+
+/// Starts task on the calling thread and blocks until it finishes. Must not be called from a
+/// thread the task needs to make progress
+template <typename T>
+T SyncWait(Task<T> task) {
+    std::promise<T> result{};
+    std::future<T> future = result.get_future();
+    // The promise lives in the coroutine, the task may still be unwinding once get returns
+    Detail::SignalWhenDone(std::move(task), std::move(result));
+    return future.get();
+}
+
+/// Runs every task concurrently and returns their results in the same order. The first exception
+/// is rethrown once all tasks finished
+template <typename T>
+Task<std::vector<T>> WhenAll(std::vector<Task<T>> tasks) {
+    Detail::WhenAllState<T> state{};
+    state.pending = tasks.size() + 1;
+    state.results.resize(tasks.size());
+    co_await Detail::WhenAllAwaiter<T>{tasks, state};
+
+    if (state.exception) {
+        std::rethrow_exception(state.exception);
+    }
+    std::vector<T> results{};
+    results.reserve(state.results.size());
+    for (std::optional<T>& result : state.results) {
+        results.push_back(std::move(*result));
+    }
+    co_return results;
+}
+
+} // namespace Common
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(std::size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        workers.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::scoped_lock lock{queue_mutex};
+        is_stopping = true;
+    }
+    queue_cv.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::GetThreadCount() const {
+    return workers.size();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+    {
+        std::scoped_lock lock{queue_mutex};
+        queue.push_back(std::move(task));
+    }
+    queue_cv.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock{queue_mutex};
+            queue_cv.wait(lock, [this] { return is_stopping || !queue.empty(); });
+            // Pending tasks are still executed when stopping
+            if (queue.empty()) {
+                return;
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace Common
@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Common {
+
+/// Fixed size pool of worker threads. Tasks start in submission order
+class ThreadPool {
+public:
+    /// Creates a pool with thread_count workers, defaults to the number of hardware threads
+    explicit ThreadPool(std::size_t thread_count = 0);
+
+    /// Waits for every submitted task to finish
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Queues func and returns a future holding its result. Tasks must not wait on tasks
+    /// submitted after them or the pool may deadlock
+    template <typename Func>
+    [[nodiscard]] std::future<std::invoke_result_t<Func>> Submit(Func&& func) {
+        using Result = std::invoke_result_t<Func>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        std::future<Result> result = task->get_future();
+        Enqueue([task] { (*task)(); });
+        return result;
+    }
+
+    [[nodiscard]] std::size_t GetThreadCount() const;
+
+private:
+    void Enqueue(std::function<void()> task);
+    void WorkerLoop();
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<std::function<void()>> queue;
+    bool is_stopping{};
+    std::vector<std::thread> workers;
+};
+
+} // namespace Common
@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <cstddef>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "the_dude_to_human/archive/gorilla.h"
+
+namespace Archive {
+namespace {
+
+TEST_CASE("Gorilla series survive encoding", "[archive]") {
+    std::vector<u32> times{};
+    std::vector<f64> values{};
+    u32 time = 1700000000;
+    for (int i = 0; i < 1000; ++i) {
+        // Mostly regular sampling with a few gaps and repeated values
+        time += i % 97 == 0 ? 300 : 30;
+        times.push_back(time);
+        values.push_back(i % 5 == 0 && !values.empty() ? values.back() : i * 0.25);
+    }
+
+    const std::vector<u8> data = EncodeSeries(times, values);
+    std::vector<u32> decoded_times{};
+    std::vector<f64> decoded_values{};
+    REQUIRE(DecodeSeries(data, times.size(), decoded_times, decoded_values));
+    REQUIRE(decoded_times == times);
+    REQUIRE(decoded_values == values);
+
+    // Asking for more points than were encoded reads past the end
+    REQUIRE_FALSE(DecodeSeries(data, times.size() + 100, decoded_times, decoded_values));
+}
+
+TEST_CASE("Gorilla rejects value bits that don't fit in 64", "[archive]") {
+    // First point of zeros, then a repeated time and a value with 31 leading zeros followed by 63
+    // meaningful bits
+    std::vector<u8> data(32);
+    data[12] = 0b0111'1111;
+    data[13] = 0b1111'1000;
+
+    std::vector<u32> times{};
+    std::vector<f64> values{};
+    REQUIRE_FALSE(DecodeSeries(data, 2, times, values));
+}
+
+} // Anonymous namespace
+} // namespace Archive
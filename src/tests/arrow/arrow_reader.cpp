@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "tests/arrow/arrow_reader.h"
+
+namespace Tests {
+
+Table Table::GetRoot(std::span<const u8> buffer) {
+    return {buffer, Read<u32>(buffer, 0)};
+}
+
+bool Table::HasField(u16 field_id) const {
+    return GetFieldOffset(field_id) != 0;
+}
+
+Table Table::GetTable(u16 field_id) const {
+    return {buffer, GetReference(field_id)};
+}
+
+std::string Table::GetString(u16 field_id) const {
+    const std::size_t offset = GetReference(field_id);
+    const u32 size = Read<u32>(buffer, offset);
+    REQUIRE(offset + sizeof(u32) + size < buffer.size());
+    return {reinterpret_cast<const char*>(buffer.data()) + offset + sizeof(u32), size};
+}
+
+std::vector<Table> Table::GetTables(u16 field_id) const {
+    const std::size_t offset = GetReference(field_id);
+    std::vector<Table> tables{};
+    for (u32 i = 0; i < Read<u32>(buffer, offset); ++i) {
+        const std::size_t entry = offset + sizeof(u32) * (i + 1);
+        tables.push_back({buffer, entry + Read<u32>(buffer, entry)});
+    }
+    return tables;
+}
+
+std::vector<std::pair<s64, s64>> Table::GetStructs(u16 field_id) const {
+    const std::size_t offset = GetReference(field_id);
+    std::vector<std::pair<s64, s64>> entries{};
+    for (u32 i = 0; i < Read<u32>(buffer, offset); ++i) {
+        const std::size_t entry = offset + sizeof(u32) + sizeof(s64) * 2 * i;
+        REQUIRE(entry % sizeof(s64) == 0);
+        entries.emplace_back(Read<s64>(buffer, entry), Read<s64>(buffer, entry + 8));
+    }
+    return entries;
+}
+
+Table::Table(std::span<const u8> buffer_, std::size_t position_)
+    : buffer{buffer_}, position{position_} {}
+
+std::size_t Table::GetFieldOffset(u16 field_id) const {
+    const std::size_t vtable = position - Read<s32>(buffer, position);
+    const u16 vtable_size = Read<u16>(buffer, vtable);
+    const std::size_t entry = sizeof(u16) * (2 + field_id);
+    return entry < vtable_size ? Read<u16>(buffer, vtable + entry) : 0;
+}
+
+std::size_t Table::GetReference(u16 field_id) const {
+    const std::size_t field = GetFieldOffset(field_id);
+    REQUIRE(field != 0);
+    return position + field + Read<u32>(buffer, position + field);
+}
+
+Table Message::GetRoot() const {
+    return Table::GetRoot(metadata);
+}
+
+u8 Message::GetHeaderType() const {
+    return GetRoot().GetScalar<u8>(1);
+}
+
+Table Message::GetHeader() const {
+    return GetRoot().GetTable(2);
+}
+
+std::vector<Message> ReadMessages(const std::string& stream) {
+    const std::span<const u8> data{reinterpret_cast<const u8*>(stream.data()), stream.size()};
+    std::vector<Message> messages{};
+    std::size_t offset = 0;
+    while (true) {
+        REQUIRE(Read<u32>(data, offset) == 0xFFFFFFFF);
+        const u32 metadata_size = Read<u32>(data, offset + 4);
+        offset += 8;
+        if (metadata_size == 0) {
+            break;
+        }
+        // Bodies start 8 byte aligned
+        REQUIRE((offset + metadata_size) % 8 == 0);
+        REQUIRE(offset + metadata_size <= data.size());
+
+        Message& message = messages.emplace_back();
+        message.metadata.assign(data.begin() + static_cast<std::ptrdiff_t>(offset),
+                                data.begin() + static_cast<std::ptrdiff_t>(offset + metadata_size));
+        offset += metadata_size;
+
+        const Table root = message.GetRoot();
+        REQUIRE(root.GetScalar<s16>(0) == 4);
+        const auto body_size = static_cast<std::size_t>(root.GetScalar<s64>(3));
+        REQUIRE(body_size % 8 == 0);
+        REQUIRE(offset + body_size <= data.size());
+        message.body.assign(data.begin() + static_cast<std::ptrdiff_t>(offset),
+                            data.begin() + static_cast<std::ptrdiff_t>(offset + body_size));
+        offset += body_size;
+    }
+    REQUIRE(offset == data.size());
+    return messages;
+}
+
+std::vector<std::vector<u8>> GetBuffers(const Message& message, Table record_batch) {
+    std::vector<std::vector<u8>> buffers{};
+    for (const auto& [offset, size] : record_batch.GetStructs(2)) {
+        REQUIRE(offset % 8 == 0);
+        REQUIRE(static_cast<std::size_t>(offset + size) <= message.body.size());
+        buffers.emplace_back(message.body.begin() + offset, message.body.begin() + offset + size);
+    }
+    return buffers;
+}
+
+std::vector<std::string> GetStrings(const std::vector<u8>& offsets, const std::vector<u8>& data) {
+    const std::vector<s32> ends = GetValues<s32>(offsets);
+    std::vector<std::string> strings{};
+    for (std::size_t i = 1; i < ends.size(); ++i) {
+        strings.emplace_back(data.begin() + ends[i - 1], data.begin() + ends[i]);
+    }
+    return strings;
+}
+
+std::vector<std::string> GetDictionary(const Message& message, s64 id, bool is_delta) {
+    REQUIRE(message.GetHeaderType() == MessageHeaderDictionaryBatch);
+    const Table dictionary_batch = message.GetHeader();
+    REQUIRE(dictionary_batch.GetScalar<s64>(0) == id);
+    REQUIRE(dictionary_batch.GetScalar<u8>(2) == (is_delta ? 1 : 0));
+
+    const std::vector<std::vector<u8>> buffers =
+        GetBuffers(message, dictionary_batch.GetTable(1));
+    REQUIRE(buffers.size() == 3);
+    return GetStrings(buffers[1], buffers[2]);
+}
+
+} // namespace Tests
@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstring>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "common/common_types.h"
+
+namespace Tests {
+
+// Flatbuffer message header types and field type ids from the Arrow schemas
+constexpr u8 MessageHeaderSchema = 1;
+constexpr u8 MessageHeaderDictionaryBatch = 2;
+constexpr u8 MessageHeaderRecordBatch = 3;
+constexpr u8 TypeInt = 2;
+constexpr u8 TypeUtf8 = 5;
+constexpr u8 TypeList = 12;
+constexpr u8 TypeFixedSizeBinary = 15;
+
+template <typename T>
+T Read(std::span<const u8> data, std::size_t offset) {
+    REQUIRE(offset + sizeof(T) <= data.size());
+    T value{};
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+// Read only view of a flatbuffer table
+class Table {
+public:
+    static Table GetRoot(std::span<const u8> buffer);
+
+    template <typename T>
+    T GetScalar(u16 field_id, T default_value = {}) const {
+        const std::size_t field = GetFieldOffset(field_id);
+        return field == 0 ? default_value : Read<T>(buffer, position + field);
+    }
+
+    bool HasField(u16 field_id) const;
+    Table GetTable(u16 field_id) const;
+    std::string GetString(u16 field_id) const;
+    std::vector<Table> GetTables(u16 field_id) const;
+
+    // Arrow FieldNode and Buffer are both structs of two int64
+    std::vector<std::pair<s64, s64>> GetStructs(u16 field_id) const;
+
+private:
+    Table(std::span<const u8> buffer_, std::size_t position_);
+
+    std::size_t GetFieldOffset(u16 field_id) const;
+    std::size_t GetReference(u16 field_id) const;
+
+    std::span<const u8> buffer;
+    std::size_t position;
+};
+
+struct Message {
+    std::vector<u8> metadata{};
+    std::vector<u8> body{};
+
+    Table GetRoot() const;
+    u8 GetHeaderType() const;
+    Table GetHeader() const;
+};
+
+// Splits an IPC stream in messages, checking the framing of each one
+std::vector<Message> ReadMessages(const std::string& stream);
+
+// Values of each buffer of a record batch
+std::vector<std::vector<u8>> GetBuffers(const Message& message, Table record_batch);
+
+template <typename T>
+std::vector<T> GetValues(const std::vector<u8>& buffer) {
+    REQUIRE(buffer.size() % sizeof(T) == 0);
+    std::vector<T> values(buffer.size() / sizeof(T));
+    std::memcpy(values.data(), buffer.data(), buffer.size());
+    return values;
+}
+
+std::vector<std::string> GetStrings(const std::vector<u8>& offsets, const std::vector<u8>& data);
+
+// Strings of a dictionary batch, which is a single utf8 column
+std::vector<std::string> GetDictionary(const Message& message, s64 id, bool is_delta);
+
+} // namespace Tests
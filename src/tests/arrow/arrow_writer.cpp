@@ -0,0 +1,165 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/arrow/arrow_reader.h"
+#include "the_dude_to_human/arrow/arrow_writer.h"
+
+namespace Arrow {
+namespace {
+
+using Tests::GetBuffers;
+using Tests::GetDictionary;
+using Tests::GetValues;
+using Tests::Message;
+using Tests::MessageHeaderRecordBatch;
+using Tests::MessageHeaderSchema;
+using Tests::ReadMessages;
+using Tests::Table;
+using Tests::TypeFixedSizeBinary;
+using Tests::TypeInt;
+using Tests::TypeList;
+using Tests::TypeUtf8;
+
+constexpr std::array<u8, 4> Address{0x20, 0x01, 0x0d, 0xb8};
+
+std::vector<Column> CreateColumns() {
+    std::vector<Column> columns{};
+    columns.emplace_back("id", ColumnType::Int32);
+    columns.emplace_back("name", ColumnType::DictionaryUtf8);
+    columns.push_back(Column::CreateList("ids", {"item", ColumnType::UInt32}));
+    columns.emplace_back("address", ColumnType::FixedSizeBinary, 4);
+    return columns;
+}
+
+void AppendRow(StreamWriter& writer, s32 id, std::string_view name, std::span<const u32> ids) {
+    writer.GetColumn(0).AppendInt32(id);
+    writer.GetColumn(1).AppendString(name);
+    Column& items = writer.GetColumn(2).BeginList();
+    for (u32 item : ids) {
+        items.AppendUInt32(item);
+    }
+    writer.GetColumn(2).EndList();
+    writer.GetColumn(3).AppendBytes(Address);
+}
+
+TEST_CASE("Arrow stream framing", "[arrow]") {
+    std::ostringstream stream{};
+    StreamWriter writer{stream, CreateColumns()};
+    REQUIRE(writer.WriteSchema());
+
+    const std::array<u32, 2> ids{7, 8};
+    AppendRow(writer, 1, "a", ids);
+    AppendRow(writer, 2, "b", {});
+    AppendRow(writer, 3, "a", std::span{ids}.first(1));
+    REQUIRE(writer.GetPendingRows() == 3);
+    REQUIRE(writer.WriteBatch());
+    REQUIRE(writer.GetPendingRows() == 0);
+
+    // Only the new dictionary entry is sent, as a delta
+    AppendRow(writer, 4, "c", {});
+    AppendRow(writer, 5, "a", {});
+    REQUIRE(writer.WriteBatch());
+
+    // No new entries, no dictionary batch
+    AppendRow(writer, 6, "b", {});
+    REQUIRE(writer.WriteBatch());
+    REQUIRE(writer.Finish());
+
+    const std::vector<Message> messages = ReadMessages(stream.str());
+    REQUIRE(messages.size() == 6);
+
+    SECTION("Schema") {
+        REQUIRE(messages[0].GetHeaderType() == MessageHeaderSchema);
+        REQUIRE(messages[0].body.empty());
+        const std::vector<Table> fields = messages[0].GetHeader().GetTables(1);
+        REQUIRE(fields.size() == 4);
+
+        REQUIRE(fields[0].GetString(0) == "id");
+        REQUIRE(fields[0].GetScalar<u8>(2) == TypeInt);
+        REQUIRE(fields[0].GetTable(3).GetScalar<s32>(0) == 32);
+        REQUIRE(fields[0].GetTable(3).GetScalar<u8>(1) == 1);
+        REQUIRE_FALSE(fields[0].HasField(4));
+
+        REQUIRE(fields[1].GetString(0) == "name");
+        REQUIRE(fields[1].GetScalar<u8>(2) == TypeUtf8);
+        const Table dictionary = fields[1].GetTable(4);
+        REQUIRE(dictionary.GetScalar<s64>(0) == 0);
+        REQUIRE(dictionary.GetTable(1).GetScalar<s32>(0) == 32);
+
+        REQUIRE(fields[2].GetString(0) == "ids");
+        REQUIRE(fields[2].GetScalar<u8>(2) == TypeList);
+        const std::vector<Table> children = fields[2].GetTables(5);
+        REQUIRE(children.size() == 1);
+        REQUIRE(children[0].GetString(0) == "item");
+        REQUIRE(children[0].GetScalar<u8>(2) == TypeInt);
+        REQUIRE(children[0].GetTable(3).GetScalar<u8>(1) == 0);
+
+        REQUIRE(fields[3].GetString(0) == "address");
+        REQUIRE(fields[3].GetScalar<u8>(2) == TypeFixedSizeBinary);
+        REQUIRE(fields[3].GetTable(3).GetScalar<s32>(0) == 4);
+    }
+
+    SECTION("Dictionaries are sent once and then as deltas") {
+        REQUIRE(GetDictionary(messages[1], 0, false) == std::vector<std::string>{"a", "b"});
+        REQUIRE(messages[2].GetHeaderType() == MessageHeaderRecordBatch);
+        REQUIRE(GetDictionary(messages[3], 0, true) == std::vector<std::string>{"c"});
+        REQUIRE(messages[4].GetHeaderType() == MessageHeaderRecordBatch);
+        REQUIRE(messages[5].GetHeaderType() == MessageHeaderRecordBatch);
+    }
+
+    SECTION("Record batches") {
+        const Table first_batch = messages[2].GetHeader();
+        REQUIRE(first_batch.GetScalar<s64>(0) == 3);
+        // One node per column and list child
+        const std::vector<std::pair<s64, s64>> nodes = first_batch.GetStructs(1);
+        REQUIRE(nodes == std::vector<std::pair<s64, s64>>{{3, 0}, {3, 0}, {3, 0}, {3, 0}, {3, 0}});
+
+        // Validity, values | validity, indices | validity, offsets | validity, values |
+        // validity, values
+        const std::vector<std::vector<u8>> buffers = GetBuffers(messages[2], first_batch);
+        REQUIRE(buffers.size() == 10);
+        for (std::size_t i = 0; i < buffers.size(); i += 2) {
+            REQUIRE(buffers[i].empty());
+        }
+        REQUIRE(GetValues<s32>(buffers[1]) == std::vector<s32>{1, 2, 3});
+        REQUIRE(GetValues<s32>(buffers[3]) == std::vector<s32>{0, 1, 0});
+        REQUIRE(GetValues<s32>(buffers[5]) == std::vector<s32>{0, 2, 2, 3});
+        REQUIRE(GetValues<u32>(buffers[7]) == std::vector<u32>{7, 8, 7});
+        REQUIRE(buffers[9].size() == Address.size() * 3);
+        REQUIRE(std::equal(Address.begin(), Address.end(), buffers[9].begin() + 8));
+
+        // Dictionary indices keep counting across batches
+        const Table second_batch = messages[4].GetHeader();
+        REQUIRE(second_batch.GetScalar<s64>(0) == 2);
+        REQUIRE(GetValues<s32>(GetBuffers(messages[4], second_batch)[3]) ==
+                std::vector<s32>{2, 0});
+        const Table third_batch = messages[5].GetHeader();
+        REQUIRE(third_batch.GetScalar<s64>(0) == 1);
+        REQUIRE(GetValues<s32>(GetBuffers(messages[5], third_batch)[3]) == std::vector<s32>{1});
+    }
+}
+
+TEST_CASE("Arrow stream without rows", "[arrow]") {
+    std::ostringstream stream{};
+    StreamWriter writer{stream, CreateColumns()};
+    REQUIRE(writer.WriteSchema());
+    REQUIRE(writer.Finish());
+
+    const std::vector<Message> messages = ReadMessages(stream.str());
+    REQUIRE(messages.size() == 1);
+    REQUIRE(messages[0].GetHeaderType() == MessageHeaderSchema);
+}
+
+} // Anonymous namespace
+} // namespace Arrow
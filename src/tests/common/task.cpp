@@ -0,0 +1,193 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "common/async_semaphore.h"
+#include "common/task.h"
+
+namespace Common {
+namespace {
+
+Task<int> Return(int value) {
+    co_return value;
+}
+
+Task<int> Throw(std::string message) {
+    throw std::runtime_error(message);
+    co_return 0;
+}
+
+Task<int> AddOne(Task<int> task) {
+    const int value = co_await task;
+    co_return value + 1;
+}
+
+// Suspends the coroutines that wait on it until the test resumes them
+class Gate {
+public:
+    struct Awaiter {
+        Gate& gate;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle) {
+            gate.waiting.push_back(handle);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    Awaiter Wait() {
+        return Awaiter{*this};
+    }
+
+    std::size_t GetWaiting() const {
+        return waiting.size();
+    }
+
+    // Resumes the coroutine that waits the longest, false if none waits
+    bool OpenOne() {
+        if (waiting.empty()) {
+            return false;
+        }
+        const std::coroutine_handle<> handle = waiting.front();
+        waiting.pop_front();
+        handle.resume();
+        return true;
+    }
+
+private:
+    std::deque<std::coroutine_handle<>> waiting{};
+};
+
+// Waits for the gate before returning id
+Task<int> WaitForGate(Gate& gate, int id) {
+    co_await gate.Wait();
+    co_return id;
+}
+
+struct Holders {
+    std::size_t current{};
+    std::size_t max{};
+    std::vector<int> order{};
+};
+
+// Holds units of the semaphore until the gate lets it go
+Task<int> Hold(AsyncSemaphore& semaphore, Gate& gate, Holders& holders, int id,
+               std::size_t units) {
+    // More than the capacity only acquires all of it
+    const std::size_t held = std::min(units, semaphore.GetCapacity());
+    co_await semaphore.Acquire(units);
+    holders.current += held;
+    holders.max = std::max(holders.max, holders.current);
+    holders.order.push_back(id);
+    co_await gate.Wait();
+    holders.current -= held;
+    semaphore.Release(held);
+    co_return id;
+}
+
+// Starts the tasks without blocking, they are driven by the gate on this thread
+std::future<std::vector<int>> Start(std::vector<Task<int>> tasks) {
+    std::promise<std::vector<int>> result{};
+    std::future<std::vector<int>> future = result.get_future();
+    Detail::SignalWhenDone(WhenAll(std::move(tasks)), std::move(result));
+    return future;
+}
+
+TEST_CASE("SyncWait returns the result of nested tasks", "[common]") {
+    REQUIRE(SyncWait(AddOne(AddOne(Return(1)))) == 3);
+}
+
+TEST_CASE("SyncWait rethrows the exception of a task", "[common]") {
+    SECTION("Thrown by the awaited task") {
+        REQUIRE_THROWS_WITH(SyncWait(Throw("failed")), "failed");
+    }
+
+    SECTION("Thrown by a task awaited further down") {
+        REQUIRE_THROWS_WITH(SyncWait(AddOne(AddOne(Throw("nested")))), "nested");
+    }
+}
+
+TEST_CASE("WhenAll keeps the order of the tasks", "[common]") {
+    std::vector<Task<int>> tasks{};
+    for (int i = 0; i < 8; ++i) {
+        tasks.push_back(AddOne(Return(i)));
+    }
+    REQUIRE(SyncWait(WhenAll(std::move(tasks))) == std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8});
+    REQUIRE(SyncWait(WhenAll(std::vector<Task<int>>{})).empty());
+}
+
+TEST_CASE("WhenAll rethrows once every task finished", "[common]") {
+    Gate gate{};
+    std::vector<Task<int>> tasks{};
+    tasks.push_back(WaitForGate(gate, 0));
+    tasks.push_back(Throw("first"));
+    tasks.push_back(WaitForGate(gate, 2));
+    std::future<std::vector<int>> result = Start(std::move(tasks));
+
+    // The failed task doesn't end the wait for the others
+    REQUIRE(gate.GetWaiting() == 2);
+    REQUIRE(result.wait_for(std::chrono::seconds{0}) == std::future_status::timeout);
+    REQUIRE(gate.OpenOne());
+    REQUIRE(result.wait_for(std::chrono::seconds{0}) == std::future_status::timeout);
+    REQUIRE(gate.OpenOne());
+    REQUIRE_THROWS_WITH(result.get(), "first");
+}
+
+TEST_CASE("AsyncSemaphore limits the holders to its capacity", "[common]") {
+    constexpr std::size_t Capacity = 3;
+    AsyncSemaphore semaphore{Capacity};
+    Gate gate{};
+    Holders holders{};
+
+    SECTION("Single units") {
+        std::vector<Task<int>> tasks{};
+        for (int i = 0; i < 10; ++i) {
+            tasks.push_back(Hold(semaphore, gate, holders, i, 1));
+        }
+        std::future<std::vector<int>> result = Start(std::move(tasks));
+
+        REQUIRE(holders.current == Capacity);
+        while (gate.OpenOne()) {
+            REQUIRE(holders.current <= Capacity);
+        }
+        REQUIRE(holders.max == Capacity);
+        REQUIRE(holders.order == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+        REQUIRE(result.get().size() == 10);
+    }
+
+    SECTION("A waiter asking for more than the capacity waits for all of it") {
+        std::vector<Task<int>> tasks{};
+        tasks.push_back(Hold(semaphore, gate, holders, 0, 1));
+        tasks.push_back(Hold(semaphore, gate, holders, 1, 100));
+        // Enough units are free, but it arrived after the large waiter
+        tasks.push_back(Hold(semaphore, gate, holders, 2, 1));
+        std::future<std::vector<int>> result = Start(std::move(tasks));
+
+        REQUIRE(holders.order == std::vector<int>{0});
+        REQUIRE(gate.OpenOne());
+        REQUIRE(holders.order == std::vector<int>{0, 1});
+        REQUIRE(holders.current == Capacity);
+        REQUIRE(gate.OpenOne());
+        REQUIRE(holders.order == std::vector<int>{0, 1, 2});
+        REQUIRE(gate.OpenOne());
+        REQUIRE_FALSE(gate.OpenOne());
+        REQUIRE(holders.current == 0);
+        REQUIRE(result.get() == std::vector<int>{0, 1, 2});
+    }
+}
+
+} // Anonymous namespace
+} // namespace Common
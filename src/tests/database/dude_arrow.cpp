@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+std::vector<u8> ReadFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Arrow export stores long long fields big endian", "[database]") {
+    Tests::FixtureDatabase fixture{};
+    fixture.AddSampleObjects();
+    fixture.Close();
+    DudeDatabase db{fixture.GetPath().string()};
+
+    const std::filesystem::path arrow_dir = fixture.GetPath().parent_path() / "arrow";
+    REQUIRE(db.SaveDatabase(arrow_dir.string(), false, {.format = ExportFormat::Arrow}) == 0);
+    const std::vector<u8> data = ReadFile(arrow_dir / "notification.arrows");
+    REQUIRE_FALSE(data.empty());
+
+    // 2001:db8::1 in network order, the same bytes as the other binary exports
+    const std::array<u8, 16> address{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    REQUIRE(std::search(data.begin(), data.end(), address.begin(), address.end()) != data.end());
+}
+
+} // Anonymous namespace
+} // namespace Database
@@ -0,0 +1,266 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_chart_index.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+constexpr std::size_t BlockRows = ChartBlockIndex::BlockRows;
+constexpr u32 SourceCount = 5;
+constexpr u32 StartTime = 1700000000;
+constexpr u32 TimeStep = 30;
+
+// Size of the DCBI version 2 header and of each entry
+constexpr std::size_t IndexHeaderSize = 64;
+constexpr std::size_t IndexEntrySize = 32;
+
+// Every source sampled at the same times, like the Dude appends values. Sources skip some times
+// so the blocks hold a different time range per source
+std::vector<ChartValue> CreateValues(u32 sample_count) {
+    std::vector<ChartValue> values{};
+    for (u32 sample = 0; sample < sample_count; ++sample) {
+        for (u32 source_id = 1; source_id <= SourceCount; ++source_id) {
+            if (sample % (source_id + 1) == 1) {
+                continue;
+            }
+            const u32 time = StartTime + sample * TimeStep;
+            values.push_back({source_id, time, static_cast<f64>(time) / source_id});
+        }
+    }
+    return values;
+}
+
+void AddValues(Tests::FixtureDatabase& fixture, std::span<const ChartValue> values) {
+    for (const ChartValue& value : values) {
+        fixture.AddChartValue(ChartResolution::Raw, value.source_id, value.time, value.value);
+    }
+}
+
+// Values of source_id with start_time <= time <= end_time in time order
+ChartSeries GetExpectedSeries(std::span<const ChartValue> values, u32 source_id, u32 start_time,
+                              u32 end_time) {
+    std::vector<ChartValue> matches{};
+    std::copy_if(values.begin(), values.end(), std::back_inserter(matches),
+                 [&](const ChartValue& value) {
+                     return value.source_id == source_id && value.time >= start_time &&
+                            value.time <= end_time;
+                 });
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const ChartValue& a, const ChartValue& b) { return a.time < b.time; });
+
+    ChartSeries series{.source_id = source_id};
+    for (const ChartValue& value : matches) {
+        series.times.push_back(value.time);
+        series.values.push_back(value.value);
+    }
+    return series;
+}
+
+void RequireSeries(const DudeDatabase& db, std::span<const ChartValue> values, u32 source_id,
+                   u32 start_time, u32 end_time) {
+    INFO("Source " << source_id << " from " << start_time << " to " << end_time);
+    ChartSeries series{};
+    REQUIRE(db.QueryChartValues(series, ChartResolution::Raw, source_id, start_time, end_time) ==
+            0);
+    const ChartSeries expected = GetExpectedSeries(values, source_id, start_time, end_time);
+    REQUIRE(series.source_id == source_id);
+    REQUIRE(series.resolution == ChartResolution::Raw);
+    REQUIRE(series.times == expected.times);
+    REQUIRE(series.values == expected.values);
+}
+
+std::vector<u8> ReadFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+template <typename T>
+T ReadHeaderValue(const std::vector<u8>& data, std::size_t offset) {
+    T value{};
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+void ExecSql(const std::filesystem::path& path, const std::string& sql) {
+    sqlite3* db{nullptr};
+    int rc = sqlite3_open(path.string().c_str(), &db);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+    }
+    sqlite3_close(db);
+    if (rc != SQLITE_OK) {
+        throw std::runtime_error("Unable to run " + sql);
+    }
+}
+
+TEST_CASE("Chart queries match a linear scan", "[database]") {
+    const bool is_rowid_key = GENERATE(false, true);
+    INFO("Rowid key: " << is_rowid_key);
+
+    // Several blocks per source and a partial last block
+    const std::vector<ChartValue> values = CreateValues(BlockRows * 3 / 2);
+    Tests::FixtureDatabase fixture{};
+    fixture.AddChartTable(ChartResolution::Raw, is_rowid_key);
+    AddValues(fixture, values);
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+
+    const u32 end_time = values.back().time;
+    SECTION("Bounds are inclusive") {
+        for (u32 source_id = 1; source_id <= SourceCount; ++source_id) {
+            RequireSeries(db, values, source_id, 0, 0xffffffff);
+            RequireSeries(db, values, source_id, StartTime, StartTime);
+            RequireSeries(db, values, source_id, StartTime + TimeStep, StartTime + TimeStep * 3);
+            RequireSeries(db, values, source_id, end_time, end_time);
+        }
+    }
+
+    SECTION("Empty results") {
+        RequireSeries(db, values, 0, 0, 0xffffffff);
+        RequireSeries(db, values, SourceCount + 1, 0, 0xffffffff);
+        RequireSeries(db, values, 1, 0, StartTime - 1);
+        RequireSeries(db, values, 1, end_time + 1, 0xffffffff);
+        RequireSeries(db, values, 1, StartTime + TimeStep, StartTime);
+        // Between two samples
+        RequireSeries(db, values, 1, StartTime + 1, StartTime + TimeStep - 1);
+    }
+
+    SECTION("Random ranges") {
+        std::mt19937 generator{5};
+        std::uniform_int_distribution<u32> time_distribution{StartTime - TimeStep,
+                                                             end_time + TimeStep};
+        std::uniform_int_distribution<u32> source_distribution{1, SourceCount};
+        for (int query = 0; query < 200; ++query) {
+            const u32 start = time_distribution(generator);
+            const u32 length = query % 4 == 0 ? 0 : time_distribution(generator) - StartTime;
+            RequireSeries(db, values, source_distribution(generator), start, start + length);
+        }
+    }
+
+    SECTION("Last time") {
+        u32 last_time{};
+        REQUIRE(db.GetLastChartTime(last_time, ChartResolution::Raw) == 0);
+        REQUIRE(last_time == end_time);
+    }
+}
+
+TEST_CASE("Chart index file is reused until the database changes", "[database]") {
+    std::vector<ChartValue> values = CreateValues(BlockRows);
+    Tests::FixtureDatabase fixture{};
+    fixture.AddChartTable(ChartResolution::Raw, false);
+    AddValues(fixture, values);
+    fixture.Close();
+
+    const std::filesystem::path index_path =
+        fixture.GetPath().string() + "." + DudeDatabase::GetChartTableName(ChartResolution::Raw) +
+        ".idx";
+    const auto query_all = [&](u32 source_id) {
+        const DudeDatabase db{fixture.GetPath().string()};
+        RequireSeries(db, values, source_id, 0, 0xffffffff);
+    };
+
+    query_all(1);
+    REQUIRE(std::filesystem::exists(index_path));
+    const std::vector<u8> index_data = ReadFile(index_path);
+    const auto index_time = std::filesystem::last_write_time(index_path);
+
+    SECTION("Header") {
+        REQUIRE(index_data.size() >= IndexHeaderSize);
+        REQUIRE(std::string(index_data.begin(), index_data.begin() + 4) == "DCBI");
+        REQUIRE(ReadHeaderValue<u32>(index_data, 4) == 2);
+        REQUIRE(ReadHeaderValue<s64>(index_data, 8) == 1);
+        REQUIRE(ReadHeaderValue<s64>(index_data, 16) == static_cast<s64>(values.size()));
+        const u64 entry_count = ReadHeaderValue<u64>(index_data, 56);
+        // One entry per source and block
+        REQUIRE(entry_count >= SourceCount * (values.size() / BlockRows));
+        REQUIRE(index_data.size() == IndexHeaderSize + entry_count * IndexEntrySize);
+    }
+
+    SECTION("An unchanged database loads the saved index") {
+        query_all(2);
+        REQUIRE(ReadFile(index_path) == index_data);
+        REQUIRE(std::filesystem::last_write_time(index_path) == index_time);
+    }
+
+    SECTION("New rows rebuild the index") {
+        {
+            Sqlite::SqliteWriter writer{fixture.GetPath().string()};
+            REQUIRE(writer.OpenDatabase() == SQLITE_OK);
+            const ChartValue value{3, values.back().time + TimeStep, -1};
+            const std::array<Sqlite::SqlValue, 2> row{
+                static_cast<s64>(u64{value.source_id} << 32 | value.time), value.value};
+            REQUIRE(writer.InsertRow(DudeDatabase::GetChartTableName(ChartResolution::Raw),
+                                     row) == SQLITE_OK);
+            values.push_back(value);
+        }
+        query_all(3);
+        const std::vector<u8> new_index_data = ReadFile(index_path);
+        REQUIRE(ReadHeaderValue<s64>(new_index_data, 16) == static_cast<s64>(values.size()));
+    }
+
+    SECTION("Updated rows rebuild the index") {
+        // Moves the first value of source 1 to a new source, the rowid range doesn't change
+        ExecSql(fixture.GetPath(),
+                "UPDATE chart_values_raw SET id = id + (8 << 32) WHERE rowid = 1");
+        REQUIRE(values[0].source_id == 1);
+        values[0].source_id = 9;
+        query_all(1);
+        query_all(9);
+        REQUIRE(ReadFile(index_path) != index_data);
+    }
+
+    SECTION("Corrupted files are rebuilt") {
+        std::vector<u8> corrupted = index_data;
+        SECTION("Wrong version") {
+            corrupted[4] = 1;
+        }
+        SECTION("Truncated") {
+            corrupted.resize(corrupted.size() - IndexEntrySize / 2);
+        }
+        SECTION("Wrong magic") {
+            corrupted[0] = 'X';
+        }
+        {
+            std::ofstream file{index_path, std::ios::binary | std::ios::trunc};
+            file.write(reinterpret_cast<const char*>(corrupted.data()),
+                       static_cast<std::streamsize>(corrupted.size()));
+        }
+        query_all(5);
+        REQUIRE(ReadFile(index_path).size() == index_data.size());
+    }
+}
+
+TEST_CASE("Chart index of a database in memory", "[database]") {
+    const std::vector<ChartValue> values = CreateValues(BlockRows / 2);
+    Tests::FixtureDatabase fixture{};
+    fixture.AddChartTable(ChartResolution::Raw, false);
+    AddValues(fixture, values);
+    fixture.Close();
+
+    const DudeDatabase db{"memory", ReadFile(fixture.GetPath())};
+    RequireSeries(db, values, 2, StartTime + TimeStep * 10, StartTime + TimeStep * 100);
+    // Nothing to save the index next to
+    for (const auto& entry : std::filesystem::directory_iterator{fixture.GetPath().parent_path()}) {
+        REQUIRE(entry.path().extension() != ".idx");
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
@@ -0,0 +1,245 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_chart_sketch.h"
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/sketch/t_digest.h"
+
+namespace Database {
+namespace {
+
+constexpr u32 SourceId = 7;
+constexpr u32 BucketTime = 10 * ChartSketchBucketWidth;
+
+// Sketch file of one source with a single bucket, written field by field so tests can corrupt it
+struct SketchFile {
+    u32 bucket_width = ChartSketchBucketWidth;
+    std::vector<u8> digest{};
+    ChartSketchEntry entry{};
+    u64 footer_offset{};
+    u32 entry_count = 1;
+
+    SketchFile() {
+        Sketch::TDigest values{};
+        for (int i = 1; i <= 100; ++i) {
+            values.Add(i);
+        }
+        digest = values.Serialize();
+        entry = {.source_id = SourceId,
+                 .bucket_time = BucketTime,
+                 .size = static_cast<u32>(digest.size()),
+                 .offset = 16};
+        footer_offset = 16 + digest.size();
+    }
+
+    std::vector<u8> GetData() const {
+        std::vector<u8> data{};
+        const auto append = [&data](const void* value, std::size_t size) {
+            const auto* bytes = static_cast<const u8*>(value);
+            data.insert(data.end(), bytes, bytes + size);
+        };
+        const u32 version = 1;
+        const u32 reserved = 0;
+        append("DTDG", 4);
+        append(&version, sizeof(version));
+        append(&bucket_width, sizeof(bucket_width));
+        append(&reserved, sizeof(reserved));
+        append(digest.data(), digest.size());
+        append(&entry, sizeof(entry));
+        append(&footer_offset, sizeof(footer_offset));
+        append(&entry_count, sizeof(entry_count));
+        append("DTDG", 4);
+        return data;
+    }
+};
+
+// Writes the sketch file and opens it, the file is removed with the object
+class SketchFileReader {
+public:
+    explicit SketchFileReader(const SketchFile& sketch_file)
+        : path{std::filesystem::temp_directory_path() /
+               ("chart_sketch_" + std::to_string(getpid()) + ".bin")} {
+        const std::vector<u8> data = sketch_file.GetData();
+        std::ofstream{path, std::ios::binary}.write(reinterpret_cast<const char*>(data.data()),
+                                                    static_cast<std::streamsize>(data.size()));
+    }
+
+    ~SketchFileReader() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+    int Open() {
+        return reader.Open(path.string());
+    }
+
+    int Query(Sketch::TDigest& digest) {
+        u32 window_start{};
+        u64 window_end{};
+        return reader.QueryWindow(digest, window_start, window_end, SourceId, BucketTime,
+                                  BucketTime + 1);
+    }
+
+private:
+    const std::filesystem::path path;
+    ChartSketchReader reader{};
+};
+
+TEST_CASE("ChartSketchReader reads the digest of a bucket", "[database]") {
+    SketchFileReader reader{SketchFile{}};
+    REQUIRE(reader.Open() == 0);
+    Sketch::TDigest digest{};
+    REQUIRE(reader.Query(digest) == 0);
+    REQUIRE(digest.GetCount() == 100);
+    REQUIRE(digest.GetMax() == 100);
+}
+
+TEST_CASE("ChartSketchReader rejects a corrupted index", "[database]") {
+    SketchFile sketch_file{};
+
+    SECTION("Zero bucket width") {
+        sketch_file.bucket_width = 0;
+    }
+
+    SECTION("Footer inside the header") {
+        sketch_file.footer_offset = 8;
+    }
+
+    SECTION("Footer past the trailer") {
+        sketch_file.footer_offset += 0x1000000;
+    }
+
+    SECTION("More entries than the footer holds") {
+        sketch_file.entry_count = 0xFFFFFFFF;
+    }
+
+    SketchFileReader reader{sketch_file};
+    REQUIRE(reader.Open() != 0);
+}
+
+TEST_CASE("ChartSketchReader rejects entries outside the digests", "[database]") {
+    SketchFile sketch_file{};
+
+    SECTION("Offset inside the header") {
+        sketch_file.entry.offset = 4;
+    }
+
+    SECTION("Offset past the footer") {
+        sketch_file.entry.offset = 0xFFFFFFFFFFFF;
+    }
+
+    SECTION("Size past the footer") {
+        sketch_file.entry.size += 1;
+    }
+
+    SketchFileReader reader{sketch_file};
+    REQUIRE(reader.Open() == 0);
+    Sketch::TDigest digest{};
+    REQUIRE(reader.Query(digest) != 0);
+}
+
+TEST_CASE("Chart sketches are merged over a window of buckets", "[database]") {
+    constexpr u32 StartTime = 1700000000 - 1700000000 % ChartSketchBucketWidth;
+    constexpr u32 TimeStep = 45;
+    constexpr u32 EndTime = StartTime + ChartSketchBucketWidth * 6;
+
+    // Source 3 has a gap of a whole bucket, source 5 has a few values per bucket
+    std::vector<ChartValue> values{};
+    for (u32 time = StartTime; time < EndTime; time += TimeStep) {
+        if ((time - StartTime) / ChartSketchBucketWidth != 3) {
+            values.push_back({3, time, static_cast<f64>(time % 1009)});
+        }
+        if ((time - StartTime) % (TimeStep * 20) == 0) {
+            values.push_back({5, time, -static_cast<f64>(time % 13)});
+        }
+    }
+
+    Tests::FixtureDatabase fixture{};
+    fixture.AddChartTable(ChartResolution::Raw, false);
+    for (const ChartValue& value : values) {
+        fixture.AddChartValue(ChartResolution::Raw, value.source_id, value.time, value.value);
+    }
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+    const std::string sketch_path = (fixture.GetPath().parent_path() / "sketches.tdg").string();
+    REQUIRE(WriteChartSketches(&db, sketch_path) == 0);
+
+    ChartSketchReader reader{};
+    REQUIRE(reader.Open(sketch_path) == 0);
+    REQUIRE(reader.GetBucketWidth() == ChartSketchBucketWidth);
+
+    SECTION("One entry per source and bucket") {
+        std::set<std::pair<u32, u32>> buckets{};
+        for (const ChartValue& value : values) {
+            buckets.insert({value.source_id, value.time - value.time % ChartSketchBucketWidth});
+        }
+        const auto entries = reader.GetEntries();
+        REQUIRE(entries.size() == buckets.size());
+        REQUIRE(std::equal(entries.begin(), entries.end(), buckets.begin(),
+                           [](const ChartSketchEntry& entry, const std::pair<u32, u32>& bucket) {
+                               return entry.source_id == bucket.first &&
+                                      entry.bucket_time == bucket.second;
+                           }));
+    }
+
+    SECTION("Window rounded out to whole buckets") {
+        const u32 start_time = StartTime + ChartSketchBucketWidth + 100;
+        const u32 end_time = StartTime + ChartSketchBucketWidth * 4 + 100;
+        const u32 window_begin = start_time - start_time % ChartSketchBucketWidth;
+        const u32 window_last = end_time - end_time % ChartSketchBucketWidth;
+
+        std::vector<f64> window_values{};
+        for (const ChartValue& value : values) {
+            if (value.source_id == 3 && value.time >= window_begin &&
+                value.time < window_last + ChartSketchBucketWidth) {
+                window_values.push_back(value.value);
+            }
+        }
+        std::sort(window_values.begin(), window_values.end());
+
+        Sketch::TDigest digest{};
+        u32 window_start{};
+        u64 window_end{};
+        REQUIRE(reader.QueryWindow(digest, window_start, window_end, 3, start_time, end_time) ==
+                0);
+        REQUIRE(window_start == window_begin);
+        REQUIRE(window_end == u64{window_last} + ChartSketchBucketWidth);
+        REQUIRE(digest.GetCount() == static_cast<f64>(window_values.size()));
+        REQUIRE(digest.GetMin() == window_values.front());
+        REQUIRE(digest.GetMax() == window_values.back());
+        // Values are spread over 0 to 1008
+        REQUIRE(digest.Quantile(0.5) ==
+                Approx(window_values[window_values.size() / 2]).margin(15));
+    }
+
+    SECTION("Window without buckets") {
+        Sketch::TDigest digest{};
+        u32 window_start{};
+        u64 window_end{};
+        REQUIRE(reader.QueryWindow(digest, window_start, window_end, 4, StartTime, EndTime) == 0);
+        REQUIRE(digest.GetCount() == 0);
+        REQUIRE(window_end == window_start);
+
+        REQUIRE(reader.QueryWindow(digest, window_start, window_end, 5, EndTime, EndTime) == 0);
+        REQUIRE(digest.GetCount() == 0);
+        REQUIRE(window_end == window_start);
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "the_dude_to_human/database/dude_chart_stats.h"
+
+namespace Database {
+namespace {
+
+constexpr f64 Threshold = 10;
+constexpr f64 NaN = std::numeric_limits<f64>::quiet_NaN();
+
+// Values around the threshold so most vectors hold crossings
+std::vector<f64> GetRandomValues(std::size_t count, u32 seed) {
+    std::mt19937 generator{seed};
+    std::uniform_real_distribution<f64> distribution{Threshold - 50, Threshold + 50};
+    std::vector<f64> values(count);
+    for (f64& value : values) {
+        value = distribution(generator);
+    }
+    return values;
+}
+
+// Adds values in calls of at most split values
+ChartStats Accumulate(std::span<const f64> values, ChartStatsKernel kernel, std::size_t split) {
+    ChartStatsAccumulator accumulator{Threshold, kernel};
+    for (std::size_t offset = 0; offset < values.size(); offset += split) {
+        accumulator.Add(values.subspan(offset, std::min(split, values.size() - offset)));
+    }
+    return accumulator.GetStats();
+}
+
+bool IsSame(f64 a, f64 b) {
+    return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+// Sums are added in a different order, only they may differ by rounding
+void RequireSameStats(const ChartStats& stats, const ChartStats& expected) {
+    REQUIRE(stats.count == expected.count);
+    REQUIRE(IsSame(stats.min, expected.min));
+    REQUIRE(IsSame(stats.max, expected.max));
+    REQUIRE(stats.threshold_crossings == expected.threshold_crossings);
+    if (std::isnan(expected.mean)) {
+        REQUIRE(std::isnan(stats.mean));
+        REQUIRE(IsSame(stats.stddev, expected.stddev));
+        return;
+    }
+    REQUIRE(stats.mean == Approx(expected.mean).epsilon(1e-12));
+    REQUIRE(stats.stddev == Approx(expected.stddev).epsilon(1e-12));
+}
+
+TEST_CASE("Chart stats kernels match the scalar kernel", "[database]") {
+    REQUIRE(GetSupportedChartStatsKernels().front() == ChartStatsKernel::Scalar);
+    const ChartStatsKernel kernel = GENERATE(from_range(GetSupportedChartStatsKernels()));
+    INFO("Kernel: " << GetChartStatsKernelName(kernel));
+
+    SECTION("Every length around the vector sizes") {
+        // Lengths below, at and past one and several 4 and 8 value vectors, with every tail
+        for (std::size_t count = 1; count <= 41; ++count) {
+            INFO("Values: " << count);
+            const std::vector<f64> values = GetRandomValues(count, static_cast<u32>(count));
+            RequireSameStats(Accumulate(values, kernel, count),
+                             Accumulate(values, ChartStatsKernel::Scalar, count));
+        }
+    }
+
+    SECTION("Calls split at the block size and inside vectors") {
+        constexpr std::size_t BlockValues = ChartStatsAccumulator::BlockValues;
+        std::vector<f64> values = GetRandomValues(BlockValues * 2 + 13, 1);
+        // The only crossing between the first two blocks is at the block boundary
+        values[BlockValues - 1] = Threshold - 1;
+        values[BlockValues] = Threshold + 1;
+
+        const ChartStats expected = Accumulate(values, ChartStatsKernel::Scalar, values.size());
+        for (const std::size_t split : {BlockValues, BlockValues - 1, BlockValues + 3,
+                                        std::size_t{7}, std::size_t{8}, values.size()}) {
+            INFO("Split: " << split);
+            RequireSameStats(Accumulate(values, kernel, split), expected);
+        }
+    }
+
+    SECTION("NaN values") {
+        // NaN at the first value, in the low and high vectors of an 8 value step and in the
+        // tail. Ordered comparisons never pick a NaN value unless it's the first one
+        for (const std::size_t position : {0, 1, 3, 4, 6, 7, 9, 15, 17, 18, 25, 26}) {
+            INFO("NaN at: " << position);
+            std::vector<f64> values = GetRandomValues(27, static_cast<u32>(position));
+            values[position] = NaN;
+            // Extremes next to the NaN value, in the same lane of the other vector when there is
+            // one
+            const std::size_t other_vector = position ^ 4;
+            values[other_vector < values.size() ? other_vector : position - 1] = -1000;
+            values[(position + 1) % values.size()] = 1000;
+            RequireSameStats(Accumulate(values, kernel, values.size()),
+                             Accumulate(values, ChartStatsKernel::Scalar, values.size()));
+        }
+    }
+}
+
+TEST_CASE("Chart stats span several calls", "[database]") {
+    const std::vector<f64> values{1, 20, 5, 30, 30, 2};
+    ChartStatsAccumulator accumulator{Threshold};
+    accumulator.Add(std::span{values}.first(3));
+    accumulator.Add({});
+    accumulator.Add(std::span{values}.subspan(3));
+
+    const ChartStats stats = accumulator.GetStats();
+    REQUIRE(stats.count == 6);
+    REQUIRE(stats.min == 1);
+    REQUIRE(stats.max == 30);
+    REQUIRE(stats.mean == Approx(88.0 / 6));
+    REQUIRE(stats.threshold_crossings == 4);
+
+    REQUIRE(ChartStatsAccumulator{}.GetStats().count == 0);
+}
+
+} // Anonymous namespace
+} // namespace Database
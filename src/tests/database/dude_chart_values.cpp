@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+void RequireSameValues(const std::vector<ChartValue>& values,
+                       const std::vector<ChartValue>& expected) {
+    REQUIRE(values.size() == expected.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        INFO("Value: " << i);
+        REQUIRE(values[i].source_id == expected[i].source_id);
+        REQUIRE(values[i].time == expected[i].time);
+        REQUIRE(values[i].value == expected[i].value);
+    }
+}
+
+bool CompareKeys(const ChartValue& a, const ChartValue& b) {
+    return a.source_id != b.source_id ? a.source_id < b.source_id : a.time < b.time;
+}
+
+std::vector<ChartValue> ReadValues(const DudeDatabase& db, ChartResolution resolution) {
+    std::vector<ChartValue> values{};
+    REQUIRE(db.ReadChartValues(resolution, [&values](std::span<const ChartValue> batch) {
+        values.insert(values.end(), batch.begin(), batch.end());
+        return 0;
+    }) == 0);
+    return values;
+}
+
+TEST_CASE("Chart values decode the source and time of the key", "[database]") {
+    // Times past 0x7fffffff and sources using every byte of the upper half of the key
+    std::vector<ChartValue> values{
+        {1, 0, 1.5},
+        {1, 1700000000, -2},
+        {1, 0x80000000, 3},
+        {1, 0xffffffff, 4},
+        {2, 1700000000, 0},
+        {0x01020304, 5, 6.25},
+        {0x7fffffff, 0xffffffff, 1e300},
+    };
+
+    const bool is_rowid_key = GENERATE(false, true);
+    INFO("Rowid key: " << is_rowid_key);
+    Tests::FixtureDatabase fixture{};
+    fixture.AddChartTable(ChartResolution::Raw, is_rowid_key);
+    std::vector<ChartValue> shuffled = values;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{3});
+    for (const ChartValue& value : shuffled) {
+        fixture.AddChartValue(ChartResolution::Raw, value.source_id, value.time, value.value);
+    }
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+
+    // Ordered by source and time whatever the insertion order
+    REQUIRE(std::is_sorted(values.begin(), values.end(), CompareKeys));
+    RequireSameValues(ReadValues(db, ChartResolution::Raw), values);
+
+    // Other resolutions are separate tables
+    REQUIRE(db.ReadChartValues(ChartResolution::TenMinutes,
+                               [](std::span<const ChartValue>) { return 0; }) != 0);
+}
+
+TEST_CASE("Chart values are read in batches", "[database]") {
+    // Rows decoded per callback in dude_database.cpp
+    constexpr u32 BatchSize = 0x10000;
+    constexpr u32 ValueCount = BatchSize * 2 + 3;
+
+    Tests::FixtureDatabase fixture{};
+    fixture.AddChartTable(ChartResolution::OneDay, true);
+    for (u32 i = 0; i < ValueCount; ++i) {
+        fixture.AddChartValue(ChartResolution::OneDay, i % 3, i, static_cast<f64>(i));
+    }
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+
+    SECTION("Every row is passed once") {
+        std::vector<std::size_t> batch_sizes{};
+        std::vector<ChartValue> values{};
+        REQUIRE(db.ReadChartValues(ChartResolution::OneDay, [&](std::span<const ChartValue> batch) {
+            batch_sizes.push_back(batch.size());
+            values.insert(values.end(), batch.begin(), batch.end());
+            return 0;
+        }) == 0);
+
+        REQUIRE(batch_sizes == std::vector<std::size_t>{BatchSize, BatchSize, 3});
+        REQUIRE(values.size() == ValueCount);
+        REQUIRE(std::is_sorted(values.begin(), values.end(), CompareKeys));
+        REQUIRE(std::all_of(values.begin(), values.end(), [](const ChartValue& value) {
+            return value.time % 3 == value.source_id && value.value == static_cast<f64>(value.time);
+        }));
+    }
+
+    SECTION("A non zero callback result stops the read") {
+        int calls = 0;
+        REQUIRE(db.ReadChartValues(ChartResolution::OneDay, [&calls](std::span<const ChartValue>) {
+            calls++;
+            return 7;
+        }) == 7);
+        REQUIRE(calls == 1);
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
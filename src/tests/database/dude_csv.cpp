@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+using Rows = std::vector<std::vector<std::string>>;
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+// Strict RFC 4180 parser, every row must end with CRLF and quotes may only surround a whole cell
+Rows ParseCsv(std::string_view text) {
+    Rows rows{};
+    std::vector<std::string> row{};
+    std::string cell{};
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] == '"') {
+            for (++i;; ++i) {
+                REQUIRE(i < text.size());
+                if (text[i] != '"') {
+                    cell.push_back(text[i]);
+                } else if (i + 1 < text.size() && text[i + 1] == '"') {
+                    cell.push_back('"');
+                    ++i;
+                } else {
+                    break;
+                }
+            }
+            ++i;
+        } else {
+            while (i < text.size() && text[i] != ',' && text[i] != '\r') {
+                REQUIRE(text[i] != '"');
+                REQUIRE(text[i] != '\n');
+                cell.push_back(text[i++]);
+            }
+        }
+
+        REQUIRE(i < text.size());
+        row.push_back(std::move(cell));
+        cell.clear();
+        if (text[i] == ',') {
+            ++i;
+            continue;
+        }
+        REQUIRE(text.substr(i, 2) == "\r\n");
+        i += 2;
+        rows.push_back(std::move(row));
+        row.clear();
+    }
+    return rows;
+}
+
+std::string GetCell(const Rows& rows, std::size_t row, std::string_view column) {
+    const auto it = std::find(rows[0].begin(), rows[0].end(), column);
+    REQUIRE(it != rows[0].end());
+    REQUIRE(rows[row].size() == rows[0].size());
+    return rows[row][static_cast<std::size_t>(it - rows[0].begin())];
+}
+
+TEST_CASE("Csv export escapes cells as RFC 4180", "[database]") {
+    Tests::FixtureDatabase fixture{};
+    fixture.AddSampleObjects();
+    fixture.Close();
+    DudeDatabase db{fixture.GetPath().string()};
+
+    const std::string delimiter = GENERATE(as<std::string>{}, ";", " | ", ",", "\"");
+    INFO("Delimiter: " << delimiter);
+    const std::filesystem::path csv_dir = fixture.GetPath().parent_path() / "csv";
+    REQUIRE(db.SaveDatabase(csv_dir.string(), true,
+                            {.format = ExportFormat::Csv, .array_delimiter = delimiter}) == 0);
+
+    SECTION("Quotes, comas and line breaks") {
+        const std::string notes = ReadFile(csv_dir / "notes.csv");
+        REQUIRE(notes.starts_with("objectId,name,parentId,timeAdded"));
+        REQUIRE(notes.find(",\"Rack \"\"B\"\", row 3\r\nsecond line\",") != std::string::npos);
+
+        const Rows rows = ParseCsv(notes);
+        REQUIRE(rows.size() == 2);
+        REQUIRE(GetCell(rows, 1, "name") == "Rack \"B\", row 3\r\nsecond line");
+        REQUIRE(GetCell(rows, 1, "timeAdded") == "1700000000");
+    }
+
+    SECTION("Array entries joined with the delimiter") {
+        const Rows rows = ParseCsv(ReadFile(csv_dir / "device.csv"));
+        REQUIRE(rows.size() == 2);
+        REQUIRE(GetCell(rows, 1, "dnsNames") ==
+                "router.lan" + delimiter + "router;backup.lan");
+        REQUIRE(GetCell(rows, 1, "ip") == "192.168.1.1" + delimiter + "10.0.0.1");
+        REQUIRE(GetCell(rows, 1, "mac") ==
+                "00:0c:42:01:02:03" + delimiter + "e4:8d:8c:aa:bb:cc");
+        REQUIRE(GetCell(rows, 1, "parentIds") == "1" + delimiter + "4294967294");
+        REQUIRE(GetCell(rows, 1, "notifyIds").empty());
+        REQUIRE(GetCell(rows, 1, "agentId") == "-5");
+    }
+
+    SECTION("Empty tables only hold the header") {
+        const std::string tools = ReadFile(csv_dir / "tool.csv");
+        REQUIRE(ParseCsv(tools).size() == 1);
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
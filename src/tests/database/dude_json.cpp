@@ -0,0 +1,118 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <array>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/core.h>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_json.h"
+
+namespace Database {
+namespace {
+
+// Objects per chunk in dude_json.cpp
+constexpr u32 ChunkSize = 0x800;
+// Splits in three chunks with a shorter last one when there are enough threads
+constexpr u32 DeviceCount = ChunkSize * 3 + 5;
+// Splits in two chunks of exactly ChunkSize objects
+constexpr u32 NoteCount = ChunkSize * 2;
+
+std::unique_ptr<Tests::FixtureDatabase> CreateDatabase() {
+    auto database = std::make_unique<Tests::FixtureDatabase>();
+    u32 id = 1;
+
+    database->AddObject(id, Tests::ObjectBuilder{DataFormat::Tool}
+                                .Int(FieldId::SysId, id)
+                                .Text(FieldId::Tool_Command, "ping \"[Device.FirstAddress]\"")
+                                .Text(FieldId::SysName, "Ping"));
+    ++id;
+
+    for (u32 i = 0; i < DeviceCount; ++i, ++id) {
+        const std::array<std::string, 2> dns_names{fmt::format("device{}.lan", i), "alias\t\\"};
+        const std::array<u32, 1> ip{0x0100000a + (i << 8)};
+        const std::array<u8, 6> mac{0x00, 0x0c, 0x42, static_cast<u8>(i >> 8),
+                                    static_cast<u8>(i), 0x01};
+        database->AddObject(id, Tests::ObjectBuilder{DataFormat::Device}
+                                    .StringArray(FieldId::Device_DnsNames, dns_names)
+                                    .IntArray(FieldId::Device_IpAddress, ip)
+                                    .Bool(FieldId::Device_RouterOs, i % 2 == 0)
+                                    .Int(FieldId::SysId, id)
+                                    .Text(FieldId::Device_Password, fmt::format("pass{}", i))
+                                    .Text(FieldId::Device_Username, "admin")
+                                    .LongArray(FieldId::Device_MacAddress, mac)
+                                    .Text(FieldId::SysName, fmt::format("Device \"{}\"", i)));
+    }
+
+    for (u32 i = 0; i < NoteCount; ++i, ++id) {
+        database->AddObject(id, Tests::ObjectBuilder{DataFormat::Notes}
+                                    .Int(FieldId::SysId, id)
+                                    .Int(FieldId::Note_ObjID, 2 + i % DeviceCount)
+                                    .Int(FieldId::Note_TimeAdded, 1700000000 + i)
+                                    .Text(FieldId::SysName, std::string(i % 300, 'n')));
+    }
+
+    database->Close();
+    return database;
+}
+
+// Output of the serializer before tables were split in chunks
+std::string SerializeSequential(const DudeDatabase& db, bool has_credentials) {
+    std::string json = "{\n";
+    std::size_t table = 0;
+    db.ForEachTable([&](std::string_view table_name, const auto& objects) {
+        std::string rows = "";
+        for (const DudeObj& object : objects) {
+            rows += fmt::format("\n    {{{}}},", object.SerializeJson(has_credentials));
+        }
+        if (!objects.empty()) {
+            rows.pop_back();
+        }
+        ++table;
+        json += fmt::format("\"{}\": [{}\n]{}\n", table_name, rows,
+                            table != DudeDatabase::TableCount ? "," : "");
+    });
+    return json + "}";
+}
+
+std::string SerializeParallel(DudeDatabase& db, bool has_credentials, std::size_t thread_count) {
+    std::ostringstream json{};
+    SerializeDatabaseJson(&db, json, has_credentials, thread_count);
+    return json.str();
+}
+
+TEST_CASE("Json tables serialized in chunks match the sequential output", "[database]") {
+    const auto fixture = CreateDatabase();
+    DudeDatabase db{fixture->GetPath().string()};
+    REQUIRE(db.GetDeviceData().size() == DeviceCount);
+    REQUIRE(db.GetNotesData().size() == NoteCount);
+
+    const bool has_credentials = GENERATE(false, true);
+    const std::string expected = SerializeSequential(db, has_credentials);
+    const bool has_password =
+        expected.find(fmt::format("\"pass{}\"", DeviceCount - 1)) != std::string::npos;
+    REQUIRE(has_password == has_credentials);
+
+    // One thread never splits a table, eight split the devices in three chunks and the notes in
+    // two
+    for (const std::size_t thread_count : std::array<std::size_t, 4>{1, 2, 3, 8}) {
+        INFO("Threads: " << thread_count);
+        const std::string json = SerializeParallel(db, has_credentials, thread_count);
+        REQUIRE(json == expected);
+        // Only the last object of a table drops its coma, tables of any size included
+        REQUIRE(json.find(",\n]") == std::string::npos);
+        REQUIRE(json.find("\"tool\": [\n    {") != std::string::npos);
+        REQUIRE(json.find("\"file\": [\n],\n") != std::string::npos);
+        REQUIRE(json.ends_with("\"panelElement\": [\n]\n}"));
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
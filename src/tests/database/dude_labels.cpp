@@ -0,0 +1,182 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/arrow/arrow_reader.h"
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_labels.h"
+
+namespace Database {
+namespace {
+
+constexpr u32 RouterId = 10;
+constexpr u32 SwitchId = 11;
+constexpr u32 PingSourceId = 30;
+constexpr u32 CpuSourceId = 31;
+constexpr u32 UnknownSourceId = 32;
+
+// A ping service on the router, a cpu function of the switch drawn by two chart lines and a
+// source without device or lines
+void AddLabelObjects(Tests::FixtureDatabase& fixture) {
+    fixture.AddObject(RouterId, Tests::ObjectBuilder{DataFormat::Device}
+                                    .Int(FieldId::SysId, RouterId)
+                                    .Text(FieldId::SysName, "router"));
+    fixture.AddObject(SwitchId, Tests::ObjectBuilder{DataFormat::Device}
+                                    .Int(FieldId::SysId, SwitchId)
+                                    .Text(FieldId::SysName, "switch"));
+    fixture.AddObject(20, Tests::ObjectBuilder{DataFormat::Service}
+                              .Int(FieldId::Service_DataSourceID, PingSourceId)
+                              .Int(FieldId::SysId, 20)
+                              .Int(FieldId::Service_DeviceID, RouterId)
+                              .Text(FieldId::SysName, "ping"));
+    // The function device of a service source is ignored, the service owns it
+    fixture.AddObject(PingSourceId, Tests::ObjectBuilder{DataFormat::DataSource}
+                                        .Int(FieldId::DataSource_FunctionDevice, SwitchId)
+                                        .Int(FieldId::SysId, PingSourceId)
+                                        .Text(FieldId::DataSource_Unit, "ms")
+                                        .Text(FieldId::SysName, "Ping latency"));
+    fixture.AddObject(CpuSourceId, Tests::ObjectBuilder{DataFormat::DataSource}
+                                       .Int(FieldId::DataSource_FunctionDevice, SwitchId)
+                                       .Int(FieldId::SysId, CpuSourceId)
+                                       .Text(FieldId::DataSource_Unit, "%")
+                                       .Text(FieldId::SysName, "CPU"));
+    fixture.AddObject(UnknownSourceId, Tests::ObjectBuilder{DataFormat::DataSource}
+                                           .Int(FieldId::SysId, UnknownSourceId)
+                                           .Text(FieldId::SysName, "Orphan"));
+    const auto add_line = [&fixture](u32 id, u32 source_id, const char* name) {
+        fixture.AddObject(id, Tests::ObjectBuilder{DataFormat::ChartLine}
+                                  .Int(FieldId::ChartLine_ChartID, 50)
+                                  .Int(FieldId::ChartLine_SourceID, source_id)
+                                  .Int(FieldId::SysId, id)
+                                  .Text(FieldId::SysName, name));
+    };
+    add_line(40, CpuSourceId, "CPU load");
+    add_line(41, PingSourceId, "Latency");
+    add_line(42, CpuSourceId, "Switch CPU");
+}
+
+void RequireLabels(const SeriesLabels& labels, std::string_view source, std::string_view unit,
+                   std::string_view service, std::string_view device, std::string_view chart) {
+    REQUIRE(labels.source == source);
+    REQUIRE(labels.unit == unit);
+    REQUIRE(labels.service == service);
+    REQUIRE(labels.device == device);
+    REQUIRE(labels.chart == chart);
+}
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Series labels are resolved from the database objects", "[database]") {
+    Tests::FixtureDatabase fixture{};
+    AddLabelObjects(fixture);
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+    SeriesLabelIndex index{&db};
+
+    SECTION("Service source") {
+        RequireLabels(index.GetLabels(PingSourceId), "Ping latency", "ms", "ping", "router",
+                      "Latency");
+    }
+
+    SECTION("Function source with several chart lines") {
+        RequireLabels(index.GetLabels(CpuSourceId), "CPU", "%", "", "switch",
+                      "CPU load, Switch CPU");
+    }
+
+    SECTION("Source without device or lines") {
+        RequireLabels(index.GetLabels(UnknownSourceId), "Orphan", "", "", "", "");
+    }
+
+    SECTION("Unknown source") {
+        RequireLabels(index.GetLabels(99), "", "", "", "", "");
+        REQUIRE(index.GetStringCount() == 0);
+    }
+
+    SECTION("Labels are interned once") {
+        const SeriesLabels& labels = index.GetLabels(CpuSourceId);
+        REQUIRE(&index.GetLabels(CpuSourceId) == &labels);
+        index.GetLabels(PingSourceId);
+        // CPU, %, switch, the joined chart names, Ping latency, ms, ping, router and Latency
+        REQUIRE(index.GetStringCount() == 9);
+    }
+}
+
+TEST_CASE("Labeled chart values are dictionary encoded", "[database]") {
+    Tests::FixtureDatabase fixture{};
+    AddLabelObjects(fixture);
+    for (const ChartResolution resolution : ChartResolutions) {
+        fixture.AddChartTable(resolution, false);
+    }
+    fixture.AddChartValue(ChartResolution::Raw, PingSourceId, 1700000000, 1.5);
+    fixture.AddChartValue(ChartResolution::Raw, PingSourceId, 1700000030, 2.5);
+    fixture.AddChartValue(ChartResolution::Raw, CpuSourceId, 1700000000, 40);
+    fixture.AddChartValue(ChartResolution::Raw, UnknownSourceId, 1700000000, 7);
+    fixture.AddChartValue(ChartResolution::OneDay, CpuSourceId, 1699920000, 35);
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+
+    const std::filesystem::path out_path = fixture.GetPath().parent_path() / "labeled.arrows";
+    REQUIRE(ExportLabeledChartValues(&db, out_path.string(), 1000) == 0);
+    const std::vector<Tests::Message> messages = Tests::ReadMessages(ReadFile(out_path));
+
+    // Schema, one dictionary per label column and a single record batch
+    REQUIRE(messages.size() == 8);
+    REQUIRE(messages[0].GetHeaderType() == Tests::MessageHeaderSchema);
+    using Strings = std::vector<std::string>;
+    REQUIRE(Tests::GetDictionary(messages[1], 0, false) ==
+            Strings{"raw", "10min", "2hour", "1day"});
+    REQUIRE(Tests::GetDictionary(messages[2], 1, false) ==
+            Strings{"Ping latency", "CPU", "Orphan"});
+    REQUIRE(Tests::GetDictionary(messages[3], 2, false) == Strings{"ms", "%", ""});
+    REQUIRE(Tests::GetDictionary(messages[4], 3, false) == Strings{"ping", ""});
+    REQUIRE(Tests::GetDictionary(messages[5], 4, false) == Strings{"router", "switch", ""});
+    REQUIRE(Tests::GetDictionary(messages[6], 5, false) ==
+            Strings{"Latency", "CPU load, Switch CPU", ""});
+
+    REQUIRE(messages[7].GetHeaderType() == Tests::MessageHeaderRecordBatch);
+    const Tests::Table record_batch = messages[7].GetHeader();
+    REQUIRE(record_batch.GetScalar<s64>(0) == 5);
+    // Validity and values or indices of every column
+    const std::vector<std::vector<u8>> buffers = Tests::GetBuffers(messages[7], record_batch);
+    REQUIRE(buffers.size() == 18);
+    using Indices = std::vector<s32>;
+    REQUIRE(Tests::GetValues<s32>(buffers[1]) == Indices{0, 0, 0, 0, 3});
+    REQUIRE(Tests::GetValues<u32>(buffers[3]) ==
+            std::vector<u32>{PingSourceId, PingSourceId, CpuSourceId, UnknownSourceId,
+                             CpuSourceId});
+    REQUIRE(Tests::GetValues<f64>(buffers[7]) == std::vector<f64>{1.5, 2.5, 40, 7, 35});
+    REQUIRE(Tests::GetValues<s32>(buffers[9]) == Indices{0, 0, 1, 2, 1});
+    REQUIRE(Tests::GetValues<s32>(buffers[11]) == Indices{0, 0, 1, 2, 1});
+    REQUIRE(Tests::GetValues<s32>(buffers[13]) == Indices{0, 0, 1, 1, 1});
+    REQUIRE(Tests::GetValues<s32>(buffers[15]) == Indices{0, 0, 1, 2, 1});
+    REQUIRE(Tests::GetValues<s32>(buffers[17]) == Indices{0, 0, 1, 2, 1});
+}
+
+TEST_CASE("Failed labeled exports leave no file", "[database]") {
+    Tests::FixtureDatabase fixture{};
+    AddLabelObjects(fixture);
+    // The rollup tables are missing
+    fixture.AddChartTable(ChartResolution::Raw, false);
+    fixture.AddChartValue(ChartResolution::Raw, PingSourceId, 1700000000, 1.5);
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+
+    const std::filesystem::path out_path = fixture.GetPath().parent_path() / "labeled.arrows";
+    REQUIRE(ExportLabeledChartValues(&db, out_path.string(), 1) != 0);
+    REQUIRE_FALSE(std::filesystem::exists(out_path));
+}
+
+} // Anonymous namespace
+} // namespace Database
@@ -0,0 +1,328 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_msgpack.h"
+
+namespace Database {
+namespace {
+
+// Decodes the subset of msgpack written by the exporter, failing on any other type byte
+class MsgpackReader {
+public:
+    explicit MsgpackReader(std::vector<u8> data_) : data{std::move(data_)} {}
+
+    bool IsEnd() const {
+        return offset == data.size();
+    }
+
+    bool ReadBool() {
+        const u8 type = ReadByte();
+        REQUIRE((type == 0xc2 || type == 0xc3));
+        return type == 0xc3;
+    }
+
+    u64 ReadUint() {
+        const u8 type = ReadByte();
+        if (type < 0x80) {
+            return type;
+        }
+        switch (type) {
+        case 0xcc:
+            return ReadBigEndian(1);
+        case 0xcd:
+            return ReadBigEndian(2);
+        case 0xce:
+            return ReadBigEndian(4);
+        case 0xcf:
+            return ReadBigEndian(8);
+        }
+        FAIL("Unexpected uint type " << static_cast<u32>(type));
+        return 0;
+    }
+
+    s64 ReadInt() {
+        const u8 type = data.at(offset);
+        if (type < 0x80 || (type >= 0xcc && type <= 0xcf)) {
+            return static_cast<s64>(ReadUint());
+        }
+        ++offset;
+        if (type >= 0xe0) {
+            return static_cast<s8>(type);
+        }
+        switch (type) {
+        case 0xd0:
+            return static_cast<s8>(ReadBigEndian(1));
+        case 0xd1:
+            return static_cast<s16>(ReadBigEndian(2));
+        case 0xd2:
+            return static_cast<s32>(ReadBigEndian(4));
+        case 0xd3:
+            return static_cast<s64>(ReadBigEndian(8));
+        }
+        FAIL("Unexpected int type " << static_cast<u32>(type));
+        return 0;
+    }
+
+    std::string ReadString() {
+        const u8 type = ReadByte();
+        std::size_t size = 0;
+        if ((type & 0xe0) == 0xa0) {
+            size = type & 0x1f;
+        } else if (type == 0xd9) {
+            size = ReadBigEndian(1);
+        } else if (type == 0xda) {
+            size = ReadBigEndian(2);
+        } else {
+            REQUIRE(type == 0xdb);
+            size = ReadBigEndian(4);
+        }
+        const std::vector<u8> bytes = ReadRaw(size);
+        return {bytes.begin(), bytes.end()};
+    }
+
+    std::vector<u8> ReadBinary() {
+        const u8 type = ReadByte();
+        REQUIRE((type >= 0xc4 && type <= 0xc6));
+        return ReadRaw(ReadBigEndian(std::size_t{1} << (type - 0xc4)));
+    }
+
+    std::size_t ReadArrayHeader() {
+        const u8 type = ReadByte();
+        if ((type & 0xf0) == 0x90) {
+            return type & 0x0f;
+        }
+        REQUIRE((type == 0xdc || type == 0xdd));
+        return ReadBigEndian(type == 0xdc ? 2 : 4);
+    }
+
+    std::size_t ReadMapHeader() {
+        const u8 type = ReadByte();
+        if ((type & 0xf0) == 0x80) {
+            return type & 0x0f;
+        }
+        REQUIRE((type == 0xde || type == 0xdf));
+        return ReadBigEndian(type == 0xde ? 2 : 4);
+    }
+
+    // Returns the payload of an extension of the given type
+    std::vector<u8> ReadExt(MsgpackExtType ext_type) {
+        const u8 type = ReadByte();
+        std::size_t size = 0;
+        if (type >= 0xd4 && type <= 0xd8) {
+            size = std::size_t{1} << (type - 0xd4);
+        } else {
+            REQUIRE((type >= 0xc7 && type <= 0xc9));
+            size = ReadBigEndian(std::size_t{1} << (type - 0xc7));
+        }
+        REQUIRE(static_cast<s8>(ReadByte()) == static_cast<s8>(ext_type));
+        return ReadRaw(size);
+    }
+
+private:
+    u8 ReadByte() {
+        REQUIRE(offset < data.size());
+        return data[offset++];
+    }
+
+    u64 ReadBigEndian(std::size_t size) {
+        u64 value = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            value = value << 8 | ReadByte();
+        }
+        return value;
+    }
+
+    std::vector<u8> ReadRaw(std::size_t size) {
+        REQUIRE(data.size() - offset >= size);
+        const auto begin = data.begin() + static_cast<std::ptrdiff_t>(offset);
+        offset += size;
+        return {begin, begin + static_cast<std::ptrdiff_t>(size)};
+    }
+
+    std::vector<u8> data;
+    std::size_t offset{};
+};
+
+u32 ReadLittleEndian(std::span<const u8> bytes) {
+    return static_cast<u32>(bytes[0] | bytes[1] << 8 | bytes[2] << 16 | bytes[3] << 24);
+}
+
+// Reads each field back and compares it with the value in the database
+struct FieldChecker {
+    MsgpackReader& reader;
+
+    void CheckName(std::string_view name) {
+        REQUIRE(reader.ReadString() == name);
+    }
+
+    void operator()(std::string_view name, const BoolField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadBool() == field.value);
+    }
+
+    void operator()(std::string_view name, const ByteField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadUint() == field.value);
+    }
+
+    void operator()(std::string_view name, const IntField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadInt() == field.value);
+    }
+
+    void operator()(std::string_view name, const TimeField& field) {
+        CheckName(name);
+        const std::vector<u8> date = reader.ReadExt(MsgpackExtType::Timestamp);
+        REQUIRE(date.size() == 4);
+        REQUIRE(static_cast<u32>(date[0] << 24 | date[1] << 16 | date[2] << 8 | date[3]) ==
+                field.date);
+    }
+
+    void operator()(std::string_view name, const LongField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadUint() == field.value);
+    }
+
+    void operator()(std::string_view name, const LongLongField& field) {
+        CheckName(name);
+        const std::vector<u8> raw = reader.ReadBinary();
+        REQUIRE(raw.size() == 16);
+        u128 value{};
+        for (std::size_t i = 0; i < raw.size(); ++i) {
+            value[i / 8] = value[i / 8] << 8 | raw[i];
+        }
+        REQUIRE(value == field.value);
+    }
+
+    void operator()(std::string_view name, const TextField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadString() == field.text);
+    }
+
+    void operator()(std::string_view name, const IntArrayField& field) {
+        CheckName(name);
+        const std::vector<u8> raw = reader.ReadExt(MsgpackExtType::U32Array);
+        REQUIRE(raw.size() == field.data.size() * sizeof(u32));
+        for (std::size_t i = 0; i < field.data.size(); ++i) {
+            REQUIRE(ReadLittleEndian(std::span{raw}.subspan(i * sizeof(u32))) == field.data[i]);
+        }
+    }
+
+    void operator()(std::string_view name, const IpArrayField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadArrayHeader() == field.data.size());
+        for (u32 entry : field.data) {
+            const std::vector<u8> ip = reader.ReadBinary();
+            REQUIRE(ip.size() == sizeof(IpAddress));
+            REQUIRE(ReadLittleEndian(ip) == entry);
+        }
+    }
+
+    void operator()(std::string_view name, const LongArrayField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadBinary() == field.data);
+    }
+
+    void operator()(std::string_view name, const MacAddressField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadArrayHeader() == field.mac_address.size());
+        for (const MacAddress& mac : field.mac_address) {
+            REQUIRE(reader.ReadBinary() == std::vector<u8>(mac.begin(), mac.end()));
+        }
+    }
+
+    void operator()(std::string_view name, const StringArrayField& field) {
+        CheckName(name);
+        REQUIRE(reader.ReadArrayHeader() == field.entries.size());
+        for (const StringArrayEntry& entry : field.entries) {
+            REQUIRE(reader.ReadString() == entry.text);
+        }
+    }
+};
+
+std::vector<u8> ReadFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+bool Contains(const std::vector<u8>& data, std::initializer_list<u8> bytes) {
+    return std::search(data.begin(), data.end(), bytes.begin(), bytes.end()) != data.end();
+}
+
+TEST_CASE("Msgpack export round trips every field type", "[database]") {
+    Tests::FixtureDatabase fixture{};
+    fixture.AddSampleObjects();
+    fixture.Close();
+    DudeDatabase db{fixture.GetPath().string()};
+
+    const bool has_credentials = GENERATE(false, true);
+    const std::filesystem::path msgpack_path = fixture.GetPath().parent_path() / "dude.msgpack";
+    REQUIRE(db.SaveDatabase(msgpack_path.string(), has_credentials,
+                            {.format = ExportFormat::Msgpack}) == 0);
+    const std::vector<u8> data = ReadFile(msgpack_path);
+
+    SECTION("Every table and field in export order") {
+        MsgpackReader reader{data};
+        std::size_t object_count = 0;
+        REQUIRE(reader.ReadMapHeader() == DudeDatabase::TableCount);
+        db.ForEachTable([&](std::string_view table_name, const auto& objects) {
+            INFO("Table: " << table_name);
+            REQUIRE(reader.ReadString() == table_name);
+            REQUIRE(reader.ReadArrayHeader() == objects.size());
+            for (const auto& object : objects) {
+                std::size_t field_count = 0;
+                object.VisitFields([&field_count](std::string_view, const auto&) { field_count++; },
+                                   has_credentials);
+                REQUIRE(reader.ReadMapHeader() == field_count);
+                object.VisitFields(FieldChecker{reader}, has_credentials);
+                ++object_count;
+            }
+        });
+        REQUIRE(reader.IsEnd());
+        REQUIRE(object_count == 5);
+    }
+
+    SECTION("Wire encoding of the extension and binary values") {
+        // Timestamp 32 extension holding 1700000000 in big endian
+        REQUIRE(Contains(data, {0xd6, 0xff, 0x65, 0x53, 0xf1, 0x00}));
+        // Parent ids as packed little endian u32 values in a fixext 8, empty notify ids in an ext 8
+        REQUIRE(Contains(data, {0xd7, 0x01, 0x01, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xff, 0xff}));
+        REQUIRE(Contains(data, {0xc7, 0x00, 0x01}));
+        // 192.168.1.1 and 10.0.0.1 as four byte binaries
+        REQUIRE(Contains(data, {0x92, 0xc4, 0x04, 0xc0, 0xa8, 0x01, 0x01, 0xc4, 0x04, 0x0a, 0x00,
+                                0x00, 0x01}));
+        REQUIRE(Contains(data, {0x92, 0xc4, 0x06, 0x00, 0x0c, 0x42, 0x01, 0x02, 0x03, 0xc4, 0x06,
+                                0xe4, 0x8d, 0x8c, 0xaa, 0xbb, 0xcc}));
+        // 2001:db8::1 in network order
+        REQUIRE(Contains(data, {0xc4, 0x10, 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01}));
+        // Negative agent id, link speed past u32 and a name past str 8
+        REQUIRE(Contains(data, {0xa7, 'a', 'g', 'e', 'n', 't', 'I', 'd', 0xfb}));
+        REQUIRE(Contains(data, {0xcf, 0x00, 0x00, 0x00, 0x02, 0x54, 0x0b, 0xe4, 0x00}));
+        REQUIRE(Contains(data, {0xda, 0x01, 0x2c, 'm', 'm'}));
+    }
+
+    SECTION("Credentials are hidden unless requested") {
+        const bool has_password = Contains(data, {0xa6, 's', 'e', 'c', 'r', 'e', 't'});
+        REQUIRE(has_password == has_credentials);
+        const bool is_hidden = Contains(data, {0xa5, '*', '*', '*', '*', '*'});
+        REQUIRE(is_hidden != has_credentials);
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_openmetrics.h"
+
+namespace Database {
+namespace {
+
+constexpr u32 StartTime = 1700000000;
+constexpr u32 SampleCount = 40;
+
+// Source, resolution, time and value of a sample
+using SampleTuple = std::tuple<u32, std::string, u32, f64>;
+
+// Two sources named CPU share a family, a device name needs escaping and source 33 has no
+// data source object. Families aren't in source id order so unsorted runs would show
+void AddMetricObjects(Tests::FixtureDatabase& fixture) {
+    fixture.AddObject(10, Tests::ObjectBuilder{DataFormat::Device}
+                              .Int(FieldId::SysId, 10)
+                              .Text(FieldId::SysName, "core \"A\"\\rack\n2"));
+    fixture.AddObject(11, Tests::ObjectBuilder{DataFormat::Device}
+                              .Int(FieldId::SysId, 11)
+                              .Text(FieldId::SysName, "switch"));
+    const auto add_source = [&fixture](u32 id, u32 device_id, const char* unit,
+                                       const char* name) {
+        fixture.AddObject(id, Tests::ObjectBuilder{DataFormat::DataSource}
+                                  .Int(FieldId::DataSource_FunctionDevice, device_id)
+                                  .Int(FieldId::SysId, id)
+                                  .Text(FieldId::DataSource_Unit, unit)
+                                  .Text(FieldId::SysName, name));
+    };
+    add_source(30, 10, "C", "Zone temperature");
+    add_source(31, 10, "%", "CPU");
+    add_source(32, 11, "%", "CPU");
+}
+
+f64 GetValue(u32 source_id, u32 time) {
+    return source_id * 1000.0 + (time - StartTime) / 8.0;
+}
+
+// Value of a label made of characters that are never escaped
+std::string GetLabel(std::string_view labels, std::string_view name) {
+    const std::string prefix = std::string{name} + "=\"";
+    const std::size_t begin = labels.find(prefix);
+    REQUIRE(begin != std::string_view::npos);
+    const std::size_t value_begin = begin + prefix.size();
+    return std::string{labels.substr(value_begin, labels.find('"', value_begin) - value_begin)};
+}
+
+std::vector<std::string> ReadLines(const std::filesystem::path& path) {
+    std::ifstream file{path};
+    std::vector<std::string> lines{};
+    for (std::string line; std::getline(file, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+TEST_CASE("OpenMetrics export merges sorted runs", "[database]") {
+    Tests::FixtureDatabase fixture{};
+    AddMetricObjects(fixture);
+    for (const ChartResolution resolution : ChartResolutions) {
+        fixture.AddChartTable(resolution, false);
+    }
+    // Rows interleaved by time like the Dude writes them
+    std::vector<SampleTuple> expected{};
+    for (u32 sample = 0; sample < SampleCount; ++sample) {
+        const u32 time = StartTime + sample * 30;
+        for (const u32 source_id : {33, 31, 30, 32}) {
+            fixture.AddChartValue(ChartResolution::Raw, source_id, time, GetValue(source_id, time));
+            expected.emplace_back(source_id, "raw", time, GetValue(source_id, time));
+        }
+    }
+    for (u32 sample = 0; sample < 5; ++sample) {
+        const u32 time = StartTime + sample * 600;
+        fixture.AddChartValue(ChartResolution::TenMinutes, 30, time, GetValue(30, time));
+        expected.emplace_back(30, "10min", time, GetValue(30, time));
+    }
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+
+    // Runs that split the samples evenly, unevenly and a single run kept in memory
+    const std::size_t run_samples = GENERATE(std::size_t{5}, std::size_t{16},
+                                             OpenMetricsRunSamples);
+    INFO("Run samples: " << run_samples);
+    REQUIRE(expected.size() % 5 == 0);
+
+    const std::filesystem::path out_path = fixture.GetPath().parent_path() / "metrics.txt";
+    REQUIRE(SerializeDatabaseOpenMetrics(&db, out_path.string(), run_samples) == 0);
+    const std::vector<std::string> lines = ReadLines(out_path);
+    REQUIRE_FALSE(lines.empty());
+    REQUIRE(lines.back() == "# EOF");
+
+    std::map<std::string, int> type_lines{};
+    std::string family{};
+    std::vector<std::tuple<std::string, std::string, u32>> series_times{};
+    std::vector<SampleTuple> samples{};
+    for (std::size_t i = 0; i + 1 < lines.size(); ++i) {
+        const std::string& line = lines[i];
+        INFO("Line: " << line);
+        if (line.starts_with("# TYPE ")) {
+            std::istringstream type_line{line.substr(7)};
+            std::string type{};
+            type_line >> family >> type;
+            REQUIRE(type == "gauge");
+            type_lines[family]++;
+            continue;
+        }
+
+        const std::size_t labels_begin = line.find('{');
+        const std::size_t labels_end = line.rfind('}');
+        REQUIRE(labels_begin != std::string::npos);
+        REQUIRE(labels_end != std::string::npos);
+        const std::string name = line.substr(0, labels_begin);
+        const std::string labels = line.substr(labels_begin + 1, labels_end - labels_begin - 1);
+        // Samples follow the type line of their family
+        REQUIRE(name == family);
+
+        f64 value{};
+        u32 time{};
+        std::istringstream{line.substr(labels_end + 1)} >> value >> time;
+        series_times.emplace_back(name, labels, time);
+        samples.emplace_back(static_cast<u32>(std::stoul(GetLabel(labels, "source_id"))),
+                             GetLabel(labels, "resolution"), time, value);
+    }
+
+    SECTION("Every sample is written once") {
+        std::sort(samples.begin(), samples.end());
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(samples == expected);
+    }
+
+    SECTION("Series and times are ordered across runs") {
+        REQUIRE(std::is_sorted(series_times.begin(), series_times.end()));
+        REQUIRE(std::adjacent_find(series_times.begin(), series_times.end()) ==
+                series_times.end());
+    }
+
+    SECTION("One type line per family") {
+        REQUIRE(type_lines == std::map<std::string, int>{{"dude_cpu", 1},
+                                                         {"dude_source_33", 1},
+                                                         {"dude_zone_temperature", 1}});
+    }
+
+    SECTION("Label values are escaped") {
+        const auto is_router_line = [](const std::string& line) {
+            return line.find(R"(device="core \"A\"\\rack\n2")") != std::string::npos;
+        };
+        // Both sources of the router
+        REQUIRE(std::count_if(lines.begin(), lines.end(), is_router_line) ==
+                SampleCount * 2 + 5);
+    }
+
+    SECTION("Runs are removed") {
+        for (const auto& entry :
+             std::filesystem::directory_iterator{fixture.GetPath().parent_path()}) {
+            REQUIRE(entry.path().filename().string().find(".run") == std::string::npos);
+        }
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
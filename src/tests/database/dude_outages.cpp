@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "the_dude_to_human/database/dude_outages.h"
+
+namespace Database {
+namespace {
+
+Outage GetOutage(u32 service_id, u32 start_time, u32 end_time) {
+    return {.service_id = service_id, .start_time = start_time, .end_time = end_time};
+}
+
+std::vector<u32> GetServiceIds(const std::vector<Outage>& outages) {
+    std::vector<u32> ids{};
+    for (const Outage& outage : outages) {
+        ids.push_back(outage.service_id);
+    }
+    return ids;
+}
+
+TEST_CASE("Outage index bounds", "[database]") {
+    const OutageIndex index{{
+        GetOutage(1, 100, 200),
+        GetOutage(2, 150, 150),
+        GetOutage(3, 200, 300),
+    }};
+
+    SECTION("An outage ends before its end time") {
+        REQUIRE(GetServiceIds(index.FindActive(100)) == std::vector<u32>{1});
+        REQUIRE(GetServiceIds(index.FindActive(199)) == std::vector<u32>{1});
+        // The next outage starts when the first one ends, only one is in progress
+        REQUIRE(GetServiceIds(index.FindActive(200)) == std::vector<u32>{3});
+        REQUIRE(index.FindActive(300).empty());
+        REQUIRE(index.FindActive(99).empty());
+    }
+
+    SECTION("Windows include both bounds") {
+        REQUIRE(GetServiceIds(index.FindOverlapping(0, 100)) == std::vector<u32>{1});
+        REQUIRE(GetServiceIds(index.FindOverlapping(199, 199)) == std::vector<u32>{1});
+        REQUIRE(GetServiceIds(index.FindOverlapping(199, 200)) == std::vector<u32>{1, 3});
+        REQUIRE(GetServiceIds(index.FindOverlapping(299, 1000)) == std::vector<u32>{3});
+        REQUIRE(index.FindOverlapping(300, 1000).empty());
+    }
+
+    SECTION("An outage of duration zero covers its start time") {
+        REQUIRE(GetServiceIds(index.FindActive(150)) == std::vector<u32>{1, 2});
+        REQUIRE(GetServiceIds(index.FindActive(151)) == std::vector<u32>{1});
+        REQUIRE(GetServiceIds(index.FindOverlapping(120, 150)) == std::vector<u32>{1, 2});
+        REQUIRE(GetServiceIds(index.FindOverlapping(151, 160)) == std::vector<u32>{1});
+    }
+
+    SECTION("Windows ending before they start are empty") {
+        REQUIRE(index.FindOverlapping(160, 140).empty());
+        REQUIRE(index.FindOverlapping(1, 0).empty());
+    }
+
+    SECTION("Empty index") {
+        const OutageIndex empty_index{{}};
+        REQUIRE(empty_index.GetCount() == 0);
+        REQUIRE(empty_index.FindOverlapping(0, 0xffffffff).empty());
+        REQUIRE(empty_index.FindActive(0).empty());
+    }
+}
+
+TEST_CASE("Outage index matches a linear search", "[database]") {
+    std::mt19937 generator{7};
+    std::uniform_int_distribution<u32> start_distribution{0, 100000};
+    // Many short outages, some of duration zero, and a few long ones
+    std::uniform_int_distribution<u32> duration_distribution{0, 200};
+    std::vector<Outage> outages{};
+    for (u32 i = 0; i < 2000; ++i) {
+        const u32 start_time = start_distribution(generator);
+        const u32 duration = i % 100 == 0 ? 20000 : duration_distribution(generator);
+        outages.push_back(GetOutage(i, start_time, start_time + duration));
+    }
+    const OutageIndex index{outages};
+    REQUIRE(index.GetCount() == outages.size());
+
+    for (int query = 0; query < 500; ++query) {
+        const u32 start = start_distribution(generator);
+        const u32 end = query % 2 == 0 ? start : start + duration_distribution(generator);
+        INFO("Window: " << start << " to " << end);
+
+        std::vector<u32> expected{};
+        for (const Outage& outage : outages) {
+            const u32 last_time =
+                outage.end_time > outage.start_time ? outage.end_time - 1 : outage.start_time;
+            if (outage.start_time <= end && last_time >= start) {
+                expected.push_back(outage.service_id);
+            }
+        }
+
+        const std::vector<Outage> result = index.FindOverlapping(start, end);
+        REQUIRE(std::is_sorted(result.begin(), result.end(), [](const Outage& a, const Outage& b) {
+            return a.start_time < b.start_time;
+        }));
+
+        // Outages starting at the same time may come in any order
+        std::vector<u32> found = GetServiceIds(result);
+        std::sort(found.begin(), found.end());
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(found == expected);
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
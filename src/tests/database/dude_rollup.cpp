@@ -0,0 +1,192 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <random>
+#include <span>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_rollup.h"
+
+namespace Database {
+namespace {
+
+constexpr f64 Infinity = std::numeric_limits<f64>::infinity();
+
+ChartBucket ComputeNaiveBucket(u32 time, std::span<const f64> values) {
+    ChartBucket bucket{.time = time, .count = static_cast<u32>(values.size())};
+    bucket.min = *std::min_element(values.begin(), values.end());
+    bucket.max = *std::max_element(values.begin(), values.end());
+    f64 sum = 0;
+    for (const f64 value : values) {
+        sum += value;
+    }
+    bucket.avg = sum / static_cast<f64>(values.size());
+    return bucket;
+}
+
+void RequireSameBucket(const ChartBucket& bucket, const ChartBucket& expected) {
+    REQUIRE(bucket.time == expected.time);
+    REQUIRE(bucket.count == expected.count);
+    REQUIRE(bucket.min == expected.min);
+    REQUIRE(bucket.max == expected.max);
+    // Sums are added in a different order
+    REQUIRE(bucket.avg == Approx(expected.avg).epsilon(1e-12));
+}
+
+TEST_CASE("Chart buckets match a naive computation", "[database]") {
+    SECTION("Every length around the four accumulators") {
+        std::mt19937 generator{11};
+        std::uniform_real_distribution<f64> distribution{-1000, 1000};
+        for (std::size_t count = 1; count <= 21; ++count) {
+            INFO("Values: " << count);
+            std::vector<f64> values(count);
+            for (f64& value : values) {
+                value = distribution(generator);
+            }
+            RequireSameBucket(ComputeChartBucket(600, values), ComputeNaiveBucket(600, values));
+        }
+    }
+
+    SECTION("Extremes in every lane and in the tail") {
+        for (std::size_t position = 0; position < 11; ++position) {
+            INFO("Extremes at: " << position);
+            std::vector<f64> values(11, 1.0);
+            values[position] = -5;
+            values[(position + 5) % values.size()] = 9;
+            RequireSameBucket(ComputeChartBucket(0, values), ComputeNaiveBucket(0, values));
+        }
+    }
+
+    SECTION("Constant and infinite values") {
+        const std::vector<f64> constant(13, 2.5);
+        const ChartBucket bucket = ComputeChartBucket(1, constant);
+        REQUIRE(bucket.min == 2.5);
+        REQUIRE(bucket.max == 2.5);
+        REQUIRE(bucket.avg == 2.5);
+        REQUIRE(bucket.count == 13);
+
+        const std::vector<f64> infinite{1, -Infinity, 3, 4, Infinity};
+        const ChartBucket infinite_bucket = ComputeChartBucket(2, infinite);
+        REQUIRE(infinite_bucket.min == -Infinity);
+        REQUIRE(infinite_bucket.max == Infinity);
+    }
+}
+
+using Bucketed = std::map<std::pair<u32, u32>, std::vector<f64>>;
+
+// Groups the values of every source by bucket, dropping values older than the retention
+Bucketed GroupValues(std::span<const ChartValue> values, u32 bucket_width, u32 keep_time,
+                     u32 last_time) {
+    const u32 first_time = keep_time > 0 && last_time > keep_time ? last_time - keep_time : 0;
+    Bucketed buckets{};
+    for (const ChartValue& value : values) {
+        if (value.time >= first_time) {
+            buckets[{value.source_id, value.time - value.time % bucket_width}].push_back(
+                value.value);
+        }
+    }
+    return buckets;
+}
+
+// Retention of the 10min, 2hour and 1day values. Zero keeps everything
+using KeepTimes = std::array<u32, 3>;
+
+void RequireRollup(std::span<const ChartValue> values, const KeepTimes& keep_times,
+                   bool is_rowid_key) {
+    constexpr u32 Day = 24 * 60 * 60;
+    constexpr std::array<u32, 3> BucketWidths{10 * 60, 2 * 60 * 60, Day};
+    constexpr std::array<ChartResolution, 3> Resolutions{
+        ChartResolution::TenMinutes, ChartResolution::TwoHours, ChartResolution::OneDay};
+
+    Tests::FixtureDatabase fixture{};
+    fixture.AddObject(1, Tests::ObjectBuilder{DataFormat::ServerConfig}
+                             .Int(FieldId::SysId, 1)
+                             .Int(FieldId::ServerConfig_ChartValueKeepTime10min, keep_times[0])
+                             .Int(FieldId::ServerConfig_ChartValueKeepTime2hour, keep_times[1])
+                             .Int(FieldId::ServerConfig_ChartValueKeepTime1day, keep_times[2]));
+    fixture.AddChartTable(ChartResolution::Raw, is_rowid_key);
+    // Interleaved like the Dude writes them
+    std::vector<ChartValue> sorted_by_time{values.begin(), values.end()};
+    std::stable_sort(sorted_by_time.begin(), sorted_by_time.end(),
+                     [](const ChartValue& a, const ChartValue& b) { return a.time < b.time; });
+    u32 last_time = 0;
+    for (const ChartValue& value : sorted_by_time) {
+        fixture.AddChartValue(ChartResolution::Raw, value.source_id, value.time, value.value);
+        last_time = value.time;
+    }
+    fixture.Close();
+    const DudeDatabase db{fixture.GetPath().string()};
+
+    const std::filesystem::path rollup_path = fixture.GetPath().parent_path() / "rollup.db";
+    REQUIRE(RollupChartValues(&db, rollup_path.string()) == 0);
+
+    for (std::size_t i = 0; i < Resolutions.size(); ++i) {
+        INFO("Resolution: " << GetChartResolutionName(Resolutions[i]));
+        const Bucketed expected = GroupValues(values, BucketWidths[i], keep_times[i], last_time);
+        const auto rows = Tests::QueryRows(
+            rollup_path, std::string{"SELECT * FROM "} +
+                             DudeDatabase::GetChartTableName(Resolutions[i]) +
+                             " ORDER BY sourceIDandTime");
+        REQUIRE(rows.size() == expected.size());
+
+        auto expected_it = expected.begin();
+        for (const auto& row : rows) {
+            const auto& [key, bucket_values] = *expected_it++;
+            const s64 row_key = std::get<s64>(row[0]);
+            const ChartBucket bucket{
+                .time = static_cast<u32>(row_key),
+                .count = static_cast<u32>(std::get<s64>(row[4])),
+                .min = std::get<f64>(row[2]),
+                .max = std::get<f64>(row[3]),
+                .avg = std::get<f64>(row[1]),
+            };
+            REQUIRE(static_cast<u32>(row_key >> 32) == key.first);
+            RequireSameBucket(bucket, ComputeNaiveBucket(key.second, bucket_values));
+        }
+    }
+}
+
+TEST_CASE("Chart rollup matches a naive computation", "[database]") {
+    constexpr u32 Day = 24 * 60 * 60;
+    constexpr u32 StartTime = 1700000000 - 1700000000 % Day - 90;
+
+    // A regular source with values on the bucket boundaries and a sparse one
+    std::vector<ChartValue> values{};
+    std::mt19937 generator{13};
+    std::uniform_real_distribution<f64> distribution{-100, 100};
+    for (u32 time = StartTime; time < StartTime + Day * 3; time += 90) {
+        values.push_back({1, time, distribution(generator)});
+        if (time % 7 == 0) {
+            values.push_back({7, time + 13, distribution(generator)});
+        }
+    }
+
+    const bool is_rowid_key = GENERATE(false, true);
+    INFO("Rowid key: " << is_rowid_key);
+    RequireRollup(values, {Day, Day * 2, 0}, is_rowid_key);
+}
+
+TEST_CASE("Chart rollup of the last bucket before 0xffffffff", "[database]") {
+    // The last bucket of every resolution ends past the largest time
+    std::vector<ChartValue> values{};
+    for (u32 time = 0xffffffff - 3 * 60 * 60; time < 0xffffffff - 60; time += 60) {
+        values.push_back({1, time, static_cast<f64>(time % 1000)});
+    }
+    values.push_back({1, 0xffffffff, -1});
+    values.push_back({2, 0xffffffff, 2});
+    RequireRollup(values, {0, 0, 0}, false);
+}
+
+} // Anonymous namespace
+} // namespace Database
@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "the_dude_to_human/database/dude_sla.h"
+
+namespace Database {
+namespace {
+
+constexpr u32 PeriodStart = 1000;
+constexpr u32 PeriodEnd = 2000;
+
+Outage GetOutage(u32 start_time, u32 end_time, u32 service_id = 10, u32 device_id = 20,
+                 u32 map_id = 30) {
+    return {
+        .service_id = service_id,
+        .device_id = device_id,
+        .map_id = map_id,
+        .start_time = start_time,
+        .end_time = end_time,
+    };
+}
+
+// Outages must be added in start time order
+Availability GetServiceAvailability(const std::vector<Outage>& outages) {
+    SlaEngine engine{PeriodStart, PeriodEnd};
+    for (const Outage& outage : outages) {
+        engine.Add(outage);
+    }
+    const auto it = engine.GetServices().find(10);
+    return it == engine.GetServices().end() ? Availability{} : it->second;
+}
+
+TEST_CASE("SLA merges outages of the same object", "[database]") {
+    SECTION("Disjoint") {
+        const Availability availability =
+            GetServiceAvailability({GetOutage(1100, 1200), GetOutage(1300, 1350)});
+        REQUIRE(availability.downtime == 150);
+        REQUIRE(availability.outage_count == 2);
+    }
+
+    SECTION("Overlapping") {
+        const Availability availability =
+            GetServiceAvailability({GetOutage(1100, 1200), GetOutage(1150, 1250)});
+        REQUIRE(availability.downtime == 150);
+        REQUIRE(availability.outage_count == 1);
+    }
+
+    SECTION("Nested") {
+        const Availability availability = GetServiceAvailability(
+            {GetOutage(1100, 1300), GetOutage(1150, 1200), GetOutage(1200, 1300)});
+        REQUIRE(availability.downtime == 200);
+        REQUIRE(availability.outage_count == 1);
+    }
+
+    SECTION("Adjacent") {
+        const Availability availability =
+            GetServiceAvailability({GetOutage(1100, 1200), GetOutage(1200, 1250)});
+        REQUIRE(availability.downtime == 150);
+        REQUIRE(availability.outage_count == 1);
+    }
+
+    SECTION("Nested in the first and overlapping the second of two") {
+        const Availability availability = GetServiceAvailability(
+            {GetOutage(1100, 1200), GetOutage(1120, 1140), GetOutage(1300, 1400),
+             GetOutage(1390, 1500)});
+        REQUIRE(availability.downtime == 300);
+        REQUIRE(availability.outage_count == 2);
+    }
+}
+
+TEST_CASE("SLA clips outages to the period", "[database]") {
+    SECTION("Starting before the period") {
+        const Availability availability = GetServiceAvailability({GetOutage(900, 1100)});
+        REQUIRE(availability.downtime == 100);
+        REQUIRE(availability.outage_count == 1);
+    }
+
+    SECTION("Ending after the period") {
+        const Availability availability = GetServiceAvailability({GetOutage(1900, 2100)});
+        REQUIRE(availability.downtime == 100);
+        REQUIRE(availability.outage_count == 1);
+    }
+
+    SECTION("Outside of the period") {
+        const Availability availability = GetServiceAvailability(
+            {GetOutage(500, 1000), GetOutage(1500, 1500), GetOutage(2000, 2100)});
+        REQUIRE(availability.downtime == 0);
+        REQUIRE(availability.outage_count == 0);
+    }
+
+    SECTION("Covering the period") {
+        SlaEngine engine{PeriodStart, PeriodEnd};
+        engine.Add(GetOutage(0, 3000));
+        const Availability& availability = engine.GetServices().at(10);
+        REQUIRE(availability.downtime == PeriodEnd - PeriodStart);
+        REQUIRE(availability.outage_count == 1);
+        REQUIRE(engine.GetAvailability(availability) == 0.0);
+    }
+
+    SECTION("Starting at zero") {
+        SlaEngine engine{0, PeriodEnd};
+        engine.Add(GetOutage(0, 100));
+        engine.Add(GetOutage(50, 150));
+        const Availability& availability = engine.GetServices().at(10);
+        REQUIRE(availability.downtime == 150);
+        REQUIRE(availability.outage_count == 1);
+    }
+}
+
+TEST_CASE("SLA rolls services up to their device and map", "[database]") {
+    SlaEngine engine{PeriodStart, PeriodEnd};
+    // Two services of device 20 overlap, device 21 is down later on the same map
+    engine.Add(GetOutage(1100, 1200, 10, 20, 30));
+    engine.Add(GetOutage(1150, 1300, 11, 20, 30));
+    engine.Add(GetOutage(1250, 1400, 12, 21, 30));
+    engine.Add(GetOutage(1500, 1600, 13, 22, 31));
+
+    REQUIRE(engine.GetServices().size() == 4);
+    REQUIRE(engine.GetServices().at(10).downtime == 100);
+    REQUIRE(engine.GetServices().at(11).downtime == 150);
+    REQUIRE(engine.GetServices().at(12).downtime == 150);
+
+    const Availability& device = engine.GetDevices().at(20);
+    REQUIRE(device.downtime == 200);
+    REQUIRE(device.outage_count == 1);
+    REQUIRE(engine.GetAvailability(device) == Approx(0.8));
+
+    const Availability& map = engine.GetMaps().at(30);
+    REQUIRE(map.downtime == 300);
+    REQUIRE(map.outage_count == 1);
+    REQUIRE(engine.GetMaps().at(31).downtime == 100);
+    REQUIRE(engine.GetMaps().at(31).outage_count == 1);
+}
+
+} // Anonymous namespace
+} // namespace Database
@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+using Rows = std::vector<std::vector<Sqlite::SqlValue>>;
+
+TEST_CASE("Sqlite export stores every field type", "[database]") {
+    Tests::FixtureDatabase fixture{};
+    fixture.AddSampleObjects();
+    fixture.Close();
+    DudeDatabase db{fixture.GetPath().string()};
+
+    const bool has_credentials = GENERATE(false, true);
+    const std::filesystem::path sqlite_path = fixture.GetPath().parent_path() / "export.db";
+    REQUIRE(db.SaveDatabase(sqlite_path.string(), has_credentials,
+                            {.format = ExportFormat::Sqlite}) == 0);
+    const auto query = [&sqlite_path](const std::string& sql) {
+        return Tests::QueryRows(sqlite_path, sql);
+    };
+
+    SECTION("Long long values as big endian blobs") {
+        // 2001:db8::1 in network order, the same bytes as the other binary exports
+        const std::vector<u8> address{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+        REQUIRE(query("SELECT mailServer6 FROM notification") == Rows{{address}});
+    }
+
+    SECTION("Scalar columns") {
+        REQUIRE(query("SELECT objectId, timeAdded, name FROM notes") ==
+                Rows{{s64{1}, s64{1700000000}, std::string{"Rack \"B\", row 3\r\nsecond line"}}});
+        REQUIRE(query("SELECT objectId, routerOs, agentId FROM device") ==
+                Rows{{s64{2}, s64{1}, s64{-5}}});
+        REQUIRE(query("SELECT speed FROM link") == Rows{{s64{10000000000}}});
+        REQUIRE(query("SELECT length(name) FROM map") == Rows{{s64{300}}});
+    }
+
+    SECTION("Array fields in join tables") {
+        REQUIRE(query("SELECT * FROM device_parentIds ORDER BY position") ==
+                Rows{{s64{2}, s64{0}, s64{1}}, {s64{2}, s64{1}, s64{0xfffffffe}}});
+        REQUIRE(query("SELECT * FROM device_notifyIds").empty());
+        REQUIRE(query("SELECT value FROM device_ip ORDER BY position") ==
+                Rows{{std::string{"192.168.1.1"}}, {std::string{"10.0.0.1"}}});
+        REQUIRE(query("SELECT value FROM device_mac ORDER BY position") ==
+                Rows{{std::string{"00:0c:42:01:02:03"}}, {std::string{"e4:8d:8c:aa:bb:cc"}}});
+        REQUIRE(query("SELECT value FROM device_dnsNames ORDER BY position") ==
+                Rows{{std::string{"router.lan"}}, {std::string{"router;backup.lan"}}});
+    }
+
+    SECTION("Credentials are hidden unless requested") {
+        const std::string password = has_credentials ? "secret" : "*****";
+        REQUIRE(query("SELECT password FROM device") == Rows{{password}});
+        const std::string mail_password = has_credentials ? "mail secret" : "*****";
+        REQUIRE(query("SELECT mailPassword FROM notification") == Rows{{mail_password}});
+    }
+}
+
+} // Anonymous namespace
+} // namespace Database
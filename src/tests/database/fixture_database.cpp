@@ -0,0 +1,276 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Tests {
+namespace {
+
+// Magic of the objects of a real database, the parser doesn't check it
+constexpr u16 ObjectMagic = 0x4d32;
+
+std::filesystem::path CreateDirectory() {
+    static std::atomic<u32> next_id{};
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        ("fixture_database_" + std::to_string(getpid()) + "_" + std::to_string(next_id++));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+} // Anonymous namespace
+
+ObjectBuilder::ObjectBuilder(Database::DataFormat format) {
+    WriteData(&ObjectMagic, sizeof(ObjectMagic));
+    const std::array<u32, 1> formats{static_cast<u32>(format)};
+    IntArray(Database::FieldId::DataFormat, formats);
+}
+
+ObjectBuilder& ObjectBuilder::Bool(Database::FieldId id, bool value) {
+    WriteInfo(id, value ? Database::FieldType::BoolTrue : Database::FieldType::BoolFalse);
+    return *this;
+}
+
+ObjectBuilder& ObjectBuilder::Byte(Database::FieldId id, u8 value) {
+    WriteInfo(id, Database::FieldType::Byte);
+    WriteData(&value, sizeof(value));
+    return *this;
+}
+
+ObjectBuilder& ObjectBuilder::Int(Database::FieldId id, u32 value) {
+    WriteInfo(id, Database::FieldType::Int);
+    WriteData(&value, sizeof(value));
+    return *this;
+}
+
+ObjectBuilder& ObjectBuilder::Long(Database::FieldId id, u64 value) {
+    WriteInfo(id, Database::FieldType::Long);
+    WriteData(&value, sizeof(value));
+    return *this;
+}
+
+ObjectBuilder& ObjectBuilder::LongLong(Database::FieldId id, u128 value) {
+    WriteInfo(id, Database::FieldType::LongLong);
+    WriteData(value.data(), sizeof(value));
+    return *this;
+}
+
+ObjectBuilder& ObjectBuilder::Text(Database::FieldId id, std::string_view text) {
+    if (text.size() <= std::numeric_limits<u8>::max()) {
+        const u8 size = static_cast<u8>(text.size());
+        WriteInfo(id, Database::FieldType::ShortString);
+        WriteData(&size, sizeof(size));
+    } else {
+        const u16 size = static_cast<u16>(text.size());
+        WriteInfo(id, Database::FieldType::LongString);
+        WriteData(&size, sizeof(size));
+    }
+    WriteData(text.data(), text.size());
+    return *this;
+}
+
+ObjectBuilder& ObjectBuilder::IntArray(Database::FieldId id, std::span<const u32> values) {
+    const u16 entries = static_cast<u16>(values.size());
+    WriteInfo(id, Database::FieldType::IntArray);
+    WriteData(&entries, sizeof(entries));
+    WriteData(values.data(), values.size_bytes());
+    return *this;
+}
+
+ObjectBuilder& ObjectBuilder::LongArray(Database::FieldId id, std::span<const u8> values) {
+    const u8 size = static_cast<u8>(values.size());
+    WriteInfo(id, Database::FieldType::LongArray);
+    WriteData(&size, sizeof(size));
+    WriteData(values.data(), values.size());
+    return *this;
+}
+
+ObjectBuilder& ObjectBuilder::StringArray(Database::FieldId id,
+                                          std::span<const std::string> entries) {
+    const u16 entry_count = static_cast<u16>(entries.size());
+    WriteInfo(id, Database::FieldType::StringArray);
+    WriteData(&entry_count, sizeof(entry_count));
+    for (const std::string& entry : entries) {
+        const u16 size = static_cast<u16>(entry.size());
+        WriteData(&size, sizeof(size));
+        WriteData(entry.data(), entry.size());
+    }
+    return *this;
+}
+
+const std::vector<u8>& ObjectBuilder::GetData() const {
+    return data;
+}
+
+void ObjectBuilder::WriteInfo(Database::FieldId id, Database::FieldType type) {
+    const u32 info = static_cast<u32>(id) | static_cast<u32>(type) << 24;
+    WriteData(&info, sizeof(info));
+}
+
+void ObjectBuilder::WriteData(const void* value, std::size_t size) {
+    const u8* bytes = static_cast<const u8*>(value);
+    data.insert(data.end(), bytes, bytes + size);
+}
+
+FixtureDatabase::FixtureDatabase()
+    : directory{CreateDirectory()}, path{directory / "dude.db"}, writer{path.string()} {
+    const std::array<Sqlite::SqlColumn, 2> objs_columns{{
+        {"id", Sqlite::SqlType::Integer, true},
+        {"obj", Sqlite::SqlType::Blob},
+    }};
+    Check(writer.OpenDatabase());
+    Check(writer.SetBulkLoad(true));
+    Check(writer.CreateTable("objs", objs_columns));
+    Check(writer.BeginTransaction());
+}
+
+FixtureDatabase::~FixtureDatabase() {
+    writer.CloseDatabase();
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+}
+
+const std::filesystem::path& FixtureDatabase::GetPath() const {
+    return path;
+}
+
+void FixtureDatabase::AddObject(u32 id, const ObjectBuilder& object) {
+    const std::array<Sqlite::SqlValue, 2> values{s64{id}, object.GetData()};
+    Check(writer.InsertRow("objs", values));
+}
+
+void FixtureDatabase::AddSampleObjects() {
+    using Database::DataFormat;
+    using Database::FieldId;
+
+    AddObject(1, ObjectBuilder{DataFormat::Notes}
+                     .Int(FieldId::SysId, 1)
+                     .Int(FieldId::Note_ObjID, 2)
+                     .Int(FieldId::Note_TimeAdded, 1700000000)
+                     .Text(FieldId::SysName, "Rack \"B\", row 3\r\nsecond line"));
+
+    const std::array<u32, 2> parent_ids{1, 0xfffffffe};
+    const std::array<std::string, 2> dns_names{"router.lan", "router;backup.lan"};
+    // 192.168.1.1 and 10.0.0.1 as they are stored
+    const std::array<u32, 2> ips{0x0101a8c0, 0x0100000a};
+    const std::array<u8, 12> macs{0x00, 0x0c, 0x42, 0x01, 0x02, 0x03,
+                                  0xe4, 0x8d, 0x8c, 0xaa, 0xbb, 0xcc};
+    AddObject(2, ObjectBuilder{DataFormat::Device}
+                     .IntArray(FieldId::Device_ParentIds, parent_ids)
+                     .IntArray(FieldId::Device_NotifyIds, {})
+                     .StringArray(FieldId::Device_DnsNames, dns_names)
+                     .IntArray(FieldId::Device_IpAddress, ips)
+                     .Bool(FieldId::Device_RouterOs, true)
+                     .Int(FieldId::Device_AgentId, static_cast<u32>(-5))
+                     .Int(FieldId::SysId, 2)
+                     .Text(FieldId::Device_Password, "secret")
+                     .Text(FieldId::Device_Username, "admin")
+                     .LongArray(FieldId::Device_MacAddress, macs)
+                     .Text(FieldId::SysName, std::string(40, 'd')));
+
+    AddObject(3, ObjectBuilder{DataFormat::Notification}
+                     .Int(FieldId::SysId, 3)
+                     .Text(FieldId::Notification_MailPassword, "mail secret")
+                     .LongLong(FieldId::Notification_MailServer6,
+                               {0x20010db800000000, 0x0000000000000001})
+                     .Text(FieldId::SysName, "Mail"));
+
+    AddObject(4, ObjectBuilder{DataFormat::Link}
+                     .Int(FieldId::SysId, 4)
+                     .Long(FieldId::Link_Speed, 10000000000)
+                     .Text(FieldId::SysName, "Uplink"));
+
+    AddObject(5, ObjectBuilder{DataFormat::Map}
+                     .Int(FieldId::SysId, 5)
+                     .Text(FieldId::SysName, std::string(300, 'm')));
+}
+
+void FixtureDatabase::AddChartTable(Database::ChartResolution resolution, bool is_rowid_key) {
+    const std::array<Sqlite::SqlColumn, 2> chart_columns{{
+        {"id", Sqlite::SqlType::Integer, is_rowid_key},
+        {"value", Sqlite::SqlType::Real},
+    }};
+    Check(writer.CreateTable(Database::DudeDatabase::GetChartTableName(resolution), chart_columns));
+}
+
+void FixtureDatabase::AddChartValue(Database::ChartResolution resolution, u32 source_id, u32 time,
+                                    f64 value) {
+    const s64 key = static_cast<s64>(static_cast<u64>(source_id) << 32 | time);
+    const std::array<Sqlite::SqlValue, 2> values{key, value};
+    Check(writer.InsertRow(Database::DudeDatabase::GetChartTableName(resolution), values));
+}
+
+void FixtureDatabase::Close() {
+    Check(writer.CommitTransaction());
+    writer.CloseDatabase();
+}
+
+void FixtureDatabase::Check(int rc) const {
+    if (rc != SQLITE_OK) {
+        throw std::runtime_error("Unable to write " + path.string() + ": " + writer.GetError());
+    }
+}
+
+std::vector<std::vector<Sqlite::SqlValue>> QueryRows(const std::filesystem::path& path,
+                                                     const std::string& sql) {
+    sqlite3* db{nullptr};
+    sqlite3_stmt* statement{nullptr};
+    int rc = sqlite3_open_v2(path.string().c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, nullptr);
+    }
+
+    std::vector<std::vector<Sqlite::SqlValue>> rows{};
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_step(statement);
+    }
+    for (; rc == SQLITE_ROW; rc = sqlite3_step(statement)) {
+        std::vector<Sqlite::SqlValue>& row = rows.emplace_back();
+        for (int column = 0; column < sqlite3_column_count(statement); ++column) {
+            switch (sqlite3_column_type(statement, column)) {
+            case SQLITE_INTEGER:
+                row.emplace_back(static_cast<s64>(sqlite3_column_int64(statement, column)));
+                break;
+            case SQLITE_FLOAT:
+                row.emplace_back(sqlite3_column_double(statement, column));
+                break;
+            case SQLITE_TEXT: {
+                const auto* text =
+                    reinterpret_cast<const char*>(sqlite3_column_text(statement, column));
+                row.emplace_back(std::string(
+                    text, static_cast<std::size_t>(sqlite3_column_bytes(statement, column))));
+                break;
+            }
+            case SQLITE_BLOB: {
+                const auto* blob = static_cast<const u8*>(sqlite3_column_blob(statement, column));
+                row.emplace_back(std::vector<u8>(
+                    blob, blob + sqlite3_column_bytes(statement, column)));
+                break;
+            }
+            default:
+                row.emplace_back(std::monostate{});
+                break;
+            }
+        }
+    }
+
+    const std::string error = db == nullptr ? "out of memory" : sqlite3_errmsg(db);
+    sqlite3_finalize(statement);
+    sqlite3_close(db);
+    if (rc != SQLITE_DONE) {
+        throw std::runtime_error("Unable to query " + path.string() + ": " + error);
+    }
+    return rows;
+}
+
+} // namespace Tests
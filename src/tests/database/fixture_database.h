@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/common_types.h"
+#include "the_dude_to_human/database/dude_field_id.h"
+#include "the_dude_to_human/database/dude_types.h"
+#include "the_dude_to_human/sqlite/sqlite_writer.h"
+
+namespace Tests {
+
+// Raw objs row in the layout DudeFieldParser reads. Fields must be added in the order the table
+// reader expects them, missing fields keep their default value
+class ObjectBuilder {
+public:
+    explicit ObjectBuilder(Database::DataFormat format);
+
+    ObjectBuilder& Bool(Database::FieldId id, bool value);
+    ObjectBuilder& Byte(Database::FieldId id, u8 value);
+    ObjectBuilder& Int(Database::FieldId id, u32 value);
+    ObjectBuilder& Long(Database::FieldId id, u64 value);
+    ObjectBuilder& LongLong(Database::FieldId id, u128 value);
+    ObjectBuilder& Text(Database::FieldId id, std::string_view text);
+    ObjectBuilder& IntArray(Database::FieldId id, std::span<const u32> values);
+    ObjectBuilder& LongArray(Database::FieldId id, std::span<const u8> data);
+    ObjectBuilder& StringArray(Database::FieldId id, std::span<const std::string> entries);
+
+    const std::vector<u8>& GetData() const;
+
+private:
+    void WriteInfo(Database::FieldId id, Database::FieldType type);
+    void WriteData(const void* data, std::size_t size);
+
+    std::vector<u8> data{};
+};
+
+// Dude database file in a new temporary directory, removed together with the object. Rows are
+// written until Close, the file can be opened once it's closed
+class FixtureDatabase {
+public:
+    FixtureDatabase();
+    ~FixtureDatabase();
+
+    FixtureDatabase(const FixtureDatabase&) = delete;
+    FixtureDatabase& operator=(const FixtureDatabase&) = delete;
+
+    const std::filesystem::path& GetPath() const;
+
+    // Id must match the SysId field of the object or the row is dropped as corrupted
+    void AddObject(u32 id, const ObjectBuilder& object);
+
+    // Adds a few objects holding every field type, credentials, negative values and values that
+    // need the wider encodings of the exporters
+    void AddSampleObjects();
+
+    // Creates the chart values table of resolution. Tables without a rowid key are read through
+    // the chart block index, their rowids follow the insertion order
+    void AddChartTable(Database::ChartResolution resolution, bool is_rowid_key);
+    void AddChartValue(Database::ChartResolution resolution, u32 source_id, u32 time, f64 value);
+
+    void Close();
+
+private:
+    void Check(int rc) const;
+
+    std::filesystem::path directory{};
+    std::filesystem::path path{};
+    Sqlite::SqliteWriter writer;
+};
+
+// Runs a query on a sqlite file and returns every row, throws if the query fails
+std::vector<std::vector<Sqlite::SqlValue>> QueryRows(const std::filesystem::path& path,
+                                                     const std::string& sql);
+
+} // namespace Tests
@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+
+#include "tests/mikrotik/fake_routeros.h"
+#include "the_dude_to_human/gzip/gzip.h"
+
+extern char** environ;
+
+namespace Tests {
+namespace {
+
+std::filesystem::path CreateDirectory() {
+    static std::atomic<u32> next_id{};
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        ("fake_routeros_" + std::to_string(getpid()) + "_" + std::to_string(next_id++));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "root");
+    return directory;
+}
+
+void WriteFile(const std::filesystem::path& path, std::span<const u8> data) {
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        throw std::runtime_error("Unable to write " + path.string());
+    }
+}
+
+// Reads the "listening <port>" line the server prints once it accepts connections
+u16 ReadPort(int fd) {
+    std::string line{};
+    char c{};
+    while (read(fd, &c, 1) == 1 && c != '\n') {
+        line += c;
+    }
+    const std::string prefix = "listening ";
+    if (!line.starts_with(prefix)) {
+        return 0;
+    }
+    return static_cast<u16>(std::strtoul(line.c_str() + prefix.size(), nullptr, 10));
+}
+
+} // Anonymous namespace
+
+std::vector<u8> CompressBackup(std::span<const u8> header, std::span<const u8> database) {
+    std::vector<u8> backup{};
+    Gzip::Compressor compressor{};
+    if (!compressor.Write(header, backup) || !compressor.Write(database, backup) ||
+        !compressor.Finish(backup)) {
+        throw std::runtime_error("Unable to compress the backup");
+    }
+    return backup;
+}
+
+u16 GetClosedPort() {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    // The port stays free once the socket is closed without listening
+    const bool is_bound =
+        bind(fd, reinterpret_cast<sockaddr*>(&address), length) == 0 &&
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) == 0;
+    close(fd);
+    if (!is_bound) {
+        throw std::runtime_error("Unable to find a closed port");
+    }
+    return ntohs(address.sin_port);
+}
+
+FakeRouterOs::FakeRouterOs(const std::vector<std::string>& arguments)
+    : directory{CreateDirectory()}, root{directory / "root"} {
+    std::vector<std::string> command{PYTHON_EXECUTABLE,
+                                     FAKE_ROUTEROS_SCRIPT,
+                                     "--root",
+                                     root.string(),
+                                     "--backup",
+                                     (directory / "backup.db").string(),
+                                     "--password",
+                                     Password};
+    command.insert(command.end(), arguments.begin(), arguments.end());
+    std::vector<char*> argv{};
+    for (std::string& argument : command) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    // Servers started later must not inherit the pipes, they would keep this one running
+    int stdin_pipe[2]{};
+    int stdout_pipe[2]{};
+    if (pipe(stdin_pipe) != 0 || pipe(stdout_pipe) != 0) {
+        throw std::runtime_error("Unable to create the pipes of the fake RouterOS server");
+    }
+    for (const int fd : {stdin_pipe[0], stdin_pipe[1], stdout_pipe[0], stdout_pipe[1]}) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    posix_spawn_file_actions_t actions{};
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, stdin_pipe[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, stdout_pipe[1], STDOUT_FILENO);
+    const int result = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(stdin_pipe[0]);
+    close(stdout_pipe[1]);
+    stdin_fd = stdin_pipe[1];
+
+    if (result == 0) {
+        port = ReadPort(stdout_pipe[0]);
+    }
+    close(stdout_pipe[0]);
+    if (port == 0) {
+        Stop();
+        throw std::runtime_error("Fake RouterOS server didn't start");
+    }
+}
+
+FakeRouterOs::~FakeRouterOs() {
+    Stop();
+}
+
+u16 FakeRouterOs::GetPort() const {
+    return port;
+}
+
+const std::filesystem::path& FakeRouterOs::GetRoot() const {
+    return root;
+}
+
+std::vector<u8> FakeRouterOs::ReadFile(const std::string& name) const {
+    std::ifstream file{root / name, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+void FakeRouterOs::SetBackup(std::span<const u8> backup) const {
+    WriteFile(directory / "backup.db", backup);
+}
+
+void FakeRouterOs::Stop() {
+    if (stdin_fd != -1) {
+        close(stdin_fd);
+        stdin_fd = -1;
+    }
+    if (pid > 0) {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        pid = -1;
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+}
+
+} // namespace Tests
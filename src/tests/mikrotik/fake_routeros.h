@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Tests {
+
+// Dude backup as the device exports it, the gzip of header followed by database
+std::vector<u8> CompressBackup(std::span<const u8> header, std::span<const u8> database);
+
+// Local port nobody listens on, connecting to it is refused
+u16 GetClosedPort();
+
+// Runs fake_routeros.py on a free local port for the lifetime of the object. The sftp root is in
+// a new temporary directory, removed together with the server
+class FakeRouterOs {
+public:
+    static constexpr char User[] = "admin";
+    static constexpr char Password[] = "secret";
+
+    // Extra arguments are passed to the script, see its --help
+    explicit FakeRouterOs(const std::vector<std::string>& arguments = {});
+    ~FakeRouterOs();
+
+    FakeRouterOs(const FakeRouterOs&) = delete;
+    FakeRouterOs& operator=(const FakeRouterOs&) = delete;
+
+    u16 GetPort() const;
+    const std::filesystem::path& GetRoot() const;
+
+    // Reads a file of the sftp root, empty if it doesn't exist
+    std::vector<u8> ReadFile(const std::string& name) const;
+
+    // Replaces the file /dude export-db copies, exports fail until it's set
+    void SetBackup(std::span<const u8> backup) const;
+
+private:
+    void Stop();
+
+    // Holds the sftp root and the backup
+    std::filesystem::path directory{};
+    std::filesystem::path root{};
+    pid_t pid{-1};
+    // The server exits once this pipe is closed
+    int stdin_fd{-1};
+    u16 port{};
+};
+
+} // namespace Tests
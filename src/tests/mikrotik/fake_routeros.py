@@ -0,0 +1,208 @@
+# SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+"""Fake RouterOS ssh server for the mikrotik tests.
+
+Accepts password logins, runs the few commands the tool sends and serves a directory over sftp
+the way RouterOS does. Prints "listening <port>" once it accepts connections and exits when its
+standard input is closed, so it never outlives the test that started it.
+"""
+
+import argparse
+import os
+import shutil
+import socket
+import sys
+import threading
+import time
+
+import paramiko
+from paramiko import SFTPAttributes, SFTPHandle, SFTPServer, SFTPServerInterface
+
+
+class ThrottledSocket:
+    """Reads at most rate bytes per second, which keeps uploads in flight for a while."""
+
+    def __init__(self, sock, rate):
+        self.sock = sock
+        self.rate = rate
+
+    def recv(self, size):
+        data = self.sock.recv(min(size, 4096))
+        time.sleep(len(data) / self.rate)
+        return data
+
+    def __getattr__(self, name):
+        return getattr(self.sock, name)
+
+
+class FileHandle(SFTPHandle):
+    def __init__(self, flags, options):
+        super().__init__(flags)
+        self.write_delay = options.write_delay
+        self.fail_reads_from = options.fail_reads_from
+
+    def stat(self):
+        return SFTPAttributes.from_stat(os.fstat(self.readfile.fileno()))
+
+    def read(self, offset, length):
+        # Leaves downloads interrupted after the first bytes
+        if self.fail_reads_from is not None and offset + length > self.fail_reads_from:
+            return paramiko.SFTP_FAILURE
+        return super().read(offset, length)
+
+    def write(self, offset, data):
+        # Late acknowledgements leave the writes of the client partially sent
+        time.sleep(self.write_delay)
+        return super().write(offset, data)
+
+
+class Sftp(SFTPServerInterface):
+    def __init__(self, server, *args, **kwargs):
+        super().__init__(server, *args, **kwargs)
+        self.options = server.options
+
+    def path(self, name):
+        return os.path.join(self.options.root, name.lstrip('/'))
+
+    def open(self, name, flags, attributes):
+        is_write = (flags & (os.O_WRONLY | os.O_RDWR)) != 0
+        try:
+            fd = os.open(self.path(name), flags, 0o644)
+        except OSError as error:
+            return SFTPServer.convert_errno(error.errno)
+        handle = FileHandle(flags, self.options)
+        handle.readfile = os.fdopen(fd, 'r+b' if is_write else 'rb')
+        if is_write:
+            handle.writefile = handle.readfile
+        return handle
+
+    def stat(self, name):
+        try:
+            return SFTPAttributes.from_stat(os.stat(self.path(name)))
+        except OSError as error:
+            return SFTPServer.convert_errno(error.errno)
+
+    lstat = stat
+
+    def remove(self, name):
+        try:
+            os.remove(self.path(name))
+        except OSError as error:
+            return SFTPServer.convert_errno(error.errno)
+        return paramiko.SFTP_OK
+
+    def rename(self, old_name, new_name):
+        # Version 3 of the protocol never replaces the target
+        if os.path.exists(self.path(new_name)):
+            return paramiko.SFTP_FAILURE
+        try:
+            os.rename(self.path(old_name), self.path(new_name))
+        except OSError as error:
+            return SFTPServer.convert_errno(error.errno)
+        return paramiko.SFTP_OK
+
+
+class Server(paramiko.ServerInterface):
+    def __init__(self, options):
+        self.options = options
+
+    def get_allowed_auths(self, username):
+        return 'password'
+
+    def check_auth_password(self, username, password):
+        if password == self.options.password:
+            return paramiko.AUTH_SUCCESSFUL
+        return paramiko.AUTH_FAILED
+
+    def check_channel_request(self, kind, channel_id):
+        return paramiko.OPEN_SUCCEEDED
+
+    def check_channel_exec_request(self, channel, command):
+        threading.Thread(target=self.run, args=(channel, command.decode()), daemon=True).start()
+        return True
+
+    def run(self, channel, command):
+        root = self.options.root
+        status = 0
+        name, _, argument = command.partition(' ')
+        if command.startswith('/dude export-db backup-file='):
+            try:
+                shutil.copy(self.options.backup, os.path.join(root, command.split('=', 1)[1]))
+            except (OSError, TypeError):
+                channel.sendall_stderr(b'failure: no database\r\n')
+                status = 1
+        elif command.startswith('/dude import-db backup-file='):
+            # Keeps what the import saw, the tool removes the uploaded file afterwards
+            shutil.copy(os.path.join(root, command.split('=', 1)[1]),
+                        os.path.join(root, 'imported.db'))
+        elif command.startswith('/file remove '):
+            try:
+                os.remove(os.path.join(root, command.split(' ', 2)[2]))
+            except OSError:
+                pass
+        elif command.startswith('/file print terse'):
+            # The database of the device changes together with the backup
+            if self.options.backup and os.path.exists(self.options.backup):
+                info = os.stat(self.options.backup)
+                modified = time.strftime('%Y-%m-%d %H:%M:%S', time.localtime(info.st_mtime))
+                channel.sendall(b' 0 name=dude/dude.db type=.db file size=%d last-modified=%s\r\n'
+                                % (info.st_size, modified.encode()))
+        elif name == '/sleep':
+            time.sleep(float(argument))
+            channel.sendall(b'slept %s\r\n' % argument.encode())
+        elif name == '/print':
+            # Numbered lines, enough of them fill the channel window
+            for line in range(int(argument)):
+                channel.sendall(b'line %d\r\n' % line)
+            channel.sendall_stderr(b'printed %d lines\r\n' % int(argument))
+        else:
+            channel.sendall_stderr(b'bad command name %s\r\n' % name.encode())
+            status = 1
+        channel.send_exit_status(status)
+        channel.close()
+
+
+def serve(connection, key, options):
+    if options.throttle != 0:
+        connection = ThrottledSocket(connection, options.throttle)
+    transport = paramiko.Transport(connection)
+    transport.add_server_key(key)
+    transport.set_subsystem_handler('sftp', SFTPServer, Sftp)
+    server = Server(options)
+    transport.start_server(server=server)
+    transport.join()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--root', required=True, help='directory served over sftp')
+    parser.add_argument('--backup', help='file copied by /dude export-db')
+    parser.add_argument('--password', default='secret')
+    parser.add_argument('--write-delay', type=float, default=0,
+                        help='seconds before each sftp write is acknowledged')
+    parser.add_argument('--fail-reads-from', type=int,
+                        help='sftp reads past this offset fail')
+    parser.add_argument('--throttle', type=int, default=0,
+                        help='bytes per second read from each connection, zero for no limit')
+    options = parser.parse_args()
+
+    # Key exchange doesn't depend on the key type, ecdsa keys are the fastest to generate
+    key = paramiko.ECDSAKey.generate()
+    listener = socket.socket()
+    listener.bind(('127.0.0.1', 0))
+    listener.listen(64)
+    print('listening', listener.getsockname()[1], flush=True)
+
+    def wait_for_parent():
+        sys.stdin.read()
+        os._exit(0)
+
+    threading.Thread(target=wait_for_parent, daemon=True).start()
+    while True:
+        connection, _ = listener.accept()
+        threading.Thread(target=serve, args=(connection, key, options), daemon=True).start()
+
+
+if __name__ == '__main__':
+    main()
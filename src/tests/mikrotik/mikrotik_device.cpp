@@ -0,0 +1,178 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/mikrotik/fake_routeros.h"
+#include "the_dude_to_human/gzip/gzip.h"
+#include "the_dude_to_human/mikrotik/database_cache.h"
+#include "the_dude_to_human/mikrotik/mikrotik_device.h"
+#include "the_dude_to_human/mikrotik/range_download.h"
+
+namespace Mikrotik {
+namespace {
+
+std::unique_ptr<MikrotikDevice> ConnectDevice(const Tests::FakeRouterOs& server) {
+    auto device = std::make_unique<MikrotikDevice>("127.0.0.1", server.GetPort());
+    device->SetTimeout(10000);
+    REQUIRE(device->Connect(Tests::FakeRouterOs::User, Tests::FakeRouterOs::Password));
+    return device;
+}
+
+// Doesn't compress, so the backup spans as many ranges as the database
+std::vector<u8> GetRandomData(std::size_t size) {
+    std::vector<u8> data(size);
+    u32 state = 1;
+    for (u8& byte : data) {
+        state = state * 1664525 + 1013904223;
+        byte = static_cast<u8>(state >> 24);
+    }
+    return data;
+}
+
+TEST_CASE("Downloads inflate the ranges of the backup", "[mikrotik][ssh]") {
+    const Tests::FakeRouterOs server{};
+    const auto device = ConnectDevice(server);
+    const std::vector<u8> header(Gzip::DudeHeaderSize, 0x5A);
+    const std::vector<u8> expected = GetRandomData(2 * RangeDownload::RangeSize + 0x12345);
+    std::vector<u8> backup = Tests::CompressBackup(header, expected);
+    const std::filesystem::path partial_path = server.GetRoot().parent_path() / "dude.part";
+    std::vector<u8> database{};
+
+    SECTION("In memory") {
+        server.SetBackup(backup);
+        REQUIRE(device->DownloadDatabase(database));
+        REQUIRE(database == expected);
+    }
+
+    SECTION("Saved to a partial file") {
+        server.SetBackup(backup);
+        REQUIRE(device->DownloadDatabase(database, partial_path));
+        REQUIRE(database == expected);
+        REQUIRE_FALSE(std::filesystem::exists(partial_path));
+    }
+
+    SECTION("Plain database") {
+        server.SetBackup(expected);
+        REQUIRE(device->DownloadDatabase(database, partial_path));
+        REQUIRE(database == expected);
+    }
+
+    SECTION("Corrupted backup") {
+        // The crc32 in the trailer no longer matches
+        backup[backup.size() - 8] ^= 0xFF;
+        server.SetBackup(backup);
+        REQUIRE_FALSE(device->DownloadDatabase(database, partial_path));
+        REQUIRE(database.empty());
+        REQUIRE_FALSE(std::filesystem::exists(partial_path));
+    }
+
+    // The export is removed from the device either way
+    REQUIRE(server.ReadFile("the_dude_to_human.db").empty());
+    REQUIRE(device->Disconnect());
+}
+
+TEST_CASE("Downloads only resume the export of the live database", "[mikrotik][ssh]") {
+    const std::vector<u8> header(Gzip::DudeHeaderSize, 0x5A);
+    const std::vector<u8> old_database = GetRandomData(2 * RangeDownload::RangeSize + 0x12345);
+    const std::vector<u8> old_backup = Tests::CompressBackup(header, old_database);
+
+    // The first run is interrupted once the device stops serving the export
+    const Tests::FakeRouterOs interrupted_server{
+        {"--fail-reads-from", std::to_string(2 * RangeDownload::RangeSize)}};
+    interrupted_server.SetBackup(old_backup);
+    const std::filesystem::path directory = interrupted_server.GetRoot().parent_path();
+    const DatabaseCache cache{directory / "cache" / "device.db"};
+    std::vector<u8> database{};
+    {
+        const auto device = ConnectDevice(interrupted_server);
+        REQUIRE(SyncDatabase(*device, cache, database, false) == SyncResult::Failed);
+        REQUIRE(device->Disconnect());
+    }
+    REQUIRE(std::filesystem::exists(cache.GetPartialPath()));
+
+    // The next run finds the export the interrupted one left on the device
+    const Tests::FakeRouterOs server{};
+    const std::filesystem::path export_path = server.GetRoot() / "the_dude_to_human.db";
+    std::filesystem::copy_file(interrupted_server.GetRoot() / "the_dude_to_human.db",
+                               export_path);
+    std::filesystem::last_write_time(
+        export_path,
+        std::filesystem::last_write_time(interrupted_server.GetRoot() / "the_dude_to_human.db"));
+    const std::filesystem::path backup_path = server.GetRoot().parent_path() / "backup.db";
+    std::vector<u8> expected{};
+
+    SECTION("Live database unchanged") {
+        // Same size and modification time, an export would be all zeros
+        server.SetBackup(std::vector<u8>(old_backup.size()));
+        std::filesystem::last_write_time(backup_path,
+                                         std::filesystem::last_write_time(directory / "backup.db"));
+        expected = old_database;
+    }
+
+    SECTION("Live database changed") {
+        expected = GetRandomData(RangeDownload::RangeSize + 0x1000);
+        server.SetBackup(Tests::CompressBackup(header, expected));
+    }
+
+    const auto device = ConnectDevice(server);
+    REQUIRE(SyncDatabase(*device, cache, database, false) == SyncResult::Downloaded);
+    REQUIRE(database == expected);
+    REQUIRE_FALSE(std::filesystem::exists(cache.GetPartialPath()));
+
+    // The cache holds what the live database is
+    REQUIRE(SyncDatabase(*device, cache, database, true) == SyncResult::Unchanged);
+    REQUIRE(database == expected);
+    REQUIRE(device->Disconnect());
+}
+
+// Decompresses the backup the device imported
+std::vector<u8> GetImported(const Tests::FakeRouterOs& server) {
+    const std::vector<u8> imported = server.ReadFile("imported.db");
+    std::vector<u8> decompressed{};
+    Gzip::Decompressor decompressor{};
+    REQUIRE(decompressor.Write(imported, decompressed));
+    REQUIRE(decompressor.IsFinished());
+    return decompressed;
+}
+
+TEST_CASE("Uploads restore the database unchanged", "[mikrotik][ssh]") {
+    // Late acknowledgements leave writes partially sent, libssh2 must skip the data it already
+    // sent when the same data is passed again
+    const Tests::FakeRouterOs server{{"--write-delay", "0.005"}};
+    const auto device = ConnectDevice(server);
+    const std::vector<u8> database = GetRandomData(0x300000);
+    std::vector<u8> header(Gzip::DudeHeaderSize, 0x5A);
+
+    SECTION("With a header") {
+        REQUIRE(device->UploadDatabase(database, header));
+    }
+
+    SECTION("With the header of the device") {
+        header.assign(Gzip::DudeHeaderSize, 0xA5);
+        server.SetBackup(Tests::CompressBackup(header, GetRandomData(0x1000)));
+        REQUIRE(device->UploadDatabase(database));
+    }
+
+    SECTION("Over a restore left by an earlier run") {
+        std::ofstream{server.GetRoot() / "the_dude_to_human_restore.db"} << "stale";
+        REQUIRE(device->UploadDatabase(database, header));
+    }
+
+    header.insert(header.end(), database.begin(), database.end());
+    REQUIRE(GetImported(server) == header);
+    // Neither the restore nor its temporary file stay on the device
+    REQUIRE(server.ReadFile("the_dude_to_human_restore.db").empty());
+    REQUIRE(server.ReadFile("the_dude_to_human_restore.db.part").empty());
+    REQUIRE(server.ReadFile("the_dude_to_human.db").empty());
+    REQUIRE(device->Disconnect());
+}
+
+} // Anonymous namespace
+} // namespace Mikrotik
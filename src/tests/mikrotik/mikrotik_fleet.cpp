@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/mikrotik/fake_routeros.h"
+#include "the_dude_to_human/gzip/gzip.h"
+#include "the_dude_to_human/mikrotik/database_cache.h"
+#include "the_dude_to_human/mikrotik/mikrotik_fleet.h"
+
+namespace Mikrotik {
+namespace {
+
+DeviceAddress GetAddress(u16 port, const std::string& password = Tests::FakeRouterOs::Password) {
+    DeviceAddress host{};
+    host.user = Tests::FakeRouterOs::User;
+    host.password = password;
+    host.address = "127.0.0.1";
+    host.port = port;
+    return host;
+}
+
+TEST_CASE("A failing fleet host doesn't stop the others", "[mikrotik][ssh]") {
+    const std::vector<u8> header(Gzip::DudeHeaderSize, 0x5A);
+    std::vector<std::unique_ptr<Tests::FakeRouterOs>> servers{};
+    std::vector<std::vector<u8>> databases{};
+    std::vector<DeviceAddress> hosts{};
+    for (u8 i = 0; i < 3; ++i) {
+        servers.push_back(std::make_unique<Tests::FakeRouterOs>());
+        databases.emplace_back(0x1000 * (i + 1), static_cast<u8>('a' + i));
+        servers.back()->SetBackup(Tests::CompressBackup(header, databases.back()));
+        hosts.push_back(GetAddress(servers.back()->GetPort()));
+    }
+    // A device without a backup fails its export after connecting
+    const Tests::FakeRouterOs empty_server{};
+    hosts.push_back(GetAddress(empty_server.GetPort()));
+    hosts.push_back(GetAddress(servers.front()->GetPort(), "wrong"));
+    hosts.push_back(GetAddress(Tests::GetClosedPort()));
+
+    const std::filesystem::path cache_dir = servers.front()->GetRoot().parent_path() / "cache";
+    FleetOptions options{};
+    options.jobs = 2;
+    options.timeout_ms = 10000;
+    options.cache_dir = cache_dir.string();
+    REQUIRE(RunFleet(hosts, options) == 3);
+
+    // Each host that worked kept its own database
+    for (std::size_t i = 0; i < servers.size(); ++i) {
+        const DatabaseCache cache{cache_dir / (GetHostName(hosts[i]) + ".db")};
+        std::vector<u8> database{};
+        REQUIRE(cache.Load(database));
+        REQUIRE(database == databases[i]);
+    }
+
+    // Unchanged databases aren't failures
+    REQUIRE(RunFleet(hosts, options) == 3);
+}
+
+TEST_CASE("A failing fleet host doesn't stop the commands of the others", "[mikrotik][ssh]") {
+    std::vector<std::unique_ptr<Tests::FakeRouterOs>> servers{};
+    std::vector<DeviceAddress> hosts{};
+    for (int i = 0; i < 3; ++i) {
+        servers.push_back(std::make_unique<Tests::FakeRouterOs>());
+        hosts.push_back(GetAddress(servers.back()->GetPort()));
+    }
+    hosts.push_back(GetAddress(servers.front()->GetPort(), "wrong"));
+    hosts.push_back(GetAddress(Tests::GetClosedPort()));
+
+    FleetCommandOptions options{};
+    options.commands = {"/sleep 1"};
+    options.timeout_ms = 10000;
+
+    // The hosts run their command at the same time
+    const auto start_time = std::chrono::steady_clock::now();
+    REQUIRE(RunFleetCommand(hosts, options) == 2);
+    REQUIRE(std::chrono::steady_clock::now() - start_time < std::chrono::seconds{3});
+}
+
+} // Anonymous namespace
+} // namespace Mikrotik
@@ -0,0 +1,212 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "the_dude_to_human/mikrotik/range_download.h"
+
+namespace Mikrotik {
+namespace {
+
+constexpr u64 RangeSize = RangeDownload::RangeSize;
+// Three full ranges and a short last one
+constexpr u64 FileSize = 3 * RangeSize + RangeSize / 2;
+constexpr u64 Modified = 1700000000;
+constexpr char Source[] = "1234 2025-01-01 00:00:00";
+
+// Holds the partial file of a test, removed with everything in it
+class TemporaryDirectory {
+public:
+    TemporaryDirectory()
+        : path{std::filesystem::temp_directory_path() /
+               ("range_download_" + std::to_string(getpid()))} {
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+    }
+
+    ~TemporaryDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    const std::filesystem::path path;
+};
+
+std::vector<u8> GetFile() {
+    std::vector<u8> file(FileSize);
+    u32 state = 1;
+    for (u8& byte : file) {
+        state = state * 1664525 + 1013904223;
+        byte = static_cast<u8>(state >> 24);
+    }
+    return file;
+}
+
+// Takes the next range and fills it the way a session would
+std::size_t FetchRange(RangeDownload& download, std::span<const u8> file) {
+    std::size_t range = 0;
+    REQUIRE(download.TakeRange(range));
+    const std::span<u8> buffer = download.GetRangeBuffer(range);
+    const u64 offset = download.GetRangeOffset(range);
+    REQUIRE(buffer.size() == std::min(RangeSize, FileSize - offset));
+    std::copy_n(file.begin() + static_cast<std::ptrdiff_t>(offset), buffer.size(),
+                buffer.begin());
+    return range;
+}
+
+TEST_CASE("RangeDownload hands out the first range nobody is fetching", "[mikrotik]") {
+    const std::vector<u8> file = GetFile();
+    RangeDownload download{{}, [](std::span<const u8>) { return true; }};
+    REQUIRE(download.Start(FileSize, Modified, Source));
+
+    std::size_t range = 0;
+    REQUIRE(download.TakeRange(range));
+    REQUIRE(range == 0);
+    REQUIRE(download.TakeRange(range));
+    REQUIRE(range == 1);
+    download.ReturnRange(0);
+    REQUIRE(download.IsPending(0));
+    REQUIRE(download.TakeRange(range));
+    REQUIRE(range == 0);
+    REQUIRE(download.TakeRange(range));
+    REQUIRE(range == 2);
+}
+
+TEST_CASE("RangeDownload hands ranges to the sink in order", "[mikrotik]") {
+    const TemporaryDirectory directory{};
+    const std::vector<u8> file = GetFile();
+    std::vector<u8> received{};
+    std::vector<std::size_t> sizes{};
+    const auto sink = [&](std::span<const u8> data) {
+        received.insert(received.end(), data.begin(), data.end());
+        sizes.push_back(data.size());
+        return true;
+    };
+
+    SECTION("Ranges ahead of the sink are held in memory") {
+        RangeDownload download{{}, sink};
+        REQUIRE(download.Start(FileSize, Modified, Source));
+        for (std::size_t i = 0; i < 4; ++i) {
+            REQUIRE(FetchRange(download, file) == i);
+        }
+        REQUIRE(download.GetBufferedBytes() == FileSize);
+
+        REQUIRE(download.CompleteRange(2));
+        REQUIRE(download.CompleteRange(1));
+        REQUIRE(received.empty());
+        REQUIRE(download.CompleteRange(0));
+        REQUIRE(sizes == std::vector<std::size_t>{RangeSize, RangeSize, RangeSize});
+        // Only the range still being fetched holds memory
+        REQUIRE(download.GetBufferedBytes() == RangeSize / 2);
+        REQUIRE(download.CompleteRange(3));
+    }
+
+    SECTION("Ranges ahead of the sink are only kept in the partial file") {
+        RangeDownload download{directory.path / "file.part", sink};
+        REQUIRE(download.Start(FileSize, Modified, Source));
+        for (std::size_t i = 0; i < 4; ++i) {
+            REQUIRE(FetchRange(download, file) == i);
+        }
+
+        REQUIRE(download.CompleteRange(2));
+        REQUIRE(download.CompleteRange(3));
+        REQUIRE(download.GetBufferedBytes() == 2 * RangeSize);
+        REQUIRE(download.CompleteRange(0));
+        REQUIRE(download.GetBufferedBytes() == RangeSize);
+        // Ranges 2 and 3 are read back once range 1 is there
+        REQUIRE(download.CompleteRange(1));
+    }
+
+    REQUIRE(received == file);
+}
+
+TEST_CASE("RangeDownload resumes the valid ranges of an earlier run", "[mikrotik]") {
+    const TemporaryDirectory directory{};
+    const std::filesystem::path partial_path = directory.path / "file.part";
+    const std::vector<u8> file = GetFile();
+    std::vector<u8> received{};
+    const auto sink = [&](std::span<const u8> data) {
+        received.insert(received.end(), data.begin(), data.end());
+        return true;
+    };
+
+    {
+        // The run ends with ranges 0, 2 and 3 completed and range 1 still being fetched
+        RangeDownload download{partial_path, sink};
+        REQUIRE_FALSE(download.HasJournal());
+        REQUIRE(download.Start(FileSize, Modified, Source));
+        for (std::size_t i = 0; i < 4; ++i) {
+            FetchRange(download, file);
+        }
+        REQUIRE(download.CompleteRange(0));
+        REQUIRE(download.CompleteRange(2));
+        REQUIRE(download.CompleteRange(3));
+    }
+    REQUIRE(received.size() == RangeSize);
+    received.clear();
+
+    // Range 3 is damaged on disk
+    {
+        std::fstream partial{partial_path, std::ios::binary | std::ios::in | std::ios::out};
+        partial.seekp(static_cast<std::streamoff>(3 * RangeSize));
+        partial.put(static_cast<char>(~file[3 * RangeSize]));
+    }
+
+    RangeDownload download{partial_path, sink};
+    REQUIRE(download.HasJournal());
+    REQUIRE_FALSE(download.Resume(FileSize, Modified + 1, Source));
+    // The remote file was made from another version of the source
+    REQUIRE_FALSE(download.Resume(FileSize, Modified, "1234 2025-01-01 00:00:01"));
+
+    REQUIRE(download.Resume(FileSize, Modified, Source));
+    REQUIRE(download.GetCompletedBytes() == 2 * RangeSize);
+    REQUIRE(download.GetPendingRanges() == 2);
+    // Range 0 comes from the partial file, range 2 waits for range 1
+    REQUIRE(received.size() == RangeSize);
+    REQUIRE(download.GetBufferedBytes() == 0);
+
+    REQUIRE(FetchRange(download, file) == 1);
+    REQUIRE(download.CompleteRange(1));
+    REQUIRE(FetchRange(download, file) == 3);
+    REQUIRE(download.CompleteRange(3));
+    REQUIRE(download.IsComplete());
+    REQUIRE(received == file);
+    download.Discard();
+    REQUIRE_FALSE(download.HasJournal());
+}
+
+TEST_CASE("RangeDownload stops once the sink fails", "[mikrotik]") {
+    const std::vector<u8> file = GetFile();
+    int calls = 0;
+    RangeDownload download{{}, [&calls](std::span<const u8>) {
+                               ++calls;
+                               return false;
+                           }};
+    REQUIRE(download.Start(FileSize, Modified, Source));
+
+    REQUIRE(FetchRange(download, file) == 0);
+    REQUIRE(FetchRange(download, file) == 1);
+    REQUIRE_FALSE(download.IsFailed());
+    REQUIRE(download.CompleteRange(0));
+    REQUIRE(download.IsFailed());
+
+    std::size_t range = 0;
+    REQUIRE_FALSE(download.TakeRange(range));
+    // The sink isn't called again
+    REQUIRE(download.CompleteRange(1));
+    REQUIRE(calls == 1);
+}
+
+} // Anonymous namespace
+} // namespace Mikrotik
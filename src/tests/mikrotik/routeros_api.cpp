@@ -0,0 +1,407 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "common/task.h"
+#include "the_dude_to_human/mikrotik/routeros_api.h"
+
+namespace Mikrotik {
+namespace {
+
+using namespace std::chrono_literals;
+using Sentence = std::vector<std::string>;
+
+std::string EncodeSentence(const Sentence& sentence) {
+    std::string data{};
+    for (const std::string& word : sentence) {
+        EncodeLength(data, word.size());
+        data += word;
+    }
+    EncodeLength(data, 0);
+    return data;
+}
+
+// Returns the .tag word of a sentence, empty if it has none
+std::string GetTag(const Sentence& sentence) {
+    for (const std::string& word : sentence) {
+        if (word.starts_with(".tag=")) {
+            return word;
+        }
+    }
+    return {};
+}
+
+// Serves the api connection of one client on a local port. Each sentence the client sends is
+// handed to the handler on the server thread, which answers with Send
+class FakeApiServer {
+public:
+    using Handler = std::function<void(FakeApiServer& server, const Sentence& sentence)>;
+
+    explicit FakeApiServer(Handler handler_) : handler{std::move(handler_)} {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        REQUIRE(bind(listener, reinterpret_cast<sockaddr*>(&address), length) == 0);
+        REQUIRE(listen(listener, 1) == 0);
+        REQUIRE(getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) == 0);
+        port = ntohs(address.sin_port);
+        thread = std::thread{[this] { Run(); }};
+    }
+
+    ~FakeApiServer() {
+        // Wakes up the server thread wherever it waits
+        shutdown(listener, SHUT_RDWR);
+        Close();
+        thread.join();
+        close(listener);
+        if (connection != -1) {
+            close(connection);
+        }
+    }
+
+    FakeApiServer(const FakeApiServer&) = delete;
+    FakeApiServer& operator=(const FakeApiServer&) = delete;
+
+    u16 GetPort() const {
+        return port;
+    }
+
+    // A chunk size other than zero sends the sentence in pieces of that size, with a pause after
+    // each one so they arrive in different reads
+    void Send(const Sentence& sentence, std::size_t chunk_size = 0) const {
+        const std::string data = EncodeSentence(sentence);
+        const std::size_t step = chunk_size == 0 ? data.size() : chunk_size;
+        for (std::size_t offset = 0; offset < data.size(); offset += step) {
+            const std::size_t size = std::min(step, data.size() - offset);
+            if (send(connection, data.data() + offset, size, MSG_NOSIGNAL) !=
+                static_cast<ssize_t>(size)) {
+                return;
+            }
+            if (chunk_size != 0) {
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+    }
+
+    // Replies to a login with the method of RouterOS 6.43 and later
+    void AcceptLogin(const Sentence& sentence) const {
+        Send({"!done", GetTag(sentence)});
+    }
+
+    void Close() const {
+        if (connection != -1) {
+            shutdown(connection, SHUT_RDWR);
+        }
+    }
+
+private:
+    void Run() {
+        connection = accept(listener, nullptr, nullptr);
+        if (connection == -1) {
+            return;
+        }
+
+        std::string input{};
+        Sentence sentence{};
+        std::array<char, 0x1000> buffer{};
+        for (;;) {
+            const ssize_t received = recv(connection, buffer.data(), buffer.size(), 0);
+            if (received <= 0) {
+                return;
+            }
+            input.append(buffer.data(), static_cast<std::size_t>(received));
+
+            std::size_t offset = 0;
+            std::size_t length = 0;
+            for (;;) {
+                const int header_size = DecodeLength(input, offset, length);
+                if (header_size <= 0 ||
+                    input.size() - offset - static_cast<std::size_t>(header_size) < length) {
+                    break;
+                }
+                offset += static_cast<std::size_t>(header_size);
+                if (length == 0) {
+                    handler(*this, sentence);
+                    sentence.clear();
+                    continue;
+                }
+                sentence.emplace_back(input, offset, length);
+                offset += length;
+            }
+            input.erase(0, offset);
+        }
+    }
+
+    Handler handler;
+    int listener{-1};
+    std::atomic<int> connection{-1};
+    u16 port{};
+    std::thread thread{};
+};
+
+std::string GetAttribute(const ApiAttributes& attributes, std::string_view key) {
+    const std::string* value = FindAttribute(attributes, key);
+    return value != nullptr ? *value : "(missing)";
+}
+
+TEST_CASE("RouterOS api word lengths take the fewest bytes", "[mikrotik]") {
+    struct LengthCase {
+        std::size_t length;
+        std::vector<u8> encoded;
+    };
+    // The last length of each class and the first of the next one
+    const std::vector<LengthCase> cases{
+        {0, {0x00}},
+        {0x7F, {0x7F}},
+        {0x80, {0x80, 0x80}},
+        {0x3FFF, {0xBF, 0xFF}},
+        {0x4000, {0xC0, 0x40, 0x00}},
+        {0x1FFFFF, {0xDF, 0xFF, 0xFF}},
+        {0x200000, {0xE0, 0x20, 0x00, 0x00}},
+        {0xFFFFFFF, {0xEF, 0xFF, 0xFF, 0xFF}},
+        {0x10000000, {0xF0, 0x10, 0x00, 0x00, 0x00}},
+    };
+
+    for (const LengthCase& test : cases) {
+        INFO("Length " << test.length);
+        std::string data{"prefix"};
+        EncodeLength(data, test.length);
+        REQUIRE(std::vector<u8>(data.begin() + 6, data.end()) == test.encoded);
+
+        std::size_t length = 0;
+        REQUIRE(DecodeLength(data, 6, length) == static_cast<int>(test.encoded.size()));
+        REQUIRE(length == test.length);
+
+        // Bytes of the length that didn't arrive yet
+        const std::string_view partial{data.data(), data.size() - 1};
+        REQUIRE(DecodeLength(partial, 6, length) == 0);
+    }
+
+    std::size_t length = 0;
+    REQUIRE(DecodeLength("", 0, length) == 0);
+    REQUIRE(DecodeLength("\xF8", 0, length) == -1);
+    REQUIRE(DecodeLength("\xFF", 0, length) == -1);
+}
+
+TEST_CASE("RouterOS api replies split across reads", "[mikrotik]") {
+    // Long enough for a two byte length, each piece is a single byte
+    const std::string value(0x100, 'v');
+    const FakeApiServer server{[&value](FakeApiServer& fake, const Sentence& sentence) {
+        const std::string tag = GetTag(sentence);
+        if (sentence[0] == "/login") {
+            fake.Send({"!done", tag}, 1);
+            return;
+        }
+        fake.Send({"!re", "=name=first", "=value=" + value, tag}, 1);
+        fake.Send({"!re", "=name=second", tag}, 3);
+        fake.Send({"!done", "=ret=*1", tag}, 1);
+    }};
+    RouterOsApi api{"127.0.0.1", server.GetPort()};
+    api.SetTimeout(5000);
+    REQUIRE(api.Connect("admin", "secret"));
+
+    const ApiReply reply = api.Execute({"/interface/print"});
+    REQUIRE(reply.is_success);
+    REQUIRE(reply.rows.size() == 2);
+    REQUIRE(GetAttribute(reply.rows[0], "name") == "first");
+    REQUIRE(GetAttribute(reply.rows[0], "value") == value);
+    REQUIRE(GetAttribute(reply.rows[1], "name") == "second");
+    REQUIRE(GetAttribute(reply.done, "ret") == "*1");
+}
+
+TEST_CASE("RouterOS api matches out of order replies by tag", "[mikrotik]") {
+    constexpr std::size_t Commands = 3;
+    // Only touched by the server thread
+    std::vector<std::pair<std::string, std::string>> received{};
+    const FakeApiServer server{[&received](FakeApiServer& fake, const Sentence& sentence) {
+        if (sentence[0] == "/login") {
+            fake.AcceptLogin(sentence);
+            return;
+        }
+        received.emplace_back(sentence[0], GetTag(sentence));
+        if (received.size() < Commands) {
+            return;
+        }
+        // Answers the last command first, with the rows of the commands interleaved
+        for (auto it = received.rbegin(); it != received.rend(); ++it) {
+            fake.Send({"!re", "=command=" + it->first, it->second});
+        }
+        for (auto it = received.rbegin(); it != received.rend(); ++it) {
+            fake.Send({"!done", "=command=" + it->first, it->second});
+        }
+    }};
+    RouterOsApi api{"127.0.0.1", server.GetPort()};
+    api.SetTimeout(5000);
+    REQUIRE(api.Connect("admin", "secret"));
+
+    std::vector<Common::Task<ApiReply>> tasks{};
+    for (std::size_t i = 0; i < Commands; ++i) {
+        tasks.push_back(api.ExecuteAsync({"/command" + std::to_string(i)}));
+    }
+    const std::vector<ApiReply> replies = Common::SyncWait(Common::WhenAll(std::move(tasks)));
+    for (std::size_t i = 0; i < Commands; ++i) {
+        const std::string command = "/command" + std::to_string(i);
+        REQUIRE(replies[i].is_success);
+        REQUIRE(replies[i].rows.size() == 1);
+        REQUIRE(GetAttribute(replies[i].rows[0], "command") == command);
+        REQUIRE(GetAttribute(replies[i].done, "command") == command);
+    }
+}
+
+TEST_CASE("RouterOS api errors", "[mikrotik]") {
+    const FakeApiServer server{[](FakeApiServer& fake, const Sentence& sentence) {
+        const std::string tag = GetTag(sentence);
+        if (sentence[0] == "/login") {
+            fake.AcceptLogin(sentence);
+        } else if (sentence[0] == "/fail") {
+            // A failed command still ends with !done
+            fake.Send({"!trap", "=category=0", "=message=no such command", tag});
+            fake.Send({"!done", tag});
+        } else if (sentence[0] == "/quit") {
+            // Untagged, the router closes the connection right after it
+            fake.Send({"!fatal", "session terminated on request"});
+            fake.Close();
+        } else {
+            fake.Send({"!re", "=name=ok", tag});
+            fake.Send({"!done", tag});
+        }
+    }};
+    RouterOsApi api{"127.0.0.1", server.GetPort()};
+    api.SetTimeout(5000);
+    REQUIRE(api.Connect("admin", "secret"));
+
+    SECTION("!trap followed by !done fails the command only") {
+        const ApiReply failed = api.Execute({"/fail"});
+        REQUIRE_FALSE(failed.is_success);
+        REQUIRE(failed.error == "no such command");
+
+        const ApiReply next = api.Execute({"/print"});
+        REQUIRE(next.is_success);
+        REQUIRE(next.rows.size() == 1);
+    }
+
+    SECTION("!fatal fails every command") {
+        const ApiReply fatal = api.Execute({"/quit"});
+        REQUIRE_FALSE(fatal.is_success);
+        REQUIRE(fatal.error == "session terminated on request");
+
+        const ApiReply next = api.Execute({"/print"});
+        REQUIRE_FALSE(next.is_success);
+        REQUIRE(next.error == "session terminated on request");
+    }
+
+    REQUIRE(api.Disconnect());
+}
+
+TEST_CASE("RouterOS api drops replies that arrive after the timeout", "[mikrotik]") {
+    // Only touched by the server thread
+    std::string slow_tag{};
+    const FakeApiServer server{[&slow_tag](FakeApiServer& fake, const Sentence& sentence) {
+        const std::string tag = GetTag(sentence);
+        if (sentence[0] == "/login") {
+            fake.AcceptLogin(sentence);
+        } else if (sentence[0] == "/slow") {
+            slow_tag = tag;
+        } else {
+            // The reply of the command that timed out arrives first
+            fake.Send({"!re", "=name=late", slow_tag});
+            fake.Send({"!done", slow_tag});
+            fake.Send({"!re", "=name=next", tag});
+            fake.Send({"!done", tag});
+        }
+    }};
+    RouterOsApi api{"127.0.0.1", server.GetPort()};
+    api.SetTimeout(300);
+    REQUIRE(api.Connect("admin", "secret"));
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const ApiReply slow = api.Execute({"/slow"});
+    REQUIRE(std::chrono::steady_clock::now() - start_time >= 300ms);
+    REQUIRE_FALSE(slow.is_success);
+    REQUIRE(slow.error == "timeout");
+
+    const ApiReply next = api.Execute({"/next"});
+    REQUIRE(next.is_success);
+    REQUIRE(next.rows.size() == 1);
+    REQUIRE(GetAttribute(next.rows[0], "name") == "next");
+    REQUIRE(api.GetCommandStatistics().failed_commands == 1);
+}
+
+TEST_CASE("RouterOS api login", "[mikrotik]") {
+    enum class LoginReply { Accepted, Challenge, Rejected };
+    std::atomic<LoginReply> login_reply{LoginReply::Accepted};
+    const FakeApiServer server{[&login_reply](FakeApiServer& fake, const Sentence& sentence) {
+        const std::string tag = GetTag(sentence);
+        switch (login_reply.load()) {
+        case LoginReply::Accepted:
+            fake.AcceptLogin(sentence);
+            break;
+        case LoginReply::Challenge:
+            // Versions before 6.43 answer with the challenge of an md5 login
+            fake.Send({"!done", "=ret=ebddd18303a54111e2dea05a92ab46b4", tag});
+            break;
+        case LoginReply::Rejected:
+            fake.Send({"!trap", "=message=invalid user name or password (6)", tag});
+            fake.Send({"!done", tag});
+            break;
+        }
+    }};
+    RouterOsApi api{"127.0.0.1", server.GetPort()};
+    api.SetTimeout(5000);
+
+    SECTION("Accepted") {
+        REQUIRE(api.Connect("admin", "secret"));
+    }
+
+    SECTION("Challenge of an older version") {
+        login_reply = LoginReply::Challenge;
+        REQUIRE_FALSE(api.Connect("admin", "secret"));
+    }
+
+    SECTION("Wrong password") {
+        login_reply = LoginReply::Rejected;
+        REQUIRE_FALSE(api.Connect("admin", "wrong"));
+    }
+}
+
+TEST_CASE("RouterOS api refuses the api-ssl port", "[mikrotik]") {
+    // Listens on the port when it's free, the client must not even connect
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(RouterOsApi::SslPort);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const bool is_listening =
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+        listen(listener, 1) == 0 && fcntl(listener, F_SETFL, O_NONBLOCK) == 0;
+
+    RouterOsApi api{"127.0.0.1", RouterOsApi::SslPort};
+    api.SetTimeout(5000);
+    REQUIRE_FALSE(api.Connect("admin", "secret"));
+    if (is_listening) {
+        REQUIRE(accept(listener, nullptr, nullptr) == -1);
+    }
+    close(listener);
+}
+
+} // Anonymous namespace
+} // namespace Mikrotik
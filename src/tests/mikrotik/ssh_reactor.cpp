@@ -0,0 +1,490 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "common/task.h"
+#include "libssh2.h"
+#include "tests/mikrotik/fake_routeros.h"
+#include "the_dude_to_human/gzip/gzip.h"
+#include "the_dude_to_human/mikrotik/mikrotik_device.h"
+#include "the_dude_to_human/mikrotik/ssh_reactor.h"
+
+namespace Mikrotik {
+namespace {
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+// Steps wait on the first socket, the test writes into the second one
+class SocketPair {
+public:
+    SocketPair() {
+        REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()) == 0);
+        REQUIRE(fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK) == 0);
+    }
+
+    ~SocketPair() {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    s32 GetReactorSocket() const {
+        return fds[0];
+    }
+
+    void Send(const std::string& data) const {
+        REQUIRE(write(fds[1], data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    }
+
+    // Writes into the first socket until its buffer is full, the steps can't send anymore
+    void FillReactorSocket() const {
+        const std::array<char, 0x1000> data{};
+        while (write(fds[0], data.data(), data.size()) > 0) {
+        }
+    }
+
+    // Reads everything the steps sent, which lets them send again
+    void Drain() const {
+        std::array<char, 0x1000> data{};
+        while (recv(fds[1], data.data(), data.size(), MSG_DONTWAIT) > 0) {
+        }
+    }
+
+private:
+    std::array<int, 2> fds{};
+};
+
+// Consumes the next byte once it's expected, other bytes are left for the other steps
+SshReactor::Step WaitForByte(s32 socket_fd, char expected) {
+    return [socket_fd, expected] {
+        char byte{};
+        if (recv(socket_fd, &byte, 1, MSG_PEEK) != 1 || byte != expected) {
+            return SshReactor::WaitRead;
+        }
+        [[maybe_unused]] const ssize_t consumed = recv(socket_fd, &byte, 1, 0);
+        return 0;
+    };
+}
+
+SshReactor::Completion SetResult(std::promise<int>& result) {
+    return [&result](int value) { result.set_value(value); };
+}
+
+bool IsReady(const std::future<int>& result, std::chrono::milliseconds timeout = 5s) {
+    return result.wait_for(timeout) == std::future_status::ready;
+}
+
+std::unique_ptr<MikrotikDevice> ConnectDevice(const Tests::FakeRouterOs& server,
+                                              u32 timeout_ms = 10000) {
+    auto device = std::make_unique<MikrotikDevice>("127.0.0.1", server.GetPort());
+    device->SetTimeout(timeout_ms);
+    REQUIRE(device->Connect(Tests::FakeRouterOs::User, Tests::FakeRouterOs::Password));
+    return device;
+}
+
+TEST_CASE("SshReactor runs the steps of a socket one after another", "[mikrotik]") {
+    constexpr std::size_t Threads = 4;
+    constexpr std::size_t StepsPerThread = 25;
+
+    const SocketPair sockets{};
+    const s32 socket_fd = sockets.GetReactorSocket();
+
+    // Only touched by the reactor thread of the socket
+    std::size_t running_step = StepsPerThread * Threads;
+    bool is_overlapping = false;
+    std::vector<char> bytes(StepsPerThread * Threads);
+    std::vector<std::promise<int>> results(StepsPerThread * Threads);
+
+    // Destroyed first, a failed test can't leave steps pointing to the variables above
+    SshReactor reactor{2};
+
+    // Each thread submits its steps while the others do the same
+    std::vector<std::thread> threads{};
+    for (std::size_t thread = 0; thread < Threads; ++thread) {
+        threads.emplace_back([&, thread] {
+            for (std::size_t i = 0; i < StepsPerThread; ++i) {
+                const std::size_t step = thread * StepsPerThread + i;
+                const auto read_byte = [&, step] {
+                    is_overlapping |= running_step != bytes.size() && running_step != step;
+                    running_step = step;
+                    const ssize_t received = recv(socket_fd, &bytes[step], 1, 0);
+                    if (received != 1) {
+                        return SshReactor::WaitRead;
+                    }
+                    running_step = bytes.size();
+                    return 0;
+                };
+                reactor.Submit(socket_fd, nullptr, 0, read_byte, SetResult(results[step]));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::string data{};
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        data += static_cast<char>(i);
+    }
+    sockets.Send(data);
+
+    for (std::promise<int>& result : results) {
+        std::future<int> future = result.get_future();
+        REQUIRE(IsReady(future));
+        REQUIRE(future.get() == 0);
+    }
+    REQUIRE_FALSE(is_overlapping);
+
+    // Steps of one thread were submitted in order, so they read increasing bytes
+    for (std::size_t thread = 0; thread < Threads; ++thread) {
+        for (std::size_t i = 1; i < StepsPerThread; ++i) {
+            const std::size_t step = thread * StepsPerThread + i;
+            REQUIRE(bytes[step - 1] < bytes[step]);
+        }
+    }
+}
+
+TEST_CASE("SshReactor times out steps waiting without progress", "[mikrotik]") {
+    const SocketPair sockets{};
+    const s32 socket_fd = sockets.GetReactorSocket();
+    std::promise<int> timed_out{};
+    std::promise<int> next{};
+    std::size_t received = 0;
+    SshReactor reactor{1};
+
+    SECTION("A silent socket times out and the next step starts") {
+        const auto start_time = Clock::now();
+        reactor.Submit(socket_fd, nullptr, 200, WaitForByte(socket_fd, 'a'),
+                       SetResult(timed_out));
+        reactor.Submit(socket_fd, nullptr, 0, WaitForByte(socket_fd, 'a'), SetResult(next));
+
+        std::future<int> timed_out_future = timed_out.get_future();
+        REQUIRE(IsReady(timed_out_future));
+        REQUIRE(timed_out_future.get() == LIBSSH2_ERROR_TIMEOUT);
+        REQUIRE(Clock::now() - start_time >= 200ms);
+
+        std::future<int> next_future = next.get_future();
+        REQUIRE_FALSE(IsReady(next_future, 100ms));
+        sockets.Send("a");
+        REQUIRE(IsReady(next_future));
+        REQUIRE(next_future.get() == 0);
+    }
+
+    SECTION("The timeout restarts with every wait") {
+        const auto read_bytes = [socket_fd, &received] {
+            char byte{};
+            while (recv(socket_fd, &byte, 1, 0) == 1) {
+                ++received;
+            }
+            return received == 6 ? 0 : SshReactor::WaitRead;
+        };
+        reactor.Submit(socket_fd, nullptr, 300, read_bytes, SetResult(next));
+
+        // Twice the timeout in total, but never more than a third of it between bytes
+        for (int i = 0; i < 6; ++i) {
+            std::this_thread::sleep_for(100ms);
+            sockets.Send("x");
+        }
+        std::future<int> future = next.get_future();
+        REQUIRE(IsReady(future));
+        REQUIRE(future.get() == 0);
+    }
+}
+
+TEST_CASE("SshReactor lets shared steps of a socket wait together", "[mikrotik]") {
+    const SocketPair sockets{};
+    const s32 socket_fd = sockets.GetReactorSocket();
+    std::promise<int> first{};
+    std::promise<int> second{};
+    std::future<int> first_future = first.get_future();
+    std::future<int> second_future = second.get_future();
+    std::atomic_bool is_released{};
+    SshReactor reactor{1};
+
+    SECTION("A waiting shared step lets the next one run") {
+        reactor.Submit(socket_fd, nullptr, 0, WaitForByte(socket_fd, 'a'), SetResult(first),
+                       true);
+        reactor.Submit(socket_fd, nullptr, 0, WaitForByte(socket_fd, 'b'), SetResult(second),
+                       true);
+
+        sockets.Send("b");
+        REQUIRE(IsReady(second_future));
+        REQUIRE(second_future.get() == 0);
+        REQUIRE_FALSE(IsReady(first_future, 100ms));
+
+        sockets.Send("a");
+        REQUIRE(IsReady(first_future));
+        REQUIRE(first_future.get() == 0);
+    }
+
+    SECTION("A waiting step that isn't shared holds back the next one") {
+        const auto wait_for_release = [&is_released] {
+            return is_released ? 0 : SshReactor::WaitRead;
+        };
+        reactor.Submit(socket_fd, nullptr, 0, wait_for_release, SetResult(first));
+        reactor.Submit(socket_fd, nullptr, 0, WaitForByte(socket_fd, 'b'), SetResult(second));
+
+        sockets.Send("b");
+        REQUIRE_FALSE(IsReady(second_future, 200ms));
+
+        is_released = true;
+        REQUIRE(IsReady(first_future));
+        REQUIRE(IsReady(second_future));
+        REQUIRE(first_future.get() == 0);
+        REQUIRE(second_future.get() == 0);
+    }
+
+    SECTION("A shared step blocked on sending holds back the next one") {
+        // The banner of the handshake can't be sent, libssh2 has to finish it before the session
+        // sends anything else
+        sockets.FillReactorSocket();
+        const std::unique_ptr<LIBSSH2_SESSION, decltype(&libssh2_session_free)> session{
+            libssh2_session_init(), libssh2_session_free};
+        REQUIRE(session != nullptr);
+        libssh2_session_set_blocking(session.get(), 0);
+        const auto handshake = [session = session.get(), socket_fd] {
+            const int result = libssh2_session_handshake(session, socket_fd);
+            // Waiting for the banner of the server means ours was sent
+            if (result == LIBSSH2_ERROR_EAGAIN &&
+                (libssh2_session_block_directions(session) & LIBSSH2_SESSION_BLOCK_OUTBOUND) ==
+                    0) {
+                return 0;
+            }
+            return result;
+        };
+        reactor.Submit(socket_fd, session.get(), 0, handshake, SetResult(first), true);
+        reactor.Submit(socket_fd, session.get(), 0, [] { return 0; }, SetResult(second), true);
+        REQUIRE_FALSE(IsReady(second_future, 200ms));
+
+        sockets.Drain();
+        REQUIRE(IsReady(first_future));
+        REQUIRE(IsReady(second_future));
+        REQUIRE(first_future.get() == 0);
+        REQUIRE(second_future.get() == 0);
+    }
+}
+
+TEST_CASE("SshReactor fails the pending steps when it's destroyed", "[mikrotik]") {
+    const SocketPair sockets{};
+    const s32 socket_fd = sockets.GetReactorSocket();
+    std::promise<int> waiting{};
+    std::promise<int> queued{};
+    auto reactor = std::make_unique<SshReactor>(1);
+    reactor->Submit(socket_fd, nullptr, 0, WaitForByte(socket_fd, 'a'), SetResult(waiting));
+    reactor->Submit(socket_fd, nullptr, 0, WaitForByte(socket_fd, 'a'), SetResult(queued));
+    reactor.reset();
+
+    std::future<int> waiting_future = waiting.get_future();
+    std::future<int> queued_future = queued.get_future();
+    REQUIRE(IsReady(waiting_future, 0ms));
+    REQUIRE(IsReady(queued_future, 0ms));
+    REQUIRE(waiting_future.get() == LIBSSH2_ERROR_SOCKET_DISCONNECT);
+    REQUIRE(queued_future.get() == LIBSSH2_ERROR_SOCKET_DISCONNECT);
+}
+
+TEST_CASE("Devices share the threads of a reactor", "[mikrotik][ssh]") {
+    constexpr std::size_t Devices = 16;
+    const Tests::FakeRouterOs server{};
+    SshReactor reactor{1};
+
+    // Every device waits on its command at the same time, one reactor thread serves them all
+    std::vector<std::string> outputs(Devices);
+    std::vector<std::thread> threads{};
+    const auto start_time = Clock::now();
+    for (std::string& output : outputs) {
+        threads.emplace_back([&server, &reactor, &output] {
+            MikrotikDevice device{"127.0.0.1", server.GetPort(), &reactor};
+            device.SetTimeout(10000);
+            if (device.Connect(Tests::FakeRouterOs::User, Tests::FakeRouterOs::Password)) {
+                device.Execute("/sleep 1", &output);
+                device.Disconnect();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(Clock::now() - start_time < 8s);
+    for (const std::string& output : outputs) {
+        REQUIRE(output.starts_with("slept 1\r\n"));
+    }
+}
+
+TEST_CASE("Commands of a session run at the same time", "[mikrotik][ssh]") {
+    const Tests::FakeRouterOs server{};
+    const auto device = ConnectDevice(server);
+
+    SECTION("Waiting commands don't hold back the others") {
+        std::array<std::string, MikrotikDevice::MaxChannels> outputs{};
+        std::vector<Common::Task<bool>> tasks{};
+        for (std::string& output : outputs) {
+            tasks.push_back(device->ExecuteAsync("/sleep 1", &output));
+        }
+
+        const auto start_time = Clock::now();
+        const std::vector<bool> results = Common::SyncWait(Common::WhenAll(std::move(tasks)));
+        REQUIRE(Clock::now() - start_time < 2500ms);
+        for (std::size_t i = 0; i < outputs.size(); ++i) {
+            REQUIRE(results[i]);
+            REQUIRE(outputs[i] == "slept 1\r\n");
+        }
+    }
+
+    SECTION("Outputs filling the channel window stay apart") {
+        constexpr int Lines = 100000;
+        std::array<std::string, 2> outputs{};
+        std::array<std::string, 2> errors{};
+        std::vector<Common::Task<bool>> tasks{};
+        for (std::size_t i = 0; i < outputs.size(); ++i) {
+            const auto output_sink = [&output = outputs[i]](std::span<const char> data) {
+                output.append(data.data(), data.size());
+            };
+            const auto error_sink = [&error = errors[i]](std::span<const char> data) {
+                error.append(data.data(), data.size());
+            };
+            tasks.push_back(device->ExecuteAsync("/print " + std::to_string(Lines), output_sink,
+                                                 error_sink));
+        }
+        std::string sleep_output{};
+        tasks.push_back(device->ExecuteAsync("/sleep 0.5", &sleep_output));
+
+        const std::vector<bool> results = Common::SyncWait(Common::WhenAll(std::move(tasks)));
+        std::string expected{};
+        for (int line = 0; line < Lines; ++line) {
+            expected += "line " + std::to_string(line) + "\r\n";
+        }
+        for (std::size_t i = 0; i < outputs.size(); ++i) {
+            REQUIRE(results[i]);
+            REQUIRE(outputs[i] == expected);
+            REQUIRE(errors[i] == "printed " + std::to_string(Lines) + " lines\r\n");
+        }
+        REQUIRE(results.back());
+        REQUIRE(sleep_output == "slept 0.5\r\n");
+    }
+
+    REQUIRE(device->Disconnect());
+}
+
+TEST_CASE("Devices that can't log in fail to connect", "[mikrotik][ssh]") {
+    const Tests::FakeRouterOs server{};
+
+    SECTION("Wrong password") {
+        MikrotikDevice device{"127.0.0.1", server.GetPort()};
+        device.SetTimeout(10000);
+        REQUIRE_FALSE(device.Connect(Tests::FakeRouterOs::User, "wrong"));
+    }
+
+    SECTION("Refused connection") {
+        MikrotikDevice device{"127.0.0.1", Tests::GetClosedPort()};
+        device.SetTimeout(10000);
+        REQUIRE_FALSE(device.Connect(Tests::FakeRouterOs::User, Tests::FakeRouterOs::Password));
+    }
+}
+
+TEST_CASE("Databases download unchanged through the reactor", "[mikrotik][ssh]") {
+    const Tests::FakeRouterOs server{};
+    const std::vector<u8> header(Gzip::DudeHeaderSize, 0x5A);
+    std::vector<u8> database(0x300000);
+    u32 state = 1;
+    for (u8& byte : database) {
+        state = state * 1664525 + 1013904223;
+        byte = static_cast<u8>(state >> 24);
+    }
+    server.SetBackup(Tests::CompressBackup(header, database));
+    const auto device = ConnectDevice(server);
+
+    std::vector<u8> downloaded{};
+    REQUIRE(device->DownloadDatabase(downloaded));
+    REQUIRE(downloaded == database);
+    // The export doesn't stay on the device
+    REQUIRE(std::filesystem::is_empty(server.GetRoot()));
+
+    REQUIRE(device->Disconnect());
+}
+
+TEST_CASE("Commands run while an upload is in flight", "[mikrotik][ssh]") {
+    // The server reads slowly, so the upload takes long enough for many commands to overlap it
+    const Tests::FakeRouterOs server{{"--throttle", "500000"}};
+    const auto device = ConnectDevice(server);
+
+    std::vector<u8> header(Gzip::DudeHeaderSize, 0x5A);
+    std::vector<u8> database(0x100000);
+    u32 state = 1;
+    for (u8& byte : database) {
+        state = state * 1664525 + 1013904223;
+        byte = static_cast<u8>(state >> 24);
+    }
+
+    // Commands keep running until the upload is done
+    std::atomic<bool> is_uploading{true};
+    std::vector<std::string> outputs{};
+    std::vector<bool> results{};
+    std::thread commands{[&] {
+        while (is_uploading) {
+            std::string output{};
+            results.push_back(device->Execute("/print 100", &output));
+            outputs.push_back(std::move(output));
+        }
+    }};
+    const bool is_uploaded = device->UploadDatabase(database, header);
+    is_uploading = false;
+    commands.join();
+
+    REQUIRE(is_uploaded);
+    REQUIRE(results.size() > 1);
+    std::string expected{};
+    for (int line = 0; line < 100; ++line) {
+        expected += "line " + std::to_string(line) + "\r\n";
+    }
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        REQUIRE(results[i]);
+        REQUIRE(outputs[i] == expected);
+    }
+
+    const std::vector<u8> imported = server.ReadFile("imported.db");
+    std::vector<u8> decompressed{};
+    Gzip::Decompressor decompressor{};
+    REQUIRE(decompressor.Write(imported, decompressed));
+    REQUIRE(decompressor.IsFinished());
+    header.insert(header.end(), database.begin(), database.end());
+    REQUIRE(decompressed == header);
+
+    REQUIRE(device->Disconnect());
+}
+
+TEST_CASE("Commands fail after the timeout without progress", "[mikrotik][ssh]") {
+    const Tests::FakeRouterOs server{};
+    const auto device = ConnectDevice(server, 500);
+
+    const auto start_time = Clock::now();
+    REQUIRE_FALSE(device->Execute("/sleep 5"));
+    REQUIRE(Clock::now() - start_time < 3s);
+
+    // The session of the timed out command was replaced
+    std::string output{};
+    REQUIRE(device->Execute("/sleep 0.1", &output));
+    REQUIRE(output == "slept 0.1\r\n");
+    REQUIRE(device->GetCommandStatistics().reconnects == 1);
+
+    REQUIRE(device->Disconnect());
+}
+
+} // Anonymous namespace
+} // namespace Mikrotik
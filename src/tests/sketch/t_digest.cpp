@@ -0,0 +1,188 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "the_dude_to_human/sketch/t_digest.h"
+
+namespace Sketch {
+namespace {
+
+// Offsets of the serialized header fields
+constexpr std::size_t CompressionOffset = 0;
+constexpr std::size_t MinOffset = 8;
+constexpr std::size_t CentroidCountOffset = 24;
+// Offsets of the mean and weight of the second centroid
+constexpr std::size_t MeanOffset = 48;
+constexpr std::size_t WeightOffset = 56;
+
+template <typename T>
+void Patch(std::vector<u8>& data, std::size_t offset, T value) {
+    std::memcpy(data.data() + offset, &value, sizeof(value));
+}
+
+TDigest GetDigest() {
+    TDigest digest{};
+    for (int i = 0; i < 10000; ++i) {
+        digest.Add(static_cast<f64>((i * 7919) % 10000));
+    }
+    return digest;
+}
+
+TEST_CASE("TDigest survives serialization", "[sketch]") {
+    SECTION("With values") {
+        const TDigest digest = GetDigest();
+        const std::vector<u8> data = digest.Serialize();
+
+        TDigest copy{};
+        REQUIRE(copy.Deserialize(data));
+        REQUIRE(copy.GetCount() == digest.GetCount());
+        REQUIRE(copy.GetMin() == 0);
+        REQUIRE(copy.GetMax() == 9999);
+        for (const f64 q : {0.0, 0.01, 0.5, 0.9, 0.99, 1.0}) {
+            REQUIRE(copy.Quantile(q) == digest.Quantile(q));
+        }
+        REQUIRE(copy.Quantile(0.5) == Approx(5000).margin(50));
+        REQUIRE(copy.Serialize() == data);
+    }
+
+    SECTION("Empty") {
+        TDigest copy = GetDigest();
+        REQUIRE(copy.Deserialize(TDigest{}.Serialize()));
+        REQUIRE(copy.GetCount() == 0);
+        REQUIRE(copy.GetCentroidCount() == 0);
+    }
+}
+
+TEST_CASE("TDigest rejects corrupted data", "[sketch]") {
+    std::vector<u8> data = GetDigest().Serialize();
+    TDigest copy{};
+
+    SECTION("Truncated header") {
+        data.resize(CentroidCountOffset);
+    }
+
+    SECTION("Truncated centroids") {
+        data.pop_back();
+    }
+
+    SECTION("Trailing bytes") {
+        data.push_back(0);
+    }
+
+    SECTION("Centroid count that overflows the size") {
+        data.resize(CentroidCountOffset + sizeof(u64));
+        Patch(data, CentroidCountOffset, u64{1} << 60);
+    }
+
+    SECTION("Compression that isn't positive") {
+        Patch(data, CompressionOffset, f64{0});
+    }
+
+    SECTION("Compression that isn't finite") {
+        Patch(data, CompressionOffset, std::numeric_limits<f64>::quiet_NaN());
+    }
+
+    SECTION("Minimum that isn't finite") {
+        Patch(data, MinOffset, -std::numeric_limits<f64>::infinity());
+    }
+
+    SECTION("Zero weight") {
+        Patch(data, WeightOffset, f64{0});
+    }
+
+    SECTION("Negative weight") {
+        Patch(data, WeightOffset, f64{-1});
+    }
+
+    SECTION("Weight that isn't finite") {
+        Patch(data, WeightOffset, std::numeric_limits<f64>::infinity());
+    }
+
+    SECTION("Weight that isn't a number") {
+        Patch(data, WeightOffset, std::numeric_limits<f64>::quiet_NaN());
+    }
+
+    SECTION("Mean that isn't a number") {
+        Patch(data, MeanOffset, std::numeric_limits<f64>::quiet_NaN());
+    }
+
+    SECTION("Unsorted means") {
+        Patch(data, MeanOffset, f64{-1});
+    }
+
+    REQUIRE_FALSE(copy.Deserialize(data));
+}
+
+TEST_CASE("TDigest merges the tail centroids", "[sketch]") {
+    // Centroids past the top of the scale used to stay apart, one per value
+    TDigest digest{};
+    for (int i = 0; i < 1000000; ++i) {
+        digest.Add(static_cast<f64>(i % 9973));
+    }
+    TDigest copy{};
+    REQUIRE(copy.Deserialize(digest.Serialize()));
+    REQUIRE(copy.GetCentroidCount() <= static_cast<std::size_t>(TDigest::DefaultCompression));
+}
+
+TEST_CASE("Merged TDigests match the exact quantiles", "[sketch]") {
+    // A month of hourly digests of a long tailed distribution, like the chart sketches
+    constexpr int BucketCount = 720;
+    constexpr int BucketValues = 120;
+    // Quantile, tolerance of the rank of the estimate and tolerance relative to the exact value
+    struct Tolerance {
+        f64 q;
+        f64 rank;
+        f64 relative;
+    };
+    constexpr std::array<Tolerance, 3> Tolerances{{
+        {0.5, 0.003, 0.01},
+        {0.95, 0.002, 0.025},
+        {0.99, 0.002, 0.06},
+    }};
+
+    std::mt19937 generator{17};
+    std::lognormal_distribution<f64> distribution{0, 1.5};
+    std::vector<f64> values{};
+    TDigest merged{};
+    bool is_deserialized = true;
+    for (int bucket = 0; bucket < BucketCount; ++bucket) {
+        TDigest digest{};
+        for (int i = 0; i < BucketValues; ++i) {
+            const f64 value = distribution(generator);
+            values.push_back(value);
+            digest.Add(value);
+        }
+        // Buckets are read back from the sketch file before they are merged
+        TDigest copy{};
+        is_deserialized = is_deserialized && copy.Deserialize(digest.Serialize());
+        merged.Merge(copy);
+    }
+    REQUIRE(is_deserialized);
+    std::sort(values.begin(), values.end());
+
+    REQUIRE(merged.GetCount() == static_cast<f64>(values.size()));
+    REQUIRE(merged.GetMin() == values.front());
+    REQUIRE(merged.GetMax() == values.back());
+    for (const Tolerance& tolerance : Tolerances) {
+        const f64 exact = values[static_cast<std::size_t>(
+            tolerance.q * static_cast<f64>(values.size() - 1))];
+        const f64 estimate = merged.Quantile(tolerance.q);
+        const auto rank = std::lower_bound(values.begin(), values.end(), estimate) - values.begin();
+        INFO("Quantile " << tolerance.q << ", exact " << exact << ", estimate " << estimate);
+        REQUIRE(static_cast<f64>(rank) / static_cast<f64>(values.size()) ==
+                Approx(tolerance.q).margin(tolerance.rank));
+        REQUIRE(estimate == Approx(exact).epsilon(tolerance.relative));
+    }
+}
+
+} // Anonymous namespace
+} // namespace Sketch
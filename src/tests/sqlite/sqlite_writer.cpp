@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "tests/database/fixture_database.h"
+#include "the_dude_to_human/sqlite/sqlite_writer.h"
+
+namespace Sqlite {
+namespace {
+
+using Rows = std::vector<std::vector<SqlValue>>;
+
+TEST_CASE("Sqlite writer rows read back", "[sqlite]") {
+    // The fixture only provides the temporary directory
+    const Tests::FixtureDatabase fixture{};
+    const std::filesystem::path path = fixture.GetPath().parent_path() / "writer.db";
+    const std::string table_name = "table \"one\"";
+
+    const std::array<SqlColumn, 5> columns{{
+        {"id", SqlType::Integer, true},
+        {"real value", SqlType::Real},
+        {"text", SqlType::Text},
+        {"blob", SqlType::Blob},
+        {"null", SqlType::Integer},
+    }};
+    const std::vector<u8> blob{0x00, 0xff, 0x10, 0x00};
+    const Rows rows{
+        {s64{-5}, 0.25, std::string{"it's \"quoted\""}, blob, std::monostate{}},
+        {s64{1}, -1e300, std::string{}, std::vector<u8>{}, s64{7}},
+        {s64{0x7fffffffffff}, 3.0, std::string{"line\r\nbreak"}, std::vector<u8>{1},
+         std::monostate{}},
+    };
+
+    {
+        SqliteWriter writer{path.string()};
+        REQUIRE(writer.InsertRow(table_name, rows[0]) == SQLITE_CANTOPEN);
+        REQUIRE(writer.OpenDatabase() == SQLITE_OK);
+        REQUIRE(writer.SetBulkLoad(true) == SQLITE_OK);
+        REQUIRE(writer.CreateTable(table_name, columns) == SQLITE_OK);
+        REQUIRE(writer.CreateTable(table_name, columns) != SQLITE_OK);
+
+        // Rows split in two transactions, the cached statement is reused after a failed insert
+        REQUIRE(writer.BeginTransaction() == SQLITE_OK);
+        REQUIRE(writer.InsertRow(table_name, rows[0]) == SQLITE_OK);
+        REQUIRE(writer.InsertRow(table_name, rows[1]) == SQLITE_OK);
+        REQUIRE(writer.CommitTransaction() == SQLITE_OK);
+        REQUIRE(writer.BeginTransaction() == SQLITE_OK);
+        REQUIRE(writer.InsertRow(table_name, rows[0]) == SQLITE_CONSTRAINT);
+        REQUIRE(writer.InsertRow(table_name, rows[2]) == SQLITE_OK);
+        REQUIRE(writer.CommitTransaction() == SQLITE_OK);
+
+        REQUIRE(writer.CreateIndex(table_name, "text") == SQLITE_OK);
+        REQUIRE(writer.SetBulkLoad(false) == SQLITE_OK);
+        writer.CloseDatabase();
+    }
+
+    REQUIRE(Tests::QueryRows(path, "SELECT * FROM \"table \"\"one\"\"\" ORDER BY id") ==
+            Rows{rows[0], rows[1], rows[2]});
+    REQUIRE(Tests::QueryRows(path, "SELECT name FROM pragma_table_info('table \"one\"')") ==
+            Rows{{std::string{"id"}},
+                 {std::string{"real value"}},
+                 {std::string{"text"}},
+                 {std::string{"blob"}},
+                 {std::string{"null"}}});
+    REQUIRE(Tests::QueryRows(path, "SELECT name FROM sqlite_master WHERE type = 'index'") ==
+            Rows{{std::string{"table \"one\"_idx_text"}}});
+}
+
+} // Anonymous namespace
+} // namespace Sqlite
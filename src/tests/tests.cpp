@@ -0,0 +1,7 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+// Catch provides the main function
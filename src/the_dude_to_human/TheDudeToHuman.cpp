@@ -1,9 +1,19 @@
 // SPDX-FileCopyrightText: Copyright 2024 Narr the Reg
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <optional>
 #include <regex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #ifdef _WIN32
 // windows.h needs to be included before shellapi.h
@@ -17,9 +27,20 @@
 #undef _UNICODE
 #include <getopt.h>
 
+#include "the_dude_to_human/database/dude_chart_archive.h"
+#include "the_dude_to_human/database/dude_chart_sketch.h"
+#include "the_dude_to_human/database/dude_chart_stats.h"
+#include "the_dude_to_human/database/dude_charts.h"
 #include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_labels.h"
+#include "the_dude_to_human/database/dude_outages.h"
+#include "the_dude_to_human/database/dude_rollup.h"
+#include "the_dude_to_human/database/dude_sla.h"
 #include "the_dude_to_human/database/dude_validator.h"
+#include "the_dude_to_human/gzip/gzip.h"
+#include "the_dude_to_human/mikrotik/database_cache.h"
 #include "the_dude_to_human/mikrotik/mikrotik_device.h"
+#include "the_dude_to_human/mikrotik/mikrotik_fleet.h"
 
 static void PrintVersion() {
     std::cout << "the dude to human version 1.0.0\n";
@@ -33,7 +54,36 @@ static void PrintHelp(const char* argv0) {
            "-f, --file                                 Load the specified database file\n"
            "-o, --out                                  Save json database file\n"
            "-c, --credentials                          Save credentials in plain text\n"
-           "-m, --mikrotik=user:password@address:port  Connect to the specified mikrotik device\n"
+           "-O, --out-dir                              Save arrow or csv tables into a directory\n"
+           "-t, --format=name                          Saved database format: json, msgpack,\n"
+           "                                           sqlite, arrow, csv, openmetrics\n"
+           "-b, --batch-size=rows                      Rows per record batch of arrow output\n"
+           "-a, --array-delimiter=text                 Separator of array entries in csv output\n"
+           "-g, --charts=dir                           Save chart values as one csv per source\n"
+           "-V, --values=source[:start[:end]]          Print raw chart values of a source\n"
+           "-L, --labeled=file                         Save labeled chart values as arrow stream\n"
+           "-r, --rollup=file                          Recompute chart aggregates from raw values\n"
+           "-A, --archive=file                         Save chart values in a compressed archive\n"
+           "-B, --bench-archive                        Compare archive decode speed with sqlite\n"
+           "-s, --sketches=file                        Save chart percentile sketches of the\n"
+           "                                           loaded database, replacing file. When no\n"
+           "                                           database is loaded it is only read by\n"
+           "                                           --percentiles\n"
+           "-p, --percentiles=source[:start[:end]]     Print sketch percentiles of a source\n"
+           "-u, --outages=start[:end]                  Print outages overlapping a time or window\n"
+           "-R, --report=chart-stats|sla               Print a report of the database\n"
+           "-P, --period=start:end                     Time window of the sla report\n"
+           "-T, --threshold=value                      Value counted by chart-stats crossings\n"
+           "-m, --mikrotik=user:password@address:port  Download the database of a mikrotik device\n"
+           "-F, --fleet=file                           Download every device listed in file\n"
+           "-j, --jobs=count                           Devices downloaded at the same time\n"
+           "-w, --timeout=seconds                      Seconds without answer before giving up\n"
+           "-C, --cache=dir                            Download databases only when they changed\n"
+           "-U, --restore=file                         Restore database on the --mikrotik device\n"
+           "-x, --execute=command                      Repeatable command run instead of download\n"
+           "-n, --count=times                          Times --execute runs per session\n"
+           "-i, --interval=seconds                     Seconds between --execute runs\n"
+           "-k, --api                                  Run --execute through the RouterOS api\n"
            //"-d, --database=user:password@address:port  Connect to the specified database\n"
            "-h, --help                                 Display this help and exit\n"
            "-v, --version                              Print tool version\n";
@@ -53,6 +103,133 @@ static void PrintAddressFormats() {
     // clang-format on
 }
 
+enum class ReportType {
+    ChartStats,
+    Sla,
+};
+
+static bool ParseReportType(const std::string& name, ReportType& report) {
+    if (name == "chart-stats") {
+        report = ReportType::ChartStats;
+        return true;
+    }
+    if (name == "sla") {
+        report = ReportType::Sla;
+        return true;
+    }
+    return false;
+}
+
+// Parses start[:end], a single time matches the outages in progress at that time
+static bool ParseTimeWindow(const std::string& window, u32& start_time, u32& end_time) {
+    const std::regex re("^([0-9]+)(?::([0-9]+))?$");
+    std::smatch match;
+    if (!std::regex_match(window, match, re)) {
+        return false;
+    }
+    start_time = static_cast<u32>(std::strtoul(match[1].str().c_str(), nullptr, 10));
+    end_time = match[2].matched
+                   ? static_cast<u32>(std::strtoul(match[2].str().c_str(), nullptr, 10))
+                   : start_time;
+    return start_time <= end_time;
+}
+
+// Parses source[:start[:end]], times are unix timestamps
+static bool ParseSourceQuery(const std::string& query, u32& source_id, u32& start_time,
+                             u32& end_time) {
+    const std::regex re("^([0-9]+)(?::([0-9]+))?(?::([0-9]+))?$");
+    std::smatch match;
+    if (!std::regex_match(query, match, re)) {
+        return false;
+    }
+    source_id = static_cast<u32>(std::strtoul(match[1].str().c_str(), nullptr, 10));
+    start_time = match[2].matched
+                     ? static_cast<u32>(std::strtoul(match[2].str().c_str(), nullptr, 10))
+                     : 0;
+    end_time = match[3].matched
+                   ? static_cast<u32>(std::strtoul(match[3].str().c_str(), nullptr, 10))
+                   : std::numeric_limits<u32>::max();
+    return start_time <= end_time;
+}
+
+static bool ParseExportFormat(const std::string& name, Database::ExportFormat& format) {
+    if (name == "json") {
+        format = Database::ExportFormat::Json;
+        return true;
+    }
+    if (name == "msgpack") {
+        format = Database::ExportFormat::Msgpack;
+        return true;
+    }
+    if (name == "sqlite") {
+        format = Database::ExportFormat::Sqlite;
+        return true;
+    }
+    if (name == "arrow") {
+        format = Database::ExportFormat::Arrow;
+        return true;
+    }
+    if (name == "csv") {
+        format = Database::ExportFormat::Csv;
+        return true;
+    }
+    if (name == "openmetrics") {
+        format = Database::ExportFormat::OpenMetrics;
+        return true;
+    }
+    return false;
+}
+
+// Directory outputs are reported as the sum of their files
+static std::uintmax_t GetOutputSize(const std::string& path) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(path, ec)) {
+        const auto size = std::filesystem::file_size(path, ec);
+        return ec ? 0 : size;
+    }
+
+    std::uintmax_t size = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+        if (entry.is_regular_file(ec)) {
+            size += entry.file_size(ec);
+        }
+    }
+    return size;
+}
+
+// Reads a dude backup or a plain database to restore. The header of a backup is kept, a plain
+// database is left without one
+static bool ReadRestoreFile(const std::string& path, std::vector<u8>& database,
+                            std::vector<u8>& header) {
+    std::error_code ec;
+    const std::uintmax_t size = std::filesystem::file_size(path, ec);
+    std::ifstream file{path, std::ios::binary};
+    if (ec || !file.is_open()) {
+        return false;
+    }
+    std::vector<u8> data(size);
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size))) {
+        return false;
+    }
+
+    header.clear();
+    if (data.size() < 2 || data[0] != 0x1F || data[1] != 0x8B) {
+        database = std::move(data);
+        return true;
+    }
+
+    database.clear();
+    Gzip::Decompressor decompressor{};
+    if (!decompressor.Write(data, database) || !decompressor.IsFinished() ||
+        database.size() < Gzip::DudeHeaderSize) {
+        return false;
+    }
+    const auto header_end = database.begin() + static_cast<std::ptrdiff_t>(Gzip::DudeHeaderSize);
+    header.assign(database.begin(), header_end);
+    database.erase(database.begin(), header_end);
+    return true;
+}
+
 #ifdef _WIN32
 static std::string takePassword() {
     HANDLE std_input = GetStdHandle(STD_INPUT_HANDLE);
@@ -106,12 +283,59 @@ int main(int argc, char** argv) {
     bool has_out_filepath{};
     bool has_credentials{};
     std::string out_filepath{};
+    Database::ExportOptions export_options{};
+
+    bool has_charts_dir{};
+    std::string charts_dir{};
+
+    bool has_values_query{};
+    u32 values_source{};
+    u32 values_start{};
+    u32 values_end{};
+
+    bool has_labeled_filepath{};
+    std::string labeled_filepath{};
+
+    bool has_rollup_filepath{};
+    std::string rollup_filepath{};
+
+    bool has_archive_filepath{};
+    bool has_archive_bench{};
+    std::string archive_filepath{};
+
+    bool has_sketch_filepath{};
+    std::string sketch_filepath{};
+
+    bool has_percentile_query{};
+    u32 percentile_source{};
+    u32 percentile_start{};
+    u32 percentile_end{};
+
+    bool has_outage_query{};
+    u32 outage_start{};
+    u32 outage_end{};
+
+    bool has_report{};
+    ReportType report{};
+    f64 report_threshold{};
+    bool has_report_period{};
+    u32 report_start{};
+    u32 report_end{};
 
     bool has_mikrotik{};
-    std::string mikrotik_user{};
-    std::string mikrotik_password{};
-    std::string mikrotik_address{};
-    u16 mikrotik_port = {22};
+    Mikrotik::DeviceAddress mikrotik{};
+    u32 timeout_seconds{60};
+
+    bool has_fleet{};
+    std::string fleet_filepath{};
+    std::size_t fleet_jobs{4};
+    std::string cache_dir{};
+    bool has_restore_filepath{};
+    std::string restore_filepath{};
+    std::vector<std::string> commands{};
+    std::size_t command_rounds{1};
+    u32 command_interval{};
+    bool use_api{};
 
     bool has_database{};
     std::string database_user{};
@@ -123,8 +347,33 @@ int main(int argc, char** argv) {
         // clang-format off
         {"file", required_argument, 0, 'f'},
         {"out", required_argument, 0, 'o'},
+        {"out-dir", required_argument, 0, 'O'},
         {"credentials", no_argument, 0, 'c'},
+        {"format", required_argument, 0, 't'},
+        {"batch-size", required_argument, 0, 'b'},
+        {"array-delimiter", required_argument, 0, 'a'},
+        {"charts", required_argument, 0, 'g'},
+        {"values", required_argument, 0, 'V'},
+        {"labeled", required_argument, 0, 'L'},
+        {"rollup", required_argument, 0, 'r'},
+        {"archive", required_argument, 0, 'A'},
+        {"bench-archive", no_argument, 0, 'B'},
+        {"sketches", required_argument, 0, 's'},
+        {"percentiles", required_argument, 0, 'p'},
+        {"outages", required_argument, 0, 'u'},
+        {"report", required_argument, 0, 'R'},
+        {"threshold", required_argument, 0, 'T'},
+        {"period", required_argument, 0, 'P'},
         {"mikrotik", required_argument, 0, 'm'},
+        {"fleet", required_argument, 0, 'F'},
+        {"jobs", required_argument, 0, 'j'},
+        {"timeout", required_argument, 0, 'w'},
+        {"cache", required_argument, 0, 'C'},
+        {"restore", required_argument, 0, 'U'},
+        {"execute", required_argument, 0, 'x'},
+        {"count", required_argument, 0, 'n'},
+        {"interval", required_argument, 0, 'i'},
+        {"api", no_argument, 0, 'k'},
         //{"database", optional_argument, 0, 'd'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
@@ -133,7 +382,12 @@ int main(int argc, char** argv) {
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "f:o:cm:hv", long_options, &option_index);
+        int arg = getopt_long(argc, argv,
+                              "f:o:O:ct:b:a:"
+                              "g:V:L:r:A:Bs:p:u:R:T:P:"
+                              "m:F:j:w:C:U:x:n:i:k"
+                              "hv",
+                              long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'f': {
@@ -142,7 +396,8 @@ int main(int argc, char** argv) {
                 filepath = str_arg;
                 break;
             }
-            case 'o': {
+            case 'o':
+            case 'O': {
                 has_out_filepath = true;
                 const std::string str_arg(optarg);
                 out_filepath = str_arg;
@@ -151,6 +406,93 @@ int main(int argc, char** argv) {
             case 'c':
                 has_credentials = true;
                 break;
+            case 't':
+                if (!ParseExportFormat(optarg, export_options.format)) {
+                    std::cout << "Unknown format " << optarg << "\n";
+                    PrintHelp(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'b': {
+                const unsigned long long batch_size = std::strtoull(optarg, nullptr, 10);
+                if (batch_size == 0) {
+                    std::cout << "Wrong batch size " << optarg << "\n";
+                    return 0;
+                }
+                export_options.batch_size = static_cast<std::size_t>(batch_size);
+                break;
+            }
+            case 'a':
+                export_options.array_delimiter = optarg;
+                break;
+            case 'g':
+                has_charts_dir = true;
+                charts_dir = optarg;
+                break;
+            case 'V':
+                if (!ParseSourceQuery(optarg, values_source, values_start, values_end)) {
+                    std::cout << "Wrong format for option --values\n";
+                    PrintHelp(argv[0]);
+                    return 0;
+                }
+                has_values_query = true;
+                break;
+            case 'L':
+                has_labeled_filepath = true;
+                labeled_filepath = optarg;
+                break;
+            case 'r':
+                has_rollup_filepath = true;
+                rollup_filepath = optarg;
+                break;
+            case 'A':
+                has_archive_filepath = true;
+                archive_filepath = optarg;
+                break;
+            case 'B':
+                has_archive_bench = true;
+                break;
+            case 's':
+                has_sketch_filepath = true;
+                sketch_filepath = optarg;
+                break;
+            case 'p':
+                if (!ParseSourceQuery(optarg, percentile_source, percentile_start,
+                                      percentile_end)) {
+                    std::cout << "Wrong format for option --percentiles\n";
+                    PrintHelp(argv[0]);
+                    return 0;
+                }
+                has_percentile_query = true;
+                break;
+            case 'u':
+                if (!ParseTimeWindow(optarg, outage_start, outage_end)) {
+                    std::cout << "Wrong format for option --outages\n";
+                    PrintHelp(argv[0]);
+                    return 0;
+                }
+                has_outage_query = true;
+                break;
+            case 'R':
+                if (!ParseReportType(optarg, report)) {
+                    std::cout << "Unknown report " << optarg << "\n";
+                    PrintHelp(argv[0]);
+                    return 0;
+                }
+                has_report = true;
+                break;
+            case 'T':
+                report_threshold = std::strtod(optarg, nullptr);
+                break;
+            case 'P':
+                if (!ParseTimeWindow(optarg, report_start, report_end) ||
+                    report_start == report_end) {
+                    std::cout << "Wrong format for option --period\n";
+                    PrintHelp(argv[0]);
+                    return 0;
+                }
+                has_report_period = true;
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -159,36 +501,47 @@ int main(int argc, char** argv) {
                 return 0;
             case 'm': {
                 has_mikrotik = true;
-                const std::string str_arg(optarg);
-                // regex to check if the format is user:password@ip:port
-                // with optional :password :port
-                const std::regex re("^([^:]+)(:(.+)?)?@([^:]+)(?::([0-9]+))?$");
-
-                std::smatch match;
-                if (!std::regex_match(str_arg, match, re) || match.size() != 6) {
+                if (!Mikrotik::ParseDeviceAddress(optarg, mikrotik)) {
                     std::cout << "Wrong format for option --mikrotik\n";
                     PrintAddressFormats();
                     PrintHelp(argv[0]);
                     return 0;
                 }
-
-                mikrotik_user = match[1];
-                mikrotik_password = match[3];
-                mikrotik_address = match[4];
-                if (!match[5].str().empty()) {
-                    mikrotik_port =
-                        static_cast<u16>(std::strtoul(match[5].str().c_str(), nullptr, 0));
-                }
-                if (mikrotik_address.empty()) {
-                    std::cout << "Address to mikrotik device must not be empty.\n";
-                    return 0;
-                }
-                if (match[2].length() != 0 && mikrotik_password.empty()) {
+                if (mikrotik.has_hidden_password) {
                     std::cout << "Enter Mikrotik password: ";
-                    mikrotik_password = takePassword();
+                    mikrotik.password = takePassword();
                 }
                 break;
             }
+            case 'F':
+                has_fleet = true;
+                fleet_filepath = optarg;
+                break;
+            case 'j':
+                fleet_jobs = std::max<std::size_t>(std::strtoull(optarg, nullptr, 0), 1);
+                break;
+            case 'w':
+                timeout_seconds = static_cast<u32>(std::strtoul(optarg, nullptr, 0));
+                break;
+            case 'C':
+                cache_dir = optarg;
+                break;
+            case 'U':
+                has_restore_filepath = true;
+                restore_filepath = optarg;
+                break;
+            case 'x':
+                commands.push_back(optarg);
+                break;
+            case 'n':
+                command_rounds = std::max<std::size_t>(std::strtoull(optarg, nullptr, 0), 1);
+                break;
+            case 'i':
+                command_interval = static_cast<u32>(std::strtoul(optarg, nullptr, 0));
+                break;
+            case 'k':
+                use_api = true;
+                break;
             case 'd': {
                 has_database = true;
                 const std::string str_arg(optarg);
@@ -215,9 +568,9 @@ int main(int argc, char** argv) {
                     std::cout << "Address to database device must not be empty.\n";
                     return 0;
                 }
-                if (match[2].length() != 0 && mikrotik_password.empty()) {
+                if (match[2].length() != 0 && database_password.empty()) {
                     std::cout << "Enter database password: ";
-                    mikrotik_password = takePassword();
+                    database_password = takePassword();
                 }
                 break;
             }
@@ -229,34 +582,239 @@ int main(int argc, char** argv) {
         }
     }
 
-    if (!has_filepath && !has_mikrotik && !has_database) {
+    if (has_report && report == ReportType::Sla && !has_report_period) {
+        std::cout << "Report sla requires --period\n";
+        return 0;
+    }
+
+    if (has_percentile_query && !has_sketch_filepath) {
+        std::cout << "Option --percentiles requires --sketches\n";
+        return 0;
+    }
+
+    if (has_archive_bench && !has_archive_filepath) {
+        std::cout << "Option --bench-archive requires --archive\n";
+        return 0;
+    }
+
+    if (has_restore_filepath && !has_mikrotik) {
+        std::cout << "Option --restore requires --mikrotik\n";
+        return 0;
+    }
+
+    const Mikrotik::FleetCommandOptions command_options{
+        .commands = commands,
+        .out_dir = has_out_filepath ? out_filepath : "",
+        .timeout_ms = timeout_seconds * 1000,
+        .rounds = command_rounds,
+        .interval_s = command_interval,
+        .use_api = use_api,
+    };
+
+    if (has_fleet) {
+        std::vector<Mikrotik::DeviceAddress> hosts{};
+        if (Mikrotik::ReadFleetHosts(fleet_filepath, hosts) != 0) {
+            std::cout << "Unable to read hosts " << fleet_filepath << "\n";
+            return 0;
+        }
+        for (Mikrotik::DeviceAddress& host : hosts) {
+            if (host.has_hidden_password) {
+                std::cout << "Enter password of " << host.user << "@" << host.address << ": ";
+                host.password = takePassword();
+            }
+        }
+
+        if (!commands.empty()) {
+            Mikrotik::RunFleetCommand(hosts, command_options);
+            return 0;
+        }
+
+        const Mikrotik::FleetOptions fleet_options{
+            .out_dir = has_out_filepath ? out_filepath : "",
+            .has_credentials = has_credentials,
+            .export_options = export_options,
+            .jobs = fleet_jobs,
+            .timeout_ms = timeout_seconds * 1000,
+            .cache_dir = cache_dir,
+        };
+        Mikrotik::RunFleet(hosts, fleet_options);
+        return 0;
+    }
+
+    if (!has_filepath && !has_mikrotik && !has_database && !has_percentile_query) {
         PrintHelp(argv[0]);
         return 0;
     }
 
-    if (has_mikrotik) {
-        std::cout << "Conecting to " << mikrotik_address << ":" << mikrotik_port << "\n";
-        Mikrotik::MikrotikDevice device = {mikrotik_address, mikrotik_port};
-        if (!device.Connect(mikrotik_user, mikrotik_password)) {
+    if (has_mikrotik && !commands.empty()) {
+        Mikrotik::RunFleetCommand({mikrotik}, command_options);
+        return 0;
+    }
+
+    if (has_mikrotik && has_restore_filepath) {
+        std::vector<u8> database_data{};
+        std::vector<u8> header{};
+        std::cout << "Reading database " << restore_filepath << "\n";
+        if (!ReadRestoreFile(restore_filepath, database_data, header)) {
+            std::cout << "Unable to read database " << restore_filepath << "\n";
+            return 0;
+        }
+        std::cout << "Conecting to " << mikrotik.address << ":" << mikrotik.port << "\n";
+        Mikrotik::MikrotikDevice device = {mikrotik.address, mikrotik.port};
+        device.SetTimeout(timeout_seconds * 1000);
+        if (!device.Connect(mikrotik.user, mikrotik.password)) {
             std::cout << "Unable to connect to device\n";
             return 0;
         }
-        std::string output{};
-        std::cout << "Executing command 'system health print;'\n";
-        device.Execute("system health print;", &output);
-        std::cout << output;
+        std::cout << "Uploading database\n";
+        if (!device.UploadDatabase(database_data, header)) {
+            std::cout << "Unable to restore database\n";
+            return 0;
+        }
         device.Disconnect();
+        return 0;
     }
 
-    if (has_filepath) {
+    std::optional<Database::DudeDatabase> database{};
+
+    if (has_mikrotik) {
+        std::cout << "Conecting to " << mikrotik.address << ":" << mikrotik.port << "\n";
+        Mikrotik::MikrotikDevice device = {mikrotik.address, mikrotik.port};
+        device.SetTimeout(timeout_seconds * 1000);
+        if (!device.Connect(mikrotik.user, mikrotik.password)) {
+            std::cout << "Unable to connect to device\n";
+            return 0;
+        }
+        std::vector<u8> database_data{};
+        std::cout << "Downloading database\n";
+        if (cache_dir.empty()) {
+            if (!device.DownloadDatabase(database_data)) {
+                std::cout << "Unable to download database\n";
+                return 0;
+            }
+        } else {
+            const Mikrotik::DatabaseCache cache{std::filesystem::path{cache_dir} /
+                                                (Mikrotik::GetHostName(mikrotik) + ".db")};
+            const Mikrotik::SyncResult result =
+                Mikrotik::SyncDatabase(device, cache, database_data, true);
+            if (result == Mikrotik::SyncResult::Failed) {
+                std::cout << "Unable to download database\n";
+                return 0;
+            }
+            if (result == Mikrotik::SyncResult::Unchanged) {
+                std::cout << "Database unchanged, using cached copy\n";
+            }
+        }
+        device.Disconnect();
+        database.emplace(mikrotik.address + ".db", std::move(database_data));
+    } else if (has_filepath) {
         std::cout << "Reading database " << filepath << "\n";
-        Database::DudeDatabase db{filepath};
+        database.emplace(filepath);
+    }
+
+    if (database) {
+        Database::DudeDatabase& db = *database;
         db.ListMapData();
         db.ListDeviceData();
 
         if (has_out_filepath) {
             std::cout << "Saving database " << out_filepath << "\n";
-            db.SaveDatabase(out_filepath, has_credentials);
+            const auto start_time = std::chrono::steady_clock::now();
+            if (db.SaveDatabase(out_filepath, has_credentials, export_options) != 0) {
+                std::cout << "Unable to save database " << out_filepath << "\n";
+                return 0;
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time);
+            std::cout << "Saved " << GetOutputSize(out_filepath) << " bytes in "
+                      << elapsed.count() << " ms\n";
+        }
+
+        if (has_charts_dir) {
+            std::cout << "Saving chart values " << charts_dir << "\n";
+            if (Database::ExportChartValuesCsv(&db, charts_dir) != 0) {
+                std::cout << "Unable to save chart values " << charts_dir << "\n";
+                return 0;
+            }
+        }
+
+        if (has_values_query) {
+            if (Database::PrintChartValues(&db, values_source, values_start, values_end) != 0) {
+                std::cout << "Unable to read chart values\n";
+                return 0;
+            }
+        }
+
+        if (has_labeled_filepath) {
+            std::cout << "Saving labeled chart values " << labeled_filepath << "\n";
+            if (Database::ExportLabeledChartValues(&db, labeled_filepath,
+                                                   export_options.batch_size) != 0) {
+                std::cout << "Unable to save labeled chart values " << labeled_filepath << "\n";
+                return 0;
+            }
+        }
+
+        if (has_rollup_filepath) {
+            std::cout << "Saving chart rollup " << rollup_filepath << "\n";
+            const auto start_time = std::chrono::steady_clock::now();
+            if (Database::RollupChartValues(&db, rollup_filepath) != 0) {
+                std::cout << "Unable to save chart rollup " << rollup_filepath << "\n";
+                return 0;
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time);
+            std::cout << "Saved chart rollup in " << elapsed.count() << " ms\n";
+        }
+
+        if (has_archive_filepath) {
+            std::cout << "Saving chart archive " << archive_filepath << "\n";
+            if (Database::WriteChartArchive(&db, archive_filepath) != 0) {
+                std::cout << "Unable to save chart archive " << archive_filepath << "\n";
+                return 0;
+            }
+            if (has_archive_bench &&
+                Database::BenchmarkChartArchive(&db, archive_filepath) != 0) {
+                std::cout << "Chart archive doesn't match the database\n";
+                return 0;
+            }
+        }
+
+        if (has_outage_query) {
+            if (Database::PrintOutages(&db, outage_start, outage_end) != 0) {
+                std::cout << "Unable to read outages\n";
+                return 0;
+            }
+        }
+
+        if (has_report && report == ReportType::ChartStats) {
+            if (Database::PrintChartStatsReport(&db, report_threshold) != 0) {
+                std::cout << "Unable to read chart values\n";
+                return 0;
+            }
+        }
+
+        if (has_report && report == ReportType::Sla) {
+            if (Database::PrintSlaReport(&db, report_start, report_end) != 0) {
+                std::cout << "Unable to read outages\n";
+                return 0;
+            }
+        }
+
+        if (has_sketch_filepath) {
+            std::cout << "Saving percentile sketches " << sketch_filepath << "\n";
+            if (Database::WriteChartSketches(&db, sketch_filepath) != 0) {
+                std::cout << "Unable to save percentile sketches " << sketch_filepath << "\n";
+                return 0;
+            }
+        }
+    }
+
+    // Sketches are queried without rereading the database
+    if (has_percentile_query) {
+        if (Database::PrintChartPercentiles(sketch_filepath, percentile_source, percentile_start,
+                                            percentile_end) != 0) {
+            std::cout << "Unable to read percentile sketches " << sketch_filepath << "\n";
+            return 0;
         }
     }
 }
@@ -0,0 +1,278 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#include "common/swap.h"
+#include "the_dude_to_human/archive/gorilla.h"
+
+namespace Archive {
+namespace {
+
+u64 GetMask(u32 bit_count) {
+    return bit_count == 64 ? ~u64{0} : (u64{1} << bit_count) - 1;
+}
+
+// Appends bits most significant first
+class BitWriter {
+public:
+    void Write(u64 value, u32 bit_count) {
+        for (u32 written = 0; written < bit_count;) {
+            const u32 free_bits = 64 - used_bits;
+            const u32 chunk = std::min(free_bits, bit_count - written);
+            const u32 shift = bit_count - written - chunk;
+            const u64 bits = (value >> shift) & GetMask(chunk);
+
+            current = chunk == 64 ? bits : (current << chunk) | bits;
+            used_bits += chunk;
+            written += chunk;
+            if (used_bits == 64) {
+                FlushWord();
+            }
+        }
+    }
+
+    void WriteBit(bool bit) {
+        Write(bit ? 1 : 0, 1);
+    }
+
+    std::vector<u8> Finish() {
+        if (used_bits != 0) {
+            current <<= 64 - used_bits;
+            const u32 byte_count = (used_bits + 7) / 8;
+            for (u32 i = 0; i < byte_count; ++i) {
+                data.push_back(static_cast<u8>(current >> (56 - i * 8)));
+            }
+        }
+        return std::move(data);
+    }
+
+private:
+    void FlushWord() {
+        for (u32 i = 0; i < 8; ++i) {
+            data.push_back(static_cast<u8>(current >> (56 - i * 8)));
+        }
+        current = 0;
+        used_bits = 0;
+    }
+
+    std::vector<u8> data{};
+    u64 current{};
+    u32 used_bits{};
+};
+
+// Reads bits most significant first. Reads past the end return zeros and set the overflow flag
+class BitReader {
+public:
+    explicit BitReader(std::span<const u8> data_) : data{data_} {}
+
+    u64 Read(u32 bit_count) {
+        u64 value = 0;
+        while (bit_count != 0) {
+            if (available_bits == 0) {
+                Refill();
+            }
+            const u32 chunk = std::min(available_bits, bit_count);
+            const u64 bits = (buffer >> (available_bits - chunk)) & GetMask(chunk);
+            value = chunk == 64 ? bits : (value << chunk) | bits;
+            available_bits -= chunk;
+            bit_count -= chunk;
+        }
+        return value;
+    }
+
+    bool ReadBit() {
+        return Read(1) != 0;
+    }
+
+    // Counts up to max_ones consecutive set bits, consuming the terminating zero if found
+    u32 ReadPrefix(u32 max_ones) {
+        u32 ones = 0;
+        while (ones < max_ones && ReadBit()) {
+            ones++;
+        }
+        return ones;
+    }
+
+    bool HasOverflow() const {
+        return has_overflow;
+    }
+
+private:
+    void Refill() {
+        // Loads a whole word when possible, the tail is loaded byte by byte
+        if (offset + 8 <= data.size()) {
+            u64 word{};
+            std::memcpy(&word, data.data() + offset, sizeof(word));
+            buffer = Common::swap64(word);
+            offset += 8;
+            available_bits = 64;
+            return;
+        }
+        if (offset < data.size()) {
+            buffer = data[offset++];
+            available_bits = 8;
+            return;
+        }
+        buffer = 0;
+        available_bits = 64;
+        has_overflow = true;
+    }
+
+    std::span<const u8> data;
+    std::size_t offset{};
+    u64 buffer{};
+    u32 available_bits{};
+    bool has_overflow{};
+};
+
+struct DeltaRange {
+    u32 prefix_bits;
+    u32 prefix;
+    u32 value_bits;
+};
+
+// Prefix codes for the delta of deltas. Deltas of u32 times may need 33 bits so the last range
+// stores the whole value
+constexpr std::array<DeltaRange, 4> DeltaRanges{{
+    {2, 0b10, 7},
+    {3, 0b110, 9},
+    {4, 0b1110, 12},
+    {4, 0b1111, 64},
+}};
+
+void WriteDeltaOfDelta(BitWriter& writer, s64 delta_of_delta) {
+    if (delta_of_delta == 0) {
+        writer.WriteBit(false);
+        return;
+    }
+
+    for (const DeltaRange& range : DeltaRanges) {
+        const s64 limit = s64{1} << (std::min(range.value_bits, 63U) - 1);
+        if (range.value_bits == 64 || (delta_of_delta >= -limit && delta_of_delta < limit)) {
+            writer.Write(range.prefix, range.prefix_bits);
+            writer.Write(static_cast<u64>(delta_of_delta) & GetMask(range.value_bits),
+                         range.value_bits);
+            return;
+        }
+    }
+}
+
+s64 ReadDeltaOfDelta(BitReader& reader) {
+    const u32 ones = reader.ReadPrefix(4);
+    if (ones == 0) {
+        return 0;
+    }
+
+    const u32 value_bits = DeltaRanges[ones - 1].value_bits;
+    const u64 raw = reader.Read(value_bits);
+    // Sign extend
+    const u64 sign_bit = u64{1} << (value_bits - 1);
+    return static_cast<s64>((raw ^ sign_bit) - sign_bit);
+}
+
+} // Anonymous namespace
+
+std::vector<u8> EncodeSeries(std::span<const u32> times, std::span<const f64> values) {
+    BitWriter writer{};
+    if (times.empty()) {
+        return writer.Finish();
+    }
+
+    writer.Write(times[0], 32);
+    writer.Write(std::bit_cast<u64>(values[0]), 64);
+
+    s64 previous_delta = 0;
+    u64 previous_value = std::bit_cast<u64>(values[0]);
+    u32 previous_leading = 65;
+    u32 previous_trailing = 0;
+
+    for (std::size_t i = 1; i < times.size(); ++i) {
+        const s64 delta = static_cast<s64>(times[i]) - static_cast<s64>(times[i - 1]);
+        WriteDeltaOfDelta(writer, delta - previous_delta);
+        previous_delta = delta;
+
+        const u64 value = std::bit_cast<u64>(values[i]);
+        const u64 xor_value = value ^ previous_value;
+        previous_value = value;
+
+        if (xor_value == 0) {
+            writer.WriteBit(false);
+            continue;
+        }
+        writer.WriteBit(true);
+
+        const u32 leading = std::min<u32>(std::countl_zero(xor_value), 31);
+        const u32 trailing = std::countr_zero(xor_value);
+
+        // Reuse the previous meaningful bit window when the value fits inside it
+        if (previous_leading <= leading && previous_trailing <= trailing) {
+            writer.WriteBit(false);
+            writer.Write(xor_value >> previous_trailing, 64 - previous_leading - previous_trailing);
+            continue;
+        }
+
+        const u32 meaningful_bits = 64 - leading - trailing;
+        writer.WriteBit(true);
+        writer.Write(leading, 5);
+        // 64 meaningful bits doesn't fit in 6 bits, it's stored as 0
+        writer.Write(meaningful_bits & 0x3f, 6);
+        writer.Write(xor_value >> trailing, meaningful_bits);
+        previous_leading = leading;
+        previous_trailing = trailing;
+    }
+
+    return writer.Finish();
+}
+
+bool DecodeSeries(std::span<const u8> data, std::size_t count, std::vector<u32>& times,
+                  std::vector<f64>& values) {
+    times.clear();
+    values.clear();
+    if (count == 0) {
+        return true;
+    }
+    times.reserve(count);
+    values.reserve(count);
+
+    BitReader reader{data};
+    u32 time = static_cast<u32>(reader.Read(32));
+    u64 value = reader.Read(64);
+    times.push_back(time);
+    values.push_back(std::bit_cast<f64>(value));
+
+    s64 delta = 0;
+    u32 leading = 0;
+    u32 trailing = 0;
+
+    for (std::size_t i = 1; i < count; ++i) {
+        delta += ReadDeltaOfDelta(reader);
+        time = static_cast<u32>(static_cast<s64>(time) + delta);
+
+        if (reader.ReadBit()) {
+            if (reader.ReadBit()) {
+                leading = static_cast<u32>(reader.Read(5));
+                u32 meaningful_bits = static_cast<u32>(reader.Read(6));
+                if (meaningful_bits == 0) {
+                    meaningful_bits = 64;
+                }
+                // Corrupted data, the shift below would be out of range
+                if (leading + meaningful_bits > 64) {
+                    return false;
+                }
+                trailing = 64 - leading - meaningful_bits;
+            }
+            value ^= reader.Read(64 - leading - trailing) << trailing;
+        }
+
+        times.push_back(time);
+        values.push_back(std::bit_cast<f64>(value));
+    }
+
+    return !reader.HasOverflow();
+}
+
+} // namespace Archive
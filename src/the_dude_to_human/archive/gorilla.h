@@ -0,0 +1,25 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Archive {
+
+// Time series compression described in "Gorilla: A Fast, Scalable, In-Memory Time Series
+// Database". Timestamps are stored as delta of deltas and values as the xor with the previous
+// value, both with variable length prefixes. Regular sampling compresses to about 1-2 bytes per
+// point
+
+// Encodes times and values, both spans must have the same length. Times must be increasing
+std::vector<u8> EncodeSeries(std::span<const u32> times, std::span<const f64> values);
+
+// Decodes count points from data. Returns false if data is truncated or corrupted
+bool DecodeSeries(std::span<const u8> data, std::size_t count, std::vector<u32>& times,
+                  std::vector<f64>& values);
+
+} // namespace Archive
@@ -0,0 +1,590 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include "the_dude_to_human/arrow/arrow_writer.h"
+
+namespace Arrow {
+namespace {
+
+// Values from the Arrow flatbuffer schemas (Schema.fbs and Message.fbs)
+constexpr s16 MetadataVersionV5 = 4;
+constexpr u8 MessageHeaderSchema = 1;
+constexpr u8 MessageHeaderDictionaryBatch = 2;
+constexpr u8 MessageHeaderRecordBatch = 3;
+constexpr u8 TypeInt = 2;
+constexpr u8 TypeFloatingPoint = 3;
+constexpr u8 TypeBinary = 4;
+constexpr u8 TypeUtf8 = 5;
+constexpr u8 TypeBool = 6;
+constexpr u8 TypeTimestamp = 10;
+constexpr u8 TypeList = 12;
+constexpr u8 TypeFixedSizeBinary = 15;
+constexpr s16 PrecisionDouble = 2;
+constexpr u32 ContinuationMarker = 0xFFFFFFFF;
+constexpr std::size_t BodyAlignment = 8;
+
+// Minimal flatbuffer builder. Like the reference implementation the buffer is filled from the
+// back, so children must be created before the tables referencing them. Offsets are measured
+// from the end of the buffer
+class FlatBufferBuilder {
+public:
+    FlatBufferBuilder() : buffer(0x400), head{buffer.size()} {}
+
+    std::size_t GetSize() const {
+        return buffer.size() - head;
+    }
+
+    template <typename T>
+    void AddScalar(u16 field_id, T value) {
+        Prep(sizeof(T), 0);
+        Push(value);
+        table_fields.emplace_back(field_id, static_cast<u32>(GetSize()));
+    }
+
+    void AddOffset(u16 field_id, u32 offset) {
+        PushOffset(offset);
+        table_fields.emplace_back(field_id, static_cast<u32>(GetSize()));
+    }
+
+    void StartTable() {
+        table_fields.clear();
+        table_start = GetSize();
+    }
+
+    u32 EndTable() {
+        Prep(sizeof(s32), 0);
+        Push<s32>(0);
+        const u32 object_offset = static_cast<u32>(GetSize());
+
+        u16 field_count = 0;
+        for (const auto& [field_id, offset] : table_fields) {
+            field_count = std::max<u16>(field_count, static_cast<u16>(field_id + 1));
+        }
+
+        std::vector<u16> field_offsets(field_count);
+        for (const auto& [field_id, offset] : table_fields) {
+            field_offsets[field_id] = static_cast<u16>(object_offset - offset);
+        }
+
+        for (std::size_t i = field_offsets.size(); i > 0; --i) {
+            Push(field_offsets[i - 1]);
+        }
+        Push(static_cast<u16>(object_offset - table_start));
+        Push(static_cast<u16>((field_count + 2) * sizeof(u16)));
+
+        // The table points back to its vtable which is stored right before it
+        const s32 vtable_distance = static_cast<s32>(GetSize() - object_offset);
+        std::memcpy(buffer.data() + buffer.size() - object_offset, &vtable_distance,
+                    sizeof(s32));
+
+        table_fields.clear();
+        return object_offset;
+    }
+
+    u32 CreateString(std::string_view text) {
+        Prep(sizeof(u32), text.size() + 1);
+        Push<u8>(0);
+        for (std::size_t i = text.size(); i > 0; --i) {
+            Push(static_cast<u8>(text[i - 1]));
+        }
+        Push(static_cast<u32>(text.size()));
+        return static_cast<u32>(GetSize());
+    }
+
+    u32 CreateOffsetVector(std::span<const u32> offsets) {
+        StartVector(offsets.size(), sizeof(u32), sizeof(u32));
+        for (std::size_t i = offsets.size(); i > 0; --i) {
+            PushOffset(offsets[i - 1]);
+        }
+        return EndVector(offsets.size());
+    }
+
+    // Arrow FieldNode and Buffer are both structs of two int64
+    u32 CreateStructVector(std::span<const std::pair<s64, s64>> entries) {
+        StartVector(entries.size(), sizeof(s64) * 2, sizeof(s64));
+        for (std::size_t i = entries.size(); i > 0; --i) {
+            Push(entries[i - 1].second);
+            Push(entries[i - 1].first);
+        }
+        return EndVector(entries.size());
+    }
+
+    std::span<const u8> Finish(u32 root) {
+        Prep(min_align, sizeof(u32));
+        PushOffset(root);
+        return {buffer.data() + head, GetSize()};
+    }
+
+private:
+    void StartVector(std::size_t count, std::size_t element_size, std::size_t alignment) {
+        Prep(sizeof(u32), count * element_size);
+        Prep(alignment, count * element_size);
+    }
+
+    u32 EndVector(std::size_t count) {
+        Push(static_cast<u32>(count));
+        return static_cast<u32>(GetSize());
+    }
+
+    void PushOffset(u32 offset) {
+        Prep(sizeof(u32), 0);
+        Push(static_cast<u32>(GetSize() - offset + sizeof(u32)));
+    }
+
+    // Pads the buffer so it's aligned after writing additional_bytes
+    void Prep(std::size_t alignment, std::size_t additional_bytes) {
+        min_align = std::max(min_align, alignment);
+        while ((GetSize() + additional_bytes) % alignment != 0) {
+            Push<u8>(0);
+        }
+    }
+
+    template <typename T>
+    void Push(T value) {
+        if (head < sizeof(T)) {
+            Grow();
+        }
+        head -= sizeof(T);
+        std::memcpy(buffer.data() + head, &value, sizeof(T));
+    }
+
+    void Grow() {
+        const std::size_t size = GetSize();
+        std::vector<u8> new_buffer(buffer.size() * 2);
+        std::memcpy(new_buffer.data() + new_buffer.size() - size, buffer.data() + head, size);
+        head = new_buffer.size() - size;
+        buffer = std::move(new_buffer);
+    }
+
+    std::vector<u8> buffer;
+    std::size_t head;
+    std::size_t min_align{1};
+    std::size_t table_start{};
+    std::vector<std::pair<u16, u32>> table_fields{};
+};
+
+// Nodes and buffers of a record batch along with its body
+struct BatchBody {
+    std::vector<u8> data{};
+    std::vector<std::pair<s64, s64>> nodes{};
+    std::vector<std::pair<s64, s64>> buffers{};
+
+    void AddNode(std::size_t length) {
+        nodes.emplace_back(static_cast<s64>(length), 0);
+    }
+
+    void AddBuffer(const void* buffer_data, std::size_t size) {
+        const std::size_t offset = data.size();
+        const u8* bytes = static_cast<const u8*>(buffer_data);
+        data.insert(data.end(), bytes, bytes + size);
+        data.resize((data.size() + BodyAlignment - 1) / BodyAlignment * BodyAlignment);
+        buffers.emplace_back(static_cast<s64>(offset), static_cast<s64>(size));
+    }
+};
+
+std::pair<u8, u32> CreateType(FlatBufferBuilder& fbb, const Column& column) {
+    const auto create_int = [&fbb](s32 bit_width, bool is_signed) {
+        fbb.StartTable();
+        fbb.AddScalar<s32>(0, bit_width);
+        fbb.AddScalar<u8>(1, is_signed ? 1 : 0);
+        return std::make_pair(TypeInt, fbb.EndTable());
+    };
+    const auto create_empty = [&fbb](u8 type) {
+        fbb.StartTable();
+        return std::make_pair(type, fbb.EndTable());
+    };
+
+    switch (column.GetType()) {
+    case ColumnType::Bool:
+        return create_empty(TypeBool);
+    case ColumnType::UInt8:
+        return create_int(8, false);
+    case ColumnType::Int32:
+        return create_int(32, true);
+    case ColumnType::UInt32:
+        return create_int(32, false);
+    case ColumnType::UInt64:
+        return create_int(64, false);
+    case ColumnType::Float64:
+        fbb.StartTable();
+        fbb.AddScalar<s16>(0, PrecisionDouble);
+        return std::make_pair(TypeFloatingPoint, fbb.EndTable());
+    case ColumnType::Timestamp:
+        // Unit defaults to seconds
+        fbb.StartTable();
+        fbb.AddScalar<s16>(0, 0);
+        return std::make_pair(TypeTimestamp, fbb.EndTable());
+    case ColumnType::FixedSizeBinary:
+        fbb.StartTable();
+        fbb.AddScalar<s32>(0, column.GetByteWidth());
+        return std::make_pair(TypeFixedSizeBinary, fbb.EndTable());
+    case ColumnType::Binary:
+        return create_empty(TypeBinary);
+    case ColumnType::Utf8:
+    case ColumnType::DictionaryUtf8:
+        return create_empty(TypeUtf8);
+    case ColumnType::List:
+        return create_empty(TypeList);
+    }
+    return create_empty(TypeBinary);
+}
+
+} // Anonymous namespace
+
+Column::Column(std::string name_, ColumnType type_, s32 byte_width_)
+    : name{std::move(name_)}, type{type_}, byte_width{byte_width_} {
+    Clear();
+}
+
+Column Column::CreateList(std::string name_, Column child) {
+    Column column{std::move(name_), ColumnType::List};
+    column.children.push_back(std::move(child));
+    return column;
+}
+
+const std::string& Column::GetName() const {
+    return name;
+}
+
+ColumnType Column::GetType() const {
+    return type;
+}
+
+s32 Column::GetByteWidth() const {
+    return byte_width;
+}
+
+std::size_t Column::GetLength() const {
+    return length;
+}
+
+s64 Column::GetDictionaryId() const {
+    return dictionary_id;
+}
+
+std::span<const u8> Column::GetValues() const {
+    return values;
+}
+
+std::span<const s32> Column::GetOffsets() const {
+    return offsets;
+}
+
+std::span<const Column> Column::GetChildren() const {
+    return children;
+}
+
+void Column::AppendBool(bool value) {
+    if (length % 8 == 0) {
+        values.push_back(0);
+    }
+    if (value) {
+        values.back() |= static_cast<u8>(1 << (length % 8));
+    }
+    length++;
+}
+
+void Column::AppendUInt8(u8 value) {
+    AppendValue(&value, sizeof(value));
+}
+
+void Column::AppendInt32(s32 value) {
+    AppendValue(&value, sizeof(value));
+}
+
+void Column::AppendUInt32(u32 value) {
+    AppendValue(&value, sizeof(value));
+}
+
+void Column::AppendUInt64(u64 value) {
+    AppendValue(&value, sizeof(value));
+}
+
+void Column::AppendFloat64(f64 value) {
+    AppendValue(&value, sizeof(value));
+}
+
+void Column::AppendTimestamp(s64 value) {
+    AppendValue(&value, sizeof(value));
+}
+
+void Column::AppendBytes(std::span<const u8> data) {
+    if (type == ColumnType::FixedSizeBinary) {
+        const std::size_t size = std::min<std::size_t>(data.size(), byte_width);
+        values.insert(values.end(), data.begin(), data.begin() + size);
+        values.resize(values.size() + byte_width - size);
+        length++;
+        return;
+    }
+
+    values.insert(values.end(), data.begin(), data.end());
+    offsets.push_back(static_cast<s32>(values.size()));
+    length++;
+}
+
+void Column::AppendString(std::string_view text) {
+    if (type != ColumnType::DictionaryUtf8) {
+        AppendBytes({reinterpret_cast<const u8*>(text.data()), text.size()});
+        return;
+    }
+
+    AppendDictionaryIndex(InternString(text));
+}
+
+s32 Column::InternString(std::string_view text) {
+    auto it = dictionary_indices.find(std::string{text});
+    if (it == dictionary_indices.end()) {
+        it = dictionary_indices.emplace(text, static_cast<s32>(dictionary.size())).first;
+        dictionary.emplace_back(text);
+    }
+    return it->second;
+}
+
+void Column::AppendDictionaryIndex(s32 index) {
+    AppendInt32(index);
+}
+
+Column& Column::BeginList() {
+    return children[0];
+}
+
+void Column::EndList() {
+    offsets.push_back(static_cast<s32>(children[0].GetLength()));
+    length++;
+}
+
+void Column::Clear() {
+    length = 0;
+    values.clear();
+    offsets.clear();
+    if (type == ColumnType::Binary || type == ColumnType::Utf8 || type == ColumnType::List) {
+        offsets.push_back(0);
+    }
+    for (Column& child : children) {
+        child.Clear();
+    }
+}
+
+void Column::AppendValue(const void* data, std::size_t size) {
+    const u8* bytes = static_cast<const u8*>(data);
+    values.insert(values.end(), bytes, bytes + size);
+    length++;
+}
+
+namespace {
+
+u32 CreateField(FlatBufferBuilder& fbb, const Column& column) {
+    std::vector<u32> child_fields{};
+    for (const Column& child : column.GetChildren()) {
+        child_fields.push_back(CreateField(fbb, child));
+    }
+    const u32 children = fbb.CreateOffsetVector(child_fields);
+    const u32 name = fbb.CreateString(column.GetName());
+    const auto [type_type, type] = CreateType(fbb, column);
+
+    u32 dictionary = 0;
+    if (column.GetType() == ColumnType::DictionaryUtf8) {
+        fbb.StartTable();
+        fbb.AddScalar<s32>(0, 32);
+        fbb.AddScalar<u8>(1, 1);
+        const u32 index_type = fbb.EndTable();
+
+        fbb.StartTable();
+        fbb.AddScalar<s64>(0, column.GetDictionaryId());
+        fbb.AddOffset(1, index_type);
+        dictionary = fbb.EndTable();
+    }
+
+    fbb.StartTable();
+    fbb.AddOffset(0, name);
+    fbb.AddScalar<u8>(1, 1);
+    fbb.AddScalar<u8>(2, type_type);
+    fbb.AddOffset(3, type);
+    if (dictionary != 0) {
+        fbb.AddOffset(4, dictionary);
+    }
+    fbb.AddOffset(5, children);
+    return fbb.EndTable();
+}
+
+void AddColumnBuffers(BatchBody& body, const Column& column) {
+    body.AddNode(column.GetLength());
+    // All values are valid, an empty validity bitmap is allowed in that case
+    body.AddBuffer(nullptr, 0);
+
+    switch (column.GetType()) {
+    case ColumnType::Binary:
+    case ColumnType::Utf8:
+    case ColumnType::List:
+        body.AddBuffer(column.GetOffsets().data(), column.GetOffsets().size_bytes());
+        break;
+    default:
+        break;
+    }
+
+    if (column.GetType() != ColumnType::List) {
+        body.AddBuffer(column.GetValues().data(), column.GetValues().size());
+    }
+
+    for (const Column& child : column.GetChildren()) {
+        AddColumnBuffers(body, child);
+    }
+}
+
+u32 CreateRecordBatch(FlatBufferBuilder& fbb, const BatchBody& body, std::size_t length) {
+    const u32 nodes = fbb.CreateStructVector(body.nodes);
+    const u32 buffers = fbb.CreateStructVector(body.buffers);
+
+    fbb.StartTable();
+    fbb.AddScalar<s64>(0, static_cast<s64>(length));
+    fbb.AddOffset(1, nodes);
+    fbb.AddOffset(2, buffers);
+    return fbb.EndTable();
+}
+
+std::span<const u8> FinishMessage(FlatBufferBuilder& fbb, u8 header_type, u32 header,
+                                  std::size_t body_length) {
+    fbb.StartTable();
+    fbb.AddScalar<s16>(0, MetadataVersionV5);
+    fbb.AddScalar<u8>(1, header_type);
+    fbb.AddOffset(2, header);
+    fbb.AddScalar<s64>(3, static_cast<s64>(body_length));
+    return fbb.Finish(fbb.EndTable());
+}
+
+} // Anonymous namespace
+
+StreamWriter::StreamWriter(std::ostream& out_stream, std::vector<Column> schema_columns)
+    : out{out_stream}, columns{std::move(schema_columns)} {
+    s64 next_id = 0;
+    AssignDictionaryIds(columns, next_id);
+}
+
+Column& StreamWriter::GetColumn(std::size_t index) {
+    return columns[index];
+}
+
+std::size_t StreamWriter::GetPendingRows() const {
+    if (columns.empty()) {
+        return 0;
+    }
+    return columns[0].GetLength();
+}
+
+bool StreamWriter::WriteSchema() {
+    FlatBufferBuilder fbb{};
+
+    std::vector<u32> fields{};
+    for (const Column& column : columns) {
+        fields.push_back(CreateField(fbb, column));
+    }
+    const u32 field_vector = fbb.CreateOffsetVector(fields);
+
+    fbb.StartTable();
+    fbb.AddScalar<s16>(0, 0); // Little endian
+    fbb.AddOffset(1, field_vector);
+    const u32 schema = fbb.EndTable();
+
+    return WriteMessage(FinishMessage(fbb, MessageHeaderSchema, schema, 0), {});
+}
+
+bool StreamWriter::WriteBatch() {
+    std::vector<Column*> dictionary_columns{};
+    CollectDictionaryColumns(columns, dictionary_columns);
+
+    // Every dictionary must be sent before the first batch. Later batches only send new entries
+    for (Column* column : dictionary_columns) {
+        if (has_dictionaries_sent && column->dictionary_sent == column->dictionary.size()) {
+            continue;
+        }
+
+        Column entries{column->GetName(), ColumnType::Utf8};
+        for (std::size_t i = column->dictionary_sent; i < column->dictionary.size(); ++i) {
+            entries.AppendString(column->dictionary[i]);
+        }
+
+        BatchBody body{};
+        AddColumnBuffers(body, entries);
+
+        FlatBufferBuilder fbb{};
+        const u32 record_batch = CreateRecordBatch(fbb, body, entries.GetLength());
+        fbb.StartTable();
+        fbb.AddScalar<s64>(0, column->dictionary_id);
+        fbb.AddOffset(1, record_batch);
+        fbb.AddScalar<u8>(2, has_dictionaries_sent ? 1 : 0);
+        const u32 dictionary_batch = fbb.EndTable();
+
+        if (!WriteMessage(FinishMessage(fbb, MessageHeaderDictionaryBatch, dictionary_batch,
+                                        body.data.size()),
+                          body.data)) {
+            return false;
+        }
+        column->dictionary_sent = column->dictionary.size();
+    }
+    has_dictionaries_sent = true;
+
+    BatchBody body{};
+    for (const Column& column : columns) {
+        AddColumnBuffers(body, column);
+    }
+
+    FlatBufferBuilder fbb{};
+    const u32 record_batch = CreateRecordBatch(fbb, body, GetPendingRows());
+    const bool result = WriteMessage(
+        FinishMessage(fbb, MessageHeaderRecordBatch, record_batch, body.data.size()), body.data);
+
+    for (Column& column : columns) {
+        column.Clear();
+    }
+    return result;
+}
+
+void StreamWriter::AssignDictionaryIds(std::vector<Column>& column_list, s64& next_id) {
+    for (Column& column : column_list) {
+        if (column.type == ColumnType::DictionaryUtf8) {
+            column.dictionary_id = next_id++;
+        }
+        AssignDictionaryIds(column.children, next_id);
+    }
+}
+
+void StreamWriter::CollectDictionaryColumns(std::vector<Column>& column_list,
+                                            std::vector<Column*>& dictionary_columns) {
+    for (Column& column : column_list) {
+        if (column.type == ColumnType::DictionaryUtf8) {
+            dictionary_columns.push_back(&column);
+        }
+        CollectDictionaryColumns(column.children, dictionary_columns);
+    }
+}
+
+bool StreamWriter::Finish() {
+    const std::array<u32, 2> end_of_stream{ContinuationMarker, 0};
+    out.write(reinterpret_cast<const char*>(end_of_stream.data()), sizeof(end_of_stream));
+    return out.good();
+}
+
+bool StreamWriter::WriteMessage(std::span<const u8> metadata, std::span<const u8> body) {
+    // Metadata is padded so the body starts 8 byte aligned
+    const std::size_t padded_size =
+        (metadata.size() + sizeof(u32) * 2 + BodyAlignment - 1) / BodyAlignment * BodyAlignment -
+        sizeof(u32) * 2;
+    const std::array<u32, 2> prefix{ContinuationMarker, static_cast<u32>(padded_size)};
+    const std::array<u8, BodyAlignment> padding{};
+
+    out.write(reinterpret_cast<const char*>(prefix.data()), sizeof(prefix));
+    out.write(reinterpret_cast<const char*>(metadata.data()),
+              static_cast<std::streamsize>(metadata.size()));
+    out.write(reinterpret_cast<const char*>(padding.data()),
+              static_cast<std::streamsize>(padded_size - metadata.size()));
+    out.write(reinterpret_cast<const char*>(body.data()),
+              static_cast<std::streamsize>(body.size()));
+    return out.good();
+}
+
+} // namespace Arrow
@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Arrow {
+
+enum class ColumnType {
+    Bool,
+    UInt8,
+    Int32,
+    UInt32,
+    UInt64,
+    Float64,
+    Timestamp, // Seconds since epoch stored as int64
+    FixedSizeBinary,
+    Binary,
+    Utf8,
+    DictionaryUtf8, // Utf8 values stored as int32 indices into a dictionary
+    List,
+};
+
+// Single column of a record batch. Values are appended row by row and released after every
+// batch is written
+class Column {
+public:
+    Column(std::string name, ColumnType type, s32 byte_width = 0);
+
+    static Column CreateList(std::string name, Column child);
+
+    const std::string& GetName() const;
+    ColumnType GetType() const;
+    s32 GetByteWidth() const;
+    std::size_t GetLength() const;
+    s64 GetDictionaryId() const;
+    std::span<const u8> GetValues() const;
+    std::span<const s32> GetOffsets() const;
+    std::span<const Column> GetChildren() const;
+
+    void AppendBool(bool value);
+    void AppendUInt8(u8 value);
+    void AppendInt32(s32 value);
+    void AppendUInt32(u32 value);
+    void AppendUInt64(u64 value);
+    void AppendFloat64(f64 value);
+    void AppendTimestamp(s64 value);
+    void AppendBytes(std::span<const u8> data);
+    void AppendString(std::string_view text);
+
+    // Dictionary columns only. Returns the dictionary index of text, adding it if needed, so
+    // repeated values can be appended by index without hashing the text again
+    s32 InternString(std::string_view text);
+    void AppendDictionaryIndex(s32 index);
+
+    // Values of a list entry are appended to the child column between these calls
+    Column& BeginList();
+    void EndList();
+
+    // Drops the values of the current batch. Dictionary entries are kept
+    void Clear();
+
+private:
+    friend class StreamWriter;
+
+    void AppendValue(const void* data, std::size_t size);
+
+    std::string name{};
+    ColumnType type{};
+    s32 byte_width{};
+    std::size_t length{};
+
+    std::vector<u8> values{};
+    std::vector<s32> offsets{};
+    std::vector<Column> children{};
+
+    s64 dictionary_id{};
+    std::size_t dictionary_sent{};
+    std::vector<std::string> dictionary{};
+    std::unordered_map<std::string, s32> dictionary_indices{};
+};
+
+// Writes columns using the Arrow IPC streaming format
+class StreamWriter {
+public:
+    StreamWriter(std::ostream& out_stream, std::vector<Column> schema_columns);
+
+    Column& GetColumn(std::size_t index);
+    std::size_t GetPendingRows() const;
+
+    bool WriteSchema();
+
+    // Writes the pending rows as a record batch preceded by any new dictionary entries
+    bool WriteBatch();
+
+    // Writes the end of stream marker
+    bool Finish();
+
+private:
+    static void AssignDictionaryIds(std::vector<Column>& column_list, s64& next_id);
+    static void CollectDictionaryColumns(std::vector<Column>& column_list,
+                                         std::vector<Column*>& dictionary_columns);
+
+    bool WriteMessage(std::span<const u8> metadata, std::span<const u8> body);
+
+    std::ostream& out;
+    std::vector<Column> columns;
+    bool has_dictionaries_sent{};
+};
+
+} // namespace Arrow
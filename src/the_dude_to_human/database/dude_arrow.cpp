@@ -0,0 +1,205 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "the_dude_to_human/arrow/arrow_writer.h"
+#include "the_dude_to_human/database/dude_arrow.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+Arrow::Column CreateColumn(std::string_view name, const BoolField&) {
+    return {std::string{name}, Arrow::ColumnType::Bool};
+}
+
+Arrow::Column CreateColumn(std::string_view name, const ByteField&) {
+    return {std::string{name}, Arrow::ColumnType::UInt8};
+}
+
+Arrow::Column CreateColumn(std::string_view name, const IntField&) {
+    return {std::string{name}, Arrow::ColumnType::Int32};
+}
+
+Arrow::Column CreateColumn(std::string_view name, const TimeField&) {
+    return {std::string{name}, Arrow::ColumnType::Timestamp};
+}
+
+Arrow::Column CreateColumn(std::string_view name, const LongField&) {
+    return {std::string{name}, Arrow::ColumnType::UInt64};
+}
+
+Arrow::Column CreateColumn(std::string_view name, const LongLongField&) {
+    return {std::string{name}, Arrow::ColumnType::FixedSizeBinary, sizeof(u128)};
+}
+
+// Text fields repeat a lot between objects (names, types, credentials) so they are stored as
+// dictionary indices
+Arrow::Column CreateColumn(std::string_view name, const TextField&) {
+    return {std::string{name}, Arrow::ColumnType::DictionaryUtf8};
+}
+
+Arrow::Column CreateColumn(std::string_view name, const LongArrayField&) {
+    return {std::string{name}, Arrow::ColumnType::Binary};
+}
+
+Arrow::Column CreateColumn(std::string_view name, const IntArrayField&) {
+    return Arrow::Column::CreateList(std::string{name}, {"item", Arrow::ColumnType::UInt32});
+}
+
+Arrow::Column CreateColumn(std::string_view name, const IpArrayField&) {
+    return Arrow::Column::CreateList(
+        std::string{name}, {"item", Arrow::ColumnType::FixedSizeBinary, sizeof(IpAddress)});
+}
+
+Arrow::Column CreateColumn(std::string_view name, const MacAddressField&) {
+    return Arrow::Column::CreateList(
+        std::string{name}, {"item", Arrow::ColumnType::FixedSizeBinary, sizeof(MacAddress)});
+}
+
+Arrow::Column CreateColumn(std::string_view name, const StringArrayField&) {
+    return Arrow::Column::CreateList(std::string{name}, {"item", Arrow::ColumnType::Utf8});
+}
+
+void AppendField(Arrow::Column& column, const BoolField& field) {
+    column.AppendBool(field.value);
+}
+
+void AppendField(Arrow::Column& column, const ByteField& field) {
+    column.AppendUInt8(field.value);
+}
+
+void AppendField(Arrow::Column& column, const IntField& field) {
+    column.AppendInt32(field.value);
+}
+
+void AppendField(Arrow::Column& column, const TimeField& field) {
+    column.AppendTimestamp(field.date);
+}
+
+void AppendField(Arrow::Column& column, const LongField& field) {
+    column.AppendUInt64(field.value);
+}
+
+void AppendField(Arrow::Column& column, const LongLongField& field) {
+    column.AppendBytes(field.GetBytes());
+}
+
+void AppendField(Arrow::Column& column, const TextField& field) {
+    column.AppendString(field.text);
+}
+
+void AppendField(Arrow::Column& column, const LongArrayField& field) {
+    column.AppendBytes(field.data);
+}
+
+void AppendField(Arrow::Column& column, const IntArrayField& field) {
+    Arrow::Column& values = column.BeginList();
+    for (u32 entry : field.data) {
+        values.AppendUInt32(entry);
+    }
+    column.EndList();
+}
+
+void AppendField(Arrow::Column& column, const IpArrayField& field) {
+    Arrow::Column& values = column.BeginList();
+    for (u32 entry : field.data) {
+        IpAddress ip{};
+        std::memcpy(&ip, &entry, sizeof(u32));
+        values.AppendBytes(ip);
+    }
+    column.EndList();
+}
+
+void AppendField(Arrow::Column& column, const MacAddressField& field) {
+    Arrow::Column& values = column.BeginList();
+    for (const MacAddress& mac : field.mac_address) {
+        values.AppendBytes(mac);
+    }
+    column.EndList();
+}
+
+void AppendField(Arrow::Column& column, const StringArrayField& field) {
+    Arrow::Column& values = column.BeginList();
+    for (const StringArrayEntry& entry : field.entries) {
+        values.AppendString(entry.text);
+    }
+    column.EndList();
+}
+
+template <typename T>
+int SerializeTable(const std::filesystem::path& file_path, const std::vector<T>& objects,
+                   bool has_credentials, std::size_t batch_size) {
+    std::ofstream out{file_path, std::ios::binary};
+    if (!out.is_open()) {
+        printf("Unable to open '%s'\n", file_path.string().c_str());
+        return 1;
+    }
+
+    std::vector<Arrow::Column> columns{};
+    T{}.VisitFields(
+        [&columns](std::string_view name, const auto& field) {
+            columns.push_back(CreateColumn(name, field));
+        },
+        has_credentials);
+
+    Arrow::StreamWriter writer{out, std::move(columns)};
+    if (!writer.WriteSchema()) {
+        return 1;
+    }
+
+    for (const T& data : objects) {
+        std::size_t column_index = 0;
+        data.VisitFields(
+            [&](std::string_view, const auto& field) {
+                AppendField(writer.GetColumn(column_index++), field);
+            },
+            has_credentials);
+
+        if (writer.GetPendingRows() >= batch_size && !writer.WriteBatch()) {
+            return 1;
+        }
+    }
+
+    if (writer.GetPendingRows() != 0 && !writer.WriteBatch()) {
+        return 1;
+    }
+    return writer.Finish() ? 0 : 1;
+}
+
+} // Anonymous namespace
+
+int SerializeDatabaseArrow(DudeDatabase* db, const std::string& out_dir, bool has_credentials,
+                           std::size_t batch_size) {
+    std::error_code ec;
+    std::filesystem::create_directories(out_dir, ec);
+    if (ec) {
+        printf("Unable to create directory '%s': %s\n", out_dir.c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    if (batch_size == 0) {
+        batch_size = 1;
+    }
+
+    int rc = 0;
+    db->ForEachTable([&](std::string_view table_name, const auto& objects) {
+        if (rc != 0) {
+            return;
+        }
+        const std::filesystem::path file_path =
+            std::filesystem::path{out_dir} / (std::string{table_name} + ".arrows");
+        rc = SerializeTable(file_path, objects, has_credentials, batch_size);
+    });
+
+    return rc;
+}
+
+} // namespace Database
@@ -0,0 +1,15 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Database {
+class DudeDatabase;
+
+// Writes one Arrow IPC stream per table into out_dir. Rows are flushed every batch_size objects
+int SerializeDatabaseArrow(DudeDatabase* db, const std::string& out_dir, bool has_credentials,
+                           std::size_t batch_size);
+} // namespace Database
@@ -0,0 +1,357 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <tuple>
+
+#include "the_dude_to_human/archive/gorilla.h"
+#include "the_dude_to_human/database/dude_chart_archive.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+constexpr std::array<char, 4> ArchiveMagic{'D', 'C', 'H', 'A'};
+constexpr u32 ArchiveVersion = 1;
+
+// Values per block. Bounds memory while writing and the cost of reading a partial series
+constexpr std::size_t BlockPoints = 0x10000;
+
+struct ArchiveHeader {
+    std::array<char, 4> magic{};
+    u32 version{};
+    u64 reserved{};
+};
+
+struct ArchiveTrailer {
+    u64 footer_offset{};
+    u32 entry_count{};
+    std::array<char, 4> magic{};
+};
+
+auto GetEntryKey(const ChartArchiveEntry& entry) {
+    return std::make_tuple(entry.resolution, entry.source_id, entry.first_time);
+}
+
+class ChartArchiveWriter {
+public:
+    explicit ChartArchiveWriter(std::ofstream& out_file) : file{out_file} {
+        const ArchiveHeader header{.magic = ArchiveMagic, .version = ArchiveVersion};
+        Write(&header, sizeof(header));
+    }
+
+    void Add(ChartResolution resolution, std::span<const ChartValue> values) {
+        for (const ChartValue& value : values) {
+            if (!times.empty() &&
+                (value.source_id != source_id || current_resolution != resolution ||
+                 times.size() == BlockPoints)) {
+                FlushBlock();
+            }
+            source_id = value.source_id;
+            current_resolution = resolution;
+            times.push_back(value.time);
+            values_.push_back(value.value);
+        }
+    }
+
+    bool Finish() {
+        FlushBlock();
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+            return GetEntryKey(a) < GetEntryKey(b);
+        });
+
+        const ArchiveTrailer trailer{
+            .footer_offset = offset,
+            .entry_count = static_cast<u32>(entries.size()),
+            .magic = ArchiveMagic,
+        };
+        Write(entries.data(), entries.size() * sizeof(ChartArchiveEntry));
+        Write(&trailer, sizeof(trailer));
+        return file.good();
+    }
+
+    u64 GetValueCount() const {
+        return value_count;
+    }
+
+private:
+    void FlushBlock() {
+        if (times.empty()) {
+            return;
+        }
+
+        const std::vector<u8> block = Archive::EncodeSeries(times, values_);
+        entries.push_back({
+            .source_id = source_id,
+            .resolution = static_cast<u8>(current_resolution),
+            .count = static_cast<u32>(times.size()),
+            .first_time = times.front(),
+            .last_time = times.back(),
+            .size = static_cast<u32>(block.size()),
+            .offset = offset,
+        });
+        Write(block.data(), block.size());
+
+        value_count += times.size();
+        times.clear();
+        values_.clear();
+    }
+
+    void Write(const void* data, std::size_t size) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        offset += size;
+    }
+
+    std::ofstream& file;
+    u64 offset{};
+    u64 value_count{};
+    std::vector<ChartArchiveEntry> entries{};
+
+    u32 source_id{};
+    ChartResolution current_resolution{};
+    std::vector<u32> times{};
+    std::vector<f64> values_{};
+};
+
+} // Anonymous namespace
+
+int WriteChartArchive(const DudeDatabase* db, const std::string& out_file) {
+    std::ofstream file{out_file, std::ios::binary};
+    if (!file.is_open()) {
+        printf("Unable to open '%s'\n", out_file.c_str());
+        return 1;
+    }
+
+    ChartArchiveWriter writer{file};
+    for (const ChartResolution resolution : ChartResolutions) {
+        const int rc = db->ReadChartValues(resolution, [&](std::span<const ChartValue> values) {
+            writer.Add(resolution, values);
+            return 0;
+        });
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    if (!writer.Finish()) {
+        return 1;
+    }
+    file.close();
+    if (file.fail()) {
+        return 1;
+    }
+
+    std::error_code ec;
+    const auto archive_size = std::filesystem::file_size(out_file, ec);
+    const u64 value_count = writer.GetValueCount();
+    // Sqlite stores at least an 8 byte key and 8 byte value per row
+    printf("Archived %llu values in %llu bytes, %.2f bytes per value, %.1fx smaller than the raw "
+           "rows\n",
+           static_cast<unsigned long long>(value_count),
+           static_cast<unsigned long long>(archive_size),
+           value_count == 0 ? 0.0 : static_cast<f64>(archive_size) / static_cast<f64>(value_count),
+           archive_size == 0 ? 0.0
+                             : static_cast<f64>(value_count * 16) / static_cast<f64>(archive_size));
+    return 0;
+}
+
+int ChartArchiveReader::Open(const std::string& file_path) {
+    file.open(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        printf("Unable to open '%s'\n", file_path.c_str());
+        return 1;
+    }
+
+    ArchiveHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != ArchiveMagic || header.version != ArchiveVersion) {
+        printf("'%s' is not a chart archive\n", file_path.c_str());
+        return 1;
+    }
+
+    ArchiveTrailer trailer{};
+    file.seekg(-static_cast<std::streamoff>(sizeof(trailer)), std::ios::end);
+    const auto trailer_offset = static_cast<u64>(file.tellg());
+    file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    if (!file || trailer.magic != ArchiveMagic) {
+        printf("'%s' is truncated\n", file_path.c_str());
+        return 1;
+    }
+
+    // Validate the footer bounds before allocating the entries it claims to hold
+    const u64 footer_size = u64{trailer.entry_count} * sizeof(ChartArchiveEntry);
+    if (trailer.footer_offset < sizeof(ArchiveHeader) || trailer.footer_offset > trailer_offset ||
+        footer_size != trailer_offset - trailer.footer_offset) {
+        printf("'%s' has a corrupted index\n", file_path.c_str());
+        return 1;
+    }
+    footer_offset = trailer.footer_offset;
+
+    entries.resize(trailer.entry_count);
+    file.seekg(static_cast<std::streamoff>(trailer.footer_offset));
+    file.read(reinterpret_cast<char*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(ChartArchiveEntry)));
+    if (!file) {
+        printf("'%s' has a corrupted index\n", file_path.c_str());
+        entries.clear();
+        return 1;
+    }
+
+    return 0;
+}
+
+std::span<const ChartArchiveEntry> ChartArchiveReader::GetEntries() const {
+    return entries;
+}
+
+int ChartArchiveReader::ReadSeries(ChartSeries& series, u32 source_id,
+                                   ChartResolution resolution) {
+    series = {.source_id = source_id, .resolution = resolution};
+
+    const ChartArchiveEntry key{.source_id = source_id, .resolution = static_cast<u8>(resolution)};
+    const auto compare = [](const ChartArchiveEntry& a, const ChartArchiveEntry& b) {
+        return std::tie(a.resolution, a.source_id) < std::tie(b.resolution, b.source_id);
+    };
+    const auto [first, last] = std::equal_range(entries.begin(), entries.end(), key, compare);
+
+    for (auto it = first; it != last; ++it) {
+        const int rc = ReadBlock(series, *it);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+int ChartArchiveReader::ReadBlock(ChartSeries& series, const ChartArchiveEntry& entry) {
+    if (entry.count > BlockPoints || entry.offset < sizeof(ArchiveHeader) ||
+        entry.offset > footer_offset || entry.size > footer_offset - entry.offset) {
+        printf("Corrupted block of source %u\n", entry.source_id);
+        return 1;
+    }
+
+    block_data.resize(entry.size);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(entry.offset));
+    file.read(reinterpret_cast<char*>(block_data.data()),
+              static_cast<std::streamsize>(block_data.size()));
+    if (!file || !Archive::DecodeSeries(block_data, entry.count, block_times, block_values)) {
+        printf("Corrupted block of source %u\n", entry.source_id);
+        return 1;
+    }
+
+    series.times.insert(series.times.end(), block_times.begin(), block_times.end());
+    series.values.insert(series.values.end(), block_values.begin(), block_values.end());
+    return 0;
+}
+
+int BenchmarkChartArchive(const DudeDatabase* db, const std::string& archive_file) {
+    using Clock = std::chrono::steady_clock;
+
+    ChartArchiveReader reader{};
+    int rc = reader.Open(archive_file);
+    if (rc != 0) {
+        return rc;
+    }
+
+    // Decoded values are u32 time and f64 value
+    constexpr f64 DecodedValueSize = sizeof(u32) + sizeof(f64);
+
+    u64 archive_values = 0;
+    f64 checksum = 0;
+    ChartSeries series{};
+    auto start_time = Clock::now();
+    for (const ChartArchiveEntry& entry : reader.GetEntries()) {
+        series.times.clear();
+        series.values.clear();
+        rc = reader.ReadBlock(series, entry);
+        if (rc != 0) {
+            return rc;
+        }
+        archive_values += series.times.size();
+        checksum += series.values.empty() ? 0 : series.values.back();
+    }
+    const std::chrono::duration<f64> archive_elapsed = Clock::now() - start_time;
+
+    u64 sqlite_values = 0;
+    start_time = Clock::now();
+    for (const ChartResolution resolution : ChartResolutions) {
+        rc = db->ReadChartValues(resolution, [&](std::span<const ChartValue> values) {
+            sqlite_values += values.size();
+            return 0;
+        });
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    const std::chrono::duration<f64> sqlite_elapsed = Clock::now() - start_time;
+
+    const auto print_speed = [&](const char* name, u64 value_count, f64 seconds) {
+        const f64 bytes = static_cast<f64>(value_count) * DecodedValueSize;
+        printf("%-8s %12llu values in %9.3f ms, %7.3f GB/s\n", name,
+               static_cast<unsigned long long>(value_count), seconds * 1000.0,
+               seconds == 0 ? 0.0 : bytes / seconds / 1e9);
+    };
+    print_speed("archive", archive_values, archive_elapsed.count());
+    print_speed("sqlite", sqlite_values, sqlite_elapsed.count());
+    printf("checksum %f\n", checksum);
+
+    if (archive_values != sqlite_values) {
+        return 1;
+    }
+
+    // Entries are sorted by series, find the one with the most values
+    const std::span<const ChartArchiveEntry> entries = reader.GetEntries();
+    const ChartArchiveEntry* largest_entry = nullptr;
+    u64 largest_count = 0;
+    for (std::size_t first = 0, last = 0; first < entries.size(); first = last) {
+        u64 count = 0;
+        for (last = first; last < entries.size() &&
+                            entries[last].resolution == entries[first].resolution &&
+                            entries[last].source_id == entries[first].source_id;
+             ++last) {
+            count += entries[last].count;
+        }
+        if (count > largest_count) {
+            largest_entry = &entries[first];
+            largest_count = count;
+        }
+    }
+    if (largest_entry == nullptr) {
+        return 0;
+    }
+
+    const auto resolution = static_cast<ChartResolution>(largest_entry->resolution);
+    ChartSeries archive_series{};
+    start_time = Clock::now();
+    rc = reader.ReadSeries(archive_series, largest_entry->source_id, resolution);
+    if (rc != 0) {
+        return rc;
+    }
+    const std::chrono::duration<f64> archive_series_elapsed = Clock::now() - start_time;
+
+    ChartSeries sqlite_series{};
+    start_time = Clock::now();
+    rc = db->QueryChartValues(sqlite_series, resolution, largest_entry->source_id, 0,
+                              std::numeric_limits<u32>::max());
+    if (rc != 0) {
+        return rc;
+    }
+    const std::chrono::duration<f64> sqlite_series_elapsed = Clock::now() - start_time;
+
+    printf("Series %u of %s\n", largest_entry->source_id,
+           DudeDatabase::GetChartTableName(resolution));
+    print_speed("archive", archive_series.times.size(), archive_series_elapsed.count());
+    print_speed("sqlite", sqlite_series.times.size(), sqlite_series_elapsed.count());
+
+    const bool matches = archive_series.times == sqlite_series.times &&
+                         archive_series.values == sqlite_series.values;
+    return matches ? 0 : 1;
+}
+
+} // namespace Database
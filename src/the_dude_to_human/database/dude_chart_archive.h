@@ -0,0 +1,68 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+#include "the_dude_to_human/database/dude_types.h"
+
+namespace Database {
+class DudeDatabase;
+
+// Compressed chart values archive. The file starts with a header, followed by gorilla encoded
+// blocks of up to BlockPoints values of a single source and ends with a footer indexing every
+// block, so a series is read without touching the rest of the file
+//
+// Header:  "DCHA" magic, u32 version, u64 reserved
+// Blocks:  EncodeSeries output
+// Footer:  ChartArchiveEntry[entry_count] sorted by resolution, source and time
+// Trailer: u64 footer offset, u32 entry_count, "DCHA" magic
+//
+// Header, footer and trailer structs are written as they are in memory, in host byte order. An
+// archive is only readable on a machine with the same endianness as the one that wrote it
+struct ChartArchiveEntry {
+    u32 source_id{};
+    u8 resolution{};
+    std::array<u8, 3> padding{};
+    u32 count{};
+    u32 first_time{};
+    u32 last_time{};
+    u32 size{};
+    u64 offset{};
+};
+static_assert(sizeof(ChartArchiveEntry) == 32, "ChartArchiveEntry has wrong size");
+
+// Writes every chart value table into a compressed archive at out_file
+int WriteChartArchive(const DudeDatabase* db, const std::string& out_file);
+
+class ChartArchiveReader {
+public:
+    int Open(const std::string& file_path);
+
+    std::span<const ChartArchiveEntry> GetEntries() const;
+
+    // Decodes all values of source_id. Only the blocks of the series are read
+    int ReadSeries(ChartSeries& series, u32 source_id, ChartResolution resolution);
+
+    // Decodes a single block, appending its values to series
+    int ReadBlock(ChartSeries& series, const ChartArchiveEntry& entry);
+
+private:
+    std::ifstream file{};
+    u64 footer_offset{};
+    std::vector<ChartArchiveEntry> entries{};
+    std::vector<u8> block_data{};
+    std::vector<u32> block_times{};
+    std::vector<f64> block_values{};
+};
+
+// Compares the archive decode speed against reading the sqlite tables, for the whole archive and
+// for the lookup of the largest series
+int BenchmarkChartArchive(const DudeDatabase* db, const std::string& archive_file);
+} // namespace Database
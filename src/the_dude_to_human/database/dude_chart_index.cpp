@@ -0,0 +1,232 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <unordered_map>
+
+#include "the_dude_to_human/database/dude_chart_index.h"
+#include "the_dude_to_human/sqlite/sqlite_reader.h"
+
+namespace Database {
+namespace {
+
+constexpr std::array<char, 4> IndexMagic{'D', 'C', 'B', 'I'};
+constexpr u32 IndexVersion = 2;
+
+struct IndexHeader {
+    std::array<char, 4> magic{};
+    u32 version{};
+    s64 min_rowid{};
+    s64 max_rowid{};
+    u64 database_size{};
+    s64 database_time{};
+    u64 wal_size{};
+    s64 wal_time{};
+    u64 entry_count{};
+};
+
+// Missing files count as empty
+void GetSizeAndTime(const std::filesystem::path& path, u64& size, s64& time) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        size = 0;
+        time = 0;
+        return;
+    }
+    time = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+}
+
+bool CompareEntries(const ChartBlockIndex::Entry& a, const ChartBlockIndex::Entry& b) {
+    if (a.source_id != b.source_id) {
+        return a.source_id < b.source_id;
+    }
+    return a.first_rowid < b.first_rowid;
+}
+
+} // Anonymous namespace
+
+int ChartBlockIndex::Open(const Sqlite::SqliteReader& reader, const std::string& table_name,
+                          const std::string& file_path) {
+    s64 table_min_rowid{};
+    s64 table_max_rowid{};
+    int rc = reader.GetRowidRange(table_min_rowid, table_max_rowid, table_name);
+    if (rc != 0) {
+        return rc;
+    }
+
+    // Updates and deletes keep the rowid range, the database file tells if anything was written
+    // since the index was built. PRAGMA data_version only tracks the writes of other connections
+    // while one stays open, it can't tell across runs
+    const bool has_file = !file_path.empty();
+    const FileStamp table_file_stamp = has_file ? GetFileStamp(reader.GetFilename()) : FileStamp{};
+    if (has_file && Load(file_path) && min_rowid == table_min_rowid &&
+        max_rowid == table_max_rowid && file_stamp == table_file_stamp) {
+        return 0;
+    }
+
+    rc = Build(reader, table_name);
+    if (rc != 0) {
+        return rc;
+    }
+
+    min_rowid = table_min_rowid;
+    max_rowid = table_max_rowid;
+    file_stamp = table_file_stamp;
+    if (has_file && !Save(file_path)) {
+        // Not fatal, the index will be rebuilt next time
+        printf("Unable to save chart index '%s'\n", file_path.c_str());
+    }
+    return 0;
+}
+
+std::vector<std::pair<s64, s64>> ChartBlockIndex::FindRowidRanges(u32 source_id, u32 start_time,
+                                                                  u32 end_time) const {
+    const auto [first, last] = std::equal_range(
+        entries.begin(), entries.end(), Entry{.source_id = source_id},
+        [](const Entry& a, const Entry& b) { return a.source_id < b.source_id; });
+
+    std::vector<std::pair<s64, s64>> ranges{};
+    for (auto it = first; it != last; ++it) {
+        if (it->max_time < start_time || it->min_time > end_time) {
+            continue;
+        }
+        // Entries are sorted by rowid, consecutive blocks are read with a single query
+        if (!ranges.empty() && ranges.back().second + 1 >= it->first_rowid) {
+            ranges.back().second = std::max(ranges.back().second, it->last_rowid);
+            continue;
+        }
+        ranges.emplace_back(it->first_rowid, it->last_rowid);
+    }
+    return ranges;
+}
+
+u32 ChartBlockIndex::GetLastTime() const {
+    u32 last_time = 0;
+    for (const Entry& entry : entries) {
+        last_time = std::max(last_time, entry.max_time);
+    }
+    return last_time;
+}
+
+ChartBlockIndex::FileStamp ChartBlockIndex::GetFileStamp(const std::string& database_path) {
+    FileStamp stamp{};
+    GetSizeAndTime(database_path, stamp.database_size, stamp.database_time);
+    GetSizeAndTime(database_path + "-wal", stamp.wal_size, stamp.wal_time);
+    return stamp;
+}
+
+int ChartBlockIndex::Build(const Sqlite::SqliteReader& reader, const std::string& table_name) {
+    printf("Building chart index of %s\n", table_name.c_str());
+
+    entries.clear();
+    std::unordered_map<u32, Entry> block_entries{};
+    std::size_t block_rows = 0;
+
+    const auto flush_block = [&] {
+        for (const auto& [source_id, entry] : block_entries) {
+            entries.push_back(entry);
+        }
+        block_entries.clear();
+        block_rows = 0;
+    };
+
+    const int rc = reader.StreamKeyValueDataByRowid(
+        table_name, BlockRows, [&](std::span<const Sqlite::SqlKeyValue> rows) {
+            for (const Sqlite::SqlKeyValue& row : rows) {
+                const u32 source_id = static_cast<u32>(row.key >> 32);
+                const u32 time = static_cast<u32>(row.key);
+                auto [it, is_new] = block_entries.try_emplace(source_id);
+                Entry& entry = it->second;
+                if (is_new) {
+                    entry = {
+                        .source_id = source_id,
+                        .min_time = time,
+                        .max_time = time,
+                        .first_rowid = row.rowid,
+                    };
+                }
+                entry.min_time = std::min(entry.min_time, time);
+                entry.max_time = std::max(entry.max_time, time);
+                entry.last_rowid = row.rowid;
+                entry.row_count++;
+
+                if (++block_rows == BlockRows) {
+                    flush_block();
+                }
+            }
+            return 0;
+        });
+    flush_block();
+
+    std::sort(entries.begin(), entries.end(), CompareEntries);
+    return rc;
+}
+
+bool ChartBlockIndex::Load(const std::string& file_path) {
+    std::ifstream file{file_path, std::ios::binary};
+    if (!file.is_open()) {
+        return false;
+    }
+
+    IndexHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != IndexMagic || header.version != IndexVersion) {
+        return false;
+    }
+
+    std::error_code ec;
+    const auto file_size = std::filesystem::file_size(file_path, ec);
+    if (ec || file_size != sizeof(IndexHeader) + header.entry_count * sizeof(Entry)) {
+        return false;
+    }
+
+    entries.resize(header.entry_count);
+    file.read(reinterpret_cast<char*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+    if (!file) {
+        entries.clear();
+        return false;
+    }
+
+    min_rowid = header.min_rowid;
+    max_rowid = header.max_rowid;
+    file_stamp = {
+        .database_size = header.database_size,
+        .database_time = header.database_time,
+        .wal_size = header.wal_size,
+        .wal_time = header.wal_time,
+    };
+    return true;
+}
+
+bool ChartBlockIndex::Save(const std::string& file_path) const {
+    std::ofstream file{file_path, std::ios::binary};
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const IndexHeader header{
+        .magic = IndexMagic,
+        .version = IndexVersion,
+        .min_rowid = min_rowid,
+        .max_rowid = max_rowid,
+        .database_size = file_stamp.database_size,
+        .database_time = file_stamp.database_time,
+        .wal_size = file_stamp.wal_size,
+        .wal_time = file_stamp.wal_time,
+        .entry_count = entries.size(),
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()),
+               static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+    file.close();
+    return !file.fail();
+}
+
+} // namespace Database
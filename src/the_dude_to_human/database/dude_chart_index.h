@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Sqlite {
+class SqliteReader;
+}
+
+namespace Database {
+
+// Index of chart value tables whose row key isn't the rowid. Rows are split in blocks of
+// BlockRows rows and every block stores the time range of each source it contains, so a query
+// only reads the blocks that may hold matching rows
+class ChartBlockIndex {
+public:
+    static constexpr std::size_t BlockRows = 0x1000;
+
+    struct Entry {
+        u32 source_id{};
+        u32 min_time{};
+        u32 max_time{};
+        u32 row_count{};
+        s64 first_rowid{};
+        s64 last_rowid{};
+    };
+
+    // Loads the index from file_path, building and saving it when missing or outdated. An empty
+    // file_path keeps the index in memory only
+    int Open(const Sqlite::SqliteReader& reader, const std::string& table_name,
+             const std::string& file_path);
+
+    // Returns the merged rowid ranges that may hold values of source_id between the given times
+    std::vector<std::pair<s64, s64>> FindRowidRanges(u32 source_id, u32 start_time,
+                                                     u32 end_time) const;
+
+    // Returns the newest time of any source
+    u32 GetLastTime() const;
+
+private:
+    // Size and modification time of the database file and its write ahead log, every write to
+    // the database changes one of them
+    struct FileStamp {
+        u64 database_size{};
+        s64 database_time{};
+        u64 wal_size{};
+        s64 wal_time{};
+
+        bool operator==(const FileStamp&) const = default;
+    };
+
+    static FileStamp GetFileStamp(const std::string& database_path);
+
+    int Build(const Sqlite::SqliteReader& reader, const std::string& table_name);
+    bool Load(const std::string& file_path);
+    bool Save(const std::string& file_path) const;
+
+    s64 min_rowid{};
+    s64 max_rowid{};
+    FileStamp file_stamp{};
+    std::vector<Entry> entries{};
+};
+
+} // namespace Database
@@ -0,0 +1,310 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <tuple>
+
+#include "common/thread_pool.h"
+#include "the_dude_to_human/database/dude_chart_sketch.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+constexpr std::array<char, 4> SketchMagic{'D', 'T', 'D', 'G'};
+constexpr u32 SketchVersion = 1;
+
+struct SketchHeader {
+    std::array<char, 4> magic{};
+    u32 version{};
+    u32 bucket_width{};
+    u32 reserved{};
+};
+
+struct SketchTrailer {
+    u64 footer_offset{};
+    u32 entry_count{};
+    std::array<char, 4> magic{};
+};
+
+// Raw values of a single data source ordered by time
+struct SourceValues {
+    u32 source_id{};
+    std::vector<u32> times{};
+    std::vector<f64> values{};
+};
+
+struct BucketSketch {
+    u32 bucket_time{};
+    std::vector<u8> data{};
+};
+
+struct SourceSketches {
+    u32 source_id{};
+    std::vector<BucketSketch> buckets{};
+};
+
+SourceSketches BuildSourceSketches(const SourceValues& source) {
+    SourceSketches sketches{.source_id = source.source_id};
+    std::size_t begin = 0;
+    while (begin < source.times.size()) {
+        const u32 begin_time = source.times[begin];
+        const u32 bucket_time = begin_time - begin_time % ChartSketchBucketWidth;
+        Sketch::TDigest digest{};
+        std::size_t end = begin;
+        for (; end < source.times.size() &&
+               source.times[end] - bucket_time < ChartSketchBucketWidth;
+             ++end) {
+            digest.Add(source.values[end]);
+        }
+        if (digest.GetCount() != 0) {
+            sketches.buckets.push_back({bucket_time, digest.Serialize()});
+        }
+        begin = end;
+    }
+    return sketches;
+}
+
+class ChartSketchWriter {
+public:
+    explicit ChartSketchWriter(std::ofstream& out_file) : file{out_file} {
+        const SketchHeader header{
+            .magic = SketchMagic,
+            .version = SketchVersion,
+            .bucket_width = ChartSketchBucketWidth,
+        };
+        Write(&header, sizeof(header));
+    }
+
+    void Add(const SourceSketches& sketches) {
+        for (const BucketSketch& bucket : sketches.buckets) {
+            entries.push_back({
+                .source_id = sketches.source_id,
+                .bucket_time = bucket.bucket_time,
+                .size = static_cast<u32>(bucket.data.size()),
+                .offset = offset,
+            });
+            Write(bucket.data.data(), bucket.data.size());
+        }
+    }
+
+    bool Finish() {
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+            return std::tie(a.source_id, a.bucket_time) < std::tie(b.source_id, b.bucket_time);
+        });
+
+        const SketchTrailer trailer{
+            .footer_offset = offset,
+            .entry_count = static_cast<u32>(entries.size()),
+            .magic = SketchMagic,
+        };
+        Write(entries.data(), entries.size() * sizeof(ChartSketchEntry));
+        Write(&trailer, sizeof(trailer));
+        return file.good();
+    }
+
+    std::size_t GetSketchCount() const {
+        return entries.size();
+    }
+
+private:
+    void Write(const void* data, std::size_t size) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        offset += size;
+    }
+
+    std::ofstream& file;
+    u64 offset{};
+    std::vector<ChartSketchEntry> entries{};
+};
+
+} // Anonymous namespace
+
+int WriteChartSketches(const DudeDatabase* db, const std::string& out_file) {
+    std::ofstream file{out_file, std::ios::binary};
+    if (!file.is_open()) {
+        printf("Unable to open '%s'\n", out_file.c_str());
+        return 1;
+    }
+
+    // Sources are sketched in parallel and written in order. The number of sources in flight is
+    // limited so memory usage stays bounded
+    ChartSketchWriter writer{file};
+    Common::ThreadPool pool{};
+    const std::size_t max_pending = pool.GetThreadCount() * 2;
+    std::deque<std::future<SourceSketches>> pending{};
+    SourceValues source{};
+
+    const auto write_oldest = [&] {
+        writer.Add(pending.front().get());
+        pending.pop_front();
+    };
+    const auto submit_source = [&] {
+        if (source.times.empty()) {
+            return;
+        }
+        pending.push_back(pool.Submit(
+            [values = std::move(source)]() { return BuildSourceSketches(values); }));
+        source = {};
+        while (pending.size() > max_pending) {
+            write_oldest();
+        }
+    };
+
+    const int rc =
+        db->ReadChartValues(ChartResolution::Raw, [&](std::span<const ChartValue> values) {
+            for (const ChartValue& value : values) {
+                if (value.source_id != source.source_id) {
+                    submit_source();
+                    source.source_id = value.source_id;
+                }
+                source.times.push_back(value.time);
+                source.values.push_back(value.value);
+            }
+            return 0;
+        });
+    submit_source();
+    while (!pending.empty()) {
+        write_oldest();
+    }
+
+    if (rc != 0 || !writer.Finish()) {
+        return 1;
+    }
+    file.close();
+    if (file.fail()) {
+        return 1;
+    }
+
+    printf("Wrote %zu percentile sketches\n", writer.GetSketchCount());
+    return 0;
+}
+
+int ChartSketchReader::Open(const std::string& file_path) {
+    file.open(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        printf("Unable to open '%s'\n", file_path.c_str());
+        return 1;
+    }
+
+    SketchHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != SketchMagic || header.version != SketchVersion) {
+        printf("'%s' is not a sketch file\n", file_path.c_str());
+        return 1;
+    }
+    if (header.bucket_width == 0) {
+        printf("'%s' has no bucket width\n", file_path.c_str());
+        return 1;
+    }
+    bucket_width = header.bucket_width;
+
+    SketchTrailer trailer{};
+    file.seekg(-static_cast<std::streamoff>(sizeof(trailer)), std::ios::end);
+    const auto trailer_offset = static_cast<u64>(file.tellg());
+    file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    if (!file || trailer.magic != SketchMagic) {
+        printf("'%s' is truncated\n", file_path.c_str());
+        return 1;
+    }
+
+    // Validate the footer bounds before allocating the entries it claims to hold
+    const u64 footer_size = u64{trailer.entry_count} * sizeof(ChartSketchEntry);
+    if (trailer.footer_offset < sizeof(SketchHeader) || trailer.footer_offset > trailer_offset ||
+        footer_size != trailer_offset - trailer.footer_offset) {
+        printf("'%s' has a corrupted index\n", file_path.c_str());
+        return 1;
+    }
+    footer_offset = trailer.footer_offset;
+
+    entries.resize(trailer.entry_count);
+    file.seekg(static_cast<std::streamoff>(trailer.footer_offset));
+    file.read(reinterpret_cast<char*>(entries.data()),
+              static_cast<std::streamsize>(entries.size() * sizeof(ChartSketchEntry)));
+    if (!file) {
+        printf("'%s' has a corrupted index\n", file_path.c_str());
+        entries.clear();
+        return 1;
+    }
+
+    return 0;
+}
+
+std::span<const ChartSketchEntry> ChartSketchReader::GetEntries() const {
+    return entries;
+}
+
+u32 ChartSketchReader::GetBucketWidth() const {
+    return bucket_width;
+}
+
+int ChartSketchReader::QueryWindow(Sketch::TDigest& digest, u32& window_start, u64& window_end,
+                                   u32 source_id, u32 start_time, u32 end_time) {
+    const u32 first_bucket = start_time - start_time % bucket_width;
+    window_start = first_bucket;
+    window_end = first_bucket;
+    const auto compare = [](const ChartSketchEntry& a, const ChartSketchEntry& b) {
+        return std::tie(a.source_id, a.bucket_time) < std::tie(b.source_id, b.bucket_time);
+    };
+    const ChartSketchEntry first_entry{.source_id = source_id, .bucket_time = first_bucket};
+    auto it = std::lower_bound(entries.begin(), entries.end(), first_entry, compare);
+
+    Sketch::TDigest bucket_digest{};
+    for (; it != entries.end() && it->source_id == source_id && it->bucket_time <= end_time;
+         ++it) {
+        if (it->offset < sizeof(SketchHeader) || it->offset > footer_offset ||
+            it->size > footer_offset - it->offset) {
+            printf("Corrupted sketch of source %u\n", source_id);
+            return 1;
+        }
+        sketch_data.resize(it->size);
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(it->offset));
+        file.read(reinterpret_cast<char*>(sketch_data.data()),
+                  static_cast<std::streamsize>(sketch_data.size()));
+        if (!file || !bucket_digest.Deserialize(sketch_data)) {
+            printf("Corrupted sketch of source %u\n", source_id);
+            return 1;
+        }
+        digest.Merge(bucket_digest);
+
+        if (window_end == window_start) {
+            window_start = it->bucket_time;
+        }
+        window_end = u64{it->bucket_time} + bucket_width;
+    }
+    return 0;
+}
+
+int PrintChartPercentiles(const std::string& sketch_file, u32 source_id, u32 start_time,
+                          u32 end_time) {
+    ChartSketchReader reader{};
+    int rc = reader.Open(sketch_file);
+    if (rc != 0) {
+        return rc;
+    }
+
+    Sketch::TDigest digest{};
+    u32 window_start{};
+    u64 window_end{};
+    rc = reader.QueryWindow(digest, window_start, window_end, source_id, start_time, end_time);
+    if (rc != 0) {
+        return rc;
+    }
+
+    // Print the whole buckets the digest was merged from, not the requested times
+    printf("Source %u in [%u, %llu), %.0f values\n", source_id, window_start,
+           static_cast<unsigned long long>(window_end), digest.GetCount());
+    if (digest.GetCount() == 0) {
+        return 0;
+    }
+    printf("min %g p50 %g p90 %g p95 %g p99 %g max %g\n", digest.GetMin(), digest.Quantile(0.5),
+           digest.Quantile(0.9), digest.Quantile(0.95), digest.Quantile(0.99), digest.GetMax());
+    return 0;
+}
+
+} // namespace Database
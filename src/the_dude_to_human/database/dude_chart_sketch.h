@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+#include "the_dude_to_human/sketch/t_digest.h"
+
+namespace Database {
+class DudeDatabase;
+
+// Raw values of a data source are summarized by one t-digest per hour
+constexpr u32 ChartSketchBucketWidth = 60 * 60;
+
+// Percentile sketch file. Laid out like the chart archive: a header, one serialized digest per
+// source and bucket and a footer indexing them
+//
+// Header:  "DTDG" magic, u32 version, u32 bucket width, u32 reserved
+// Digests: TDigest::Serialize output
+// Footer:  ChartSketchEntry[entry_count] sorted by source and bucket time
+// Trailer: u64 footer offset, u32 entry_count, "DTDG" magic
+struct ChartSketchEntry {
+    u32 source_id{};
+    u32 bucket_time{};
+    u32 size{};
+    u32 padding{};
+    u64 offset{};
+};
+static_assert(sizeof(ChartSketchEntry) == 24, "ChartSketchEntry has wrong size");
+
+// Builds the sketches of every data source from chart_values_raw and saves them at out_file
+int WriteChartSketches(const DudeDatabase* db, const std::string& out_file);
+
+class ChartSketchReader {
+public:
+    int Open(const std::string& file_path);
+
+    std::span<const ChartSketchEntry> GetEntries() const;
+    u32 GetBucketWidth() const;
+
+    // Merges the sketches of source_id into digest. Every bucket overlapping start_time to
+    // end_time is included, so the window is rounded out to whole buckets. The merged buckets
+    // cover window_start <= time < window_end, an empty window if there are none
+    int QueryWindow(Sketch::TDigest& digest, u32& window_start, u64& window_end, u32 source_id,
+                    u32 start_time, u32 end_time);
+
+private:
+    std::ifstream file{};
+    u32 bucket_width{};
+    u64 footer_offset{};
+    std::vector<ChartSketchEntry> entries{};
+    std::vector<u8> sketch_data{};
+};
+
+// Prints the percentiles of source_id between start_time and end_time from a sketch file, along
+// with the whole buckets they were computed from
+int PrintChartPercentiles(const std::string& sketch_file, u32 source_id, u32 start_time,
+                          u32 end_time);
+} // namespace Database
@@ -0,0 +1,438 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <future>
+#include <map>
+#include <set>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHART_STATS_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define CHART_STATS_NEON
+#include <arm_neon.h>
+#endif
+
+#include "common/thread_pool.h"
+#include "the_dude_to_human/database/dude_chart_stats.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+struct StatsBlock {
+    f64 min{};
+    f64 max{};
+    f64 sum{};
+    f64 sum_squares{};
+    u64 crossings{};
+};
+
+// Aggregates a non empty block. Sums are relative to shift and crossings are only counted
+// between values of the block
+using AccumulateFunc = StatsBlock (*)(std::span<const f64> values, f64 shift, f64 threshold);
+
+// min and max match the operand order of the SIMD instructions so every kernel handles NaN
+// values the same way
+void AccumulateScalarRange(StatsBlock& block, std::span<const f64> values, std::size_t begin,
+                           f64 shift, f64 threshold) {
+    bool is_above = values[begin == 0 ? 0 : begin - 1] > threshold;
+    for (std::size_t i = begin; i < values.size(); ++i) {
+        const f64 value = values[i];
+        const f64 delta = value - shift;
+        const bool is_value_above = value > threshold;
+        block.min = value < block.min ? value : block.min;
+        block.max = value > block.max ? value : block.max;
+        block.sum += delta;
+        block.sum_squares += delta * delta;
+        block.crossings += is_value_above != is_above ? 1 : 0;
+        is_above = is_value_above;
+    }
+}
+
+StatsBlock AccumulateScalar(std::span<const f64> values, f64 shift, f64 threshold) {
+    StatsBlock block{.min = values[0], .max = values[0]};
+    AccumulateScalarRange(block, values, 0, shift, threshold);
+    return block;
+}
+
+#ifdef CHART_STATS_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+AVX2_TARGET f64 ReduceAdd(__m256d value) {
+    const __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+// Counts the threshold crossings of four values. Bit n is compared with bit n - 1, bit 0 with the
+// last value of the previous vector
+AVX2_TARGET u64 CountCrossings(__m256d value, __m256d threshold_vector, int& previous_above) {
+    const int above = _mm256_movemask_pd(_mm256_cmp_pd(value, threshold_vector, _CMP_GT_OQ));
+    const int previous = (above << 1) | previous_above;
+    previous_above = above >> 3;
+    return static_cast<u64>(std::popcount(static_cast<u32>((above ^ previous) & 0xf)));
+}
+
+AVX2_TARGET StatsBlock AccumulateAvx2(std::span<const f64> values, f64 shift, f64 threshold) {
+    const f64* data = values.data();
+    const __m256d shift_vector = _mm256_set1_pd(shift);
+    const __m256d threshold_vector = _mm256_set1_pd(threshold);
+
+    // Two sets of accumulators hide the latency of the additions
+    __m256d min_vector = _mm256_set1_pd(data[0]);
+    __m256d max_vector = min_vector;
+    __m256d sum_low = _mm256_setzero_pd();
+    __m256d sum_high = _mm256_setzero_pd();
+    __m256d square_low = _mm256_setzero_pd();
+    __m256d square_high = _mm256_setzero_pd();
+    int previous_above = data[0] > threshold ? 1 : 0;
+    u64 crossings = 0;
+
+    std::size_t i = 0;
+    for (; i + 8 <= values.size(); i += 8) {
+        const __m256d low = _mm256_loadu_pd(data + i);
+        const __m256d high = _mm256_loadu_pd(data + i + 4);
+        const __m256d low_delta = _mm256_sub_pd(low, shift_vector);
+        const __m256d high_delta = _mm256_sub_pd(high, shift_vector);
+        // Each vector is folded on its own, min(low, high) would return a NaN high value and drop
+        // the low one
+        min_vector = _mm256_min_pd(high, _mm256_min_pd(low, min_vector));
+        max_vector = _mm256_max_pd(high, _mm256_max_pd(low, max_vector));
+        sum_low = _mm256_add_pd(sum_low, low_delta);
+        sum_high = _mm256_add_pd(sum_high, high_delta);
+        square_low = _mm256_add_pd(square_low, _mm256_mul_pd(low_delta, low_delta));
+        square_high = _mm256_add_pd(square_high, _mm256_mul_pd(high_delta, high_delta));
+        crossings += CountCrossings(low, threshold_vector, previous_above);
+        crossings += CountCrossings(high, threshold_vector, previous_above);
+    }
+
+    alignas(32) std::array<f64, 4> min_values{};
+    alignas(32) std::array<f64, 4> max_values{};
+    _mm256_store_pd(min_values.data(), min_vector);
+    _mm256_store_pd(max_values.data(), max_vector);
+
+    StatsBlock block{
+        .min = min_values[0],
+        .max = max_values[0],
+        .sum = ReduceAdd(_mm256_add_pd(sum_low, sum_high)),
+        .sum_squares = ReduceAdd(_mm256_add_pd(square_low, square_high)),
+        .crossings = crossings,
+    };
+    for (std::size_t lane = 1; lane < 4; ++lane) {
+        block.min = min_values[lane] < block.min ? min_values[lane] : block.min;
+        block.max = max_values[lane] > block.max ? max_values[lane] : block.max;
+    }
+
+    AccumulateScalarRange(block, values, i, shift, threshold);
+    return block;
+}
+
+bool IsAvx2Supported() {
+#ifdef _MSC_VER
+    std::array<int, 4> info{};
+    __cpuid(info.data(), 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info.data(), 1);
+    // The OS must save the ymm registers on context switches
+    constexpr int OsxsaveBit = 1 << 27;
+    if ((info[2] & OsxsaveBit) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info.data(), 7, 0);
+    constexpr int Avx2Bit = 1 << 5;
+    return (info[1] & Avx2Bit) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef CHART_STATS_NEON
+StatsBlock AccumulateNeon(std::span<const f64> values, f64 shift, f64 threshold) {
+    const f64* data = values.data();
+    const float64x2_t shift_vector = vdupq_n_f64(shift);
+    const float64x2_t threshold_vector = vdupq_n_f64(threshold);
+
+    float64x2_t min_vector = vdupq_n_f64(data[0]);
+    float64x2_t max_vector = min_vector;
+    std::array<float64x2_t, 2> sum_vector{vdupq_n_f64(0), vdupq_n_f64(0)};
+    std::array<float64x2_t, 2> square_vector{vdupq_n_f64(0), vdupq_n_f64(0)};
+    u64 previous_above = data[0] > threshold ? 1 : 0;
+    u64 crossings = 0;
+
+    std::size_t i = 0;
+    for (; i + 4 <= values.size(); i += 4) {
+        for (std::size_t lane = 0; lane < 2; ++lane) {
+            const float64x2_t value = vld1q_f64(data + i + lane * 2);
+            const float64x2_t delta = vsubq_f64(value, shift_vector);
+            // Same operand order as the scalar kernel, vminq would propagate NaN values
+            min_vector = vbslq_f64(vcltq_f64(value, min_vector), value, min_vector);
+            max_vector = vbslq_f64(vcgtq_f64(value, max_vector), value, max_vector);
+            sum_vector[lane] = vaddq_f64(sum_vector[lane], delta);
+            square_vector[lane] = vfmaq_f64(square_vector[lane], delta, delta);
+
+            const uint64x2_t above = vshrq_n_u64(vcgtq_f64(value, threshold_vector), 63);
+            const u64 above_low = vgetq_lane_u64(above, 0);
+            const u64 above_high = vgetq_lane_u64(above, 1);
+            crossings += (above_low ^ previous_above) + (above_high ^ above_low);
+            previous_above = above_high;
+        }
+    }
+
+    StatsBlock block{
+        .min = vgetq_lane_f64(min_vector, 0),
+        .max = vgetq_lane_f64(max_vector, 0),
+        .sum = vaddvq_f64(vaddq_f64(sum_vector[0], sum_vector[1])),
+        .sum_squares = vaddvq_f64(vaddq_f64(square_vector[0], square_vector[1])),
+        .crossings = crossings,
+    };
+    const f64 min_high = vgetq_lane_f64(min_vector, 1);
+    const f64 max_high = vgetq_lane_f64(max_vector, 1);
+    block.min = min_high < block.min ? min_high : block.min;
+    block.max = max_high > block.max ? max_high : block.max;
+
+    AccumulateScalarRange(block, values, i, shift, threshold);
+    return block;
+}
+#endif
+
+AccumulateFunc GetAccumulateFunc(ChartStatsKernel kernel) {
+    switch (kernel) {
+#ifdef CHART_STATS_AVX2
+    case ChartStatsKernel::Avx2:
+        return AccumulateAvx2;
+#endif
+#ifdef CHART_STATS_NEON
+    case ChartStatsKernel::Neon:
+        return AccumulateNeon;
+#endif
+    default:
+        return AccumulateScalar;
+    }
+}
+
+ChartStatsKernel GetFastestKernel() {
+    static const ChartStatsKernel kernel = GetSupportedChartStatsKernels().back();
+    return kernel;
+}
+
+using SourceStats = std::map<u32, ChartStats>;
+
+// Values arrive ordered by source and time, each source is aggregated from a contiguous buffer
+SourceStats ComputeResolutionStats(int& rc, const DudeDatabase* db, ChartResolution resolution,
+                                   f64 threshold, u64& value_count) {
+    SourceStats stats{};
+    std::vector<f64> buffer{};
+    buffer.reserve(ChartStatsAccumulator::BlockValues);
+    ChartStatsAccumulator accumulator{threshold};
+    u32 source_id = 0;
+
+    const auto flush_buffer = [&] {
+        accumulator.Add(buffer);
+        buffer.clear();
+    };
+    const auto finish_source = [&] {
+        flush_buffer();
+        const ChartStats source_stats = accumulator.GetStats();
+        if (source_stats.count != 0) {
+            stats[source_id] = source_stats;
+        }
+        accumulator = ChartStatsAccumulator{threshold};
+    };
+
+    rc = db->ReadChartValues(resolution, [&](std::span<const ChartValue> values) {
+        for (const ChartValue& value : values) {
+            if (value.source_id != source_id) {
+                finish_source();
+                source_id = value.source_id;
+            }
+            if (buffer.size() == ChartStatsAccumulator::BlockValues) {
+                flush_buffer();
+            }
+            buffer.push_back(value.value);
+        }
+        value_count += values.size();
+        return 0;
+    });
+    finish_source();
+
+    return stats;
+}
+
+void PrintStatsRow(std::string_view line_name, u32 source_id, std::string_view source_name,
+                   ChartResolution resolution, const ChartStats& stats) {
+    printf("%-24.*s %10u %-6s %12llu %14.4f %14.4f %14.4f %14.4f %10llu  %.*s\n",
+           static_cast<int>(line_name.size()), line_name.data(), source_id,
+           GetChartResolutionName(resolution), static_cast<unsigned long long>(stats.count),
+           stats.min, stats.max, stats.mean, stats.stddev,
+           static_cast<unsigned long long>(stats.threshold_crossings),
+           static_cast<int>(source_name.size()), source_name.data());
+}
+
+} // Anonymous namespace
+
+ChartStatsAccumulator::ChartStatsAccumulator(f64 threshold_value)
+    : ChartStatsAccumulator{threshold_value, GetFastestKernel()} {}
+
+ChartStatsAccumulator::ChartStatsAccumulator(f64 threshold_value, ChartStatsKernel kernel_value)
+    : threshold{threshold_value}, kernel{kernel_value} {}
+
+void ChartStatsAccumulator::Add(std::span<const f64> values) {
+    if (values.empty()) {
+        return;
+    }
+
+    const bool is_first_above = values.front() > threshold;
+    if (count == 0) {
+        min = values.front();
+        max = values.front();
+        shift = values.front();
+    } else if (is_first_above != is_above) {
+        crossings++;
+    }
+
+    const StatsBlock block = GetAccumulateFunc(kernel)(values, shift, threshold);
+    count += values.size();
+    min = block.min < min ? block.min : min;
+    max = block.max > max ? block.max : max;
+    sum += block.sum;
+    sum_squares += block.sum_squares;
+    crossings += block.crossings;
+    is_above = values.back() > threshold;
+}
+
+ChartStats ChartStatsAccumulator::GetStats() const {
+    if (count == 0) {
+        return {};
+    }
+
+    const f64 total = static_cast<f64>(count);
+    const f64 mean_delta = sum / total;
+    const f64 variance = std::max(0.0, sum_squares / total - mean_delta * mean_delta);
+    return {
+        .count = count,
+        .min = min,
+        .max = max,
+        .mean = shift + mean_delta,
+        .stddev = std::sqrt(variance),
+        .threshold_crossings = crossings,
+    };
+}
+
+std::vector<ChartStatsKernel> GetSupportedChartStatsKernels() {
+    std::vector<ChartStatsKernel> kernels{ChartStatsKernel::Scalar};
+#if defined(CHART_STATS_AVX2)
+    if (IsAvx2Supported()) {
+        kernels.push_back(ChartStatsKernel::Avx2);
+    }
+#elif defined(CHART_STATS_NEON)
+    kernels.push_back(ChartStatsKernel::Neon);
+#endif
+    return kernels;
+}
+
+const char* GetChartStatsKernelName(ChartStatsKernel kernel) {
+    switch (kernel) {
+    case ChartStatsKernel::Scalar:
+        return "scalar";
+    case ChartStatsKernel::Avx2:
+        return "avx2";
+    case ChartStatsKernel::Neon:
+        return "neon";
+    }
+    return "scalar";
+}
+
+int PrintChartStatsReport(const DudeDatabase* db, f64 threshold) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Resolutions are read in parallel, each one streams its table in source order
+    Common::ThreadPool pool{};
+    std::array<std::future<SourceStats>, ChartResolutions.size()> results{};
+    std::array<int, ChartResolutions.size()> result_codes{};
+    std::array<u64, ChartResolutions.size()> value_counts{};
+    for (std::size_t i = 0; i < ChartResolutions.size(); ++i) {
+        results[i] = pool.Submit([&, i] {
+            return ComputeResolutionStats(result_codes[i], db, ChartResolutions[i], threshold,
+                                          value_counts[i]);
+        });
+    }
+
+    std::array<SourceStats, ChartResolutions.size()> stats{};
+    u64 value_count = 0;
+    for (std::size_t i = 0; i < ChartResolutions.size(); ++i) {
+        stats[i] = results[i].get();
+        if (result_codes[i] != 0) {
+            return result_codes[i];
+        }
+        value_count += value_counts[i];
+    }
+
+    const std::vector<DataSourceData> data_sources = db->GetDataSourceData();
+    const std::vector<ChartLineData> chart_lines = db->GetChartLineData();
+    std::multimap<u32, const ChartLineData*> source_lines{};
+    for (const ChartLineData& line : chart_lines) {
+        source_lines.emplace(static_cast<u32>(line.source_id.value), &line);
+    }
+
+    printf("%-24s %10s %-6s %12s %14s %14s %14s %14s %10s  %s\n", "line", "source", "res", "count",
+           "min", "max", "mean", "stddev", "crossings", "name");
+
+    const auto print_source = [&](u32 source_id, std::string_view source_name) {
+        const auto [first_line, last_line] = source_lines.equal_range(source_id);
+        for (std::size_t i = 0; i < ChartResolutions.size(); ++i) {
+            const auto it = stats[i].find(source_id);
+            if (it == stats[i].end()) {
+                continue;
+            }
+            if (first_line == last_line) {
+                PrintStatsRow("-", source_id, source_name, ChartResolutions[i], it->second);
+            }
+            for (auto line = first_line; line != last_line; ++line) {
+                PrintStatsRow(line->second->name.text, source_id, source_name,
+                              ChartResolutions[i], it->second);
+            }
+        }
+    };
+
+    std::set<u32> printed_sources{};
+    for (const DataSourceData& source : data_sources) {
+        const u32 source_id = static_cast<u32>(source.object_id.value);
+        print_source(source_id, source.name.text);
+        printed_sources.insert(source_id);
+    }
+
+    // Values left behind by deleted data sources
+    for (const SourceStats& resolution_stats : stats) {
+        for (const auto& [source_id, source_stats] : resolution_stats) {
+            if (!printed_sources.contains(source_id)) {
+                print_source(source_id, "(deleted)");
+                printed_sources.insert(source_id);
+            }
+        }
+    }
+
+    const std::chrono::duration<f64> elapsed = std::chrono::steady_clock::now() - start_time;
+    printf("Aggregated %llu values in %.3f s using the %s kernel, threshold %g\n",
+           static_cast<unsigned long long>(value_count), elapsed.count(),
+           GetChartStatsKernelName(GetFastestKernel()), threshold);
+    return 0;
+}
+
+} // namespace Database
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Database {
+class DudeDatabase;
+
+struct ChartStats {
+    u64 count{};
+    f64 min{};
+    f64 max{};
+    f64 mean{};
+    f64 stddev{};
+    // Consecutive values where one is above the threshold and the other isn't
+    u64 threshold_crossings{};
+};
+
+enum class ChartStatsKernel {
+    Scalar,
+    Avx2,
+    Neon,
+};
+
+// Running statistics of a series. Values are added in time order in one or more calls and
+// aggregated with SIMD kernels when the cpu supports them
+class ChartStatsAccumulator {
+public:
+    // Values per Add call of buffered series, keeps the buffer in cache
+    static constexpr std::size_t BlockValues = 0x4000;
+
+    explicit ChartStatsAccumulator(f64 threshold_value = 0);
+    // Uses kernel instead of the fastest one, it must be supported by the cpu
+    ChartStatsAccumulator(f64 threshold_value, ChartStatsKernel kernel_value);
+
+    void Add(std::span<const f64> values);
+    ChartStats GetStats() const;
+
+private:
+    f64 threshold{};
+    ChartStatsKernel kernel{};
+    u64 count{};
+    f64 min{};
+    f64 max{};
+    // Sums are relative to the first value to avoid cancellation on large values
+    f64 shift{};
+    f64 sum{};
+    f64 sum_squares{};
+    u64 crossings{};
+    bool is_above{};
+};
+
+// Kernels supported by this cpu, the fastest one last
+std::vector<ChartStatsKernel> GetSupportedChartStatsKernels();
+
+const char* GetChartStatsKernelName(ChartStatsKernel kernel);
+
+// Prints the statistics of every data source and resolution, one row per chart line drawing it
+int PrintChartStatsReport(const DudeDatabase* db, f64 threshold);
+} // namespace Database
@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <fmt/format.h>
+
+#include "the_dude_to_human/database/dude_charts.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+// Rows arrive ordered by source so only the file of the current source is open at any time
+class ChartSourceWriter {
+public:
+    static constexpr std::size_t FlushThreshold = 0x10000;
+
+    explicit ChartSourceWriter(std::filesystem::path directory) : out_dir{std::move(directory)} {
+        buffer.reserve(FlushThreshold * 2);
+    }
+
+    ~ChartSourceWriter() {
+        Close();
+    }
+
+    int Write(std::span<const ChartValue> values) {
+        for (const ChartValue& value : values) {
+            if (!file.is_open() || value.source_id != source_id) {
+                const int rc = Open(value.source_id);
+                if (rc != 0) {
+                    return rc;
+                }
+            }
+
+            fmt::format_to(std::back_inserter(buffer), "{},{}\n", value.time, value.value);
+            if (buffer.size() >= FlushThreshold) {
+                Flush();
+            }
+        }
+        return file.good() ? 0 : 1;
+    }
+
+    int Close() {
+        if (!file.is_open()) {
+            return 0;
+        }
+        Flush();
+        file.close();
+        return file.fail() ? 1 : 0;
+    }
+
+    std::size_t GetSourceCount() const {
+        return source_count;
+    }
+
+private:
+    int Open(u32 new_source_id) {
+        if (Close() != 0) {
+            return 1;
+        }
+
+        const std::filesystem::path file_path = out_dir / fmt::format("{}.csv", new_source_id);
+        file.open(file_path, std::ios::binary);
+        if (!file.is_open()) {
+            printf("Unable to open '%s'\n", file_path.string().c_str());
+            return 1;
+        }
+
+        source_id = new_source_id;
+        source_count++;
+        buffer.append("time,value\n");
+        return 0;
+    }
+
+    void Flush() {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+    std::filesystem::path out_dir;
+    std::ofstream file{};
+    std::string buffer{};
+    u32 source_id{};
+    std::size_t source_count{};
+};
+
+} // Anonymous namespace
+
+int ExportChartValuesCsv(const DudeDatabase* db, const std::string& out_dir) {
+    for (const ChartResolution resolution : ChartResolutions) {
+        const std::filesystem::path resolution_dir =
+            std::filesystem::path{out_dir} / GetChartResolutionName(resolution);
+
+        std::error_code ec;
+        std::filesystem::create_directories(resolution_dir, ec);
+        if (ec) {
+            printf("Unable to create directory '%s': %s\n", resolution_dir.string().c_str(),
+                   ec.message().c_str());
+            return 1;
+        }
+
+        std::size_t value_count = 0;
+        ChartSourceWriter writer{resolution_dir};
+        int rc = db->ReadChartValues(resolution, [&](std::span<const ChartValue> values) {
+            value_count += values.size();
+            return writer.Write(values);
+        });
+        if (rc == 0) {
+            rc = writer.Close();
+        }
+        if (rc != 0) {
+            printf("Unable to export %s\n", DudeDatabase::GetChartTableName(resolution));
+            return rc;
+        }
+
+        printf("Exported %zu values of %zu sources from %s\n", value_count,
+               writer.GetSourceCount(), DudeDatabase::GetChartTableName(resolution));
+    }
+
+    return 0;
+}
+
+int PrintChartValues(const DudeDatabase* db, u32 source_id, u32 start, u32 end) {
+    // The first query of a table without a rowid key also opens or builds its block index
+    const auto start_time = std::chrono::steady_clock::now();
+    ChartSeries series{};
+    const int rc = db->QueryChartValues(series, ChartResolution::Raw, source_id, start, end);
+    const std::chrono::duration<f64, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start_time;
+    if (rc != 0) {
+        return rc;
+    }
+
+    std::string out{};
+    for (std::size_t i = 0; i < series.times.size(); ++i) {
+        fmt::format_to(std::back_inserter(out), "{},{}\n", series.times[i], series.values[i]);
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    printf("Read %zu values of source %u in %.2f ms\n", series.times.size(), source_id,
+           elapsed.count());
+    return 0;
+}
+
+} // namespace Database
@@ -0,0 +1,20 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+
+#include "common/common_types.h"
+
+namespace Database {
+class DudeDatabase;
+
+// Writes the chart values of every resolution into <out_dir>/<resolution>/<source_id>.csv files
+// with time and value columns. Values are streamed so memory usage doesn't depend on the history
+int ExportChartValuesCsv(const DudeDatabase* db, const std::string& out_dir);
+
+// Prints the raw values of source_id with start <= time <= end as time,value lines, followed by
+// the time the query took
+int PrintChartValues(const DudeDatabase* db, u32 source_id, u32 start, u32 end);
+} // namespace Database
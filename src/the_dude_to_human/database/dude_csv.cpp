@@ -0,0 +1,260 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+
+#include "common/thread_pool.h"
+#include "the_dude_to_human/database/dude_csv.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Database {
+namespace {
+
+constexpr std::array<bool, 0x100> CreateQuoteTable() {
+    std::array<bool, 0x100> table{};
+    table[','] = true;
+    table['"'] = true;
+    table['\r'] = true;
+    table['\n'] = true;
+    return table;
+}
+
+// Characters that force a cell to be quoted
+constexpr std::array<bool, 0x100> NeedsQuote = CreateQuoteTable();
+
+// Buffered csv encoder. Cells are escaped as described by RFC 4180: cells containing commas,
+// quotes or line breaks are quoted and quotes are doubled
+class CsvWriter {
+public:
+    static constexpr std::size_t FlushThreshold = 0x10000;
+
+    explicit CsvWriter(std::ofstream& out_file) : file{out_file} {
+        buffer.reserve(FlushThreshold * 2);
+    }
+
+    ~CsvWriter() {
+        Flush();
+    }
+
+    void Flush() {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+    void WriteCell(std::string_view cell) {
+        StartCell();
+
+        std::size_t i = 0;
+        while (i < cell.size() && !NeedsQuote[static_cast<u8>(cell[i])]) {
+            i++;
+        }
+        if (i == cell.size()) {
+            buffer.append(cell);
+            return;
+        }
+
+        // Only quotes need escaping once the cell is quoted, copy the text between them
+        buffer.push_back('"');
+        while (!cell.empty()) {
+            const void* quote = std::memchr(cell.data(), '"', cell.size());
+            if (quote == nullptr) {
+                buffer.append(cell);
+                break;
+            }
+            const std::size_t length = static_cast<const char*>(quote) - cell.data() + 1;
+            buffer.append(cell.substr(0, length));
+            buffer.push_back('"');
+            cell.remove_prefix(length);
+        }
+        buffer.push_back('"');
+    }
+
+    void EndRow() {
+        buffer.append("\r\n");
+        is_first_cell = true;
+        if (buffer.size() >= FlushThreshold) {
+            Flush();
+        }
+    }
+
+private:
+    void StartCell() {
+        if (!is_first_cell) {
+            buffer.push_back(',');
+        }
+        is_first_cell = false;
+    }
+
+    std::ofstream& file;
+    std::string buffer{};
+    bool is_first_cell{true};
+};
+
+// Converts fields to cell text. Scalars match the json output, arrays are joined with the
+// configured delimiter
+class CsvCellFormatter {
+public:
+    explicit CsvCellFormatter(std::string_view delimiter) : array_delimiter{delimiter} {}
+
+    std::string_view Format(const BoolField& field) {
+        return field.value ? "true" : "false";
+    }
+
+    std::string_view Format(const ByteField& field) {
+        return FormatValue(field.value);
+    }
+
+    std::string_view Format(const IntField& field) {
+        return FormatValue(field.value);
+    }
+
+    std::string_view Format(const TimeField& field) {
+        return FormatValue(field.date);
+    }
+
+    std::string_view Format(const LongField& field) {
+        return FormatValue(field.value);
+    }
+
+    std::string_view Format(const LongLongField& field) {
+        cell.clear();
+        fmt::format_to(std::back_inserter(cell), "0x{:x}{:08x}", field.value[0], field.value[1]);
+        return cell;
+    }
+
+    std::string_view Format(const TextField& field) {
+        return field.text;
+    }
+
+    std::string_view Format(const LongArrayField& field) {
+        return Join(field.data,
+                    [this](u8 byte) { fmt::format_to(std::back_inserter(cell), "{}", byte); });
+    }
+
+    std::string_view Format(const IntArrayField& field) {
+        return Join(field.data,
+                    [this](u32 entry) { fmt::format_to(std::back_inserter(cell), "{}", entry); });
+    }
+
+    std::string_view Format(const IpArrayField& field) {
+        return Join(field.data, [this](u32 entry) {
+            IpAddress ip{};
+            std::memcpy(&ip, &entry, sizeof(u32));
+            fmt::format_to(std::back_inserter(cell), "{}.{}.{}.{}", ip[0], ip[1], ip[2], ip[3]);
+        });
+    }
+
+    std::string_view Format(const MacAddressField& field) {
+        return Join(field.mac_address, [this](const MacAddress& mac) {
+            fmt::format_to(std::back_inserter(cell), "{:02x}:{:02x}:{:02x}:{:02x}:{:02x}:{:02x}",
+                           mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        });
+    }
+
+    std::string_view Format(const StringArrayField& field) {
+        return Join(field.entries,
+                    [this](const StringArrayEntry& entry) { cell.append(entry.text); });
+    }
+
+private:
+    template <typename T>
+    std::string_view FormatValue(T value) {
+        cell.clear();
+        fmt::format_to(std::back_inserter(cell), "{}", value);
+        return cell;
+    }
+
+    template <typename Container, typename Func>
+    std::string_view Join(const Container& entries, Func&& format_entry) {
+        cell.clear();
+        bool is_first = true;
+        for (const auto& entry : entries) {
+            if (!is_first) {
+                cell.append(array_delimiter);
+            }
+            is_first = false;
+            format_entry(entry);
+        }
+        return cell;
+    }
+
+    std::string_view array_delimiter;
+    std::string cell{};
+};
+
+template <typename T>
+int SerializeTable(const std::filesystem::path& file_path, const std::vector<T>& objects,
+                   bool has_credentials, std::string_view array_delimiter) {
+    std::ofstream csv_file(file_path, std::ios::binary);
+    if (!csv_file.is_open()) {
+        printf("Unable to open '%s'\n", file_path.string().c_str());
+        return 1;
+    }
+
+    {
+        CsvWriter writer{csv_file};
+        CsvCellFormatter formatter{array_delimiter};
+
+        T{}.VisitFields([&writer](std::string_view name, const auto&) { writer.WriteCell(name); },
+                        has_credentials);
+        writer.EndRow();
+
+        for (const T& data : objects) {
+            data.VisitFields(
+                [&](std::string_view, const auto& field) {
+                    writer.WriteCell(formatter.Format(field));
+                },
+                has_credentials);
+            writer.EndRow();
+        }
+    }
+
+    csv_file.close();
+    return csv_file.fail() ? 1 : 0;
+}
+
+} // Anonymous namespace
+
+int SerializeDatabaseCsv(DudeDatabase* db, const std::string& out_dir, bool has_credentials,
+                         const std::string& array_delimiter) {
+    std::error_code ec;
+    std::filesystem::create_directories(out_dir, ec);
+    if (ec) {
+        printf("Unable to create directory '%s': %s\n", out_dir.c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    // Tables are loaded and written in parallel. The objs table is read once by
+    // ForEachTableLoader and shared by the loaders, each loader only parses its own table
+    Common::ThreadPool pool{};
+    std::vector<std::future<int>> results{};
+    results.reserve(DudeDatabase::TableCount);
+
+    db->ForEachTableLoader([&](std::string_view table_name, auto loader) {
+        const std::filesystem::path file_path =
+            std::filesystem::path{out_dir} / (std::string{table_name} + ".csv");
+        results.push_back(pool.Submit([=] {
+            return SerializeTable(file_path, loader(), has_credentials, array_delimiter);
+        }));
+    });
+
+    int rc = 0;
+    for (auto& result : results) {
+        const int table_rc = result.get();
+        if (table_rc != 0) {
+            rc = table_rc;
+        }
+    }
+    return rc;
+}
+
+} // namespace Database
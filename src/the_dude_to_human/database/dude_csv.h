@@ -0,0 +1,15 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+
+namespace Database {
+class DudeDatabase;
+
+// Writes one RFC 4180 csv file per table into out_dir. Array entries are joined with
+// array_delimiter inside a single cell
+int SerializeDatabaseCsv(DudeDatabase* db, const std::string& out_dir, bool has_credentials,
+                         const std::string& array_delimiter);
+} // namespace Database
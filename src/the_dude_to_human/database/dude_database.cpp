@@ -4,10 +4,18 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdio>
+#include <limits>
+#include <utility>
 
+#include "the_dude_to_human/database/dude_arrow.h"
+#include "the_dude_to_human/database/dude_chart_index.h"
+#include "the_dude_to_human/database/dude_csv.h"
 #include "the_dude_to_human/database/dude_database.h"
 #include "the_dude_to_human/database/dude_field_parser.h"
 #include "the_dude_to_human/database/dude_json.h"
+#include "the_dude_to_human/database/dude_msgpack.h"
+#include "the_dude_to_human/database/dude_openmetrics.h"
+#include "the_dude_to_human/database/dude_sqlite.h"
 
 namespace Database {
 DudeDatabase::DudeDatabase(const std::string& db_file) : db{db_file} {
@@ -19,6 +27,16 @@ DudeDatabase::DudeDatabase(const std::string& db_file) : db{db_file} {
     printf("Opened database successfully\n");
 }
 
+DudeDatabase::DudeDatabase(const std::string& name, std::vector<u8> db_data)
+    : db{name, std::move(db_data)} {
+    int rc = db.OpenDatabase();
+    if (rc != 0) {
+        printf("Error at '%s': %s\n", name.c_str(), db.GetError());
+        return;
+    }
+    printf("Opened database successfully\n");
+}
+
 DudeDatabase::~DudeDatabase() {
     db.CloseDatabase();
 }
@@ -39,16 +57,226 @@ int DudeDatabase::GetChartValues1Day(Sqlite::SqlData& data) const {
     return db.GetTableData(data, "chart_values_1day");
 }
 
+int DudeDatabase::ReadChartValues(ChartResolution resolution,
+                                  const ChartValueCallback& callback) const {
+    // Rows decoded per callback, keeps memory bounded on databases with years of history
+    constexpr std::size_t ChartBatchSize = 0x10000;
+
+    std::vector<ChartValue> values{};
+    values.reserve(ChartBatchSize);
+    const auto decode_rows = [&](std::span<const Sqlite::SqlKeyValue> rows) {
+        values.clear();
+        for (const Sqlite::SqlKeyValue& row : rows) {
+            values.push_back({
+                .source_id = static_cast<u32>(row.key >> 32),
+                .time = static_cast<u32>(row.key),
+                .value = row.value,
+            });
+        }
+        return callback(values);
+    };
+
+    return db.StreamKeyValueData(GetChartTableName(resolution), ChartBatchSize, decode_rows);
+}
+
+const char* DudeDatabase::GetChartTableName(ChartResolution resolution) {
+    switch (resolution) {
+    case ChartResolution::Raw:
+        return "chart_values_raw";
+    case ChartResolution::TenMinutes:
+        return "chart_values_10min";
+    case ChartResolution::TwoHours:
+        return "chart_values_2hour";
+    case ChartResolution::OneDay:
+        return "chart_values_1day";
+    }
+    return "chart_values_raw";
+}
+
+int DudeDatabase::QueryChartValues(ChartSeries& series, ChartResolution resolution,
+                                   u32 source_id, u32 start_time, u32 end_time) const {
+    series = {.source_id = source_id, .resolution = resolution};
+
+    std::vector<std::pair<s64, s64>> ranges{};
+    int rc = GetChartRowidRanges(ranges, resolution, source_id, start_time, end_time);
+    if (rc != 0) {
+        return rc;
+    }
+
+    std::vector<Sqlite::SqlKeyValue> rows{};
+    for (const auto& [first_rowid, last_rowid] : ranges) {
+        rc = db.GetKeyValueRange(rows, GetChartTableName(resolution), first_rowid, last_rowid);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    // Blocks may hold other sources or times outside of the requested range
+    std::vector<std::pair<u32, f64>> values{};
+    values.reserve(rows.size());
+    for (const Sqlite::SqlKeyValue& row : rows) {
+        const u32 time = static_cast<u32>(row.key);
+        if (static_cast<u32>(row.key >> 32) == source_id && time >= start_time &&
+            time <= end_time) {
+            values.emplace_back(time, row.value);
+        }
+    }
+    std::stable_sort(values.begin(), values.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    series.times.reserve(values.size());
+    series.values.reserve(values.size());
+    for (const auto& [time, value] : values) {
+        series.times.push_back(time);
+        series.values.push_back(value);
+    }
+    return 0;
+}
+
+int DudeDatabase::GetLastChartTime(u32& last_time, ChartResolution resolution) const {
+    const std::string table_name = GetChartTableName(resolution);
+    last_time = 0;
+
+    int rc = 0;
+    std::scoped_lock lock{chart_table_mutex};
+    const ChartTableInfo* info = GetChartTableInfo(rc, resolution);
+    if (info == nullptr) {
+        return rc;
+    }
+
+    if (!info->is_rowid_key) {
+        last_time = info->index->GetLastTime();
+        return 0;
+    }
+
+    // Walk back from the newest row of each source, one lookup per source
+    s64 limit = std::numeric_limits<s64>::max();
+    while (true) {
+        s64 rowid{};
+        rc = db.GetMaxRowidBelow(rowid, table_name, limit);
+        if (rc == SQLITE_NOTFOUND) {
+            return 0;
+        }
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+
+        last_time = std::max(last_time, static_cast<u32>(rowid));
+        const s64 source_key = rowid & ~s64{0xffffffff};
+        if (source_key <= 0) {
+            return 0;
+        }
+        limit = source_key - 1;
+    }
+}
+
+DudeDatabase::ChartTableInfo* DudeDatabase::GetChartTableInfo(int& rc,
+                                                              ChartResolution resolution) const {
+    const std::string table_name = GetChartTableName(resolution);
+    ChartTableInfo& info = chart_tables[static_cast<std::size_t>(resolution)];
+    rc = 0;
+
+    if (info.is_checked) {
+        return &info;
+    }
+
+    rc = db.IsRowidKey(info.is_rowid_key, table_name);
+    if (rc != 0) {
+        return nullptr;
+    }
+    if (!info.is_rowid_key) {
+        info.index = std::make_unique<ChartBlockIndex>();
+        // Downloaded databases have no file to save the index next to
+        const std::string index_path =
+            db.IsMemoryDatabase() ? "" : db.GetFilename() + "." + table_name + ".idx";
+        rc = info.index->Open(db, table_name, index_path);
+        if (rc != 0) {
+            info.index.reset();
+            return nullptr;
+        }
+    }
+
+    info.is_checked = true;
+    return &info;
+}
+
+int DudeDatabase::GetChartRowidRanges(std::vector<std::pair<s64, s64>>& ranges,
+                                      ChartResolution resolution, u32 source_id, u32 start_time,
+                                      u32 end_time) const {
+    int rc = 0;
+    std::scoped_lock lock{chart_table_mutex};
+    const ChartTableInfo* info = GetChartTableInfo(rc, resolution);
+    if (info == nullptr) {
+        return rc;
+    }
+
+    if (info->is_rowid_key) {
+        const s64 source_key = static_cast<s64>(source_id) << 32;
+        ranges.emplace_back(source_key | start_time, source_key | end_time);
+        return 0;
+    }
+
+    ranges = info->index->FindRowidRanges(source_id, start_time, end_time);
+    return 0;
+}
+
+int DudeDatabase::ReadOutages(std::vector<Outage>& outages) const {
+    static constexpr std::array<std::string_view, 6> columns{
+        "serviceID", "deviceID", "mapID", "status", "time", "duration",
+    };
+
+    return db.StreamIntegerRows("outages", columns, [&outages](std::span<const s64> row) {
+        const u32 start_time = static_cast<u32>(row[4]);
+        const u64 end_time = start_time + static_cast<u64>(std::max<s64>(row[5], 0));
+        outages.push_back({
+            .service_id = static_cast<u32>(row[0]),
+            .device_id = static_cast<u32>(row[1]),
+            .map_id = static_cast<u32>(row[2]),
+            .status = static_cast<u32>(row[3]),
+            .start_time = start_time,
+            .end_time = static_cast<u32>(std::min<u64>(end_time, std::numeric_limits<u32>::max())),
+        });
+        return 0;
+    });
+}
+
 int DudeDatabase::GetObjs(Sqlite::SqlData& data) const {
     return db.GetTableData(data, "objs");
 }
 
+DudeDatabase::ObjectRows DudeDatabase::GetObjectRows() const {
+    Sqlite::SqlData sql_data{};
+    GetObjs(sql_data);
+
+    ObjectRows rows{};
+    for (auto& row : sql_data) {
+        const DataFormat format = DudeFieldParser{row.second}.GetMainFormat();
+        rows[format].push_back(std::move(row));
+    }
+    return rows;
+}
+
 int DudeDatabase::GetOutages(Sqlite::SqlData& data) const {
     return db.GetTableData(data, "outages");
 }
 
-int DudeDatabase::SaveDatabase(const std::string& db_file, bool has_credentials) {
-    return SerializeDatabaseJson(this, db_file, has_credentials);
+int DudeDatabase::SaveDatabase(const std::string& db_file, bool has_credentials,
+                               const ExportOptions& options) {
+    switch (options.format) {
+    case ExportFormat::Json:
+        return SerializeDatabaseJson(this, db_file, has_credentials);
+    case ExportFormat::Msgpack:
+        return SerializeDatabaseMsgpack(this, db_file, has_credentials);
+    case ExportFormat::Sqlite:
+        return SerializeDatabaseSqlite(this, db_file, has_credentials);
+    case ExportFormat::Arrow:
+        return SerializeDatabaseArrow(this, db_file, has_credentials, options.batch_size);
+    case ExportFormat::Csv:
+        return SerializeDatabaseCsv(this, db_file, has_credentials, options.array_delimiter);
+    case ExportFormat::OpenMetrics:
+        return SerializeDatabaseOpenMetrics(this, db_file, OpenMetricsRunSamples);
+    }
+    return 1;
 }
 
 std::vector<DataFormat> DudeDatabase::ListUsedDataFormats() const {
@@ -91,14 +319,19 @@ std::vector<DeviceData> DudeDatabase::ListDeviceData() const {
 }
 
 template <typename T>
-std::vector<T> DudeDatabase::GetObjectData(DataFormat format,
+std::vector<T> DudeDatabase::GetObjectData(const ObjectRows* rows, DataFormat format,
                                            T (DudeDatabase::*RawToObjData)(DudeFieldParser& parser)
                                                const) const {
     std::vector<T> data{};
-    Sqlite::SqlData sql_data{};
-    GetObjs(sql_data);
+    Sqlite::SqlData objs{};
+    const Sqlite::SqlData* sql_data = &objs;
+    if (rows == nullptr) {
+        GetObjs(objs);
+    } else if (const auto it = rows->find(format); it != rows->end()) {
+        sql_data = &it->second;
+    }
 
-    for (auto& [id, blob] : sql_data) {
+    for (const auto& [id, blob] : *sql_data) {
         DudeFieldParser parser{blob};
 
         if (parser.GetMainFormat() != format) {
@@ -120,101 +353,107 @@ std::vector<T> DudeDatabase::GetObjectData(DataFormat format,
     return data;
 }
 
-std::vector<ServerConfigData> DudeDatabase::GetServerConfigData() const {
-    return GetObjectData<ServerConfigData>(DataFormat::ServerConfig,
+std::vector<ServerConfigData> DudeDatabase::GetServerConfigData(const ObjectRows* rows) const {
+    return GetObjectData<ServerConfigData>(rows, DataFormat::ServerConfig,
                                            &DudeDatabase::GetServerConfigData);
 }
 
-std::vector<ToolData> DudeDatabase::GetToolData() const {
-    return GetObjectData<ToolData>(DataFormat::Tool, &DudeDatabase::GetToolData);
+std::vector<ToolData> DudeDatabase::GetToolData(const ObjectRows* rows) const {
+    return GetObjectData<ToolData>(rows, DataFormat::Tool, &DudeDatabase::GetToolData);
 }
 
-std::vector<FileData> DudeDatabase::GetFileData() const {
-    return GetObjectData<FileData>(DataFormat::File, &DudeDatabase::GetFileData);
+std::vector<FileData> DudeDatabase::GetFileData(const ObjectRows* rows) const {
+    return GetObjectData<FileData>(rows, DataFormat::File, &DudeDatabase::GetFileData);
 }
 
-std::vector<NotesData> DudeDatabase::GetNotesData() const {
-    return GetObjectData<NotesData>(DataFormat::Notes, &DudeDatabase::GetNotesData);
+std::vector<NotesData> DudeDatabase::GetNotesData(const ObjectRows* rows) const {
+    return GetObjectData<NotesData>(rows, DataFormat::Notes, &DudeDatabase::GetNotesData);
 }
 
-std::vector<MapData> DudeDatabase::GetMapData() const {
-    return GetObjectData<MapData>(DataFormat::Map, &DudeDatabase::GetMapData);
+std::vector<MapData> DudeDatabase::GetMapData(const ObjectRows* rows) const {
+    return GetObjectData<MapData>(rows, DataFormat::Map, &DudeDatabase::GetMapData);
 }
 
-std::vector<ProbeData> DudeDatabase::GetProbeData() const {
-    return GetObjectData<ProbeData>(DataFormat::Probe, &DudeDatabase::GetProbeData);
+std::vector<ProbeData> DudeDatabase::GetProbeData(const ObjectRows* rows) const {
+    return GetObjectData<ProbeData>(rows, DataFormat::Probe, &DudeDatabase::GetProbeData);
 }
 
-std::vector<DeviceTypeData> DudeDatabase::GetDeviceTypeData() const {
-    return GetObjectData<DeviceTypeData>(DataFormat::DeviceType, &DudeDatabase::GetDeviceTypeData);
+std::vector<DeviceTypeData> DudeDatabase::GetDeviceTypeData(const ObjectRows* rows) const {
+    return GetObjectData<DeviceTypeData>(rows, DataFormat::DeviceType,
+                                         &DudeDatabase::GetDeviceTypeData);
 }
 
-std::vector<DeviceData> DudeDatabase::GetDeviceData() const {
-    return GetObjectData<DeviceData>(DataFormat::Device, &DudeDatabase::GetDeviceData);
+std::vector<DeviceData> DudeDatabase::GetDeviceData(const ObjectRows* rows) const {
+    return GetObjectData<DeviceData>(rows, DataFormat::Device, &DudeDatabase::GetDeviceData);
 }
 
-std::vector<NetworkData> DudeDatabase::GetNetworkData() const {
-    return GetObjectData<NetworkData>(DataFormat::Network, &DudeDatabase::GetNetworkData);
+std::vector<NetworkData> DudeDatabase::GetNetworkData(const ObjectRows* rows) const {
+    return GetObjectData<NetworkData>(rows, DataFormat::Network, &DudeDatabase::GetNetworkData);
 }
 
-std::vector<ServiceData> DudeDatabase::GetServiceData() const {
-    return GetObjectData<ServiceData>(DataFormat::Service, &DudeDatabase::GetServiceData);
+std::vector<ServiceData> DudeDatabase::GetServiceData(const ObjectRows* rows) const {
+    return GetObjectData<ServiceData>(rows, DataFormat::Service, &DudeDatabase::GetServiceData);
 }
 
-std::vector<NotificationData> DudeDatabase::GetNotificationData() const {
-    return GetObjectData<NotificationData>(DataFormat::Notification,
+std::vector<NotificationData> DudeDatabase::GetNotificationData(const ObjectRows* rows) const {
+    return GetObjectData<NotificationData>(rows, DataFormat::Notification,
                                            &DudeDatabase::GetNotificationData);
 }
 
-std::vector<LinkData> DudeDatabase::GetLinkData() const {
-    return GetObjectData<LinkData>(DataFormat::Link, &DudeDatabase::GetLinkData);
+std::vector<LinkData> DudeDatabase::GetLinkData(const ObjectRows* rows) const {
+    return GetObjectData<LinkData>(rows, DataFormat::Link, &DudeDatabase::GetLinkData);
 }
 
-std::vector<LinkTypeData> DudeDatabase::GetLinkTypeData() const {
-    return GetObjectData<LinkTypeData>(DataFormat::LinkType, &DudeDatabase::GetLinkTypeData);
+std::vector<LinkTypeData> DudeDatabase::GetLinkTypeData(const ObjectRows* rows) const {
+    return GetObjectData<LinkTypeData>(rows, DataFormat::LinkType, &DudeDatabase::GetLinkTypeData);
 }
 
-std::vector<DataSourceData> DudeDatabase::GetDataSourceData() const {
-    return GetObjectData<DataSourceData>(DataFormat::DataSource, &DudeDatabase::GetDataSourceData);
+std::vector<DataSourceData> DudeDatabase::GetDataSourceData(const ObjectRows* rows) const {
+    return GetObjectData<DataSourceData>(rows, DataFormat::DataSource,
+                                         &DudeDatabase::GetDataSourceData);
 }
 
-std::vector<ObjectListData> DudeDatabase::GetObjectListData() const {
-    return GetObjectData<ObjectListData>(DataFormat::ObjectList, &DudeDatabase::GetObjectListData);
+std::vector<ObjectListData> DudeDatabase::GetObjectListData(const ObjectRows* rows) const {
+    return GetObjectData<ObjectListData>(rows, DataFormat::ObjectList,
+                                         &DudeDatabase::GetObjectListData);
 }
 
-std::vector<DeviceGroupData> DudeDatabase::GetDeviceGroupData() const {
-    return GetObjectData<DeviceGroupData>(DataFormat::DeviceGroup,
+std::vector<DeviceGroupData> DudeDatabase::GetDeviceGroupData(const ObjectRows* rows) const {
+    return GetObjectData<DeviceGroupData>(rows, DataFormat::DeviceGroup,
                                           &DudeDatabase::GetDeviceGroupData);
 }
 
-std::vector<FunctionData> DudeDatabase::GetFunctionData() const {
-    return GetObjectData<FunctionData>(DataFormat::Function, &DudeDatabase::GetFunctionData);
+std::vector<FunctionData> DudeDatabase::GetFunctionData(const ObjectRows* rows) const {
+    return GetObjectData<FunctionData>(rows, DataFormat::Function, &DudeDatabase::GetFunctionData);
 }
 
-std::vector<SnmpProfileData> DudeDatabase::GetSnmpProfileData() const {
-    return GetObjectData<SnmpProfileData>(DataFormat::SnmpProfile,
+std::vector<SnmpProfileData> DudeDatabase::GetSnmpProfileData(const ObjectRows* rows) const {
+    return GetObjectData<SnmpProfileData>(rows, DataFormat::SnmpProfile,
                                           &DudeDatabase::GetSnmpProfileData);
 }
 
-std::vector<PanelData> DudeDatabase::GetPanelData() const {
-    return GetObjectData<PanelData>(DataFormat::Panel, &DudeDatabase::GetPanelData);
+std::vector<PanelData> DudeDatabase::GetPanelData(const ObjectRows* rows) const {
+    return GetObjectData<PanelData>(rows, DataFormat::Panel, &DudeDatabase::GetPanelData);
 }
 
-std::vector<SysLogRuleData> DudeDatabase::GetSysLogRuleData() const {
-    return GetObjectData<SysLogRuleData>(DataFormat::SysLogRule, &DudeDatabase::GetSysLogRuleData);
+std::vector<SysLogRuleData> DudeDatabase::GetSysLogRuleData(const ObjectRows* rows) const {
+    return GetObjectData<SysLogRuleData>(rows, DataFormat::SysLogRule,
+                                         &DudeDatabase::GetSysLogRuleData);
 }
 
-std::vector<NetworkMapElementData> DudeDatabase::GetNetworkMapElementData() const {
-    return GetObjectData<NetworkMapElementData>(DataFormat::NetworkMapElement,
+std::vector<NetworkMapElementData> DudeDatabase::GetNetworkMapElementData(
+    const ObjectRows* rows) const {
+    return GetObjectData<NetworkMapElementData>(rows, DataFormat::NetworkMapElement,
                                                 &DudeDatabase::GetNetworkMapElementData);
 }
 
-std::vector<ChartLineData> DudeDatabase::GetChartLineData() const {
-    return GetObjectData<ChartLineData>(DataFormat::ChartLine, &DudeDatabase::GetChartLineData);
+std::vector<ChartLineData> DudeDatabase::GetChartLineData(const ObjectRows* rows) const {
+    return GetObjectData<ChartLineData>(rows, DataFormat::ChartLine,
+                                        &DudeDatabase::GetChartLineData);
 }
 
-std::vector<PanelElementData> DudeDatabase::GetPanelElementData() const {
-    return GetObjectData<PanelElementData>(DataFormat::PanelElement,
+std::vector<PanelElementData> DudeDatabase::GetPanelElementData(const ObjectRows* rows) const {
+    return GetObjectData<PanelElementData>(rows, DataFormat::PanelElement,
                                            &DudeDatabase::GetPanelElementData);
 }
 
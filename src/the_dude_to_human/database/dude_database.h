@@ -3,8 +3,15 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "common/common_types.h"
@@ -12,11 +19,33 @@
 #include "the_dude_to_human/sqlite/sqlite_reader.h"
 
 namespace Database {
+class ChartBlockIndex;
 class DudeFieldParser;
 
+enum class ExportFormat {
+    Json,
+    Msgpack,
+    Sqlite,
+    Arrow,
+    Csv,
+    OpenMetrics,
+};
+
+using ChartValueCallback = std::function<int(std::span<const ChartValue>)>;
+
+struct ExportOptions {
+    ExportFormat format{ExportFormat::Json};
+    // Rows per record batch of columnar formats
+    std::size_t batch_size{0x10000};
+    // Separator between array entries of csv cells
+    std::string array_delimiter{";"};
+};
+
 class DudeDatabase {
 public:
     DudeDatabase(const std::string& db_file);
+    // Opens a downloaded database image without writing it to disk
+    DudeDatabase(const std::string& name, std::vector<u8> db_data);
     ~DudeDatabase();
 
     int GetChartValuesRaw(Sqlite::SqlData& data) const;
@@ -24,10 +53,32 @@ public:
     int GetChartValues2Hour(Sqlite::SqlData& data) const;
     int GetChartValues1Day(Sqlite::SqlData& data) const;
 
+    // Streams decoded chart values ordered by source and time in batches. Returns the first non
+    // zero value returned by callback
+    int ReadChartValues(ChartResolution resolution, const ChartValueCallback& callback) const;
+    static const char* GetChartTableName(ChartResolution resolution);
+
+    // Reads the values of source_id with start_time <= time <= end_time. Tables keyed by rowid
+    // are read with a key range lookup, other tables use a block index built on first use and
+    // saved next to the database file
+    int QueryChartValues(ChartSeries& series, ChartResolution resolution, u32 source_id,
+                         u32 start_time, u32 end_time) const;
+
+    // Finds the newest time of any source, zero if the table is empty
+    int GetLastChartTime(u32& last_time, ChartResolution resolution) const;
+
+    // Decodes every row of the outages table in table order
+    int ReadOutages(std::vector<Outage>& outages) const;
+
     int GetObjs(Sqlite::SqlData& data) const;
+    // Rows of the objs table grouped by their main format
+    using ObjectRows = std::unordered_map<DataFormat, Sqlite::SqlData>;
+    // Reads the objs table once, so several tables can be decoded from a single read
+    ObjectRows GetObjectRows() const;
     int GetOutages(Sqlite::SqlData& data) const;
 
-    int SaveDatabase(const std::string& db_file, bool has_credentials);
+    int SaveDatabase(const std::string& db_file, bool has_credentials,
+                     const ExportOptions& options = {});
 
     // Usefull to find new unsuported types
     std::vector<DataFormat> ListUsedDataFormats() const;
@@ -35,33 +86,88 @@ public:
     std::vector<MapData> ListMapData() const;
     std::vector<DeviceData> ListDeviceData() const;
 
-    std::vector<ServerConfigData> GetServerConfigData() const;
-    std::vector<ToolData> GetToolData() const;
-    std::vector<FileData> GetFileData() const;
-    std::vector<NotesData> GetNotesData() const;
-    std::vector<MapData> GetMapData() const;
-    std::vector<ProbeData> GetProbeData() const;
-    std::vector<DeviceTypeData> GetDeviceTypeData() const;
-    std::vector<DeviceData> GetDeviceData() const;
-    std::vector<NetworkData> GetNetworkData() const;
-    std::vector<ServiceData> GetServiceData() const;
-    std::vector<NotificationData> GetNotificationData() const;
-    std::vector<LinkData> GetLinkData() const;
-    std::vector<LinkTypeData> GetLinkTypeData() const;
-    std::vector<DataSourceData> GetDataSourceData() const;
-    std::vector<ObjectListData> GetObjectListData() const;
-    std::vector<DeviceGroupData> GetDeviceGroupData() const;
-    std::vector<FunctionData> GetFunctionData() const;
-    std::vector<SnmpProfileData> GetSnmpProfileData() const;
-    std::vector<PanelData> GetPanelData() const;
-    std::vector<SysLogRuleData> GetSysLogRuleData() const;
-    std::vector<NetworkMapElementData> GetNetworkMapElementData() const;
-    std::vector<ChartLineData> GetChartLineData() const;
-    std::vector<PanelElementData> GetPanelElementData() const;
+    // Decodes the objects of a table from rows, or from a new read of the objs table if null
+    std::vector<ServerConfigData> GetServerConfigData(const ObjectRows* rows = nullptr) const;
+    std::vector<ToolData> GetToolData(const ObjectRows* rows = nullptr) const;
+    std::vector<FileData> GetFileData(const ObjectRows* rows = nullptr) const;
+    std::vector<NotesData> GetNotesData(const ObjectRows* rows = nullptr) const;
+    std::vector<MapData> GetMapData(const ObjectRows* rows = nullptr) const;
+    std::vector<ProbeData> GetProbeData(const ObjectRows* rows = nullptr) const;
+    std::vector<DeviceTypeData> GetDeviceTypeData(const ObjectRows* rows = nullptr) const;
+    std::vector<DeviceData> GetDeviceData(const ObjectRows* rows = nullptr) const;
+    std::vector<NetworkData> GetNetworkData(const ObjectRows* rows = nullptr) const;
+    std::vector<ServiceData> GetServiceData(const ObjectRows* rows = nullptr) const;
+    std::vector<NotificationData> GetNotificationData(const ObjectRows* rows = nullptr) const;
+    std::vector<LinkData> GetLinkData(const ObjectRows* rows = nullptr) const;
+    std::vector<LinkTypeData> GetLinkTypeData(const ObjectRows* rows = nullptr) const;
+    std::vector<DataSourceData> GetDataSourceData(const ObjectRows* rows = nullptr) const;
+    std::vector<ObjectListData> GetObjectListData(const ObjectRows* rows = nullptr) const;
+    std::vector<DeviceGroupData> GetDeviceGroupData(const ObjectRows* rows = nullptr) const;
+    std::vector<FunctionData> GetFunctionData(const ObjectRows* rows = nullptr) const;
+    std::vector<SnmpProfileData> GetSnmpProfileData(const ObjectRows* rows = nullptr) const;
+    std::vector<PanelData> GetPanelData(const ObjectRows* rows = nullptr) const;
+    std::vector<SysLogRuleData> GetSysLogRuleData(const ObjectRows* rows = nullptr) const;
+    std::vector<NetworkMapElementData> GetNetworkMapElementData(
+        const ObjectRows* rows = nullptr) const;
+    std::vector<ChartLineData> GetChartLineData(const ObjectRows* rows = nullptr) const;
+    std::vector<PanelElementData> GetPanelElementData(const ObjectRows* rows = nullptr) const;
+
+    // Number of tables visited by ForEachTable
+    static constexpr std::size_t TableCount = 23;
+
+    // Calls func(table_name, objects) for every exported table in export order
+    template <typename Func>
+    void ForEachTable(Func&& func) const {
+        ForEachTableLoader([&func](std::string_view table_name, auto loader) {
+            func(table_name, loader());
+        });
+    }
+
+    // Calls func(table_name, loader) for every exported table in export order, where loader()
+    // returns the table objects. Allows loading the tables from other threads. The objs table is
+    // read once and shared by the loaders, loaders running at the same time don't each hold it
+    template <typename Func>
+    void ForEachTableLoader(Func&& func) const {
+        const auto rows = std::make_shared<const ObjectRows>(GetObjectRows());
+        func("serverConfig", [this, rows] { return GetServerConfigData(rows.get()); });
+        func("tool", [this, rows] { return GetToolData(rows.get()); });
+        func("file", [this, rows] { return GetFileData(rows.get()); });
+        func("notes", [this, rows] { return GetNotesData(rows.get()); });
+        func("map", [this, rows] { return GetMapData(rows.get()); });
+        func("probe", [this, rows] { return GetProbeData(rows.get()); });
+        func("deviceType", [this, rows] { return GetDeviceTypeData(rows.get()); });
+        func("device", [this, rows] { return GetDeviceData(rows.get()); });
+        func("network", [this, rows] { return GetNetworkData(rows.get()); });
+        func("service", [this, rows] { return GetServiceData(rows.get()); });
+        func("notification", [this, rows] { return GetNotificationData(rows.get()); });
+        func("link", [this, rows] { return GetLinkData(rows.get()); });
+        func("linkType", [this, rows] { return GetLinkTypeData(rows.get()); });
+        func("dataSource", [this, rows] { return GetDataSourceData(rows.get()); });
+        func("objectList", [this, rows] { return GetObjectListData(rows.get()); });
+        func("deviceGroup", [this, rows] { return GetDeviceGroupData(rows.get()); });
+        func("function", [this, rows] { return GetFunctionData(rows.get()); });
+        func("snmpProfile", [this, rows] { return GetSnmpProfileData(rows.get()); });
+        func("panel", [this, rows] { return GetPanelData(rows.get()); });
+        func("sysLogRule", [this, rows] { return GetSysLogRuleData(rows.get()); });
+        func("networkMapElement", [this, rows] { return GetNetworkMapElementData(rows.get()); });
+        func("chartLine", [this, rows] { return GetChartLineData(rows.get()); });
+        func("panelElement", [this, rows] { return GetPanelElementData(rows.get()); });
+    }
 
 private:
+    struct ChartTableInfo {
+        bool is_checked{};
+        bool is_rowid_key{};
+        std::unique_ptr<ChartBlockIndex> index{};
+    };
+
+    ChartTableInfo* GetChartTableInfo(int& rc, ChartResolution resolution) const;
+    int GetChartRowidRanges(std::vector<std::pair<s64, s64>>& ranges,
+                            ChartResolution resolution, u32 source_id, u32 start_time,
+                            u32 end_time) const;
+
     template <typename T>
-    std::vector<T> GetObjectData(DataFormat format,
+    std::vector<T> GetObjectData(const ObjectRows* rows, DataFormat format,
                                  T (DudeDatabase::*RawToObjData)(DudeFieldParser& parser)
                                      const) const;
 
@@ -90,5 +196,8 @@ private:
     PanelElementData GetPanelElementData(DudeFieldParser& parser) const;
 
     Sqlite::SqliteReader db;
+
+    mutable std::mutex chart_table_mutex;
+    mutable std::array<ChartTableInfo, 4> chart_tables;
 };
 } // namespace Database
@@ -1,33 +1,58 @@
 // SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
 #include <fstream>
+#include <future>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <vector>
 #include <fmt/core.h>
 
+#include "common/thread_pool.h"
 #include "the_dude_to_human/database/dude_database.h"
 #include "the_dude_to_human/database/dude_json.h"
 
 namespace Database {
 
+// Objects serialized by a single task. Smaller tables aren't worth splitting
+constexpr std::size_t MinObjectsPerChunk = 0x800;
+
+// Serialized objects of a table split in chunks. Every object is followed by a coma
+using TableChunks = std::vector<std::future<std::string>>;
+
 template <typename T>
-static std::string SerializeData(std::vector<T> obj, bool has_credentials) {
+static std::string SerializeData(std::span<const T> obj, bool has_credentials) {
     std::string json = "";
 
     for (const DudeObj& data : obj) {
         json += fmt::format("\n    {{{}}},", data.SerializeJson(has_credentials));
     }
-    if (!obj.empty()) {
-        json.pop_back();
-    }
 
     return json;
 }
 
+// Queues one serialization task per chunk. Tasks never wait on each other so they can share the
+// same pool
 template <typename T>
-static std::string SerializeTable(std::string table_name, std::vector<T> obj, bool has_credentials,
-                                  bool has_coma = true) {
-    return fmt::format("\"{}\": [{}\n]{}\n", table_name, SerializeData(obj, has_credentials),
-                       has_coma ? "," : "");
+static TableChunks SerializeTableChunks(Common::ThreadPool& pool, std::vector<T> obj,
+                                        bool has_credentials) {
+    const auto objects = std::make_shared<const std::vector<T>>(std::move(obj));
+    const std::size_t chunk_count = std::clamp<std::size_t>(
+        objects->size() / MinObjectsPerChunk, 1, pool.GetThreadCount());
+    const std::size_t chunk_size = (objects->size() + chunk_count - 1) / chunk_count;
+
+    TableChunks chunks{};
+    for (std::size_t offset = 0; offset < objects->size(); offset += chunk_size) {
+        const std::size_t count = std::min(chunk_size, objects->size() - offset);
+        chunks.push_back(pool.Submit([objects, offset, count, has_credentials] {
+            return SerializeData(std::span{*objects}.subspan(offset, count), has_credentials);
+        }));
+    }
+
+    return chunks;
 }
 
 int SerializeDatabaseJson(DudeDatabase* db, const std::string& db_file, bool has_credentials) {
@@ -35,35 +60,41 @@ int SerializeDatabaseJson(DudeDatabase* db, const std::string& db_file, bool has
     if (!jsonFile.is_open())
         return 1;
 
-    jsonFile << "{\n";
-    jsonFile << SerializeTable("serverConfig", db->GetServerConfigData(), has_credentials);
-    jsonFile << SerializeTable("tool", db->GetToolData(), has_credentials);
-    jsonFile << SerializeTable("file", db->GetFileData(), has_credentials);
-    jsonFile << SerializeTable("notes", db->GetNotesData(), has_credentials);
-    jsonFile << SerializeTable("map", db->GetMapData(), has_credentials);
-    jsonFile << SerializeTable("probe", db->GetProbeData(), has_credentials);
-    jsonFile << SerializeTable("deviceType", db->GetDeviceTypeData(), has_credentials);
-    jsonFile << SerializeTable("device", db->GetDeviceData(), has_credentials);
-    jsonFile << SerializeTable("network", db->GetNetworkData(), has_credentials);
-    jsonFile << SerializeTable("service", db->GetServiceData(), has_credentials);
-    jsonFile << SerializeTable("notification", db->GetNotificationData(), has_credentials);
-    jsonFile << SerializeTable("link", db->GetLinkData(), has_credentials);
-    jsonFile << SerializeTable("linkType", db->GetLinkTypeData(), has_credentials);
-    jsonFile << SerializeTable("dataSource", db->GetDataSourceData(), has_credentials);
-    jsonFile << SerializeTable("objectList", db->GetObjectListData(), has_credentials);
-    jsonFile << SerializeTable("deviceGroup", db->GetDeviceGroupData(), has_credentials);
-    jsonFile << SerializeTable("function", db->GetFunctionData(), has_credentials);
-    jsonFile << SerializeTable("snmpProfile", db->GetSnmpProfileData(), has_credentials);
-    jsonFile << SerializeTable("panel", db->GetPanelData(), has_credentials);
-    jsonFile << SerializeTable("sysLogRule", db->GetSysLogRuleData(), has_credentials);
-    jsonFile << SerializeTable("networkMapElement", db->GetNetworkMapElementData(),
-                               has_credentials);
-    jsonFile << SerializeTable("chartLine", db->GetChartLineData(), has_credentials);
-    jsonFile << SerializeTable("panelElement", db->GetPanelElementData(), has_credentials, false);
-    jsonFile << "}";
+    SerializeDatabaseJson(db, jsonFile, has_credentials);
 
     jsonFile.close();
     return 0;
 }
 
+void SerializeDatabaseJson(DudeDatabase* db, std::ostream& out, bool has_credentials,
+                           std::size_t thread_count) {
+    // Tables are loaded and serialized in parallel, the output is written in table order as soon
+    // as each chunk is ready
+    Common::ThreadPool pool{thread_count};
+    std::vector<std::pair<std::string_view, std::future<TableChunks>>> tables{};
+    tables.reserve(DudeDatabase::TableCount);
+    db->ForEachTableLoader([&](std::string_view table_name, auto loader) {
+        tables.emplace_back(table_name, pool.Submit([&pool, loader, has_credentials] {
+                                return SerializeTableChunks(pool, loader(), has_credentials);
+                            }));
+    });
+
+    out << "{\n";
+    for (std::size_t i = 0; i < tables.size(); ++i) {
+        auto& [table_name, table] = tables[i];
+        TableChunks chunks = table.get();
+
+        out << fmt::format("\"{}\": [", table_name);
+        for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+            std::string json = chunks[chunk].get();
+            if (chunk + 1 == chunks.size()) {
+                json.pop_back();
+            }
+            out << json;
+        }
+        out << fmt::format("\n]{}\n", i + 1 != tables.size() ? "," : "");
+    }
+    out << "}";
+}
+
 } // namespace Database
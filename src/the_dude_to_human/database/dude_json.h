@@ -3,7 +3,15 @@
 
 #pragma once
 
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
 namespace Database {
 class DudeDatabase;
 int SerializeDatabaseJson(DudeDatabase* db, const std::string& db_file, bool has_credentials);
+// Tables are split in chunks serialized by thread_count threads, zero uses every hardware thread.
+// The output doesn't depend on the thread count
+void SerializeDatabaseJson(DudeDatabase* db, std::ostream& out, bool has_credentials,
+                           std::size_t thread_count = 0);
 } // namespace Database
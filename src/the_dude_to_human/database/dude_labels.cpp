@@ -0,0 +1,218 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#include "the_dude_to_human/arrow/arrow_writer.h"
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_labels.h"
+
+namespace Database {
+namespace {
+
+enum LabeledColumn : std::size_t {
+    ResolutionColumn,
+    SourceIdColumn,
+    TimeColumn,
+    ValueColumn,
+    SourceColumn,
+    UnitColumn,
+    ServiceColumn,
+    DeviceColumn,
+    ChartColumn,
+};
+
+// Dictionary indices of the label columns of a single source
+struct SourceLabelIndices {
+    s32 source{};
+    s32 unit{};
+    s32 service{};
+    s32 device{};
+    s32 chart{};
+};
+
+std::vector<Arrow::Column> CreateLabeledColumns() {
+    std::vector<Arrow::Column> columns{};
+    columns.emplace_back("resolution", Arrow::ColumnType::DictionaryUtf8);
+    columns.emplace_back("sourceId", Arrow::ColumnType::UInt32);
+    columns.emplace_back("time", Arrow::ColumnType::Timestamp);
+    columns.emplace_back("value", Arrow::ColumnType::Float64);
+    columns.emplace_back("source", Arrow::ColumnType::DictionaryUtf8);
+    columns.emplace_back("unit", Arrow::ColumnType::DictionaryUtf8);
+    columns.emplace_back("service", Arrow::ColumnType::DictionaryUtf8);
+    columns.emplace_back("device", Arrow::ColumnType::DictionaryUtf8);
+    columns.emplace_back("chart", Arrow::ColumnType::DictionaryUtf8);
+    return columns;
+}
+
+int WriteLabeledChartValues(const DudeDatabase* db, std::ofstream& file, std::size_t batch_size) {
+    SeriesLabelIndex label_index{db};
+    Arrow::StreamWriter writer{file, CreateLabeledColumns()};
+    if (!writer.WriteSchema()) {
+        return 1;
+    }
+
+    std::unordered_map<u32, SourceLabelIndices> source_indices{};
+    const auto get_indices = [&](u32 source_id) -> const SourceLabelIndices& {
+        const auto it = source_indices.find(source_id);
+        if (it != source_indices.end()) {
+            return it->second;
+        }
+        const SeriesLabels& series_labels = label_index.GetLabels(source_id);
+        const SourceLabelIndices indices{
+            .source = writer.GetColumn(SourceColumn).InternString(series_labels.source),
+            .unit = writer.GetColumn(UnitColumn).InternString(series_labels.unit),
+            .service = writer.GetColumn(ServiceColumn).InternString(series_labels.service),
+            .device = writer.GetColumn(DeviceColumn).InternString(series_labels.device),
+            .chart = writer.GetColumn(ChartColumn).InternString(series_labels.chart),
+        };
+        return source_indices.emplace(source_id, indices).first->second;
+    };
+
+    u64 value_count = 0;
+    for (const ChartResolution resolution : ChartResolutions) {
+        u32 source_id = 0;
+        const SourceLabelIndices* indices = nullptr;
+        const s32 resolution_index =
+            writer.GetColumn(ResolutionColumn).InternString(GetChartResolutionName(resolution));
+
+        const int rc = db->ReadChartValues(resolution, [&](std::span<const ChartValue> values) {
+            for (const ChartValue& value : values) {
+                if (indices == nullptr || value.source_id != source_id) {
+                    source_id = value.source_id;
+                    indices = &get_indices(source_id);
+                }
+                writer.GetColumn(ResolutionColumn).AppendDictionaryIndex(resolution_index);
+                writer.GetColumn(SourceIdColumn).AppendUInt32(value.source_id);
+                writer.GetColumn(TimeColumn).AppendTimestamp(value.time);
+                writer.GetColumn(ValueColumn).AppendFloat64(value.value);
+                writer.GetColumn(SourceColumn).AppendDictionaryIndex(indices->source);
+                writer.GetColumn(UnitColumn).AppendDictionaryIndex(indices->unit);
+                writer.GetColumn(ServiceColumn).AppendDictionaryIndex(indices->service);
+                writer.GetColumn(DeviceColumn).AppendDictionaryIndex(indices->device);
+                writer.GetColumn(ChartColumn).AppendDictionaryIndex(indices->chart);
+
+                if (writer.GetPendingRows() >= batch_size && !writer.WriteBatch()) {
+                    return 1;
+                }
+            }
+            value_count += values.size();
+            return 0;
+        });
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    if (writer.GetPendingRows() != 0 && !writer.WriteBatch()) {
+        return 1;
+    }
+    if (!writer.Finish()) {
+        return 1;
+    }
+
+    printf("Wrote %llu labeled values of %zu sources using %zu label strings\n",
+           static_cast<unsigned long long>(value_count), source_indices.size(),
+           label_index.GetStringCount());
+    return 0;
+}
+
+} // Anonymous namespace
+
+SeriesLabelIndex::SeriesLabelIndex(const DudeDatabase* db)
+    : data_sources{db->GetDataSourceData()}, services{db->GetServiceData()},
+      devices{db->GetDeviceData()}, chart_lines{db->GetChartLineData()} {
+    for (const DataSourceData& data_source : data_sources) {
+        data_source_by_id.emplace(static_cast<u32>(data_source.object_id.value), &data_source);
+    }
+    for (const ServiceData& service : services) {
+        service_by_source.emplace(static_cast<u32>(service.data_source_id.value), &service);
+    }
+    for (const DeviceData& device : devices) {
+        device_by_id.emplace(static_cast<u32>(device.object_id.value), &device);
+    }
+    for (const ChartLineData& chart_line : chart_lines) {
+        chart_lines_by_source[static_cast<u32>(chart_line.source_id.value)].push_back(&chart_line);
+    }
+}
+
+const SeriesLabels& SeriesLabelIndex::GetLabels(u32 source_id) {
+    const auto it = labels.find(source_id);
+    if (it != labels.end()) {
+        return it->second;
+    }
+    return labels.emplace(source_id, ResolveLabels(source_id)).first->second;
+}
+
+std::size_t SeriesLabelIndex::GetStringCount() const {
+    return strings.size();
+}
+
+std::string_view SeriesLabelIndex::Intern(std::string_view text) {
+    return *strings.emplace(text).first;
+}
+
+SeriesLabels SeriesLabelIndex::ResolveLabels(u32 source_id) {
+    const auto data_source = data_source_by_id.find(source_id);
+    if (data_source == data_source_by_id.end()) {
+        return {};
+    }
+
+    SeriesLabels series_labels{
+        .source = Intern(data_source->second->name.text),
+        .unit = Intern(data_source->second->unit.text),
+    };
+
+    // Services own the data source of their probe, other sources belong to the device running
+    // the function
+    u32 device_id = static_cast<u32>(data_source->second->function_device_id.value);
+    const auto service = service_by_source.find(source_id);
+    if (service != service_by_source.end()) {
+        series_labels.service = Intern(service->second->name.text);
+        device_id = static_cast<u32>(service->second->device_id.value);
+    }
+
+    const auto device = device_by_id.find(device_id);
+    if (device != device_by_id.end()) {
+        series_labels.device = Intern(device->second->name.text);
+    }
+
+    // A source drawn by several chart lines gets all their names
+    std::string chart_names{};
+    const auto lines = chart_lines_by_source.find(source_id);
+    if (lines != chart_lines_by_source.end()) {
+        for (const ChartLineData* line : lines->second) {
+            if (!chart_names.empty()) {
+                chart_names += ", ";
+            }
+            chart_names += line->name.text;
+        }
+    }
+    series_labels.chart = Intern(chart_names);
+
+    return series_labels;
+}
+
+int ExportLabeledChartValues(const DudeDatabase* db, const std::string& out_file,
+                             std::size_t batch_size) {
+    std::ofstream file{out_file, std::ios::binary};
+    if (!file.is_open()) {
+        printf("Unable to open '%s'\n", out_file.c_str());
+        return 1;
+    }
+
+    // A stream cut short is unreadable, don't leave it behind
+    const int rc = WriteLabeledChartValues(db, file, batch_size);
+    if (rc != 0) {
+        file.close();
+        std::error_code ec;
+        std::filesystem::remove(out_file, ec);
+    }
+    return rc;
+}
+
+} // namespace Database
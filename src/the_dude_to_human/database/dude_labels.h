@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/common_types.h"
+#include "the_dude_to_human/database/dude_types.h"
+
+namespace Database {
+class DudeDatabase;
+
+// Human readable labels of a chart series. Views point into the interned strings of the
+// SeriesLabelIndex that resolved them
+struct SeriesLabels {
+    std::string_view source{};
+    std::string_view unit{};
+    std::string_view service{};
+    std::string_view device{};
+    std::string_view chart{};
+};
+
+// Resolves data source ids to labels by joining chart lines, data sources, services and devices.
+// The join tables are built once by object id and every source is resolved on first use
+class SeriesLabelIndex {
+public:
+    explicit SeriesLabelIndex(const DudeDatabase* db);
+
+    SeriesLabelIndex(const SeriesLabelIndex&) = delete;
+    SeriesLabelIndex& operator=(const SeriesLabelIndex&) = delete;
+
+    // Returns empty labels for sources without a data source object
+    const SeriesLabels& GetLabels(u32 source_id);
+
+    std::size_t GetStringCount() const;
+
+private:
+    std::string_view Intern(std::string_view text);
+    SeriesLabels ResolveLabels(u32 source_id);
+
+    std::vector<DataSourceData> data_sources;
+    std::vector<ServiceData> services;
+    std::vector<DeviceData> devices;
+    std::vector<ChartLineData> chart_lines;
+
+    std::unordered_map<u32, const DataSourceData*> data_source_by_id{};
+    std::unordered_map<u32, const ServiceData*> service_by_source{};
+    std::unordered_map<u32, const DeviceData*> device_by_id{};
+    // Lines of a source in database order
+    std::unordered_map<u32, std::vector<const ChartLineData*>> chart_lines_by_source{};
+
+    std::unordered_set<std::string> strings{};
+    std::unordered_map<u32, SeriesLabels> labels{};
+};
+
+// Writes the chart values of every resolution with their labels as an Arrow IPC stream. Label
+// columns are dictionary encoded, each source interns its labels once
+int ExportLabeledChartValues(const DudeDatabase* db, const std::string& out_file,
+                             std::size_t batch_size);
+} // namespace Database
@@ -0,0 +1,314 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_msgpack.h"
+
+namespace Database {
+namespace {
+
+// Buffered MessagePack encoder. Output is flushed to disk once the buffer reaches
+// FlushThreshold bytes so memory usage doesn't grow with the database size.
+class MsgpackWriter {
+public:
+    static constexpr std::size_t FlushThreshold = 0x10000;
+
+    explicit MsgpackWriter(std::ofstream& out_file) : file{out_file} {
+        buffer.reserve(FlushThreshold);
+    }
+
+    ~MsgpackWriter() {
+        Flush();
+    }
+
+    void Flush() {
+        file.write(reinterpret_cast<const char*>(buffer.data()),
+                   static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+    void WriteBool(bool value) {
+        WriteByte(value ? 0xc3 : 0xc2);
+    }
+
+    void WriteUint(u64 value) {
+        if (value < 0x80) {
+            WriteByte(static_cast<u8>(value));
+        } else if (value <= 0xff) {
+            WriteByte(0xcc);
+            WriteBigEndian(static_cast<u8>(value));
+        } else if (value <= 0xffff) {
+            WriteByte(0xcd);
+            WriteBigEndian(static_cast<u16>(value));
+        } else if (value <= 0xffffffff) {
+            WriteByte(0xce);
+            WriteBigEndian(static_cast<u32>(value));
+        } else {
+            WriteByte(0xcf);
+            WriteBigEndian(value);
+        }
+    }
+
+    void WriteInt(s64 value) {
+        if (value >= 0) {
+            WriteUint(static_cast<u64>(value));
+        } else if (value >= -32) {
+            WriteByte(static_cast<u8>(value));
+        } else if (value >= INT8_MIN) {
+            WriteByte(0xd0);
+            WriteBigEndian(static_cast<u8>(value));
+        } else if (value >= INT16_MIN) {
+            WriteByte(0xd1);
+            WriteBigEndian(static_cast<u16>(value));
+        } else if (value >= INT32_MIN) {
+            WriteByte(0xd2);
+            WriteBigEndian(static_cast<u32>(value));
+        } else {
+            WriteByte(0xd3);
+            WriteBigEndian(static_cast<u64>(value));
+        }
+    }
+
+    void WriteString(std::string_view text) {
+        const std::size_t size = text.size();
+        if (size < 32) {
+            WriteByte(static_cast<u8>(0xa0 | size));
+        } else if (size <= 0xff) {
+            WriteByte(0xd9);
+            WriteBigEndian(static_cast<u8>(size));
+        } else if (size <= 0xffff) {
+            WriteByte(0xda);
+            WriteBigEndian(static_cast<u16>(size));
+        } else {
+            WriteByte(0xdb);
+            WriteBigEndian(static_cast<u32>(size));
+        }
+        WriteRaw(text.data(), size);
+    }
+
+    void WriteBinary(std::span<const u8> data) {
+        const std::size_t size = data.size();
+        if (size <= 0xff) {
+            WriteByte(0xc4);
+            WriteBigEndian(static_cast<u8>(size));
+        } else if (size <= 0xffff) {
+            WriteByte(0xc5);
+            WriteBigEndian(static_cast<u16>(size));
+        } else {
+            WriteByte(0xc6);
+            WriteBigEndian(static_cast<u32>(size));
+        }
+        WriteRaw(data.data(), size);
+    }
+
+    void WriteArrayHeader(std::size_t entries) {
+        if (entries < 16) {
+            WriteByte(static_cast<u8>(0x90 | entries));
+        } else if (entries <= 0xffff) {
+            WriteByte(0xdc);
+            WriteBigEndian(static_cast<u16>(entries));
+        } else {
+            WriteByte(0xdd);
+            WriteBigEndian(static_cast<u32>(entries));
+        }
+    }
+
+    void WriteMapHeader(std::size_t entries) {
+        if (entries < 16) {
+            WriteByte(static_cast<u8>(0x80 | entries));
+        } else if (entries <= 0xffff) {
+            WriteByte(0xde);
+            WriteBigEndian(static_cast<u16>(entries));
+        } else {
+            WriteByte(0xdf);
+            WriteBigEndian(static_cast<u32>(entries));
+        }
+    }
+
+    void WriteExtHeader(MsgpackExtType type, std::size_t size) {
+        switch (size) {
+        case 1:
+            WriteByte(0xd4);
+            break;
+        case 2:
+            WriteByte(0xd5);
+            break;
+        case 4:
+            WriteByte(0xd6);
+            break;
+        case 8:
+            WriteByte(0xd7);
+            break;
+        case 16:
+            WriteByte(0xd8);
+            break;
+        default:
+            if (size <= 0xff) {
+                WriteByte(0xc7);
+                WriteBigEndian(static_cast<u8>(size));
+            } else if (size <= 0xffff) {
+                WriteByte(0xc8);
+                WriteBigEndian(static_cast<u16>(size));
+            } else {
+                WriteByte(0xc9);
+                WriteBigEndian(static_cast<u32>(size));
+            }
+            break;
+        }
+        WriteByte(static_cast<u8>(type));
+    }
+
+    void WriteLittleEndian(u32 value) {
+        for (std::size_t i = 0; i < sizeof(u32); ++i) {
+            WriteByte(static_cast<u8>(value >> (i * 8)));
+        }
+    }
+
+    template <typename T>
+    void WriteBigEndian(T value) {
+        for (std::size_t i = sizeof(T); i > 0; --i) {
+            WriteByte(static_cast<u8>(value >> ((i - 1) * 8)));
+        }
+    }
+
+private:
+    void WriteByte(u8 value) {
+        buffer.push_back(value);
+        if (buffer.size() >= FlushThreshold) {
+            Flush();
+        }
+    }
+
+    void WriteRaw(const void* data, std::size_t size) {
+        const u8* bytes = static_cast<const u8*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+        if (buffer.size() >= FlushThreshold) {
+            Flush();
+        }
+    }
+
+    std::ofstream& file;
+    std::vector<u8> buffer;
+};
+
+// Encodes each field with the most compact msgpack type that preserves its value
+struct MsgpackFieldVisitor {
+    MsgpackWriter& writer;
+
+    void operator()(std::string_view name, const BoolField& field) {
+        writer.WriteString(name);
+        writer.WriteBool(field.value);
+    }
+
+    void operator()(std::string_view name, const ByteField& field) {
+        writer.WriteString(name);
+        writer.WriteUint(field.value);
+    }
+
+    void operator()(std::string_view name, const IntField& field) {
+        writer.WriteString(name);
+        writer.WriteInt(field.value);
+    }
+
+    void operator()(std::string_view name, const TimeField& field) {
+        writer.WriteString(name);
+        writer.WriteExtHeader(MsgpackExtType::Timestamp, sizeof(u32));
+        writer.WriteBigEndian(field.date);
+    }
+
+    void operator()(std::string_view name, const LongField& field) {
+        writer.WriteString(name);
+        writer.WriteUint(field.value);
+    }
+
+    void operator()(std::string_view name, const LongLongField& field) {
+        writer.WriteString(name);
+        writer.WriteBinary(field.GetBytes());
+    }
+
+    void operator()(std::string_view name, const TextField& field) {
+        writer.WriteString(name);
+        writer.WriteString(field.text);
+    }
+
+    void operator()(std::string_view name, const IntArrayField& field) {
+        writer.WriteString(name);
+        writer.WriteExtHeader(MsgpackExtType::U32Array, field.data.size() * sizeof(u32));
+        for (u32 entry : field.data) {
+            writer.WriteLittleEndian(entry);
+        }
+    }
+
+    void operator()(std::string_view name, const IpArrayField& field) {
+        writer.WriteString(name);
+        writer.WriteArrayHeader(field.data.size());
+        for (u32 entry : field.data) {
+            IpAddress ip{};
+            std::memcpy(&ip, &entry, sizeof(u32));
+            writer.WriteBinary(ip);
+        }
+    }
+
+    void operator()(std::string_view name, const LongArrayField& field) {
+        writer.WriteString(name);
+        writer.WriteBinary(field.data);
+    }
+
+    void operator()(std::string_view name, const MacAddressField& field) {
+        writer.WriteString(name);
+        writer.WriteArrayHeader(field.mac_address.size());
+        for (const MacAddress& mac : field.mac_address) {
+            writer.WriteBinary(mac);
+        }
+    }
+
+    void operator()(std::string_view name, const StringArrayField& field) {
+        writer.WriteString(name);
+        writer.WriteArrayHeader(field.entries.size());
+        for (const StringArrayEntry& entry : field.entries) {
+            writer.WriteString(entry.text);
+        }
+    }
+};
+
+template <typename T>
+void SerializeObject(MsgpackWriter& writer, const T& data, bool has_credentials) {
+    std::size_t field_count = 0;
+    data.VisitFields([&field_count](std::string_view, const auto&) { field_count++; },
+                     has_credentials);
+
+    writer.WriteMapHeader(field_count);
+    data.VisitFields(MsgpackFieldVisitor{writer}, has_credentials);
+}
+
+} // Anonymous namespace
+
+int SerializeDatabaseMsgpack(DudeDatabase* db, const std::string& db_file, bool has_credentials) {
+    std::ofstream msgpack_file(db_file, std::ios::binary);
+    if (!msgpack_file.is_open())
+        return 1;
+
+    {
+        MsgpackWriter writer{msgpack_file};
+        writer.WriteMapHeader(DudeDatabase::TableCount);
+        db->ForEachTable([&](std::string_view table_name, const auto& objects) {
+            writer.WriteString(table_name);
+            writer.WriteArrayHeader(objects.size());
+            for (const auto& data : objects) {
+                SerializeObject(writer, data, has_credentials);
+            }
+        });
+    }
+
+    msgpack_file.close();
+    return msgpack_file.fail() ? 1 : 0;
+}
+
+} // namespace Database
@@ -0,0 +1,20 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+
+#include "common/common_types.h"
+
+namespace Database {
+class DudeDatabase;
+
+// MessagePack extension types used by the exporter
+enum class MsgpackExtType : s8 {
+    Timestamp = -1, // Standard msgpack timestamp 32
+    U32Array = 1,   // Packed little endian u32 values
+};
+
+int SerializeDatabaseMsgpack(DudeDatabase* db, const std::string& db_file, bool has_credentials);
+} // namespace Database
@@ -0,0 +1,302 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fmt/format.h>
+
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_labels.h"
+#include "the_dude_to_human/database/dude_openmetrics.h"
+
+namespace Database {
+namespace {
+
+// Samples read at once from each run while merging
+constexpr std::size_t MergeReadSamples = 0x1000;
+
+constexpr std::size_t FlushThreshold = 0x10000;
+
+struct Sample {
+    u32 series{};
+    u32 time{};
+    f64 value{};
+};
+
+// Family name and label text of a series. Samples of a family must be contiguous
+struct SeriesKey {
+    std::string name{};
+    std::string labels{};
+};
+
+std::string GetMetricName(std::string_view source_name, u32 source_id) {
+    std::string name = "dude_";
+    for (const char c : source_name) {
+        const bool is_valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                              (c >= '0' && c <= '9') || c == '_' || c == ':';
+        const char lower = c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        name.push_back(is_valid ? lower : '_');
+    }
+    if (source_name.empty()) {
+        name += fmt::format("source_{}", source_id);
+    }
+    return name;
+}
+
+void AppendLabel(std::string& labels, std::string_view name, std::string_view value) {
+    if (!labels.empty()) {
+        labels.push_back(',');
+    }
+    labels.append(name);
+    labels.append("=\"");
+    for (const char c : value) {
+        switch (c) {
+        case '\\':
+            labels.append("\\\\");
+            break;
+        case '"':
+            labels.append("\\\"");
+            break;
+        case '\n':
+            labels.append("\\n");
+            break;
+        default:
+            labels.push_back(c);
+            break;
+        }
+    }
+    labels.push_back('"');
+}
+
+SeriesKey CreateSeriesKey(const SeriesLabels& labels, u32 source_id,
+                          ChartResolution resolution) {
+    SeriesKey key{.name = GetMetricName(labels.source, source_id)};
+    AppendLabel(key.labels, "source_id", fmt::format("{}", source_id));
+    AppendLabel(key.labels, "resolution", GetChartResolutionName(resolution));
+    AppendLabel(key.labels, "device", labels.device);
+    AppendLabel(key.labels, "service", labels.service);
+    AppendLabel(key.labels, "unit", labels.unit);
+    return key;
+}
+
+// Orders samples by family, series and time
+class SampleCompare {
+public:
+    explicit SampleCompare(const std::vector<SeriesKey>& series_keys) : keys{series_keys} {}
+
+    bool operator()(const Sample& a, const Sample& b) const {
+        if (a.series == b.series) {
+            return a.time < b.time;
+        }
+        const SeriesKey& key_a = keys[a.series];
+        const SeriesKey& key_b = keys[b.series];
+        if (key_a.name != key_b.name) {
+            return key_a.name < key_b.name;
+        }
+        return key_a.labels < key_b.labels;
+    }
+
+private:
+    const std::vector<SeriesKey>& keys;
+};
+
+// Sequential reader of a spilled run
+class RunReader {
+public:
+    explicit RunReader(const std::filesystem::path& path) : file{path, std::ios::binary} {}
+
+    bool Next(Sample& sample) {
+        if (position == samples.size() && !Fill()) {
+            return false;
+        }
+        sample = samples[position++];
+        return true;
+    }
+
+private:
+    bool Fill() {
+        samples.resize(MergeReadSamples);
+        file.read(reinterpret_cast<char*>(samples.data()),
+                  static_cast<std::streamsize>(samples.size() * sizeof(Sample)));
+        samples.resize(static_cast<std::size_t>(file.gcount()) / sizeof(Sample));
+        position = 0;
+        return !samples.empty();
+    }
+
+    std::ifstream file;
+    std::vector<Sample> samples{};
+    std::size_t position{};
+};
+
+class OpenMetricsWriter {
+public:
+    OpenMetricsWriter(std::ofstream& out_file, const std::vector<SeriesKey>& series_keys)
+        : file{out_file}, keys{series_keys} {
+        buffer.reserve(FlushThreshold * 2);
+    }
+
+    void Write(const Sample& sample) {
+        const SeriesKey& key = keys[sample.series];
+        if (!has_family || key.name != family) {
+            family = key.name;
+            has_family = true;
+            fmt::format_to(std::back_inserter(buffer), "# TYPE {} gauge\n", family);
+        }
+
+        fmt::format_to(std::back_inserter(buffer), "{}{{{}}} ", key.name, key.labels);
+        if (std::isnan(sample.value)) {
+            buffer.append("NaN");
+        } else if (std::isinf(sample.value)) {
+            buffer.append(sample.value > 0 ? "+Inf" : "-Inf");
+        } else {
+            fmt::format_to(std::back_inserter(buffer), "{}", sample.value);
+        }
+        fmt::format_to(std::back_inserter(buffer), " {}\n", sample.time);
+
+        if (buffer.size() >= FlushThreshold) {
+            Flush();
+        }
+    }
+
+    void Finish() {
+        buffer.append("# EOF\n");
+        Flush();
+    }
+
+private:
+    void Flush() {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+    std::ofstream& file;
+    const std::vector<SeriesKey>& keys;
+    std::string buffer{};
+    std::string family{};
+    bool has_family{};
+};
+
+} // Anonymous namespace
+
+int SerializeDatabaseOpenMetrics(const DudeDatabase* db, const std::string& out_file,
+                                 std::size_t run_samples) {
+    SeriesLabelIndex label_index{db};
+    std::vector<SeriesKey> series_keys{};
+    std::unordered_map<u64, u32> series_ids{};
+    const SampleCompare compare{series_keys};
+
+    std::vector<std::filesystem::path> runs{};
+    std::vector<Sample> samples{};
+    const auto remove_runs = [&runs] {
+        std::error_code ec;
+        for (const auto& run : runs) {
+            std::filesystem::remove(run, ec);
+        }
+    };
+    const auto spill_run = [&] {
+        std::sort(samples.begin(), samples.end(), compare);
+        runs.emplace_back(fmt::format("{}.run{}", out_file, runs.size()));
+        std::ofstream run_file{runs.back(), std::ios::binary};
+        run_file.write(reinterpret_cast<const char*>(samples.data()),
+                       static_cast<std::streamsize>(samples.size() * sizeof(Sample)));
+        samples.clear();
+        return run_file.good();
+    };
+
+    for (const ChartResolution resolution : ChartResolutions) {
+        const int rc = db->ReadChartValues(resolution, [&](std::span<const ChartValue> values) {
+            for (const ChartValue& value : values) {
+                const u64 series = (static_cast<u64>(resolution) << 32) | value.source_id;
+                auto it = series_ids.find(series);
+                if (it == series_ids.end()) {
+                    it = series_ids.emplace(series, static_cast<u32>(series_keys.size())).first;
+                    series_keys.push_back(CreateSeriesKey(label_index.GetLabels(value.source_id),
+                                                          value.source_id, resolution));
+                }
+                samples.push_back({it->second, value.time, value.value});
+                if (samples.size() == run_samples && !spill_run()) {
+                    return 1;
+                }
+            }
+            return 0;
+        });
+        if (rc != 0) {
+            remove_runs();
+            return rc;
+        }
+    }
+
+    std::ofstream file{out_file, std::ios::binary};
+    if (!file.is_open()) {
+        printf("Unable to open '%s'\n", out_file.c_str());
+        remove_runs();
+        return 1;
+    }
+
+    OpenMetricsWriter writer{file, series_keys};
+    std::sort(samples.begin(), samples.end(), compare);
+
+    // The last run stays in memory and is merged with the spilled ones
+    std::vector<RunReader> readers{};
+    readers.reserve(runs.size());
+    for (const auto& run : runs) {
+        readers.emplace_back(run);
+    }
+    std::size_t memory_position = 0;
+    const auto next_sample = [&](std::size_t run, Sample& sample) {
+        if (run < readers.size()) {
+            return readers[run].Next(sample);
+        }
+        if (memory_position == samples.size()) {
+            return false;
+        }
+        sample = samples[memory_position++];
+        return true;
+    };
+
+    using MergeEntry = std::pair<Sample, std::size_t>;
+    const auto merge_compare = [&compare](const MergeEntry& a, const MergeEntry& b) {
+        return compare(b.first, a.first);
+    };
+    std::priority_queue<MergeEntry, std::vector<MergeEntry>, decltype(merge_compare)> queue{
+        merge_compare};
+    for (std::size_t run = 0; run <= readers.size(); ++run) {
+        Sample sample{};
+        if (next_sample(run, sample)) {
+            queue.emplace(sample, run);
+        }
+    }
+
+    u64 sample_count = 0;
+    while (!queue.empty()) {
+        const auto [sample, run] = queue.top();
+        queue.pop();
+        writer.Write(sample);
+        sample_count++;
+
+        Sample next{};
+        if (next_sample(run, next)) {
+            queue.emplace(next, run);
+        }
+    }
+    writer.Finish();
+    remove_runs();
+
+    file.close();
+    if (file.fail()) {
+        return 1;
+    }
+    printf("Wrote %llu samples of %zu series from %zu runs\n",
+           static_cast<unsigned long long>(sample_count), series_keys.size(), runs.size() + 1);
+    return 0;
+}
+
+} // namespace Database
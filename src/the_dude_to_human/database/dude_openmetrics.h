@@ -0,0 +1,21 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Database {
+class DudeDatabase;
+
+// Samples sorted in memory before a run is spilled, 64 MiB of records
+constexpr std::size_t OpenMetricsRunSamples = 0x400000;
+
+// Writes the chart values of every resolution as OpenMetrics text, the input format of
+// "promtool tsdb create-blocks-from openmetrics". Samples are sorted by series and time with an
+// external merge sort, runs of run_samples are spilled next to out_file so memory usage stays
+// bounded
+int SerializeDatabaseOpenMetrics(const DudeDatabase* db, const std::string& out_file,
+                                 std::size_t run_samples);
+} // namespace Database
@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+#include <unordered_map>
+
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_outages.h"
+
+namespace Database {
+namespace {
+
+// Last second covered by the outage
+u32 GetLastTime(const Outage& outage) {
+    return outage.end_time > outage.start_time ? outage.end_time - 1 : outage.start_time;
+}
+
+} // Anonymous namespace
+
+OutageIndex::OutageIndex(std::vector<Outage> outage_list) : outages{std::move(outage_list)} {
+    std::sort(outages.begin(), outages.end(), [](const Outage& a, const Outage& b) {
+        return a.start_time < b.start_time;
+    });
+    max_last_times.resize(outages.size());
+    BuildMaxLastTimes(0, outages.size());
+}
+
+u32 OutageIndex::BuildMaxLastTimes(std::size_t begin, std::size_t end) {
+    if (begin >= end) {
+        return 0;
+    }
+    const std::size_t middle = begin + (end - begin) / 2;
+    const u32 left = BuildMaxLastTimes(begin, middle);
+    const u32 right = BuildMaxLastTimes(middle + 1, end);
+    max_last_times[middle] = std::max({GetLastTime(outages[middle]), left, right});
+    return max_last_times[middle];
+}
+
+std::size_t OutageIndex::GetCount() const {
+    return outages.size();
+}
+
+std::vector<Outage> OutageIndex::FindOverlapping(u32 start, u32 end) const {
+    std::vector<Outage> result{};
+    if (start > end) {
+        return result;
+    }
+    FindOverlapping(result, 0, outages.size(), start, end);
+    return result;
+}
+
+std::vector<Outage> OutageIndex::FindActive(u32 time) const {
+    return FindOverlapping(time, time);
+}
+
+void OutageIndex::FindOverlapping(std::vector<Outage>& result, std::size_t begin,
+                                  std::size_t end, u32 start, u32 end_time) const {
+    if (begin >= end) {
+        return;
+    }
+    const std::size_t middle = begin + (end - begin) / 2;
+
+    // Every outage of this subtree ended before the window
+    if (max_last_times[middle] < start) {
+        return;
+    }
+
+    FindOverlapping(result, begin, middle, start, end_time);
+
+    // Outages on the right start after this one
+    if (outages[middle].start_time > end_time) {
+        return;
+    }
+    if (GetLastTime(outages[middle]) >= start) {
+        result.push_back(outages[middle]);
+    }
+    FindOverlapping(result, middle + 1, end, start, end_time);
+}
+
+int PrintOutages(const DudeDatabase* db, u32 start, u32 end) {
+    std::vector<Outage> outage_list{};
+    const int rc = db->ReadOutages(outage_list);
+    if (rc != 0) {
+        return rc;
+    }
+
+    const OutageIndex index{std::move(outage_list)};
+    const auto start_time = std::chrono::steady_clock::now();
+    const std::vector<Outage> outages = index.FindOverlapping(start, end);
+    const std::chrono::duration<f64, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start_time;
+
+    std::unordered_map<u32, std::string> service_names{};
+    for (const ServiceData& service : db->GetServiceData()) {
+        service_names.emplace(static_cast<u32>(service.object_id.value), service.name.text);
+    }
+    std::unordered_map<u32, std::string> device_names{};
+    for (const DeviceData& device : db->GetDeviceData()) {
+        device_names.emplace(static_cast<u32>(device.object_id.value), device.name.text);
+    }
+    const auto get_name = [](const auto& names, u32 id) -> std::string_view {
+        const auto it = names.find(id);
+        return it == names.end() ? "(deleted)" : std::string_view{it->second};
+    };
+
+    printf("%10s %10s %10s %8s %12s %12s %10s  %s\n", "service", "device", "map", "status",
+           "start", "end", "duration", "name");
+    for (const Outage& outage : outages) {
+        const std::string_view service_name = get_name(service_names, outage.service_id);
+        const std::string_view device_name = get_name(device_names, outage.device_id);
+        printf("%10u %10u %10u %8u %12u %12u %10u  %.*s / %.*s\n", outage.service_id,
+               outage.device_id, outage.map_id, outage.status, outage.start_time,
+               outage.end_time, outage.end_time - outage.start_time,
+               static_cast<int>(device_name.size()), device_name.data(),
+               static_cast<int>(service_name.size()), service_name.data());
+    }
+    printf("Found %zu of %zu outages in %.1f us\n", outages.size(), index.GetCount(),
+           elapsed.count());
+    return 0;
+}
+
+} // namespace Database
@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <vector>
+
+#include "common/common_types.h"
+#include "the_dude_to_human/database/dude_types.h"
+
+namespace Database {
+class DudeDatabase;
+
+// Static interval tree over outages. Outages are sorted by start time and each element is the
+// root of the subtree of its index range, which stores the latest last second below it. Subtrees
+// that end before the window or start after it are skipped, so a query visits O(m log n) nodes for
+// m results in the worst case and O(log n) when nothing overlaps.
+// An outage covers the seconds from start_time up to end_time excluding end_time, like the SLA
+// report counts them. An outage of duration zero covers its start second so it's still found
+class OutageIndex {
+public:
+    explicit OutageIndex(std::vector<Outage> outage_list);
+
+    std::size_t GetCount() const;
+
+    // Returns the outages covering any second from start to end, both included, ordered by start
+    // time. Nothing is found if end is before start
+    std::vector<Outage> FindOverlapping(u32 start, u32 end) const;
+
+    // Returns the outages in progress at time, an outage ending at time isn't
+    std::vector<Outage> FindActive(u32 time) const;
+
+private:
+    u32 BuildMaxLastTimes(std::size_t begin, std::size_t end);
+    void FindOverlapping(std::vector<Outage>& result, std::size_t begin, std::size_t end,
+                         u32 start, u32 end_time) const;
+
+    std::vector<Outage> outages;
+    std::vector<u32> max_last_times;
+};
+
+// Prints the outages overlapping start to end with their service and device names
+int PrintOutages(const DudeDatabase* db, u32 start, u32 end);
+} // namespace Database
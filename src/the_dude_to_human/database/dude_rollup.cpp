@@ -0,0 +1,273 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <vector>
+
+#include "common/thread_pool.h"
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_rollup.h"
+#include "the_dude_to_human/sqlite/sqlite_writer.h"
+
+namespace Database {
+namespace {
+
+// Rows written before the transaction is committed and a new one started
+constexpr std::size_t RowsPerTransaction = 0x40000;
+
+struct RollupResolution {
+    ChartResolution resolution;
+    u32 bucket_width;
+    s32 keep_time;
+};
+
+// Raw values of a single data source ordered by time
+struct SourceValues {
+    u32 source_id{};
+    std::vector<u32> times{};
+    std::vector<f64> values{};
+};
+
+struct SourceRollup {
+    u32 source_id{};
+    std::array<std::vector<ChartBucket>, 3> buckets{};
+};
+
+std::vector<ChartBucket> ComputeBuckets(const SourceValues& source, u32 bucket_width,
+                                        u32 first_time) {
+    std::vector<ChartBucket> buckets{};
+    const auto begin = std::lower_bound(source.times.begin(), source.times.end(), first_time);
+
+    for (auto it = begin; it != source.times.end();) {
+        const u32 bucket_time = *it - *it % bucket_width;
+        // The last bucket may end past 0xffffffff
+        const auto bucket_end =
+            std::lower_bound(it, source.times.end(), u64{bucket_time} + bucket_width);
+        const std::size_t offset = static_cast<std::size_t>(it - source.times.begin());
+        const std::size_t count = static_cast<std::size_t>(bucket_end - it);
+
+        buckets.push_back(
+            ComputeChartBucket(bucket_time, std::span{source.values}.subspan(offset, count)));
+        it = bucket_end;
+    }
+
+    return buckets;
+}
+
+SourceRollup RollupSource(const SourceValues& source,
+                          std::span<const RollupResolution> resolutions, u32 last_time) {
+    SourceRollup rollup{.source_id = source.source_id};
+    for (std::size_t i = 0; i < resolutions.size(); ++i) {
+        const RollupResolution& resolution = resolutions[i];
+        u32 first_time = 0;
+        if (resolution.keep_time > 0 && last_time > static_cast<u32>(resolution.keep_time)) {
+            first_time = last_time - static_cast<u32>(resolution.keep_time);
+        }
+        rollup.buckets[i] = ComputeBuckets(source, resolution.bucket_width, first_time);
+    }
+    return rollup;
+}
+
+class RollupWriter {
+public:
+    explicit RollupWriter(Sqlite::SqliteWriter& sqlite_writer) : writer{sqlite_writer} {}
+
+    int CreateTables(std::span<const RollupResolution> resolutions) {
+        static constexpr std::array<Sqlite::SqlColumn, 5> columns{{
+            {.name = "sourceIDandTime", .type = Sqlite::SqlType::Integer, .is_primary_key = true},
+            {.name = "value", .type = Sqlite::SqlType::Real},
+            {.name = "min", .type = Sqlite::SqlType::Real},
+            {.name = "max", .type = Sqlite::SqlType::Real},
+            {.name = "count", .type = Sqlite::SqlType::Integer},
+        }};
+
+        for (const RollupResolution& resolution : resolutions) {
+            const int rc =
+                writer.CreateTable(DudeDatabase::GetChartTableName(resolution.resolution), columns);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+        }
+        return writer.BeginTransaction();
+    }
+
+    int Write(const SourceRollup& rollup, std::span<const RollupResolution> resolutions) {
+        const s64 source_key = static_cast<s64>(rollup.source_id) << 32;
+        std::array<Sqlite::SqlValue, 5> row{};
+
+        for (std::size_t i = 0; i < resolutions.size(); ++i) {
+            const std::string table_name =
+                DudeDatabase::GetChartTableName(resolutions[i].resolution);
+            for (const ChartBucket& bucket : rollup.buckets[i]) {
+                row[0] = source_key | bucket.time;
+                row[1] = bucket.avg;
+                row[2] = bucket.min;
+                row[3] = bucket.max;
+                row[4] = static_cast<s64>(bucket.count);
+
+                int rc = writer.InsertRow(table_name, row);
+                if (rc == SQLITE_OK && ++pending_rows == RowsPerTransaction) {
+                    pending_rows = 0;
+                    rc = writer.CommitTransaction();
+                    if (rc == SQLITE_OK) {
+                        rc = writer.BeginTransaction();
+                    }
+                }
+                if (rc != SQLITE_OK) {
+                    return rc;
+                }
+                row_count++;
+            }
+        }
+        return SQLITE_OK;
+    }
+
+    int Finish() {
+        return writer.CommitTransaction();
+    }
+
+    std::size_t GetRowCount() const {
+        return row_count;
+    }
+
+private:
+    Sqlite::SqliteWriter& writer;
+    std::size_t pending_rows{};
+    std::size_t row_count{};
+};
+
+} // Anonymous namespace
+
+ChartBucket ComputeChartBucket(u32 time, std::span<const f64> values) {
+    // Four independent accumulators break the dependency chains so the loop can be vectorized
+    std::array<f64, 4> min{values[0], values[0], values[0], values[0]};
+    std::array<f64, 4> max = min;
+    std::array<f64, 4> sum{};
+
+    std::size_t i = 0;
+    for (; i + 4 <= values.size(); i += 4) {
+        for (std::size_t lane = 0; lane < 4; ++lane) {
+            const f64 value = values[i + lane];
+            min[lane] = value < min[lane] ? value : min[lane];
+            max[lane] = value > max[lane] ? value : max[lane];
+            sum[lane] += value;
+        }
+    }
+    for (; i < values.size(); ++i) {
+        min[0] = values[i] < min[0] ? values[i] : min[0];
+        max[0] = values[i] > max[0] ? values[i] : max[0];
+        sum[0] += values[i];
+    }
+
+    return {
+        .time = time,
+        .count = static_cast<u32>(values.size()),
+        .min = std::min({min[0], min[1], min[2], min[3]}),
+        .max = std::max({max[0], max[1], max[2], max[3]}),
+        .avg = (sum[0] + sum[1] + sum[2] + sum[3]) / static_cast<f64>(values.size()),
+    };
+}
+
+int RollupChartValues(const DudeDatabase* db, const std::string& out_file) {
+    const std::vector<ServerConfigData> server_config = db->GetServerConfigData();
+    std::array<RollupResolution, 3> resolutions{{
+        {ChartResolution::TenMinutes, 10 * 60, 0},
+        {ChartResolution::TwoHours, 2 * 60 * 60, 0},
+        {ChartResolution::OneDay, 24 * 60 * 60, 0},
+    }};
+    if (!server_config.empty()) {
+        resolutions[0].keep_time = server_config[0].chart_value_keep_time_10_min.value;
+        resolutions[1].keep_time = server_config[0].chart_value_keep_time_2_hour.value;
+        resolutions[2].keep_time = server_config[0].chart_value_keep_time_1_day.value;
+    }
+
+    // Retention is relative to the newest raw value since databases are usually old backups
+    u32 last_time = 0;
+    int rc = db->GetLastChartTime(last_time, ChartResolution::Raw);
+    if (rc != 0) {
+        return rc;
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(out_file, ec);
+
+    Sqlite::SqliteWriter writer{out_file};
+    rc = writer.OpenDatabase();
+    if (rc != SQLITE_OK) {
+        printf("Error at '%s': %s\n", out_file.c_str(), writer.GetError());
+        return 1;
+    }
+
+    rc = writer.SetBulkLoad(true);
+    RollupWriter rollup_writer{writer};
+    if (rc == SQLITE_OK) {
+        rc = rollup_writer.CreateTables(resolutions);
+    }
+
+    // Sources are rolled up in parallel and written in order. The number of sources in flight is
+    // limited so memory usage stays bounded
+    Common::ThreadPool pool{};
+    const std::size_t max_pending = pool.GetThreadCount() * 2;
+    std::deque<std::future<SourceRollup>> pending{};
+    SourceValues source{};
+
+    const auto write_oldest = [&] {
+        const SourceRollup rollup = pending.front().get();
+        pending.pop_front();
+        if (rc == SQLITE_OK) {
+            rc = rollup_writer.Write(rollup, resolutions);
+        }
+    };
+    const auto submit_source = [&] {
+        if (source.times.empty()) {
+            return;
+        }
+        pending.push_back(
+            pool.Submit([values = std::move(source), &resolutions, last_time]() {
+                return RollupSource(values, resolutions, last_time);
+            }));
+        source = {};
+        while (pending.size() > max_pending) {
+            write_oldest();
+        }
+    };
+
+    if (rc == SQLITE_OK) {
+        rc = db->ReadChartValues(ChartResolution::Raw, [&](std::span<const ChartValue> values) {
+            for (const ChartValue& value : values) {
+                if (value.source_id != source.source_id) {
+                    submit_source();
+                    source.source_id = value.source_id;
+                }
+                source.times.push_back(value.time);
+                source.values.push_back(value.value);
+            }
+            return rc;
+        });
+    }
+    submit_source();
+    while (!pending.empty()) {
+        write_oldest();
+    }
+
+    if (rc == SQLITE_OK) {
+        rc = rollup_writer.Finish();
+    }
+    if (rc == SQLITE_OK) {
+        rc = writer.SetBulkLoad(false);
+    }
+    writer.CloseDatabase();
+
+    if (rc != SQLITE_OK) {
+        return 1;
+    }
+    printf("Wrote %zu rollup values\n", rollup_writer.GetRowCount());
+    return 0;
+}
+
+} // namespace Database
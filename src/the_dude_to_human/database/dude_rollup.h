@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <span>
+#include <string>
+
+#include "common/common_types.h"
+
+namespace Database {
+class DudeDatabase;
+
+// Aggregate of the raw values inside a single time bucket
+struct ChartBucket {
+    u32 time{};
+    u32 count{};
+    f64 min{};
+    f64 max{};
+    f64 avg{};
+};
+
+// Computes min, max and average of values. Values can't be empty
+ChartBucket ComputeChartBucket(u32 time, std::span<const f64> values);
+
+// Recomputes the 10min, 2hour and 1day chart values from chart_values_raw into a new sqlite
+// database at out_file. Buckets older than the server retention settings are skipped
+int RollupChartValues(const DudeDatabase* db, const std::string& out_file);
+} // namespace Database
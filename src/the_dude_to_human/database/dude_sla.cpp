@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_sla.h"
+
+namespace Database {
+namespace {
+
+void PrintAvailabilityRow(const SlaEngine& engine, const SlaEngine::AvailabilityMap& objects,
+                          u32 object_id, std::string_view name) {
+    const auto it = objects.find(object_id);
+    const Availability availability = it == objects.end() ? Availability{} : it->second;
+    printf("%10u %10.4f %12llu %8u  %.*s\n", object_id,
+           engine.GetAvailability(availability) * 100.0,
+           static_cast<unsigned long long>(availability.downtime), availability.outage_count,
+           static_cast<int>(name.size()), name.data());
+}
+
+template <typename T>
+void PrintAvailabilitySection(const char* title, const SlaEngine& engine,
+                              const SlaEngine::AvailabilityMap& objects,
+                              const std::vector<T>& object_data) {
+    printf("\n%s\n%10s %10s %12s %8s  %s\n", title, "id", "available", "downtime", "outages",
+           "name");
+    for (const T& data : object_data) {
+        PrintAvailabilityRow(engine, objects, static_cast<u32>(data.object_id.value),
+                             data.name.text);
+    }
+}
+
+} // Anonymous namespace
+
+SlaEngine::SlaEngine(u32 start, u32 end) : period_start{start}, period_end{end} {}
+
+void SlaEngine::Add(const Outage& outage) {
+    const u32 start = std::max(outage.start_time, period_start);
+    const u32 end = std::min(outage.end_time, period_end);
+    if (start >= end) {
+        return;
+    }
+
+    AddDowntime(services[outage.service_id], start, end);
+    AddDowntime(devices[outage.device_id], start, end);
+    AddDowntime(maps[outage.map_id], start, end);
+}
+
+void SlaEngine::AddDowntime(Availability& availability, u32 start, u32 end) {
+    // Every added outage has downtime, none means this is the first one
+    if (availability.downtime == 0 || start > availability.covered_until) {
+        availability.outage_count++;
+    }
+    if (end <= availability.covered_until) {
+        return;
+    }
+    availability.downtime += end - std::max(start, availability.covered_until);
+    availability.covered_until = end;
+}
+
+const SlaEngine::AvailabilityMap& SlaEngine::GetServices() const {
+    return services;
+}
+
+const SlaEngine::AvailabilityMap& SlaEngine::GetDevices() const {
+    return devices;
+}
+
+const SlaEngine::AvailabilityMap& SlaEngine::GetMaps() const {
+    return maps;
+}
+
+f64 SlaEngine::GetAvailability(const Availability& availability) const {
+    const f64 period = static_cast<f64>(period_end - period_start);
+    return 1.0 - static_cast<f64>(availability.downtime) / period;
+}
+
+int PrintSlaReport(const DudeDatabase* db, u32 start, u32 end) {
+    std::vector<Outage> outages{};
+    const int rc = db->ReadOutages(outages);
+    if (rc != 0) {
+        return rc;
+    }
+
+    // Outages are keyed by time so they are usually sorted already
+    const auto by_start_time = [](const Outage& a, const Outage& b) {
+        return a.start_time < b.start_time;
+    };
+    if (!std::is_sorted(outages.begin(), outages.end(), by_start_time)) {
+        std::stable_sort(outages.begin(), outages.end(), by_start_time);
+    }
+
+    SlaEngine engine{start, end};
+    for (const Outage& outage : outages) {
+        engine.Add(outage);
+    }
+
+    printf("Availability from %u to %u, %zu outages\n", start, end, outages.size());
+    PrintAvailabilitySection("Services", engine, engine.GetServices(), db->GetServiceData());
+    PrintAvailabilitySection("Devices", engine, engine.GetDevices(), db->GetDeviceData());
+    PrintAvailabilitySection("Maps", engine, engine.GetMaps(), db->GetMapData());
+    return 0;
+}
+
+} // namespace Database
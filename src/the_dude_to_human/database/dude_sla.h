@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <unordered_map>
+
+#include "common/common_types.h"
+#include "the_dude_to_human/database/dude_types.h"
+
+namespace Database {
+class DudeDatabase;
+
+struct Availability {
+    // Seconds down inside the period, overlapping outages are only counted once
+    u64 downtime{};
+    // Periods of downtime inside the period. Outages overlapping or adjacent to an earlier one
+    // extend its period instead of starting a new one
+    u32 outage_count{};
+    // End of the merged outages seen so far
+    u32 covered_until{};
+};
+
+// Accumulates downtime per service, device and map in a single pass over the outages. Outages
+// must be added in start time order, which lets overlapping outages be merged by remembering the
+// end of the last one
+class SlaEngine {
+public:
+    using AvailabilityMap = std::unordered_map<u32, Availability>;
+
+    // Downtime is counted between start and end, excluding end
+    SlaEngine(u32 start, u32 end);
+
+    void Add(const Outage& outage);
+
+    const AvailabilityMap& GetServices() const;
+    const AvailabilityMap& GetDevices() const;
+    const AvailabilityMap& GetMaps() const;
+
+    // Fraction of the period the object was up
+    f64 GetAvailability(const Availability& availability) const;
+
+private:
+    static void AddDowntime(Availability& availability, u32 start, u32 end);
+
+    u32 period_start{};
+    u32 period_end{};
+    AvailabilityMap services{};
+    AvailabilityMap devices{};
+    AvailabilityMap maps{};
+};
+
+// Prints the availability of every service, device and map between start and end
+int PrintSlaReport(const DudeDatabase* db, u32 start, u32 end);
+} // namespace Database
@@ -0,0 +1,292 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fmt/core.h>
+
+#include "the_dude_to_human/database/dude_database.h"
+#include "the_dude_to_human/database/dude_sqlite.h"
+#include "the_dude_to_human/sqlite/sqlite_writer.h"
+
+namespace Database {
+namespace {
+
+// Rows written before the transaction is committed and a new one started
+constexpr std::size_t RowsPerTransaction = 0x40000;
+
+template <typename T>
+constexpr bool IsArrayField = std::is_base_of_v<IntArrayField, T> ||
+                              std::is_same_v<T, MacAddressField> ||
+                              std::is_same_v<T, StringArrayField>;
+
+Sqlite::SqlValue ToSqlValue(const BoolField& field) {
+    return static_cast<s64>(field.value);
+}
+
+Sqlite::SqlValue ToSqlValue(const ByteField& field) {
+    return static_cast<s64>(field.value);
+}
+
+Sqlite::SqlValue ToSqlValue(const IntField& field) {
+    return static_cast<s64>(field.value);
+}
+
+Sqlite::SqlValue ToSqlValue(const TimeField& field) {
+    return static_cast<s64>(field.date);
+}
+
+Sqlite::SqlValue ToSqlValue(const LongField& field) {
+    return static_cast<s64>(field.value);
+}
+
+Sqlite::SqlValue ToSqlValue(const LongLongField& field) {
+    const std::array<u8, sizeof(u128)> raw = field.GetBytes();
+    return std::vector<u8>(raw.begin(), raw.end());
+}
+
+Sqlite::SqlValue ToSqlValue(const TextField& field) {
+    return field.text;
+}
+
+Sqlite::SqlValue ToSqlValue(const LongArrayField& field) {
+    return field.data;
+}
+
+std::vector<Sqlite::SqlValue> ToSqlValues(const IntArrayField& field) {
+    std::vector<Sqlite::SqlValue> values{};
+    values.reserve(field.data.size());
+    for (u32 entry : field.data) {
+        values.emplace_back(static_cast<s64>(entry));
+    }
+    return values;
+}
+
+std::vector<Sqlite::SqlValue> ToSqlValues(const IpArrayField& field) {
+    std::vector<Sqlite::SqlValue> values{};
+    values.reserve(field.data.size());
+    for (u32 entry : field.data) {
+        IpAddress ip{};
+        std::memcpy(&ip, &entry, sizeof(u32));
+        values.emplace_back(fmt::format("{}.{}.{}.{}", ip[0], ip[1], ip[2], ip[3]));
+    }
+    return values;
+}
+
+std::vector<Sqlite::SqlValue> ToSqlValues(const MacAddressField& field) {
+    std::vector<Sqlite::SqlValue> values{};
+    values.reserve(field.mac_address.size());
+    for (const MacAddress& mac : field.mac_address) {
+        values.emplace_back(fmt::format("{:02x}:{:02x}:{:02x}:{:02x}:{:02x}:{:02x}", mac[0],
+                                        mac[1], mac[2], mac[3], mac[4], mac[5]));
+    }
+    return values;
+}
+
+std::vector<Sqlite::SqlValue> ToSqlValues(const StringArrayField& field) {
+    std::vector<Sqlite::SqlValue> values{};
+    values.reserve(field.entries.size());
+    for (const StringArrayEntry& entry : field.entries) {
+        values.emplace_back(entry.text);
+    }
+    return values;
+}
+
+Sqlite::SqlType GetSqlType(const Sqlite::SqlValue& value) {
+    if (std::holds_alternative<s64>(value)) {
+        return Sqlite::SqlType::Integer;
+    }
+    if (std::holds_alternative<f64>(value)) {
+        return Sqlite::SqlType::Real;
+    }
+    if (std::holds_alternative<std::string>(value)) {
+        return Sqlite::SqlType::Text;
+    }
+    return Sqlite::SqlType::Blob;
+}
+
+template <typename T>
+Sqlite::SqlType GetArraySqlType(const T&) {
+    if constexpr (std::is_same_v<T, IntArrayField>) {
+        return Sqlite::SqlType::Integer;
+    }
+    return Sqlite::SqlType::Text;
+}
+
+// Writes every object into one table per data format. Array fields are stored in
+// <table>_<field> join tables with one row per entry
+class SqliteExporter {
+public:
+    SqliteExporter(Sqlite::SqliteWriter& sqlite_writer, bool credentials)
+        : writer{sqlite_writer}, has_credentials{credentials} {}
+
+    template <typename T>
+    int ExportTable(const std::string& table_name, const std::vector<T>& objects) {
+        int rc = CreateTables(table_name, T{});
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+
+        std::vector<Sqlite::SqlValue> row{};
+        for (const T& data : objects) {
+            const s64 object_id = data.object_id.value;
+            row.clear();
+
+            data.VisitFields(
+                [&](std::string_view name, const auto& field) {
+                    using FieldType = std::decay_t<decltype(field)>;
+                    if constexpr (IsArrayField<FieldType>) {
+                        const std::string join_table = GetJoinTableName(table_name, name);
+                        const std::vector<Sqlite::SqlValue> values = ToSqlValues(field);
+                        for (std::size_t i = 0; i < values.size() && rc == SQLITE_OK; ++i) {
+                            const std::array<Sqlite::SqlValue, 3> join_row{
+                                object_id, static_cast<s64>(i), values[i]};
+                            rc = InsertRow(join_table, join_row);
+                        }
+                    } else {
+                        row.push_back(ToSqlValue(field));
+                    }
+                },
+                has_credentials);
+
+            if (rc == SQLITE_OK) {
+                rc = InsertRow(table_name, row);
+            }
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+        }
+
+        return SQLITE_OK;
+    }
+
+    int Begin() {
+        return writer.BeginTransaction();
+    }
+
+    // Commits pending rows and builds the indexes. Indexes are created after the bulk insert
+    // since updating them on every row is much slower
+    int Finish() {
+        int rc = writer.CommitTransaction();
+        for (const auto& [table_name, column_name] : pending_indexes) {
+            if (rc != SQLITE_OK) {
+                break;
+            }
+            rc = writer.CreateIndex(table_name, column_name);
+        }
+        return rc;
+    }
+
+private:
+    template <typename T>
+    int CreateTables(const std::string& table_name, const T& empty_object) {
+        std::vector<Sqlite::SqlColumn> columns{};
+        std::vector<std::pair<std::string, Sqlite::SqlType>> join_tables{};
+
+        empty_object.VisitFields(
+            [&](std::string_view name, const auto& field) {
+                using FieldType = std::decay_t<decltype(field)>;
+                if constexpr (IsArrayField<FieldType>) {
+                    join_tables.emplace_back(GetJoinTableName(table_name, name),
+                                             GetArraySqlType(field));
+                } else {
+                    columns.push_back({
+                        .name = std::string{name},
+                        .type = GetSqlType(ToSqlValue(field)),
+                        .is_primary_key = name == "objectId",
+                    });
+                }
+            },
+            has_credentials);
+
+        int rc = writer.CreateTable(table_name, columns);
+
+        for (const auto& [join_table, value_type] : join_tables) {
+            if (rc != SQLITE_OK) {
+                break;
+            }
+            const std::array<Sqlite::SqlColumn, 3> join_columns{{
+                {.name = "objectId", .type = Sqlite::SqlType::Integer},
+                {.name = "position", .type = Sqlite::SqlType::Integer},
+                {.name = "value", .type = value_type},
+            }};
+            rc = writer.CreateTable(join_table, join_columns);
+            pending_indexes.emplace_back(join_table, "objectId");
+            pending_indexes.emplace_back(join_table, "value");
+        }
+
+        return rc;
+    }
+
+    int InsertRow(const std::string& table_name, std::span<const Sqlite::SqlValue> values) {
+        int rc = writer.InsertRow(table_name, values);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+
+        if (++pending_rows < RowsPerTransaction) {
+            return SQLITE_OK;
+        }
+
+        pending_rows = 0;
+        rc = writer.CommitTransaction();
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        return writer.BeginTransaction();
+    }
+
+    static std::string GetJoinTableName(const std::string& table_name, std::string_view field) {
+        return fmt::format("{}_{}", table_name, field);
+    }
+
+    Sqlite::SqliteWriter& writer;
+    bool has_credentials{};
+    std::size_t pending_rows{};
+    std::vector<std::pair<std::string, std::string>> pending_indexes{};
+};
+
+} // Anonymous namespace
+
+int SerializeDatabaseSqlite(DudeDatabase* db, const std::string& db_file, bool has_credentials) {
+    // Tables are created from scratch. Appending to a previous export would fail
+    std::error_code ec;
+    std::filesystem::remove(db_file, ec);
+
+    Sqlite::SqliteWriter writer{db_file};
+    int rc = writer.OpenDatabase();
+    if (rc != SQLITE_OK) {
+        printf("Error at '%s': %s\n", db_file.c_str(), writer.GetError());
+        return 1;
+    }
+
+    rc = writer.SetBulkLoad(true);
+
+    SqliteExporter exporter{writer, has_credentials};
+    if (rc == SQLITE_OK) {
+        rc = exporter.Begin();
+    }
+
+    db->ForEachTable([&](std::string_view table_name, const auto& objects) {
+        if (rc == SQLITE_OK) {
+            rc = exporter.ExportTable(std::string{table_name}, objects);
+        }
+    });
+
+    if (rc == SQLITE_OK) {
+        rc = exporter.Finish();
+    }
+    if (rc == SQLITE_OK) {
+        rc = writer.SetBulkLoad(false);
+    }
+
+    writer.CloseDatabase();
+    return rc == SQLITE_OK ? 0 : 1;
+}
+
+} // namespace Database
@@ -0,0 +1,11 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string>
+
+namespace Database {
+class DudeDatabase;
+int SerializeDatabaseSqlite(DudeDatabase* db, const std::string& db_file, bool has_credentials);
+} // namespace Database
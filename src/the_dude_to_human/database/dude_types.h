@@ -4,7 +4,10 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fmt/core.h>
 
@@ -45,6 +48,61 @@ enum class DataFormat : u32 {
     PanelElement = 0x4d,
 };
 
+enum class ChartResolution {
+    Raw,
+    TenMinutes,
+    TwoHours,
+    OneDay,
+};
+
+constexpr std::array<ChartResolution, 4> ChartResolutions{
+    ChartResolution::Raw,
+    ChartResolution::TenMinutes,
+    ChartResolution::TwoHours,
+    ChartResolution::OneDay,
+};
+
+constexpr const char* GetChartResolutionName(ChartResolution resolution) {
+    switch (resolution) {
+    case ChartResolution::Raw:
+        return "raw";
+    case ChartResolution::TenMinutes:
+        return "10min";
+    case ChartResolution::TwoHours:
+        return "2hour";
+    case ChartResolution::OneDay:
+        return "1day";
+    }
+    return "raw";
+}
+
+// Decoded row of the chart_values_* tables. The row key holds the data source id in the upper 32
+// bits and the unix time in the lower 32 bits
+struct ChartValue {
+    u32 source_id{};
+    u32 time{};
+    f64 value{};
+};
+
+// Chart values of a single data source ordered by time. Times and values are stored in parallel
+// arrays
+struct ChartSeries {
+    u32 source_id{};
+    ChartResolution resolution{};
+    std::vector<u32> times{};
+    std::vector<f64> values{};
+};
+
+// Decoded row of the outages table. The service was in status from start_time to end_time
+struct Outage {
+    u32 service_id{};
+    u32 device_id{};
+    u32 map_id{};
+    u32 status{};
+    u32 start_time{};
+    u32 end_time{};
+};
+
 enum class FieldType : u32 {
     BoolFalse = 0x00,
     BoolTrue = 0x01,
@@ -133,6 +191,17 @@ struct LongLongField {
     std::string SerializeJson() const {
         return fmt::format("\"0x{:x}{:08x}\"", value[0], value[1]);
     }
+
+    // Big endian bytes of value[0] followed by value[1]. Every binary exporter stores the field
+    // with this layout, ipv6 addresses end up in network order
+    std::array<u8, sizeof(u128)> GetBytes() const {
+        std::array<u8, sizeof(u128)> raw{};
+        for (std::size_t i = 0; i < raw.size(); ++i) {
+            const u64 word = value[i / sizeof(u64)];
+            raw[i] = static_cast<u8>(word >> ((sizeof(u64) - 1 - (i % sizeof(u64))) * 8));
+        }
+        return raw;
+    }
 };
 
 // This is FieldType::ShortString or FieldType::LongString
@@ -249,6 +318,11 @@ struct StringArrayField {
     }
 };
 
+// Placeholder written instead of credentials when they are not requested
+inline const TextField HiddenCredential{.text_size = 5, .text = "*****"};
+
+// Every object also provides VisitFields(visitor, has_credentials), which calls
+// visitor(name, field) for each field in export order. All exporters are driven by it
 struct DudeObj {
     virtual ~DudeObj() {}
     virtual std::string SerializeJson(bool has_credentials) const {
@@ -256,6 +330,19 @@ struct DudeObj {
     }
 };
 
+// Members of the json object of data, without the braces
+template <typename T>
+std::string SerializeFieldsJson(const T& data, bool has_credentials) {
+    std::string json{};
+    data.VisitFields(
+        [&json](std::string_view name, const auto& field) {
+            fmt::format_to(std::back_inserter(json), "{}\"{}\":{}", json.empty() ? "" : ", ",
+                           name, field.SerializeJson());
+        },
+        has_credentials);
+    return json;
+}
+
 // This is type 0x03 data
 struct ServerConfigData : DudeObj {
     IntArrayField time_zone_history;
@@ -365,94 +452,116 @@ struct ServerConfigData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"timeZoneHistory\":{}, \"discoverSkipTypes\":{}, "
-            "\"discoverSkipProbes\":{}, \"customColors\":{}, \"chartLineColors\":{}, "
-            "\"notifyIds\":{}, \"discoverIdentification\":{}, \"discoverNetworks\":{}, "
-            "\"discoverLinks\":{}, \"mapDeviceVisible\":{}, \"discoverLayer2\":{}, "
-            "\"firstConnection\":{}, \"discoverPpp\":{}, \"discoverGraphServices\":{}, "
-            "\"mapNetworkVisible\":{}, \"discoverGraphLinks\":{}, \"discoverServiceLess\":{}, "
-            "\"mapSubmapVisible\":{}, \"probeEnabled\":{}, \"mapStaticVisible\":{}, "
-            "\"syslogEnabled\":{}, \"mapLinkVisible\":{}, \"snmpTrapEnabled\":{}, "
-            "\"confirmRemove\":{}, \"resolveMacAddressManufacturer\":{}, \"mapDepVisible\":{}, "
-            "\"mapAntialiasedGeometry\":{}, \"mapGradients\":{}, \"version\":{}, "
-            "\"snmpProfileId\":{}, \"agentId\":{}, \"probeInterval\":{}, \"probeTimeout\":{}, "
-            "\"probeDownCount\":{}, \"syslogPort\":{}, \"snmpTrapPort\":{}, "
-            "\"mapBackgroundColor\":{}, \"mapLabelRefreshInterval\":{}, \"mapUpColor\":{}, "
-            "\"mapDownPartialColor\":{}, \"mapDownCompleteColor\":{}, \"mapUnknownColor\":{}, "
-            "\"mapAckedColor\":{}, \"mapNetworkColor\":{}, \"mapSubmapColor\":{}, "
-            "\"mapSubmapUpColor\":{}, \"mapSubmapDownPartialColor\":{}, "
-            "\"mapSubmapDownCompleteColor\":{}, \"mapSubmapAckedColor\":{}, \"mapStaticColor\":{}, "
-            "\"mapLinkColor\":{}, \"mapLinkLabelColor\":{}, \"mapLinkFullColor\":{}, "
-            "\"mapDeviceShape\":{}, \"mapNetworkShape\":{}, \"mapSubmapShape\":{}, "
-            "\"mapStaticShape\":{}, \"mapLinkThickness\":{}, \"mapDepColor\":{}, "
-            "\"mapDepThickness\":{}, \"mapDepStyle\":{}, \"chartValueKeepTimeRaw\":{}, "
-            "\"chartValueKeepTime10Min\":{}, \"chartValueKeepTime2Hour\":{}, "
-            "\"chartValueKeepTime1Day\":{}, \"chartBackgroundColor\":{}, \"chartGridColor\":{}, "
-            "\"chartTextColor\":{}, \"discoverNamePreference\":{}, \"discoverMode\":{}, "
-            "\"discoverHops\":{}, \"discoverHopNetworkSizeLimit\":{}, \"discoverSimultaneous\":{}, "
-            "\"discoverInterval\":{}, \"discoverItemWidth\":{}, \"discoverItemHeight\":{}, "
-            "\"discoverBigRow\":{}, \"discoverBigColumn\":{}, \"discoverWholeRow\":{}, "
-            "\"discoverWholeColumn\":{}, \"rosConnInterval\":{}, \"rosConnIntervalAuthFailed\":{}, "
-            "\"undoQueueSize\":{}, \"macMappingRefreshInterval\":{}, \"contentsPaneBehavior\":{}, "
-            "\"lastChartMaintenanceTime\":{}, \"discoverBlackList\":{}, \"reportFont\":{}, "
-            "\"chartFont\":{}, \"mapLinkFont\":{}, \"mapLinkTooltip\":{}, \"mapLinkLabel\":{}, "
-            "\"mapStaticFont\":{}, \"mapSubmapFont\":{}, \"mapSubmapTooltip\":{}, "
-            "\"mapSubmapLabel\":{}, \"mapNetworkFont\":{}, \"mapNetworkTooltip\":{}, "
-            "\"mapNetworkLabel\":{}, \"mapDeviceFont\":{}, \"mapDeviceTooltip\":{}, "
-            "\"mapDeviceLabel\":{}, \"uniqueId\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), time_zone_history.SerializeJson(),
-            discover_skip_types.SerializeJson(), discover_skip_probes.SerializeJson(),
-            custom_colors.SerializeJson(), chart_line_colors.SerializeJson(),
-            notify_ids.SerializeJson(), discover_identification.SerializeJson(),
-            discover_networks.SerializeJson(), discover_links.SerializeJson(),
-            map_device_visible.SerializeJson(), discover_layer_2.SerializeJson(),
-            first_connection.SerializeJson(), discover_ppp.SerializeJson(),
-            discover_graph_services.SerializeJson(), map_network_visible.SerializeJson(),
-            discover_graph_links.SerializeJson(), discover_service_less.SerializeJson(),
-            map_submap_visible.SerializeJson(), probe_enabled.SerializeJson(),
-            map_static_visible.SerializeJson(), syslog_enabled.SerializeJson(),
-            map_link_visible.SerializeJson(), snmp_trap_enabled.SerializeJson(),
-            confirm_remove.SerializeJson(), resolve_mac_address_manufacturer.SerializeJson(),
-            map_dep_visible.SerializeJson(), map_antialiased_geometry.SerializeJson(),
-            map_gradients.SerializeJson(), version.SerializeJson(), snmp_profile_id.SerializeJson(),
-            agent_id.SerializeJson(), probe_interval.SerializeJson(), probe_timeout.SerializeJson(),
-            probe_down_count.SerializeJson(), syslog_port.SerializeJson(),
-            snmp_trap_port.SerializeJson(), map_background_color.SerializeJson(),
-            map_label_refresh_interval.SerializeJson(), map_up_color.SerializeJson(),
-            map_down_partial_color.SerializeJson(), map_down_complete_color.SerializeJson(),
-            map_unknown_color.SerializeJson(), map_acked_color.SerializeJson(),
-            map_network_color.SerializeJson(), map_submap_color.SerializeJson(),
-            map_submap_up_color.SerializeJson(), map_submap_down_partial_color.SerializeJson(),
-            map_submap_down_complete_color.SerializeJson(), map_submap_acked_color.SerializeJson(),
-            map_static_color.SerializeJson(), map_link_color.SerializeJson(),
-            map_link_label_color.SerializeJson(), map_link_full_color.SerializeJson(),
-            map_device_shape.SerializeJson(), map_network_shape.SerializeJson(),
-            map_submap_shape.SerializeJson(), map_static_shape.SerializeJson(),
-            map_link_thickness.SerializeJson(), map_dep_color.SerializeJson(),
-            map_dep_thickness.SerializeJson(), map_dep_style.SerializeJson(),
-            chart_value_keep_time_raw.SerializeJson(), chart_value_keep_time_10_min.SerializeJson(),
-            chart_value_keep_time_2_hour.SerializeJson(),
-            chart_value_keep_time_1_day.SerializeJson(), chart_background_color.SerializeJson(),
-            chart_grid_color.SerializeJson(), chart_text_color.SerializeJson(),
-            discover_name_preference.SerializeJson(), discover_mode.SerializeJson(),
-            discover_hops.SerializeJson(), discover_hop_network_size_limit.SerializeJson(),
-            discover_simultaneous.SerializeJson(), discover_interval.SerializeJson(),
-            discover_item_width.SerializeJson(), discover_item_height.SerializeJson(),
-            discover_big_row.SerializeJson(), discover_big_column.SerializeJson(),
-            discover_whole_row.SerializeJson(), discover_whole_column.SerializeJson(),
-            ros_conn_interval.SerializeJson(), ros_conn_interval_auth_failed.SerializeJson(),
-            undo_queue_size.SerializeJson(), mac_mapping_refresh_interval.SerializeJson(),
-            contents_pane_behavior.SerializeJson(), last_chart_maintenance_time.SerializeJson(),
-            discover_black_list.SerializeJson(), report_font.SerializeJson(),
-            chart_font.SerializeJson(), map_link_font.SerializeJson(),
-            map_link_tooltip.SerializeJson(), map_link_label.SerializeJson(),
-            map_static_font.SerializeJson(), map_submap_font.SerializeJson(),
-            map_submap_tooltip.SerializeJson(), map_submap_label.SerializeJson(),
-            map_network_font.SerializeJson(), map_network_tooltip.SerializeJson(),
-            map_network_label.SerializeJson(), map_device_font.SerializeJson(),
-            map_device_tooltip.SerializeJson(), map_device_label.SerializeJson(),
-            unique_id.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("timeZoneHistory", time_zone_history);
+        visitor("discoverSkipTypes", discover_skip_types);
+        visitor("discoverSkipProbes", discover_skip_probes);
+        visitor("customColors", custom_colors);
+        visitor("chartLineColors", chart_line_colors);
+        visitor("notifyIds", notify_ids);
+        visitor("discoverIdentification", discover_identification);
+        visitor("discoverNetworks", discover_networks);
+        visitor("discoverLinks", discover_links);
+        visitor("mapDeviceVisible", map_device_visible);
+        visitor("discoverLayer2", discover_layer_2);
+        visitor("firstConnection", first_connection);
+        visitor("discoverPpp", discover_ppp);
+        visitor("discoverGraphServices", discover_graph_services);
+        visitor("mapNetworkVisible", map_network_visible);
+        visitor("discoverGraphLinks", discover_graph_links);
+        visitor("discoverServiceLess", discover_service_less);
+        visitor("mapSubmapVisible", map_submap_visible);
+        visitor("probeEnabled", probe_enabled);
+        visitor("mapStaticVisible", map_static_visible);
+        visitor("syslogEnabled", syslog_enabled);
+        visitor("mapLinkVisible", map_link_visible);
+        visitor("snmpTrapEnabled", snmp_trap_enabled);
+        visitor("confirmRemove", confirm_remove);
+        visitor("resolveMacAddressManufacturer", resolve_mac_address_manufacturer);
+        visitor("mapDepVisible", map_dep_visible);
+        visitor("mapAntialiasedGeometry", map_antialiased_geometry);
+        visitor("mapGradients", map_gradients);
+        visitor("version", version);
+        visitor("snmpProfileId", snmp_profile_id);
+        visitor("agentId", agent_id);
+        visitor("probeInterval", probe_interval);
+        visitor("probeTimeout", probe_timeout);
+        visitor("probeDownCount", probe_down_count);
+        visitor("syslogPort", syslog_port);
+        visitor("snmpTrapPort", snmp_trap_port);
+        visitor("mapBackgroundColor", map_background_color);
+        visitor("mapLabelRefreshInterval", map_label_refresh_interval);
+        visitor("mapUpColor", map_up_color);
+        visitor("mapDownPartialColor", map_down_partial_color);
+        visitor("mapDownCompleteColor", map_down_complete_color);
+        visitor("mapUnknownColor", map_unknown_color);
+        visitor("mapAckedColor", map_acked_color);
+        visitor("mapNetworkColor", map_network_color);
+        visitor("mapSubmapColor", map_submap_color);
+        visitor("mapSubmapUpColor", map_submap_up_color);
+        visitor("mapSubmapDownPartialColor", map_submap_down_partial_color);
+        visitor("mapSubmapDownCompleteColor", map_submap_down_complete_color);
+        visitor("mapSubmapAckedColor", map_submap_acked_color);
+        visitor("mapStaticColor", map_static_color);
+        visitor("mapLinkColor", map_link_color);
+        visitor("mapLinkLabelColor", map_link_label_color);
+        visitor("mapLinkFullColor", map_link_full_color);
+        visitor("mapDeviceShape", map_device_shape);
+        visitor("mapNetworkShape", map_network_shape);
+        visitor("mapSubmapShape", map_submap_shape);
+        visitor("mapStaticShape", map_static_shape);
+        visitor("mapLinkThickness", map_link_thickness);
+        visitor("mapDepColor", map_dep_color);
+        visitor("mapDepThickness", map_dep_thickness);
+        visitor("mapDepStyle", map_dep_style);
+        visitor("chartValueKeepTimeRaw", chart_value_keep_time_raw);
+        visitor("chartValueKeepTime10Min", chart_value_keep_time_10_min);
+        visitor("chartValueKeepTime2Hour", chart_value_keep_time_2_hour);
+        visitor("chartValueKeepTime1Day", chart_value_keep_time_1_day);
+        visitor("chartBackgroundColor", chart_background_color);
+        visitor("chartGridColor", chart_grid_color);
+        visitor("chartTextColor", chart_text_color);
+        visitor("discoverNamePreference", discover_name_preference);
+        visitor("discoverMode", discover_mode);
+        visitor("discoverHops", discover_hops);
+        visitor("discoverHopNetworkSizeLimit", discover_hop_network_size_limit);
+        visitor("discoverSimultaneous", discover_simultaneous);
+        visitor("discoverInterval", discover_interval);
+        visitor("discoverItemWidth", discover_item_width);
+        visitor("discoverItemHeight", discover_item_height);
+        visitor("discoverBigRow", discover_big_row);
+        visitor("discoverBigColumn", discover_big_column);
+        visitor("discoverWholeRow", discover_whole_row);
+        visitor("discoverWholeColumn", discover_whole_column);
+        visitor("rosConnInterval", ros_conn_interval);
+        visitor("rosConnIntervalAuthFailed", ros_conn_interval_auth_failed);
+        visitor("undoQueueSize", undo_queue_size);
+        visitor("macMappingRefreshInterval", mac_mapping_refresh_interval);
+        visitor("contentsPaneBehavior", contents_pane_behavior);
+        visitor("lastChartMaintenanceTime", last_chart_maintenance_time);
+        visitor("discoverBlackList", discover_black_list);
+        visitor("reportFont", report_font);
+        visitor("chartFont", chart_font);
+        visitor("mapLinkFont", map_link_font);
+        visitor("mapLinkTooltip", map_link_tooltip);
+        visitor("mapLinkLabel", map_link_label);
+        visitor("mapStaticFont", map_static_font);
+        visitor("mapSubmapFont", map_submap_font);
+        visitor("mapSubmapTooltip", map_submap_tooltip);
+        visitor("mapSubmapLabel", map_submap_label);
+        visitor("mapNetworkFont", map_network_font);
+        visitor("mapNetworkTooltip", map_network_tooltip);
+        visitor("mapNetworkLabel", map_network_label);
+        visitor("mapDeviceFont", map_device_font);
+        visitor("mapDeviceTooltip", map_device_tooltip);
+        visitor("mapDeviceLabel", map_device_label);
+        visitor("uniqueId", unique_id);
     }
 };
 
@@ -466,11 +575,17 @@ struct ToolData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"builtin\":{}, \"type\":{}, "
-                           "\"deviceId\":{}, \"command\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(), builtin.SerializeJson(),
-                           type.SerializeJson(), device_id.SerializeJson(),
-                           command.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("builtin", builtin);
+        visitor("type", type);
+        visitor("deviceId", device_id);
+        visitor("command", command);
     }
 };
 
@@ -482,9 +597,15 @@ struct FileData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"parentId\":{}, \"fileName\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(),
-                           parent_id.SerializeJson(), file_name.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("parentId", parent_id);
+        visitor("fileName", file_name);
     }
 };
 
@@ -496,9 +617,15 @@ struct NotesData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"parentId\":{}, \"timeAdded\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(),
-                           parent_id.SerializeJson(), time_added.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("parentId", parent_id);
+        visitor("timeAdded", time_added);
     }
 };
 
@@ -591,71 +718,96 @@ struct MapData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"notifyIds\":{}, \"useStaticColor\":{}, "
-            "\"useLinkColor\":{}, \"useLinkLabelColor\":{}, \"useLinkFullColor\":{}, "
-            "\"useDeviceLabel\":{}, \"useDeviceShape\":{}, \"useDeviceFont\":{}, "
-            "\"useNetworkLabel\":{}, \"useNetworkShape\":{}, \"useNetworkFont\":{}, "
-            "\"useSubmapLabel\":{}, \"useSubmapShape\":{}, \"useSubmapFont\":{}, "
-            "\"useStaticShape\":{}, \"useStaticFont\":{}, \"useLinkLabel\":{}, \"useLinkFont\":{}, "
-            "\"useLinkThickness\":{}, \"ordered\":{}, \"proveEnabled\":{}, \"notifyUse\":{}, "
-            "\"reportScanning\":{}, \"locked\":{}, \"imageTile\":{}, \"colorVisible\":{}, "
-            "\"deviceVisible\":{}, \"networkVisible\":{}, \"submapVisible\":{}, "
-            "\"staticVisible\":{}, \"linkVisible\":{}, \"useBackgroundColor\":{}, "
-            "\"useUpColor\":{}, \"useDownPartialColor\":{}, \"useDownCompleteColor\":{}, "
-            "\"useUnknownColor\":{}, \"useAckedColor\":{}, \"useNetworkColor\":{}, "
-            "\"useSubmapColor\":{}, \"useSubmapUpColor\":{}, \"useSubmapDownPartialColor\":{}, "
-            "\"useSubmapDownCompleteColor\":{}, \"useSubmapAckedColor\":{}, \"linkThickness\":{}, "
-            "\"layoutDensity\":{}, \"layoutQuality\":{}, \"proveInterval\":{}, "
-            "\"proveTimeout\":{}, \"proveDownCount\":{}, \"defaultZoom\":{}, \"imageId\":{}, "
-            "\"imageScale\":{}, \"labelRefreshInterval\":{}, \"backgroundColor\":{}, "
-            "\"upColor\":{}, \"downPartialColor\":{}, \"downCompleteColor\":{}, "
-            "\"unknownColor\":{}, \"ackedColor\":{}, \"networkColor\":{}, \"submapColor\":{}, "
-            "\"submapUpColor\":{}, \"submapDownPartialColor\":{}, \"submapDownCompleteColor\":{}, "
-            "\"submapAckedColor\":{}, \"staticColor\":{}, \"linkColor\":{}, \"linkLabelColor\":{}, "
-            "\"linkFullColor\":{}, \"deviceShape\":{}, \"networkShape\":{}, \"submapShape\":{}, "
-            "\"staticShape\":{}, \"linkFont\":{}, \"linkLabel\":{}, \"staticFont\":{}, "
-            "\"submapFont\":{}, \"submapLabel\":{}, \"networkFont\":{}, \"networkLabel\":{}, "
-            "\"deviceFont\":{}, \"deviceLabel\":{}, \"listType\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), notify_ids.SerializeJson(),
-            use_static_color.SerializeJson(), use_link_color.SerializeJson(),
-            use_link_label_color.SerializeJson(), use_link_full_color.SerializeJson(),
-            use_device_label.SerializeJson(), use_device_shape.SerializeJson(),
-            use_device_font.SerializeJson(), use_network_label.SerializeJson(),
-            use_network_shape.SerializeJson(), use_network_font.SerializeJson(),
-            use_submap_label.SerializeJson(), use_submap_shape.SerializeJson(),
-            use_submap_font.SerializeJson(), use_static_shape.SerializeJson(),
-            use_static_font.SerializeJson(), use_link_label.SerializeJson(),
-            use_link_font.SerializeJson(), use_link_thickness.SerializeJson(),
-            ordered.SerializeJson(), prove_enabled.SerializeJson(), notify_use.SerializeJson(),
-            report_scanning.SerializeJson(), locked.SerializeJson(), image_tile.SerializeJson(),
-            color_visible.SerializeJson(), device_visible.SerializeJson(),
-            network_visible.SerializeJson(), submap_visible.SerializeJson(),
-            static_visible.SerializeJson(), link_visible.SerializeJson(),
-            use_background_color.SerializeJson(), use_up_color.SerializeJson(),
-            use_down_partial_color.SerializeJson(), use_down_complete_color.SerializeJson(),
-            use_unknown_color.SerializeJson(), use_acked_color.SerializeJson(),
-            use_network_color.SerializeJson(), use_submap_color.SerializeJson(),
-            use_submap_up_color.SerializeJson(), use_submap_down_partial_color.SerializeJson(),
-            use_submap_down_complete_color.SerializeJson(), use_submap_acked_color.SerializeJson(),
-            link_thickness.SerializeJson(), layout_density.SerializeJson(),
-            layout_quality.SerializeJson(), prove_interval.SerializeJson(),
-            prove_timeout.SerializeJson(), prove_down_count.SerializeJson(),
-            default_zoom.SerializeJson(), image_id.SerializeJson(), image_scale.SerializeJson(),
-            label_refresh_interval.SerializeJson(), background_color.SerializeJson(),
-            up_color.SerializeJson(), down_partial_color.SerializeJson(),
-            down_complete_color.SerializeJson(), unknown_color.SerializeJson(),
-            acked_color.SerializeJson(), network_color.SerializeJson(),
-            submap_color.SerializeJson(), submap_up_color.SerializeJson(),
-            submap_down_partial_color.SerializeJson(), submap_down_complete_color.SerializeJson(),
-            submap_acked_color.SerializeJson(), static_color.SerializeJson(),
-            link_color.SerializeJson(), link_label_color.SerializeJson(),
-            link_full_color.SerializeJson(), device_shape.SerializeJson(),
-            network_shape.SerializeJson(), submap_shape.SerializeJson(),
-            static_shape.SerializeJson(), link_font.SerializeJson(), link_label.SerializeJson(),
-            static_font.SerializeJson(), submap_font.SerializeJson(), submap_label.SerializeJson(),
-            network_font.SerializeJson(), network_label.SerializeJson(),
-            device_font.SerializeJson(), device_label.SerializeJson(), list_type.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("notifyIds", notify_ids);
+        visitor("useStaticColor", use_static_color);
+        visitor("useLinkColor", use_link_color);
+        visitor("useLinkLabelColor", use_link_label_color);
+        visitor("useLinkFullColor", use_link_full_color);
+        visitor("useDeviceLabel", use_device_label);
+        visitor("useDeviceShape", use_device_shape);
+        visitor("useDeviceFont", use_device_font);
+        visitor("useNetworkLabel", use_network_label);
+        visitor("useNetworkShape", use_network_shape);
+        visitor("useNetworkFont", use_network_font);
+        visitor("useSubmapLabel", use_submap_label);
+        visitor("useSubmapShape", use_submap_shape);
+        visitor("useSubmapFont", use_submap_font);
+        visitor("useStaticShape", use_static_shape);
+        visitor("useStaticFont", use_static_font);
+        visitor("useLinkLabel", use_link_label);
+        visitor("useLinkFont", use_link_font);
+        visitor("useLinkThickness", use_link_thickness);
+        visitor("ordered", ordered);
+        visitor("proveEnabled", prove_enabled);
+        visitor("notifyUse", notify_use);
+        visitor("reportScanning", report_scanning);
+        visitor("locked", locked);
+        visitor("imageTile", image_tile);
+        visitor("colorVisible", color_visible);
+        visitor("deviceVisible", device_visible);
+        visitor("networkVisible", network_visible);
+        visitor("submapVisible", submap_visible);
+        visitor("staticVisible", static_visible);
+        visitor("linkVisible", link_visible);
+        visitor("useBackgroundColor", use_background_color);
+        visitor("useUpColor", use_up_color);
+        visitor("useDownPartialColor", use_down_partial_color);
+        visitor("useDownCompleteColor", use_down_complete_color);
+        visitor("useUnknownColor", use_unknown_color);
+        visitor("useAckedColor", use_acked_color);
+        visitor("useNetworkColor", use_network_color);
+        visitor("useSubmapColor", use_submap_color);
+        visitor("useSubmapUpColor", use_submap_up_color);
+        visitor("useSubmapDownPartialColor", use_submap_down_partial_color);
+        visitor("useSubmapDownCompleteColor", use_submap_down_complete_color);
+        visitor("useSubmapAckedColor", use_submap_acked_color);
+        visitor("linkThickness", link_thickness);
+        visitor("layoutDensity", layout_density);
+        visitor("layoutQuality", layout_quality);
+        visitor("proveInterval", prove_interval);
+        visitor("proveTimeout", prove_timeout);
+        visitor("proveDownCount", prove_down_count);
+        visitor("defaultZoom", default_zoom);
+        visitor("imageId", image_id);
+        visitor("imageScale", image_scale);
+        visitor("labelRefreshInterval", label_refresh_interval);
+        visitor("backgroundColor", background_color);
+        visitor("upColor", up_color);
+        visitor("downPartialColor", down_partial_color);
+        visitor("downCompleteColor", down_complete_color);
+        visitor("unknownColor", unknown_color);
+        visitor("ackedColor", acked_color);
+        visitor("networkColor", network_color);
+        visitor("submapColor", submap_color);
+        visitor("submapUpColor", submap_up_color);
+        visitor("submapDownPartialColor", submap_down_partial_color);
+        visitor("submapDownCompleteColor", submap_down_complete_color);
+        visitor("submapAckedColor", submap_acked_color);
+        visitor("staticColor", static_color);
+        visitor("linkColor", link_color);
+        visitor("linkLabelColor", link_label_color);
+        visitor("linkFullColor", link_full_color);
+        visitor("deviceShape", device_shape);
+        visitor("networkShape", network_shape);
+        visitor("submapShape", submap_shape);
+        visitor("staticShape", static_shape);
+        visitor("linkFont", link_font);
+        visitor("linkLabel", link_label);
+        visitor("staticFont", static_font);
+        visitor("submapFont", submap_font);
+        visitor("submapLabel", submap_label);
+        visitor("networkFont", network_font);
+        visitor("networkLabel", network_label);
+        visitor("deviceFont", device_font);
+        visitor("deviceLabel", device_label);
+        visitor("listType", list_type);
     }
 };
 
@@ -699,33 +851,47 @@ struct ProbeData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"logicProbeIds\":{}, \"snmpValueOid\":{}, "
-            "\"snmpOid\":{}, \"dnsAddresses\":{}, \"snmpAvailIfUp\":{}, \"tcpOnlyConnect\":{}, "
-            "\"tcpFirstReceive\":{}, \"logicType\":{}, \"typeId\":{}, \"agentId\":{}, "
-            "\"defaultPort\":{}, \"icmpSize\":{}, \"icmpRetryCount\":{}, \"icmpRetryInterval\":{}, "
-            "\"randomProbability\":{}, \"icmpTtl\":{}, \"snmpProfileId\":{}, \"snmpOidType\":{}, "
-            "\"snmpCompareMethod\":{}, \"snmpValueNumber\":{}, \"snmpValueIp\":{}, "
-            "\"functionUnit\":{}, \"funtionValue\":{}, \"functionError\":{}, "
-            "\"functionAvailable\":{}, \"snmpValueString\":{}, \"snmpValueBigNumber\":{}, "
-            "\"dnsName\":{}, \"tcpReceive3\":{}, \"tcpSend3\":{}, \"tcpReceive2\":{}, "
-            "\"tcpSend2\":{}, \"tcpReceive1\":{}, \"tcpSend1\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), logic_probe_ids.SerializeJson(),
-            snmp_value_oid.SerializeJson(), snmp_oid.SerializeJson(), dns_addresses.SerializeJson(),
-            snmp_avail_if_up.SerializeJson(), tcp_only_connect.SerializeJson(),
-            tcp_first_receive.SerializeJson(), logic_type.SerializeJson(), type_id.SerializeJson(),
-            agent_id.SerializeJson(), default_port.SerializeJson(), icmp_size.SerializeJson(),
-            icmp_retry_count.SerializeJson(), icmp_retry_interval.SerializeJson(),
-            random_probability.SerializeJson(), icmp_ttl.SerializeJson(),
-            snmp_profile_id.SerializeJson(), snmp_oid_type.SerializeJson(),
-            snmp_compare_method.SerializeJson(), snmp_value_number.SerializeJson(),
-            snmp_value_ip.SerializeJson(), function_unit.SerializeJson(),
-            funtion_value.SerializeJson(), // Using "funtion" to match struct
-            function_error.SerializeJson(), function_available.SerializeJson(),
-            snmp_value_string.SerializeJson(), snmp_value_big_number.SerializeJson(),
-            dns_name.SerializeJson(), tcp_receive_3.SerializeJson(), tcp_send_3.SerializeJson(),
-            tcp_receive_2.SerializeJson(), tcp_send_2.SerializeJson(),
-            tcp_receive_1.SerializeJson(), tcp_send_1.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("logicProbeIds", logic_probe_ids);
+        visitor("snmpValueOid", snmp_value_oid);
+        visitor("snmpOid", snmp_oid);
+        visitor("dnsAddresses", dns_addresses);
+        visitor("snmpAvailIfUp", snmp_avail_if_up);
+        visitor("tcpOnlyConnect", tcp_only_connect);
+        visitor("tcpFirstReceive", tcp_first_receive);
+        visitor("logicType", logic_type);
+        visitor("typeId", type_id);
+        visitor("agentId", agent_id);
+        visitor("defaultPort", default_port);
+        visitor("icmpSize", icmp_size);
+        visitor("icmpRetryCount", icmp_retry_count);
+        visitor("icmpRetryInterval", icmp_retry_interval);
+        visitor("randomProbability", random_probability);
+        visitor("icmpTtl", icmp_ttl);
+        visitor("snmpProfileId", snmp_profile_id);
+        visitor("snmpOidType", snmp_oid_type);
+        visitor("snmpCompareMethod", snmp_compare_method);
+        visitor("snmpValueNumber", snmp_value_number);
+        visitor("snmpValueIp", snmp_value_ip);
+        visitor("functionUnit", function_unit);
+        visitor("funtionValue", funtion_value);
+        visitor("functionError", function_error);
+        visitor("functionAvailable", function_available);
+        visitor("snmpValueString", snmp_value_string);
+        visitor("snmpValueBigNumber", snmp_value_big_number);
+        visitor("dnsName", dns_name);
+        visitor("tcpReceive3", tcp_receive_3);
+        visitor("tcpSend3", tcp_send_3);
+        visitor("tcpReceive2", tcp_receive_2);
+        visitor("tcpSend2", tcp_send_2);
+        visitor("tcpReceive1", tcp_receive_1);
+        visitor("tcpSend1", tcp_send_1);
     }
 };
 
@@ -742,13 +908,20 @@ struct DeviceTypeData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"ignoredServices\":{}, \"allowedServices\":{}, "
-            "\"requiredServices\":{}, \"imageId\":{}, \"imageScale\":{}, \"nextId\":{}, \"url\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), ignored_services.SerializeJson(),
-            allowed_services.SerializeJson(), required_services.SerializeJson(),
-            image_id.SerializeJson(), image_scale.SerializeJson(), next_id.SerializeJson(),
-            url.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("ignoredServices", ignored_services);
+        visitor("allowedServices", allowed_services);
+        visitor("requiredServices", required_services);
+        visitor("imageId", image_id);
+        visitor("imageScale", image_scale);
+        visitor("nextId", next_id);
+        visitor("url", url);
     }
 };
 
@@ -782,24 +955,37 @@ struct DeviceData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"parentIds\":{}, \"notifyIds\":{}, \"dnsNames\":{}, "
-            "\"ip\":{}, \"secureMode\":{}, \"routerOs\":{}, \"dudeServer\":{}, \"notifyUse\":{}, "
-            "\"proveEnabled\":{}, \"lookup\":{}, \"dnsLookupInterval\":{}, \"macLookup\":{}, "
-            "\"typeId\":{}, \"agentId\":{}, \"snmpProfileId\":{}, \"proveInterval\":{}, "
-            "\"proveTimeout\":{}, \"proveDownCount\":{}, \"customField3\":{}, \"customField2\":{}, "
-            "\"customField1\":{}, \"password\":{}, \"username\":{}, \"mac\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), parent_ids.SerializeJson(),
-            notify_ids.SerializeJson(), dns_names.SerializeJson(), ip.SerializeJson(),
-            secure_mode.SerializeJson(), router_os.SerializeJson(), dude_server.SerializeJson(),
-            notify_use.SerializeJson(), prove_enabled.SerializeJson(), lookup.SerializeJson(),
-            dns_lookup_interval.SerializeJson(), mac_lookup.SerializeJson(),
-            type_id.SerializeJson(), agent_id.SerializeJson(), snmp_profile_id.SerializeJson(),
-            prove_interval.SerializeJson(), prove_timeout.SerializeJson(),
-            prove_down_count.SerializeJson(), custom_field_3.SerializeJson(),
-            custom_field_2.SerializeJson(), custom_field_1.SerializeJson(),
-            has_credentials ? password.SerializeJson() : "\"*****\"",
-            has_credentials ? username.SerializeJson() : "\"*****\"", mac.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("parentIds", parent_ids);
+        visitor("notifyIds", notify_ids);
+        visitor("dnsNames", dns_names);
+        visitor("ip", ip);
+        visitor("secureMode", secure_mode);
+        visitor("routerOs", router_os);
+        visitor("dudeServer", dude_server);
+        visitor("notifyUse", notify_use);
+        visitor("proveEnabled", prove_enabled);
+        visitor("lookup", lookup);
+        visitor("dnsLookupInterval", dns_lookup_interval);
+        visitor("macLookup", mac_lookup);
+        visitor("typeId", type_id);
+        visitor("agentId", agent_id);
+        visitor("snmpProfileId", snmp_profile_id);
+        visitor("proveInterval", prove_interval);
+        visitor("proveTimeout", prove_timeout);
+        visitor("proveDownCount", prove_down_count);
+        visitor("customField3", custom_field_3);
+        visitor("customField2", custom_field_2);
+        visitor("customField1", custom_field_1);
+        visitor("password", has_credentials ? password : HiddenCredential);
+        visitor("username", has_credentials ? username : HiddenCredential);
+        visitor("mac", mac);
     }
 };
 
@@ -812,10 +998,16 @@ struct NetworkData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"subnets\":{}, \"netMapId\":{}, \"netMapElement\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), subnets.SerializeJson(),
-            net_map_id.SerializeJson(), net_map_element.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("subnets", subnets);
+        visitor("netMapId", net_map_id);
+        visitor("netMapElement", net_map_element);
     }
 };
 
@@ -846,23 +1038,34 @@ struct ServiceData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"notifyIds\":{}, \"enabled\":{}, \"history\":{}, "
-            "\"notifyUse\":{}, \"acked\":{}, \"probePort\":{}, \"probeInterval\":{}, "
-            "\"probeTimeout\":{}, \"probeDownCount\":{}, \"dataSourceId\":{}, \"status\":{}, "
-            "\"timeSinceChanged\":{}, \"timeSinceLastUp\":{}, \"timeSinceLastDown\":{}, "
-            "\"timePreviousUp\":{}, \"timePreviousDown\":{}, \"provesDown\":{}, \"deviceId\":{}, "
-            "\"agentId\":{}, \"proveId\":{}, \"value\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), notify_ids.SerializeJson(),
-            enabled.SerializeJson(), history.SerializeJson(), notify_use.SerializeJson(),
-            acked.SerializeJson(), probe_port.SerializeJson(), probe_interval.SerializeJson(),
-            probe_timeout.SerializeJson(), probe_down_count.SerializeJson(),
-            data_source_id.SerializeJson(), status.SerializeJson(),
-            time_since_changed.SerializeJson(), time_since_last_up.SerializeJson(),
-            time_since_last_down.SerializeJson(), time_previous_up.SerializeJson(),
-            time_previous_down.SerializeJson(), proves_down.SerializeJson(),
-            device_id.SerializeJson(), agent_id.SerializeJson(), prove_id.SerializeJson(),
-            value.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("notifyIds", notify_ids);
+        visitor("enabled", enabled);
+        visitor("history", history);
+        visitor("notifyUse", notify_use);
+        visitor("acked", acked);
+        visitor("probePort", probe_port);
+        visitor("probeInterval", probe_interval);
+        visitor("probeTimeout", probe_timeout);
+        visitor("probeDownCount", probe_down_count);
+        visitor("dataSourceId", data_source_id);
+        visitor("status", status);
+        visitor("timeSinceChanged", time_since_changed);
+        visitor("timeSinceLastUp", time_since_last_up);
+        visitor("timeSinceLastDown", time_since_last_down);
+        visitor("timePreviousUp", time_previous_up);
+        visitor("timePreviousDown", time_previous_down);
+        visitor("provesDown", proves_down);
+        visitor("deviceId", device_id);
+        visitor("agentId", agent_id);
+        visitor("proveId", prove_id);
+        visitor("value", value);
     }
 };
 
@@ -900,28 +1103,41 @@ struct NotificationData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"statusList\":{}, \"groupNotifyIds\":{}, "
-            "\"mailCc\":{}, \"activity\":{}, \"logUseColor\":{}, \"enabled\":{}, "
-            "\"mailTlsMode\":{}, \"sysLogServer\":{}, \"sysLogPort\":{}, \"soundFileId\":{}, "
-            "\"logColor\":{}, \"speakRate\":{}, \"speakVolume\":{}, \"delayInterval\":{}, "
-            "\"repeatInterval\":{}, \"repeatCount\":{}, \"typeId\":{}, \"mailServer\":{}, "
-            "\"mailPort\":{}, \"logPrefix\":{}, \"mailSubject\":{}, \"mailTo\":{}, "
-            "\"mailFrom\":{}, \"mailPassword\":{}, \"mailUser\":{}, \"mailServerDns\":{}, "
-            "\"mailServer6\":{}, \"textTemplate\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), status_list.SerializeJson(),
-            group_notify_ids.SerializeJson(), mail_cc.SerializeJson(), activity.SerializeJson(),
-            log_use_color.SerializeJson(), enabled.SerializeJson(), mail_tls_mode.SerializeJson(),
-            sys_log_server.SerializeJson(), sys_log_port.SerializeJson(),
-            sound_file_id.SerializeJson(), log_color.SerializeJson(), speak_rate.SerializeJson(),
-            speak_volume.SerializeJson(), delay_interval.SerializeJson(),
-            repeat_interval.SerializeJson(), repeat_count.SerializeJson(), type_id.SerializeJson(),
-            mail_server.SerializeJson(), mail_port.SerializeJson(), log_prefix.SerializeJson(),
-            mail_subject.SerializeJson(), mail_to.SerializeJson(), mail_from.SerializeJson(),
-            has_credentials ? mail_password.SerializeJson() : "\"*****\"",
-            has_credentials ? mail_user.SerializeJson() : "\"*****\"",
-            mail_server_dns.SerializeJson(), mail_server6.SerializeJson(),
-            text_template.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("statusList", status_list);
+        visitor("groupNotifyIds", group_notify_ids);
+        visitor("mailCc", mail_cc);
+        visitor("activity", activity);
+        visitor("logUseColor", log_use_color);
+        visitor("enabled", enabled);
+        visitor("mailTlsMode", mail_tls_mode);
+        visitor("sysLogServer", sys_log_server);
+        visitor("sysLogPort", sys_log_port);
+        visitor("soundFileId", sound_file_id);
+        visitor("logColor", log_color);
+        visitor("speakRate", speak_rate);
+        visitor("speakVolume", speak_volume);
+        visitor("delayInterval", delay_interval);
+        visitor("repeatInterval", repeat_interval);
+        visitor("repeatCount", repeat_count);
+        visitor("typeId", type_id);
+        visitor("mailServer", mail_server);
+        visitor("mailPort", mail_port);
+        visitor("logPrefix", log_prefix);
+        visitor("mailSubject", mail_subject);
+        visitor("mailTo", mail_to);
+        visitor("mailFrom", mail_from);
+        visitor("mailPassword", has_credentials ? mail_password : HiddenCredential);
+        visitor("mailUser", has_credentials ? mail_user : HiddenCredential);
+        visitor("mailServerDns", mail_server_dns);
+        visitor("mailServer6", mail_server6);
+        visitor("textTemplate", text_template);
     }
 };
 
@@ -941,16 +1157,23 @@ struct LinkData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"history\":{}, \"masteringType\":{}, "
-            "\"masterDevice\":{}, \"masterInterface\":{}, \"netMapId\":{}, \"netMapElementId\":{}, "
-            "\"typeId\":{}, \"txDataSourceId\":{}, \"rxDataSourceId\":{}, \"speed\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), history.SerializeJson(),
-            mastering_type.SerializeJson(), master_device.SerializeJson(),
-            master_interface.SerializeJson(), net_map_id.SerializeJson(),
-            net_map_element_id.SerializeJson(), type_id.SerializeJson(),
-            tx_data_source_id.SerializeJson(), rx_data_source_id.SerializeJson(),
-            speed.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("history", history);
+        visitor("masteringType", mastering_type);
+        visitor("masterDevice", master_device);
+        visitor("masterInterface", master_interface);
+        visitor("netMapId", net_map_id);
+        visitor("netMapElementId", net_map_element_id);
+        visitor("typeId", type_id);
+        visitor("txDataSourceId", tx_data_source_id);
+        visitor("rxDataSourceId", rx_data_source_id);
+        visitor("speed", speed);
     }
 };
 
@@ -965,11 +1188,18 @@ struct LinkTypeData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"style\":{}, \"thickness\":{}, "
-                           "\"snmpType\":{}, \"nextId\":{}, \"snmpSpeed\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(), style.SerializeJson(),
-                           thickness.SerializeJson(), snmp_type.SerializeJson(),
-                           next_id.SerializeJson(), snmp_speed.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("style", style);
+        visitor("thickness", thickness);
+        visitor("snmpType", snmp_type);
+        visitor("nextId", next_id);
+        visitor("snmpSpeed", snmp_speed);
     }
 };
 
@@ -989,16 +1219,23 @@ struct DataSourceData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"enabled\":{}, \"functionDeviceId\":{}, "
-                           "\"functionInterval\":{}, \"dataSourceType\":{}, \"keepTimeRaw\":{}, "
-                           "\"keepTime10min\":{}, \"keepTime2hour\":{}, \"keepTime1Day\":{}, "
-                           "\"functionCode\":{}, \"unit\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(), enabled.SerializeJson(),
-                           function_device_id.SerializeJson(), function_interval.SerializeJson(),
-                           data_source_type.SerializeJson(), keep_time_raw.SerializeJson(),
-                           keep_time_10min.SerializeJson(), keep_time_2hour.SerializeJson(),
-                           keep_time_1Day.SerializeJson(), function_code.SerializeJson(),
-                           unit.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("enabled", enabled);
+        visitor("functionDeviceId", function_device_id);
+        visitor("functionInterval", function_interval);
+        visitor("dataSourceType", data_source_type);
+        visitor("keepTimeRaw", keep_time_raw);
+        visitor("keepTime10min", keep_time_10min);
+        visitor("keepTime2hour", keep_time_2hour);
+        visitor("keepTime1Day", keep_time_1Day);
+        visitor("functionCode", function_code);
+        visitor("unit", unit);
     }
 };
 
@@ -1010,9 +1247,15 @@ struct ObjectListData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"ordered\":{}, \"type\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(), ordered.SerializeJson(),
-                           type.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("ordered", ordered);
+        visitor("type", type);
     }
 };
 
@@ -1023,9 +1266,14 @@ struct DeviceGroupData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"deviceIds\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(),
-                           device_ids.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("deviceIds", device_ids);
     }
 };
 
@@ -1041,12 +1289,19 @@ struct FunctionData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"argumentDescriptors\":{}, \"builtin\":{}, "
-            "\"minArguments\":{}, \"maxArguments\":{}, \"description\":{}, \"code\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), argument_descriptors.SerializeJson(),
-            builtin.SerializeJson(), min_arguments.SerializeJson(), max_arguments.SerializeJson(),
-            description.SerializeJson(), code.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("argumentDescriptors", argument_descriptors);
+        visitor("builtin", builtin);
+        visitor("minArguments", min_arguments);
+        visitor("maxArguments", max_arguments);
+        visitor("description", description);
+        visitor("code", code);
     }
 };
 
@@ -1066,15 +1321,23 @@ struct SnmpProfileData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"version\":{}, \"port\":{}, \"security\":{}, "
-            "\"authMethod\":{}, \"crypthMethod\":{}, \"tryCount\":{}, \"tryTimeout\":{}, "
-            "\"cryptPassword\":{}, \"authPassword\":{}, \"community\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), version.SerializeJson(),
-            port.SerializeJson(), security.SerializeJson(), auth_method.SerializeJson(),
-            crypth_method.SerializeJson(), try_count.SerializeJson(), try_timeout.SerializeJson(),
-            crypt_password.SerializeJson(), auth_password.SerializeJson(),
-            community.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("version", version);
+        visitor("port", port);
+        visitor("security", security);
+        visitor("authMethod", auth_method);
+        visitor("crypthMethod", crypth_method);
+        visitor("tryCount", try_count);
+        visitor("tryTimeout", try_timeout);
+        visitor("cryptPassword", crypt_password);
+        visitor("authPassword", auth_password);
+        visitor("community", community);
     }
 };
 
@@ -1090,12 +1353,19 @@ struct PanelData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"ordered\":{}, \"locked\":{}, "
-                           "\"titleBars\":{}, \"topElementId\":{}, \"admin\":{}, \"type\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(), ordered.SerializeJson(),
-                           locked.SerializeJson(), title_bars.SerializeJson(),
-                           top_element_id.SerializeJson(), admin.SerializeJson(),
-                           type.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("ordered", ordered);
+        visitor("locked", locked);
+        visitor("titleBars", title_bars);
+        visitor("topElementId", top_element_id);
+        visitor("admin", admin);
+        visitor("type", type);
     }
 };
 
@@ -1116,15 +1386,24 @@ struct SysLogRuleData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"regexpNot\":{}, \"sourceSet\":{}, \"regexpSet\":{}, "
-            "\"enabled\":{}, \"sourceNot\":{}, \"sourceFirst\":{}, \"sourceSecond\":{}, "
-            "\"action\":{}, \"notifyId\":{}, \"nextId\":{}, \"regexp\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), regexp_not.SerializeJson(),
-            source_set.SerializeJson(), regexp_set.SerializeJson(), enabled.SerializeJson(),
-            source_not.SerializeJson(), source_first.SerializeJson(), source_second.SerializeJson(),
-            action.SerializeJson(), notify_id.SerializeJson(), next_id.SerializeJson(),
-            regexp.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("regexpNot", regexp_not);
+        visitor("sourceSet", source_set);
+        visitor("regexpSet", regexp_set);
+        visitor("enabled", enabled);
+        visitor("sourceNot", source_not);
+        visitor("sourceFirst", source_first);
+        visitor("sourceSecond", source_second);
+        visitor("action", action);
+        visitor("notifyId", notify_id);
+        visitor("nextId", next_id);
+        visitor("regexp", regexp);
     }
 };
 
@@ -1165,29 +1444,42 @@ struct NetworkMapElementData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"itemUseAckedColor\":{}, \"itemUseLabel\":{}, "
-            "\"itemUseShapes\":{}, \"itemUseFont\":{}, \"itemUseImage\":{}, "
-            "\"itemUseImageScale\":{}, \"itemUseWidth\":{}, \"itemUseUpColor\":{}, "
-            "\"itemUse_down_partialColor\":{}, \"itemUseDown_complete_color\":{}, "
-            "\"itemUseUnknownColor\":{}, \"itemUpColor\":{}, \"itemDownPartialColor\":{}, "
-            "\"itemDownCompleteColor\":{}, \"itemUnknownColor\":{}, \"itemAckedColor\":{}, "
-            "\"itemShape\":{}, \"linkFrom\":{}, \"linkTo\":{}, \"linkId\":{}, \"linkWidth\":{}, "
-            "\"mapId\":{}, \"type\":{}, \"itemType\":{}, \"itemId\":{}, \"itemX\":{}, "
-            "\"itemY\":{}, \"labelRefreshInterval\":{}, \"itemFont\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), item_use_acked_color.SerializeJson(),
-            item_use_label.SerializeJson(), item_use_shapes.SerializeJson(),
-            item_use_font.SerializeJson(), item_use_image.SerializeJson(),
-            item_use_image_scale.SerializeJson(), item_use_width.SerializeJson(),
-            item_use_up_color.SerializeJson(), item_use_down_partial_color.SerializeJson(),
-            item_use_down_complete_color.SerializeJson(), item_use_unknown_color.SerializeJson(),
-            item_up_color.SerializeJson(), item_down_partial_color.SerializeJson(),
-            item_down_complete_color.SerializeJson(), item_unknown_color.SerializeJson(),
-            item_acked_color.SerializeJson(), item_shape.SerializeJson(), link_from.SerializeJson(),
-            link_to.SerializeJson(), link_id.SerializeJson(), link_width.SerializeJson(),
-            map_id.SerializeJson(), type.SerializeJson(), item_type.SerializeJson(),
-            item_id.SerializeJson(), item_x.SerializeJson(), item_y.SerializeJson(),
-            label_refresh_interval.SerializeJson(), item_font.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("itemUseAckedColor", item_use_acked_color);
+        visitor("itemUseLabel", item_use_label);
+        visitor("itemUseShapes", item_use_shapes);
+        visitor("itemUseFont", item_use_font);
+        visitor("itemUseImage", item_use_image);
+        visitor("itemUseImageScale", item_use_image_scale);
+        visitor("itemUseWidth", item_use_width);
+        visitor("itemUseUpColor", item_use_up_color);
+        visitor("itemUse_down_partialColor", item_use_down_partial_color);
+        visitor("itemUseDown_complete_color", item_use_down_complete_color);
+        visitor("itemUseUnknownColor", item_use_unknown_color);
+        visitor("itemUpColor", item_up_color);
+        visitor("itemDownPartialColor", item_down_partial_color);
+        visitor("itemDownCompleteColor", item_down_complete_color);
+        visitor("itemUnknownColor", item_unknown_color);
+        visitor("itemAckedColor", item_acked_color);
+        visitor("itemShape", item_shape);
+        visitor("linkFrom", link_from);
+        visitor("linkTo", link_to);
+        visitor("linkId", link_id);
+        visitor("linkWidth", link_width);
+        visitor("mapId", map_id);
+        visitor("type", type);
+        visitor("itemType", item_type);
+        visitor("itemId", item_id);
+        visitor("itemX", item_x);
+        visitor("itemY", item_y);
+        visitor("labelRefreshInterval", label_refresh_interval);
+        visitor("itemFont", item_font);
     }
 };
 
@@ -1205,14 +1497,21 @@ struct ChartLineData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format("\"objectId\":{}, \"name\":{}, \"chartId\":{}, \"sourceId\":{}, "
-                           "\"lineStyle\":{}, \"lineColor\":{}, \"lineOpacity\":{}, "
-                           "\"fillColor\":{}, \"fillOpacity\":{}, \"nextId\":{}",
-                           object_id.SerializeJson(), name.SerializeJson(),
-                           chart_id.SerializeJson(), source_id.SerializeJson(),
-                           line_style.SerializeJson(), line_color.SerializeJson(),
-                           line_opacity.SerializeJson(), fill_color.SerializeJson(),
-                           fill_opacity.SerializeJson(), next_id.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("chartId", chart_id);
+        visitor("sourceId", source_id);
+        visitor("lineStyle", line_style);
+        visitor("lineColor", line_color);
+        visitor("lineOpacity", line_opacity);
+        visitor("fillColor", fill_color);
+        visitor("fillOpacity", fill_opacity);
+        visitor("nextId", next_id);
     }
 };
 
@@ -1230,13 +1529,21 @@ struct PanelElementData : DudeObj {
     TextField name;
 
     std::string SerializeJson(bool has_credentials) const override {
-        return fmt::format(
-            "\"objectId\":{}, \"name\":{}, \"split\":{}, \"panelId\":{}, \"splitType\":{}, "
-            "\"splitShare\":{}, \"firstId\":{}, \"secondId\":{}, \"objId\":{}, \"objMeta\":{}",
-            object_id.SerializeJson(), name.SerializeJson(), split.SerializeJson(),
-            panel_id.SerializeJson(), split_type.SerializeJson(), split_share.SerializeJson(),
-            first_id.SerializeJson(), second_id.SerializeJson(), obj_id.SerializeJson(),
-            obj_meta.SerializeJson());
+        return SerializeFieldsJson(*this, has_credentials);
+    }
+
+    template <typename Visitor>
+    void VisitFields(Visitor&& visitor, bool has_credentials) const {
+        visitor("objectId", object_id);
+        visitor("name", name);
+        visitor("split", split);
+        visitor("panelId", panel_id);
+        visitor("splitType", split_type);
+        visitor("splitShare", split_share);
+        visitor("firstId", first_id);
+        visitor("secondId", second_id);
+        visitor("objId", obj_id);
+        visitor("objMeta", obj_meta);
     }
 };
 } // namespace Database
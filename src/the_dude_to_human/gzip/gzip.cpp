@@ -1,6 +1,8 @@
 // SPDX-FileCopyrightText: Copyright 2024 Narr the Reg
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
+#include <array>
 #include <fstream>
 #include <iostream>
 
@@ -22,7 +24,9 @@ static bool DecompressFiles(gzFile in, FILE* out) {
             break;
         if (is_first_batch) {
             // Dude db files have a header. Skip it
-            if ((int)fwrite(buf + 0x200, 1, (unsigned)len - 0x200, out) != len - 0x200) {
+            constexpr int header_size = static_cast<int>(Gzip::DudeHeaderSize);
+            if ((int)fwrite(buf + header_size, 1, (unsigned)(len - header_size), out) !=
+                len - header_size) {
                 return false;
             }
             is_first_batch = false;
@@ -76,8 +80,127 @@ bool Gzip::Decompress(const std::string& out_file) {
     return DecompressFiles(in, out);
 }
 
+u32 Checksum(std::span<const u8> data) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    // crc32 takes at most 4 GiB per call
+    while (!data.empty()) {
+        const std::size_t length = std::min<std::size_t>(data.size(), 0x40000000);
+        crc = crc32(crc, data.data(), static_cast<uInt>(length));
+        data = data.subspan(length);
+    }
+    return static_cast<u32>(crc);
+}
+
 bool Gzip::Compress(const std::string& out_file) {
     return true;
 }
 
+Decompressor::Decompressor(std::size_t skip_output)
+    : stream{std::make_unique<z_stream_s>()}, skip_bytes{skip_output} {
+    // 16 selects gzip decoding
+    is_initialized = inflateInit2(stream.get(), 16 + MAX_WBITS) == Z_OK;
+}
+
+Decompressor::~Decompressor() {
+    if (is_initialized) {
+        inflateEnd(stream.get());
+    }
+}
+
+bool Decompressor::Write(std::span<const u8> data, std::vector<u8>& out) {
+    if (!is_initialized) {
+        return false;
+    }
+
+    std::array<u8, BUFLEN * 4> buffer{};
+    // inflate takes at most 4 GiB per call
+    do {
+        const std::size_t length = std::min<std::size_t>(data.size(), 0x40000000);
+        stream->next_in = const_cast<u8*>(data.data());
+        stream->avail_in = static_cast<uInt>(length);
+        data = data.subspan(length);
+
+        // A full output buffer means zlib may still hold pending output
+        do {
+            stream->next_out = buffer.data();
+            stream->avail_out = static_cast<uInt>(buffer.size());
+
+            const int rc = inflate(stream.get(), Z_NO_FLUSH);
+            if (rc == Z_BUF_ERROR && stream->avail_in == 0) {
+                break;
+            }
+            if (rc != Z_OK && rc != Z_STREAM_END) {
+                return false;
+            }
+            is_finished = rc == Z_STREAM_END;
+
+            const std::size_t produced = buffer.size() - stream->avail_out;
+            const std::size_t skipped = std::min(skip_bytes, produced);
+            skip_bytes -= skipped;
+            out.insert(out.end(), buffer.begin() + static_cast<std::ptrdiff_t>(skipped),
+                       buffer.begin() + static_cast<std::ptrdiff_t>(produced));
+        } while ((stream->avail_in != 0 || stream->avail_out == 0) && !is_finished);
+    } while (!data.empty() && !is_finished);
+
+    return true;
+}
+
+bool Decompressor::IsFinished() const {
+    return is_finished;
+}
+
+Compressor::Compressor(int level) : stream{std::make_unique<z_stream_s>()} {
+    // 16 selects gzip encoding
+    is_initialized = deflateInit2(stream.get(), level, Z_DEFLATED, 16 + MAX_WBITS, 8,
+                                  Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+Compressor::~Compressor() {
+    if (is_initialized) {
+        deflateEnd(stream.get());
+    }
+}
+
+bool Compressor::Write(std::span<const u8> data, std::vector<u8>& out) {
+    return Deflate(data, Z_NO_FLUSH, out);
+}
+
+bool Compressor::Finish(std::vector<u8>& out) {
+    return Deflate({}, Z_FINISH, out);
+}
+
+bool Compressor::Deflate(std::span<const u8> data, int flush, std::vector<u8>& out) {
+    if (!is_initialized || is_finished) {
+        return false;
+    }
+
+    std::array<u8, BUFLEN * 4> buffer{};
+    // deflate takes at most 4 GiB per call
+    do {
+        const std::size_t length = std::min<std::size_t>(data.size(), 0x40000000);
+        stream->next_in = const_cast<u8*>(data.data());
+        stream->avail_in = static_cast<uInt>(length);
+        data = data.subspan(length);
+        const int chunk_flush = data.empty() ? flush : Z_NO_FLUSH;
+
+        // A full output buffer means zlib may still hold pending output
+        do {
+            stream->next_out = buffer.data();
+            stream->avail_out = static_cast<uInt>(buffer.size());
+
+            const int rc = deflate(stream.get(), chunk_flush);
+            if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+                return false;
+            }
+            is_finished = rc == Z_STREAM_END;
+
+            const std::size_t produced = buffer.size() - stream->avail_out;
+            out.insert(out.end(), buffer.begin(),
+                       buffer.begin() + static_cast<std::ptrdiff_t>(produced));
+        } while (stream->avail_out == 0 && !is_finished);
+    } while (!data.empty());
+
+    return flush != Z_FINISH || is_finished;
+}
+
 } // namespace Gzip
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <span>
 #include <string>
 #include <vector>
@@ -10,8 +12,18 @@
 #include "common/bit_field.h"
 #include "common/common_types.h"
 
+struct z_stream_s;
+
 namespace Gzip {
 
+// Dude db files start with a header that isn't part of the sqlite database
+constexpr std::size_t DudeHeaderSize = 0x200;
+// zlib compression level, 1 is the fastest and 9 the smallest
+constexpr int DefaultLevel = 6;
+
+// Crc32 of data, the checksum of the gzip trailer
+u32 Checksum(std::span<const u8> data);
+
 // Compress/Decompress gzip files
 class Gzip {
 public:
@@ -25,4 +37,46 @@ public:
 private:
     std::string filename{};
 };
+
+// Inflates a gzip stream fed in chunks of any size, used when the file never touches the disk
+class Decompressor {
+public:
+    // The first skip_output bytes of decompressed data are discarded
+    Decompressor(std::size_t skip_output = 0);
+    ~Decompressor();
+
+    // Appends the decompressed data to out. Returns false if the stream is corrupted
+    bool Write(std::span<const u8> data, std::vector<u8>& out);
+
+    // True once the gzip trailer has been read
+    bool IsFinished() const;
+
+private:
+    std::unique_ptr<z_stream_s> stream;
+    std::size_t skip_bytes{};
+    bool is_initialized{};
+    bool is_finished{};
+};
+
+// Deflates data fed in chunks of any size into a gzip stream, used when the file never touches
+// the disk
+class Compressor {
+public:
+    Compressor(int level = DefaultLevel);
+    ~Compressor();
+
+    // Appends the compressed data to out. zlib keeps small inputs until it has enough of them, so
+    // out may not grow at all
+    bool Write(std::span<const u8> data, std::vector<u8>& out);
+
+    // Appends the data zlib kept and the gzip trailer, nothing can be written after
+    bool Finish(std::vector<u8>& out);
+
+private:
+    bool Deflate(std::span<const u8> data, int flush, std::vector<u8>& out);
+
+    std::unique_ptr<z_stream_s> stream;
+    bool is_initialized{};
+    bool is_finished{};
+};
 } // namespace Gzip
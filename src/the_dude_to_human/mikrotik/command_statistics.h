@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "common/common_types.h"
+
+namespace Mikrotik {
+
+// Latency of the commands sent to a device
+struct CommandStatistics {
+    std::size_t commands{};
+    std::size_t failed_commands{};
+    std::size_t reconnects{};
+    // Latency from the call until the command output ended
+    s64 total_us{};
+    s64 min_us{};
+    s64 max_us{};
+
+    void Record(s64 elapsed_us, bool is_success) {
+        if (commands == 0 || elapsed_us < min_us) {
+            min_us = elapsed_us;
+        }
+        max_us = std::max(max_us, elapsed_us);
+        total_us += elapsed_us;
+        ++commands;
+        if (!is_success) {
+            ++failed_commands;
+        }
+    }
+};
+
+} // namespace Mikrotik
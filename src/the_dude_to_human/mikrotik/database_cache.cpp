@@ -0,0 +1,165 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "the_dude_to_human/gzip/gzip.h"
+#include "the_dude_to_human/mikrotik/database_cache.h"
+
+namespace Mikrotik {
+
+// Files are written under this extension and renamed once complete, an interrupted save leaves
+// the previous copy untouched
+constexpr char TemporaryExtension[] = ".tmp";
+
+static bool WriteFile(const std::filesystem::path& path, std::span<const char> data) {
+    std::filesystem::path temporary_path = path;
+    temporary_path += TemporaryExtension;
+    {
+        std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+        if (!file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporary_path, path, ec);
+    return !ec;
+}
+
+DatabaseCache::DatabaseCache(std::filesystem::path database_path_)
+    : database_path{std::move(database_path_)} {
+    manifest_path = database_path;
+    manifest_path += ".manifest";
+}
+
+bool DatabaseCache::IsCurrent(const DatabaseFingerprint& fingerprint) const {
+    Manifest manifest{};
+    if (!ReadManifest(manifest) || manifest.fingerprint != fingerprint) {
+        return false;
+    }
+
+    std::error_code ec;
+    const std::uintmax_t size = std::filesystem::file_size(database_path, ec);
+    return !ec && size == manifest.length;
+}
+
+bool DatabaseCache::Load(std::vector<u8>& database) const {
+    Manifest manifest{};
+    if (!ReadManifest(manifest)) {
+        return false;
+    }
+
+    std::ifstream file{database_path, std::ios::binary};
+    if (!file.is_open()) {
+        return false;
+    }
+    database.resize(manifest.length);
+    if (!file.read(reinterpret_cast<char*>(database.data()),
+                   static_cast<std::streamsize>(database.size())) ||
+        file.peek() != std::ifstream::traits_type::eof()) {
+        fprintf(stderr, "Cached database '%s' has the wrong size\n",
+                database_path.string().c_str());
+        return false;
+    }
+
+    if (Gzip::Checksum(database) != manifest.checksum) {
+        fprintf(stderr, "Cached database '%s' is corrupted\n", database_path.string().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseCache::Save(const DatabaseFingerprint& fingerprint,
+                         std::span<const u8> database) const {
+    std::error_code ec;
+    if (database_path.has_parent_path()) {
+        std::filesystem::create_directories(database_path.parent_path(), ec);
+    }
+
+    // The manifest goes last, a copy without one is never trusted
+    std::filesystem::remove(manifest_path, ec);
+    if (!WriteFile(database_path,
+                   {reinterpret_cast<const char*>(database.data()), database.size()})) {
+        return false;
+    }
+
+    char checksum[9]{};
+    snprintf(checksum, sizeof(checksum), "%08x", Gzip::Checksum(database));
+    const std::string manifest = "size=" + fingerprint.size + "\nmodified=" +
+                                 fingerprint.modified + "\nlength=" +
+                                 std::to_string(database.size()) + "\nchecksum=" + checksum + "\n";
+    return WriteFile(manifest_path, manifest);
+}
+
+const std::filesystem::path& DatabaseCache::GetManifestPath() const {
+    return manifest_path;
+}
+
+std::filesystem::path DatabaseCache::GetPartialPath() const {
+    std::filesystem::path partial_path = database_path;
+    partial_path += ".gz.part";
+    return partial_path;
+}
+
+bool DatabaseCache::ReadManifest(Manifest& manifest) const {
+    std::ifstream file{manifest_path};
+    if (!file.is_open()) {
+        return false;
+    }
+
+    bool has_length = false;
+    bool has_checksum = false;
+    std::string line{};
+    while (std::getline(file, line)) {
+        const std::size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        const std::string_view name{line.data(), separator};
+        std::string value = line.substr(separator + 1);
+        if (name == "size") {
+            manifest.fingerprint.size = std::move(value);
+        } else if (name == "modified") {
+            manifest.fingerprint.modified = std::move(value);
+        } else if (name == "length") {
+            manifest.length = std::strtoull(value.c_str(), nullptr, 10);
+            has_length = true;
+        } else if (name == "checksum") {
+            manifest.checksum = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 16));
+            has_checksum = true;
+        }
+    }
+
+    return has_length && has_checksum && !manifest.fingerprint.size.empty() &&
+           !manifest.fingerprint.modified.empty();
+}
+
+SyncResult SyncDatabase(MikrotikDevice& device, const DatabaseCache& cache,
+                        std::vector<u8>& database, bool load_unchanged) {
+    // Taken before the export, a change during the download is fetched again by the next sync
+    DatabaseFingerprint fingerprint{};
+    const bool has_fingerprint = device.GetDatabaseFingerprint(fingerprint);
+    if (has_fingerprint && cache.IsCurrent(fingerprint)) {
+        if (!load_unchanged || cache.Load(database)) {
+            return SyncResult::Unchanged;
+        }
+    }
+
+    if (!device.DownloadDatabase(database, cache.GetPartialPath(), fingerprint)) {
+        return SyncResult::Failed;
+    }
+    if (!has_fingerprint) {
+        fprintf(stderr, "Device didn't report its database version, it isn't cached\n");
+    } else if (!cache.Save(fingerprint, database)) {
+        fprintf(stderr, "Unable to save the database into the cache\n");
+    }
+    return SyncResult::Downloaded;
+}
+
+} // namespace Mikrotik
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+#include "the_dude_to_human/mikrotik/mikrotik_device.h"
+
+namespace Mikrotik {
+
+// Local copy of a device database next to a manifest with the fingerprint the database had when
+// it was downloaded and the checksum of the copy
+class DatabaseCache {
+public:
+    // The manifest is saved as database_path with the .manifest extension added
+    explicit DatabaseCache(std::filesystem::path database_path_);
+
+    // True if the copy was taken from a database with this fingerprint. Only the manifest and
+    // the size of the copy are checked
+    bool IsCurrent(const DatabaseFingerprint& fingerprint) const;
+
+    // Reads the copy, fails if it doesn't match the checksum of the manifest
+    bool Load(std::vector<u8>& database) const;
+
+    // Replaces the copy and its manifest
+    bool Save(const DatabaseFingerprint& fingerprint, std::span<const u8> database) const;
+
+    const std::filesystem::path& GetManifestPath() const;
+    // Where an unfinished download of the database is kept
+    std::filesystem::path GetPartialPath() const;
+
+private:
+    struct Manifest {
+        DatabaseFingerprint fingerprint{};
+        u64 length{};
+        u32 checksum{};
+    };
+
+    bool ReadManifest(Manifest& manifest) const;
+
+    std::filesystem::path database_path{};
+    std::filesystem::path manifest_path{};
+};
+
+enum class SyncResult {
+    Failed,
+    Unchanged,
+    Downloaded,
+};
+
+// Downloads the database of device unless the cache holds the version it has now, and saves new
+// downloads into the cache. An unchanged database is only read from the cache if load_unchanged.
+// Devices that don't report a fingerprint are always downloaded
+SyncResult SyncDatabase(MikrotikDevice& device, const DatabaseCache& cache,
+                        std::vector<u8>& database, bool load_unchanged);
+
+} // namespace Mikrotik
@@ -10,50 +10,86 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+
 #include "libssh2.h"
+#include "libssh2_sftp.h"
+#include "the_dude_to_human/gzip/gzip.h"
 #include "the_dude_to_human/mikrotik/mikrotik_device.h"
-
-#define BUFSIZE 32000
+#include "the_dude_to_human/mikrotik/range_download.h"
+
+// Name of the exported database on the device storage
+constexpr char RemoteDatabaseFile[] = "the_dude_to_human.db";
+// Name of a database uploaded to be restored, written with the temporary extension first
+constexpr char RemoteRestoreFile[] = "the_dude_to_human_restore.db";
+constexpr char RemoteTemporaryExtension[] = ".part";
+// Prints the live database of the dude as name=value pairs
+constexpr char DatabaseFileCommand[] = "/file print terse without-paging where "
+                                       "name=([/dude get data-directory] . \"/dude.db\")";
+
+// Bytes requested per sftp read. libssh2 splits big reads in many read requests that are in
+// flight at the same time, so one large read hides the round trip time of each request
+constexpr std::size_t SftpReadSize = 0x200000;
+// Compressed bytes handed to sftp writes at a time. libssh2 sends them as many write requests
+// and only waits for the acknowledgements once they are all in flight
+constexpr std::size_t SftpWriteSize = 0x200000;
+// Database bytes compressed at a time while uploading, small enough to keep the writes flowing
+constexpr std::size_t CompressChunkSize = 0x40000;
+// Bytes read at a time while looking for the dude header of an export
+constexpr std::size_t HeaderReadSize = 0x4000;
+
+// Attempts to fetch the ranges of a download, the session is opened again between them
+constexpr int DownloadAttempts = 4;
+// Wait before opening the session again, grows with each attempt
+constexpr std::chrono::seconds DownloadRetryDelay{1};
+
+// Bytes requested per channel read, enough for a couple of ssh packets
+constexpr std::size_t ChannelReadSize = 0x10000;
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4996)
 #endif
 
-static int waitsocket(libssh2_socket_t socket_fd, LIBSSH2_SESSION* session) {
-    fd_set fd;
-    fd_set* writefd = NULL;
-    fd_set* readfd = NULL;
-
-    timeval timeout{
-        .tv_sec = 10,
-        .tv_usec = 0,
-    };
-
-    FD_ZERO(&fd);
-
-#if defined(__GNUC__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wsign-conversion"
-#endif
-    FD_SET(socket_fd, &fd);
-#if defined(__GNUC__)
-#pragma GCC diagnostic pop
-#endif
-
-    /* now make sure we wait in the correct direction */
-    int dir = libssh2_session_block_directions(session);
-
-    if (dir & LIBSSH2_SESSION_BLOCK_INBOUND)
-        readfd = &fd;
+// Errors after which the session can't be used anymore
+static bool IsSessionError(int result) {
+    switch (result) {
+    case LIBSSH2_ERROR_SOCKET_SEND:
+    case LIBSSH2_ERROR_SOCKET_RECV:
+    case LIBSSH2_ERROR_SOCKET_DISCONNECT:
+    case LIBSSH2_ERROR_SOCKET_TIMEOUT:
+    case LIBSSH2_ERROR_TIMEOUT:
+        return true;
+    default:
+        return false;
+    }
+}
 
-    if (dir & LIBSSH2_SESSION_BLOCK_OUTBOUND)
-        writefd = &fd;
+static s64 GetElapsedUs(std::chrono::steady_clock::time_point start_time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start_time)
+        .count();
+}
 
-    return select(static_cast<int>(socket_fd + 1), readfd, writefd, NULL, &timeout);
+// Functions returning a handle report why it's null through the session error
+static int GetPointerResult(LIBSSH2_SESSION* session, const void* pointer) {
+    if (pointer != nullptr) {
+        return 0;
+    }
+    const int error = libssh2_session_last_errno(session);
+    return error != 0 ? error : -1;
 }
 
 namespace Mikrotik {
-MikrotikDevice::MikrotikDevice(std::string address_, u16 port_) : hostname{address_}, port{port_} {
+MikrotikDevice::MikrotikDevice(std::string address_, u16 port_, SshReactor* reactor_)
+    : hostname{address_}, port{port_},
+      reactor{reactor_ != nullptr ? reactor_ : &SshReactor::GetDefault()} {
     InitializeSSH();
 }
 
@@ -66,63 +102,367 @@ MikrotikDevice::~MikrotikDevice() {
         libssh2_session_free(session);
     }
 
+    auto lock = std::scoped_lock(lib_mutex);
     if (--MikrotikDevice::lib_refcount == 0) {
         libssh2_exit();
     }
 }
 
-bool MikrotikDevice::Connect(std::string username, std::string password) {
+void MikrotikDevice::SetTimeout(u32 milliseconds) {
+    timeout_ms = milliseconds;
+}
+
+bool MikrotikDevice::Connect(std::string username_, std::string password_) {
+    return Common::SyncWait(ConnectAsync(std::move(username_), std::move(password_)));
+}
+
+bool MikrotikDevice::Disconnect() {
+    return Common::SyncWait(DisconnectAsync());
+}
+
+bool MikrotikDevice::Execute(std::string commandline, std::string* output) {
+    return Common::SyncWait(ExecuteAsync(std::move(commandline), output));
+}
+
+bool MikrotikDevice::Execute(std::string commandline, OutputSink output, OutputSink error) {
+    return Common::SyncWait(
+        ExecuteAsync(std::move(commandline), std::move(output), std::move(error)));
+}
+
+Common::Task<bool> MikrotikDevice::ConnectAsync(std::string username_, std::string password_) {
+    co_await channels.Acquire(MaxChannels);
+    if (!is_connected) {
+        username = std::move(username_);
+        password = std::move(password_);
+        const int result = co_await ConnectSSH();
+        if (result != 0) {
+            co_await DisconnectSSH();
+        }
+        is_connected = result == 0;
+        is_session_lost = false;
+        ++session_generation;
+    }
+    const bool result = is_connected;
+    channels.Release(MaxChannels);
+    co_return result;
+}
+
+Common::Task<bool> MikrotikDevice::DisconnectAsync() {
+    co_await channels.Acquire(MaxChannels);
     if (is_connected) {
-        return true;
+        co_await DisconnectSSH();
+        is_connected = false;
     }
+    channels.Release(MaxChannels);
+    co_return true;
+}
 
-    if (ConnectSSH(username, password) != 0) {
-        DisconnectSSH();
-        return false;
+Common::Task<bool> MikrotikDevice::ExecuteAsync(std::string commandline, std::string* output) {
+    OutputSink sink{};
+    if (output != nullptr) {
+        sink = [output](std::span<const char> data) { output->append(data.data(), data.size()); };
     }
+    return ExecuteAsync(std::move(commandline), std::move(sink));
+}
 
-    is_connected = true;
-    return true;
+Common::Task<bool> MikrotikDevice::ExecuteAsync(std::string commandline, OutputSink output,
+                                                OutputSink error) {
+    const auto start_time = std::chrono::steady_clock::now();
+    int result = LIBSSH2_ERROR_SOCKET_DISCONNECT;
+    bool is_started = false;
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        co_await channels.Acquire();
+        const bool is_available = is_connected;
+        const bool is_session_up = is_connected && !is_session_lost;
+        const u64 generation = session_generation;
+        if (is_session_up) {
+            result = co_await ExecuteSSH(commandline, output, error, is_started);
+        }
+        channels.Release();
+
+        if (!is_available) {
+            co_return false;
+        }
+        if (is_session_up && !IsSessionError(result)) {
+            break;
+        }
+
+        // Only a command that never reached the device can run again safely
+        const bool is_reconnected = co_await ReconnectSSH(generation);
+        if (!is_reconnected || is_started) {
+            break;
+        }
+    }
+
+    RecordCommand(GetElapsedUs(start_time), result == 0);
+    co_return result == 0;
 }
 
-bool MikrotikDevice::Disconnect() {
-    if (!is_connected) {
-        return true;
+Common::Task<bool> MikrotikDevice::AcquireChannel() {
+    co_await channels.Acquire();
+    co_return is_connected && !is_session_lost;
+}
+
+Common::Task<bool> MikrotikDevice::ReconnectSSH(u64 failed_generation) {
+    co_await channels.Acquire(MaxChannels);
+    if (is_connected && session_generation == failed_generation) {
+        co_await DisconnectSSH();
+        const int result = co_await ConnectSSH();
+        if (result != 0) {
+            co_await DisconnectSSH();
+        }
+        is_session_lost = result != 0;
+        ++session_generation;
+
+        std::scoped_lock lock{statistics_mutex};
+        ++statistics.reconnects;
     }
+    const bool result = is_connected && !is_session_lost;
+    channels.Release(MaxChannels);
+    co_return result;
+}
 
-    DisconnectSSH();
+int MikrotikDevice::SendKeepalive() {
+    return Common::SyncWait(SendKeepaliveAsync());
+}
 
-    is_connected = false;
-    return true;
+Common::Task<int> MikrotikDevice::SendKeepaliveAsync() {
+    co_await channels.Acquire();
+    const bool is_session_up = is_connected && !is_session_lost;
+    const u64 generation = session_generation;
+    int seconds_to_next = KeepaliveInterval;
+    int result = LIBSSH2_ERROR_SOCKET_DISCONNECT;
+    if (is_session_up) {
+        result = co_await AwaitSSH(
+            [this, &seconds_to_next] { return libssh2_keepalive_send(session, &seconds_to_next); });
+    }
+    channels.Release();
+
+    if (result == 0) {
+        co_return seconds_to_next;
+    }
+    const bool is_reconnected = co_await ReconnectSSH(generation);
+    co_return is_reconnected ? KeepaliveInterval : -1;
 }
 
-bool MikrotikDevice::Execute(std::string commandline, std::string* output) {
-    if (!is_connected) {
+CommandStatistics MikrotikDevice::GetCommandStatistics() const {
+    std::scoped_lock lock{statistics_mutex};
+    return statistics;
+}
+
+void MikrotikDevice::RecordCommand(s64 elapsed_us, bool is_success) {
+    std::scoped_lock lock{statistics_mutex};
+    statistics.Record(elapsed_us, is_success);
+}
+
+bool MikrotikDevice::GetDatabaseFingerprint(DatabaseFingerprint& fingerprint) {
+    std::string output{};
+    if (!is_connected || !Execute(DatabaseFileCommand, &output)) {
         return false;
     }
 
-    ExecuteSSH(commandline, output);
+    // Terse lines are name=value pairs separated by spaces, dates contain a space as well
+    fingerprint = {};
+    std::string* value = nullptr;
+    std::size_t start = output.find_first_not_of(" \r\n");
+    while (start != std::string::npos) {
+        const std::size_t end = output.find_first_of(" \r\n", start);
+        const std::string_view token{output.data() + start,
+                                     (end == std::string::npos ? output.size() : end) - start};
+        const std::size_t separator = token.find('=');
+        if (separator == std::string_view::npos) {
+            if (value != nullptr) {
+                *value += ' ';
+                value->append(token);
+            }
+        } else {
+            const std::string_view name = token.substr(0, separator);
+            // RouterOS 6 names the modification time creation-time
+            if (name == "size") {
+                value = &fingerprint.size;
+            } else if (name == "last-modified" || name == "creation-time") {
+                value = &fingerprint.modified;
+            } else {
+                value = nullptr;
+            }
+            if (value != nullptr) {
+                *value = token.substr(separator + 1);
+            }
+        }
+        start = end == std::string::npos || output[end] != ' ' ? std::string::npos
+                                                               : output.find_first_not_of(' ', end);
+    }
 
-    return true;
+    return !fingerprint.size.empty() && !fingerprint.modified.empty();
 }
 
-void MikrotikDevice::DownloadDatabase() {
+bool MikrotikDevice::DownloadDatabase(std::vector<u8>& database,
+                                      const std::filesystem::path& partial_path,
+                                      const DatabaseFingerprint& fingerprint) {
     if (!is_connected) {
-        return;
+        return false;
     }
+
+    // Ranges are inflated in order as they complete. Dude backups are gzip files, the gzip
+    // trailer checks the crc32 of the whole database before it's handed to the decoder
+    database.clear();
+    Gzip::Decompressor decompressor{Gzip::DudeHeaderSize};
+    bool is_first_range = true;
+    bool is_compressed = false;
+    const auto inflate = [&](std::span<const u8> data) {
+        if (is_first_range) {
+            is_first_range = false;
+            is_compressed = data.size() >= 2 && data[0] == 0x1F && data[1] == 0x8B;
+        }
+        if (!is_compressed) {
+            database.insert(database.end(), data.begin(), data.end());
+            return true;
+        }
+        return decompressor.Write(data, database);
+    };
+    RangeDownload download{partial_path, inflate};
+
+    // The export of an interrupted download is still on the device, exporting again would
+    // change it. It's only resumed while the live database is the one it was exported from,
+    // otherwise an old export would be cached as the current database
+    const std::string source =
+        fingerprint.size.empty() ? std::string{} : fingerprint.size + ' ' + fingerprint.modified;
+    u64 file_size = 0;
+    u64 modified = 0;
+    const bool is_resumed =
+        !source.empty() && download.HasJournal() &&
+        Common::SyncWait(StatSFTP(RemoteDatabaseFile, file_size, modified)) == 0 &&
+        download.Resume(file_size, modified, source);
+    if (is_resumed) {
+        printf("Resuming download, %llu of %llu bytes already received\n",
+               static_cast<unsigned long long>(download.GetCompletedBytes()),
+               static_cast<unsigned long long>(file_size));
+    } else {
+        if (!Execute(std::string("/dude export-db backup-file=") + RemoteDatabaseFile)) {
+            fprintf(stderr, "Unable to export the dude database\n");
+            return false;
+        }
+        if (Common::SyncWait(StatSFTP(RemoteDatabaseFile, file_size, modified)) != 0 ||
+            !download.Start(file_size, modified, source)) {
+            Execute(std::string("/file remove ") + RemoteDatabaseFile);
+            return false;
+        }
+    }
+    // The compressed size is a lower bound of the database size
+    database.reserve(static_cast<std::size_t>(file_size));
+    const u64 resumed_bytes = download.GetCompletedBytes();
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // Each attempt fetches the ranges left on parallel sftp sessions
+    for (int attempt = 1; !download.IsComplete(); ++attempt) {
+        const u64 generation = session_generation;
+        const std::size_t workers = std::min(MaxChannels, download.GetPendingRanges());
+        std::vector<Common::Task<int>> tasks{};
+        for (std::size_t i = 0; i < workers; ++i) {
+            tasks.push_back(DownloadRanges(RemoteDatabaseFile, download));
+        }
+        const std::vector<int> results = Common::SyncWait(Common::WhenAll(std::move(tasks)));
+        if (std::ranges::none_of(results, IsSessionError) || attempt == DownloadAttempts) {
+            break;
+        }
+
+        // A link that just dropped rarely accepts a new connection right away
+        std::this_thread::sleep_for(DownloadRetryDelay * attempt);
+        Common::SyncWait(ReconnectSSH(generation));
+    }
+
+    if (download.IsFailed() || (download.IsComplete() && is_compressed &&
+                                !decompressor.IsFinished())) {
+        fprintf(stderr, "Corrupted database received from '%s'\n", hostname.c_str());
+        Execute(std::string("/file remove ") + RemoteDatabaseFile);
+        database.clear();
+        download.Discard();
+        return false;
+    }
+    if (!download.IsComplete()) {
+        // A journaled download keeps the export for the next run
+        if (partial_path.empty()) {
+            Execute(std::string("/file remove ") + RemoteDatabaseFile);
+        } else {
+            fprintf(stderr, "Download of '%s' interrupted, the next run resumes it\n",
+                    hostname.c_str());
+        }
+        database.clear();
+        return false;
+    }
+    Execute(std::string("/file remove ") + RemoteDatabaseFile);
+    download.Discard();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    const u64 received = file_size - resumed_bytes;
+    printf("Downloaded %llu bytes (%zu decompressed) in %.2f s, %.2f MB/s\n",
+           static_cast<unsigned long long>(received), database.size(), elapsed.count(),
+           static_cast<double>(received) / 1e6 / std::max(elapsed.count(), 1e-9));
+    return true;
 }
 
-void MikrotikDevice::UploadDatabase() {
+bool MikrotikDevice::UploadDatabase(std::span<const u8> database, std::span<const u8> header) {
     if (!is_connected) {
-        return;
+        return false;
+    }
+
+    // The layout of the header isn't known, the one of the device matches its dude version
+    std::vector<u8> device_header{};
+    if (header.empty()) {
+        if (!Execute(std::string("/dude export-db backup-file=") + RemoteDatabaseFile)) {
+            fprintf(stderr, "Unable to export the dude database\n");
+            return false;
+        }
+        const int result = Common::SyncWait(ReadHeaderSFTP(RemoteDatabaseFile, device_header));
+        Execute(std::string("/file remove ") + RemoteDatabaseFile);
+        if (result != 0) {
+            fprintf(stderr, "Unable to read the dude header of '%s' (%d)\n", hostname.c_str(),
+                    result);
+            return false;
+        }
+        header = device_header;
     }
+    if (header.size() != Gzip::DudeHeaderSize) {
+        fprintf(stderr, "Dude header has %zu bytes instead of %zu\n", header.size(),
+                Gzip::DudeHeaderSize);
+        return false;
+    }
+
+    const std::string temporary_file = std::string(RemoteRestoreFile) + RemoteTemporaryExtension;
+    const auto start_time = std::chrono::steady_clock::now();
+    u64 written = 0;
+    const int result = Common::SyncWait(
+        UploadSFTP(temporary_file, RemoteRestoreFile, header, database, written));
+    if (result != 0) {
+        fprintf(stderr, "Unable to upload the database to '%s' (%d)\n", hostname.c_str(), result);
+        Execute("/file remove " + temporary_file);
+        return false;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    printf("Uploaded %llu bytes (%zu uncompressed) in %.2f s, %.2f MB/s\n",
+           static_cast<unsigned long long>(written), header.size() + database.size(),
+           elapsed.count(),
+           static_cast<double>(written) / 1e6 / std::max(elapsed.count(), 1e-9));
+
+    const bool is_imported =
+        Execute(std::string("/dude import-db backup-file=") + RemoteRestoreFile);
+    Execute(std::string("/file remove ") + RemoteRestoreFile);
+    if (!is_imported) {
+        fprintf(stderr, "Unable to import the database into the dude\n");
+    }
+    return is_imported;
 }
 
 int MikrotikDevice::InitializeSSH() {
-    if (MikrotikDevice::lib_refcount++ == 0) {
-        if (auto rc = libssh2_init(0); rc) {
-            fprintf(stderr, "libssh2 initialization failed (%d)\n", rc);
-            return 1;
+    {
+        auto lock = std::scoped_lock(lib_mutex);
+        if (MikrotikDevice::lib_refcount++ == 0) {
+            if (auto rc = libssh2_init(0); rc) {
+                fprintf(stderr, "libssh2 initialization failed (%d)\n", rc);
+                return 1;
+            }
         }
     }
 
@@ -136,7 +476,7 @@ int MikrotikDevice::InitializeSSH() {
     return 0;
 }
 
-int MikrotikDevice::ConnectSSH(std::string username, std::string password) {
+Common::Task<int> MikrotikDevice::ConnectSSH() {
     int result = 0;
 
 #ifdef _WIN32
@@ -144,124 +484,397 @@ int MikrotikDevice::ConnectSSH(std::string username, std::string password) {
     result = WSAStartup(MAKEWORD(2, 0), &wsadata);
     if (result) {
         fprintf(stderr, "WSAStartup failed with error: %d\n", result);
-        return result;
+        co_return result;
     }
 #endif
 
-    auto hostaddr = inet_addr(hostname.c_str());
-
-    sock = static_cast<s32>(socket(AF_INET, SOCK_STREAM, 0));
-    if (sock == static_cast<s32>(LIBSSH2_INVALID_SOCKET)) {
-        fprintf(stderr, "failed to create socket.\n");
-        return errno;
-    }
-
-    sockaddr_in sin = {
-        .sin_family = AF_INET,
-        .sin_port = htons(port),
-        .sin_addr = {},
-    };
-    sin.sin_addr.s_addr = hostaddr;
-
-    result = connect(sock, reinterpret_cast<sockaddr*>(&sin), sizeof(sockaddr_in));
+    result = co_await reactor->ConnectSocket(hostname, port, timeout_ms, sock);
     if (result) {
-        return result;
+        co_return result;
     }
 
-    auto lock = std::scoped_lock(session_mutex);
+    libssh2_session_set_blocking(session, 0);
 
-    result = libssh2_session_handshake(session, sock);
+    result = co_await AwaitSSH([this] { return libssh2_session_handshake(session, sock); });
     if (result)
-        return result;
+        co_return result;
 
-    result = libssh2_userauth_password(session, username.data(), password.data());
+    result = co_await AwaitSSH([this] {
+        return libssh2_userauth_password(session, username.data(), password.data());
+    });
     if (result)
-        return result;
+        co_return result;
 
-    libssh2_session_set_blocking(session, 1);
+    // Replies aren't needed, the keepalive only has to keep the connection busy
+    libssh2_keepalive_config(session, 0, KeepaliveInterval);
 
-    return result;
+    co_return result;
 }
 
-int MikrotikDevice::ExecuteSSH(std::string commandline, std::string* output) {
+Common::Task<int> MikrotikDevice::ExecuteSSH(const std::string& commandline,
+                                             const OutputSink& output, const OutputSink& error,
+                                             bool& is_started) {
     int result{};
-    LIBSSH2_CHANNEL* channel;
+    LIBSSH2_CHANNEL* channel = nullptr;
 
-    /* Exec non-blocking on the remote host */
-    do {
+    // Opening uses the session state, only the steps of an open channel are shared
+    result = co_await AwaitSSH([this, &channel] {
         channel = libssh2_channel_open_session(session);
-        if (channel || libssh2_session_last_error(session, NULL, NULL, 0) != LIBSSH2_ERROR_EAGAIN)
-            break;
-        waitsocket(sock, session);
-    } while (1);
+        return GetPointerResult(session, channel);
+    });
     if (!channel) {
-        return 1;
-    }
-    while ((result = libssh2_channel_exec(channel, commandline.c_str())) == LIBSSH2_ERROR_EAGAIN) {
-        waitsocket(sock, session);
+        co_return result != 0 ? result : 1;
     }
+
+    is_started = true;
+    result = co_await AwaitSSH(
+        [&] { return libssh2_channel_exec(channel, commandline.c_str()); }, true);
     if (result) {
-        return 1;
+        co_await AwaitSSH([channel] { return libssh2_channel_free(channel); }, true);
+        co_return result;
     }
-    for (;;) {
-        ssize_t nread{};
-        /* loop until we block */
-        do {
-            std::array<char, 0x400> buffer{};
-            nread = libssh2_channel_read(channel, buffer.data(), buffer.size());
 
-            if (nread <= 0) {
-                continue;
+    std::vector<char> buffer(ChannelReadSize);
+    const auto read_step = [&] {
+        // Standard error is drained too, otherwise it fills the channel window and stalls the
+        // command
+        const ssize_t nread = libssh2_channel_read(channel, buffer.data(), buffer.size());
+        if (nread > 0) {
+            if (output) {
+                output({buffer.data(), static_cast<std::size_t>(nread)});
             }
-            if (output == nullptr) {
-                continue;
+            return SshReactor::Yield;
+        }
+        const ssize_t nread_error =
+            libssh2_channel_read_stderr(channel, buffer.data(), buffer.size());
+        if (nread_error > 0) {
+            if (error) {
+                error({buffer.data(), static_cast<std::size_t>(nread_error)});
             }
-
-            for (ssize_t i = 0; i < nread; ++i)
-                *output += buffer[i];
-            *output += "\n";
-        } while (nread > 0);
+            return SshReactor::Yield;
+        }
 
         if (nread < 0 && nread != LIBSSH2_ERROR_EAGAIN) {
-            fprintf(stderr, "libssh2_channel_read returned %ld\n", (long)nread);
+            return static_cast<int>(nread);
+        }
+        if (nread_error < 0 && nread_error != LIBSSH2_ERROR_EAGAIN) {
+            return static_cast<int>(nread_error);
         }
+        if (nread == LIBSSH2_ERROR_EAGAIN || nread_error == LIBSSH2_ERROR_EAGAIN) {
+            return LIBSSH2_ERROR_EAGAIN;
+        }
+        // Both streams reached the end of the command
+        return 0;
+    };
+    const int read_result = co_await AwaitSSH(read_step, true);
+    if (read_result != 0) {
+        fprintf(stderr, "libssh2_channel_read returned %d\n", read_result);
+    }
+
+    result = co_await AwaitSSH([channel] { return libssh2_channel_close(channel); }, true);
+    co_await AwaitSSH([channel] { return libssh2_channel_free(channel); }, true);
+
+    // A timed out command may still be running, its output can't be trusted
+    co_return read_result != 0 ? read_result : result;
+}
+
+Common::Task<int> MikrotikDevice::OpenSFTP(const std::string& remote_file, LIBSSH2_SFTP*& sftp,
+                                           LIBSSH2_SFTP_HANDLE*& handle, bool is_write) {
+    // Starting sftp opens a channel, which uses the session state
+    int result = co_await AwaitSSH([this, &sftp] {
+        sftp = libssh2_sftp_init(session);
+        return GetPointerResult(session, sftp);
+    });
+    if (!sftp) {
+        fprintf(stderr, "Unable to start sftp session\n");
+        co_return result != 0 ? result : 1;
+    }
+
+    result = co_await AwaitSSH(
+        [&] {
+            if (is_write) {
+                handle = libssh2_sftp_open(
+                    sftp, remote_file.c_str(),
+                    LIBSSH2_FXF_WRITE | LIBSSH2_FXF_CREAT | LIBSSH2_FXF_TRUNC,
+                    LIBSSH2_SFTP_S_IRUSR | LIBSSH2_SFTP_S_IWUSR | LIBSSH2_SFTP_S_IRGRP |
+                        LIBSSH2_SFTP_S_IROTH);
+            } else {
+                handle = libssh2_sftp_open(sftp, remote_file.c_str(), LIBSSH2_FXF_READ, 0);
+            }
+            return GetPointerResult(session, handle);
+        },
+        true);
+    if (!handle) {
+        fprintf(stderr, "Unable to open '%s' (%lu)\n", remote_file.c_str(),
+                libssh2_sftp_last_error(sftp));
+        co_await CloseSFTP(sftp, handle);
+        co_return result != 0 ? result : 2;
+    }
+    co_return 0;
+}
 
-        /* this is due to blocking that would occur otherwise so we loop on
-           this condition */
-        if (nread == LIBSSH2_ERROR_EAGAIN) {
-            waitsocket(sock, session);
-            continue;
+Common::Task<int> MikrotikDevice::CloseSFTP(LIBSSH2_SFTP* sftp, LIBSSH2_SFTP_HANDLE* handle) {
+    if (handle) {
+        co_await AwaitSSH([handle] { return libssh2_sftp_close(handle); }, true);
+    }
+    const int result = co_await AwaitSSH([sftp] { return libssh2_sftp_shutdown(sftp); }, true);
+    co_return result;
+}
+
+Common::Task<int> MikrotikDevice::StatSFTP(std::string remote_file, u64& size,
+                                           u64& modified) {
+    co_await channels.Acquire();
+    int result = LIBSSH2_ERROR_SOCKET_DISCONNECT;
+    if (is_connected && !is_session_lost) {
+        LIBSSH2_SFTP* sftp = nullptr;
+        LIBSSH2_SFTP_HANDLE* handle = nullptr;
+        result = co_await OpenSFTP(remote_file, sftp, handle);
+        if (result == 0) {
+            LIBSSH2_SFTP_ATTRIBUTES attributes{};
+            result = co_await AwaitSSH(
+                [&] { return libssh2_sftp_fstat(handle, &attributes); }, true);
+            if (result == 0 && (attributes.flags & LIBSSH2_SFTP_ATTR_SIZE) == 0) {
+                result = LIBSSH2_ERROR_SFTP_PROTOCOL;
+            }
+            size = attributes.filesize;
+            modified = attributes.mtime;
+            co_await CloseSFTP(sftp, handle);
         }
-        break;
     }
+    channels.Release();
+    co_return result;
+}
 
-    while ((result = libssh2_channel_close(channel)) == LIBSSH2_ERROR_EAGAIN)
-        waitsocket(sock, session);
+Common::Task<int> MikrotikDevice::DownloadRanges(std::string remote_file,
+                                                 RangeDownload& download) {
+    // Holding a channel keeps a reconnect from replacing the session during the download
+    co_await channels.Acquire();
+    const bool is_session_up = is_connected && !is_session_lost;
+    int result = LIBSSH2_ERROR_SOCKET_DISCONNECT;
+    LIBSSH2_SFTP* sftp = nullptr;
+    LIBSSH2_SFTP_HANDLE* handle = nullptr;
+    if (is_session_up) {
+        result = co_await OpenSFTP(remote_file, sftp, handle);
+    }
+
+    // Offset the handle reads next, ranges that follow each other need no seek
+    u64 position = 0;
+    std::size_t range = 0;
+    while (result == 0 && download.TakeRange(range)) {
+        const std::span<u8> buffer = download.GetRangeBuffer(range);
+        const u64 offset = download.GetRangeOffset(range);
+        std::size_t received = 0;
+        if (position != offset) {
+            libssh2_sftp_seek64(handle, offset);
+        }
+
+        // libssh2 keeps requests for four times the read size in flight. Near a range that
+        // another session will fetch the reads shrink, data requested past it would be discarded
+        result = co_await AwaitSSH(
+            [&] {
+                const std::size_t remaining = buffer.size() - received;
+                std::size_t size = std::min(SftpReadSize, remaining);
+                if (!download.IsPending(range + 1)) {
+                    size = std::clamp<std::size_t>(remaining / 4, 1, size);
+                }
+                const ssize_t nread = libssh2_sftp_read(
+                    handle, reinterpret_cast<char*>(buffer.data() + received), size);
+                if (nread < 0) {
+                    return static_cast<int>(nread);
+                }
+                if (nread == 0) {
+                    // The file is shorter than when the download started
+                    return LIBSSH2_ERROR_SFTP_PROTOCOL;
+                }
+                received += static_cast<std::size_t>(nread);
+                // Lets the other ranges and sessions of the reactor thread run between chunks
+                return received == buffer.size() ? 0 : SshReactor::Yield;
+            },
+            true);
+        position = offset + received;
+
+        if (result == 0 && !download.CompleteRange(range)) {
+            result = 1;
+        }
+        if (result != 0) {
+            fprintf(stderr, "libssh2_sftp_read returned %d\n", result);
+            download.ReturnRange(range);
+        }
+    }
 
-    libssh2_channel_free(channel);
-    channel = nullptr;
+    // A lost session is replaced by the next attempt, which fetches the ranges left
+    if (sftp && !IsSessionError(result)) {
+        co_await CloseSFTP(sftp, handle);
+    }
+    channels.Release();
+    co_return result;
+}
 
-    return result;
+Common::Task<int> MikrotikDevice::ReadHeaderSFTP(std::string remote_file,
+                                                 std::vector<u8>& header) {
+    co_await channels.Acquire();
+    int result = LIBSSH2_ERROR_SOCKET_DISCONNECT;
+    if (is_connected && !is_session_lost) {
+        LIBSSH2_SFTP* sftp = nullptr;
+        LIBSSH2_SFTP_HANDLE* handle = nullptr;
+        result = co_await OpenSFTP(remote_file, sftp, handle);
+        if (result == 0) {
+            // The header is in the first blocks of the backup, the rest is never read
+            Gzip::Decompressor decompressor{};
+            std::vector<u8> buffer(HeaderReadSize);
+            header.clear();
+            result = co_await AwaitSSH(
+                [&] {
+                    const ssize_t nread = libssh2_sftp_read(
+                        handle, reinterpret_cast<char*>(buffer.data()), buffer.size());
+                    if (nread < 0) {
+                        return static_cast<int>(nread);
+                    }
+                    if (nread == 0 ||
+                        !decompressor.Write({buffer.data(), static_cast<std::size_t>(nread)},
+                                            header)) {
+                        // Too short or not a gzip file
+                        return LIBSSH2_ERROR_SFTP_PROTOCOL;
+                    }
+                    return header.size() >= Gzip::DudeHeaderSize ? 0 : SshReactor::Yield;
+                },
+                true);
+            header.resize(std::min(header.size(), Gzip::DudeHeaderSize));
+            co_await CloseSFTP(sftp, handle);
+        }
+    }
+    channels.Release();
+    co_return result;
 }
 
-int MikrotikDevice::DisconnectSSH() {
-    int result = 0;
-    auto lock = std::scoped_lock(session_mutex);
+Common::Task<int> MikrotikDevice::UploadSFTP(std::string temporary_file, std::string remote_file,
+                                             std::span<const u8> header,
+                                             std::span<const u8> database, u64& written) {
+    co_await channels.Acquire();
+    int result = LIBSSH2_ERROR_SOCKET_DISCONNECT;
+    LIBSSH2_SFTP* sftp = nullptr;
+    LIBSSH2_SFTP_HANDLE* handle = nullptr;
+    if (is_connected && !is_session_lost) {
+        result = co_await OpenSFTP(temporary_file, sftp, handle, true);
+    }
+    // sftp version 3 doesn't replace an existing file when renaming. A restore left by an
+    // earlier run is removed now, so the rename below either publishes the complete file or fails
+    if (result == 0) {
+        co_await AwaitSSH([&] { return libssh2_sftp_unlink(sftp, remote_file.c_str()); }, true);
+    }
 
-    if (session) {
-        result = libssh2_session_disconnect(session, "Normal Shutdown");
+    // Compressed data from the first byte that wasn't acknowledged yet
+    Gzip::Compressor compressor{};
+    std::vector<u8> pending{};
+    std::size_t acknowledged = 0;
+    std::span<const u8> input = database;
+    bool is_compressed = false;
+    written = 0;
+    if (result == 0 && !compressor.Write(header, pending)) {
+        result = 1;
+    }
+
+    // The database is compressed while the writes sent before are in flight
+    if (result == 0) {
+        result = co_await AwaitSSH(
+            [&] {
+                if (!is_compressed && pending.size() - acknowledged < SftpWriteSize) {
+                    const std::size_t size = std::min(CompressChunkSize, input.size());
+                    const bool is_compressor_ok =
+                        size != 0 ? compressor.Write(input.first(size), pending)
+                                  : compressor.Finish(pending);
+                    if (!is_compressor_ok) {
+                        return 1;
+                    }
+                    input = input.subspan(size);
+                    is_compressed = size == 0;
+                }
+                if (acknowledged == pending.size()) {
+                    return is_compressed ? 0 : SshReactor::Yield;
+                }
+
+                // libssh2 skips the data it already sent, which must be passed again until the
+                // server acknowledges it
+                const ssize_t nwritten = libssh2_sftp_write(
+                    handle, reinterpret_cast<const char*>(pending.data() + acknowledged),
+                    pending.size() - acknowledged);
+                if (nwritten == LIBSSH2_ERROR_EAGAIN && !is_compressed &&
+                    pending.size() - acknowledged < SftpWriteSize) {
+                    return SshReactor::Yield;
+                }
+                if (nwritten < 0) {
+                    return static_cast<int>(nwritten);
+                }
+                acknowledged += static_cast<std::size_t>(nwritten);
+                written += static_cast<u64>(nwritten);
+                if (acknowledged >= SftpWriteSize) {
+                    pending.erase(pending.begin(),
+                                  pending.begin() + static_cast<std::ptrdiff_t>(acknowledged));
+                    acknowledged = 0;
+                }
+                return SshReactor::Yield;
+            },
+            true);
     }
 
+    // Servers may only report a failed write when the file is closed
+    if (result == 0) {
+        result = co_await AwaitSSH([handle] { return libssh2_sftp_close(handle); }, true);
+        handle = nullptr;
+    }
+    if (result == 0) {
+        result = co_await AwaitSSH(
+            [&] {
+                return libssh2_sftp_rename(sftp, temporary_file.c_str(), remote_file.c_str());
+            },
+            true);
+        if (result != 0) {
+            fprintf(stderr, "Unable to rename '%s' (%lu)\n", temporary_file.c_str(),
+                    libssh2_sftp_last_error(sftp));
+        }
+    }
+
+    if (sftp && !IsSessionError(result)) {
+        co_await CloseSFTP(sftp, handle);
+    }
+    channels.Release();
+    co_return result;
+}
+
+SshReactor::StepAwaiter MikrotikDevice::AwaitSSH(SshReactor::Step step, bool is_shared) {
+    return reactor->Await(sock, session, timeout_ms, std::move(step), is_shared);
+}
+
+Common::Task<int> MikrotikDevice::DisconnectSSH() {
+    int result = 0;
+
     if (sock != static_cast<s32>(LIBSSH2_INVALID_SOCKET)) {
+        if (session) {
+            result = co_await AwaitSSH(
+                [this] { return libssh2_session_disconnect(session, "Normal Shutdown"); });
+            // Channels left by failed commands are freed while the socket is still open
+            co_await AwaitSSH([this] { return libssh2_session_free(session); });
+            session = nullptr;
+        }
+
         shutdown(sock, 2);
         LIBSSH2_SOCKET_CLOSE(sock);
+        sock = static_cast<s32>(LIBSSH2_INVALID_SOCKET);
     }
 
 #ifdef _WIN32
     WSACleanup();
 #endif
 
-    return result;
+    if (session) {
+        libssh2_session_free(session);
+    }
+    session = libssh2_session_init();
+    if (!session) {
+        fprintf(stderr, "Could not initialize SSH session.\n");
+    }
+
+    co_return result;
 }
 
 } // namespace Mikrotik
@@ -4,49 +4,171 @@
 #pragma once
 
 #include <atomic>
+#include <filesystem>
+#include <functional>
 #include <mutex>
+#include <span>
 #include <string>
+#include <vector>
 
+#include "common/async_semaphore.h"
 #include "common/common_types.h"
+#include "common/task.h"
+#include "the_dude_to_human/mikrotik/command_statistics.h"
+#include "the_dude_to_human/mikrotik/ssh_reactor.h"
 
-struct _LIBSSH2_SESSION;
-typedef struct _LIBSSH2_SESSION LIBSSH2_SESSION;
+struct _LIBSSH2_SFTP;
+typedef struct _LIBSSH2_SFTP LIBSSH2_SFTP;
+struct _LIBSSH2_SFTP_HANDLE;
+typedef struct _LIBSSH2_SFTP_HANDLE LIBSSH2_SFTP_HANDLE;
 
 namespace Mikrotik {
 
-// Connects to a mikrotik device using ssh
+class RangeDownload;
+
+// Version of the live dude database as reported by the device. Values are kept as printed, they
+// are only compared
+struct DatabaseFingerprint {
+    std::string size{};
+    std::string modified{};
+
+    bool operator==(const DatabaseFingerprint&) const = default;
+};
+
+// Connects to a mikrotik device using ssh. The session is non blocking, calls wait on the reactor
+// threads so many devices can share a few threads. The Async functions resume the awaiting
+// coroutine on a reactor thread, where the blocking functions must not be called. A device used
+// from coroutines must be disconnected with DisconnectAsync before it's destroyed.
+// The session stays open between commands and several commands may run at the same time, each
+// on its own channel. A lost session is opened again by the next command
 class MikrotikDevice {
 public:
-    MikrotikDevice(std::string address, u16 port_ = 22);
+    // Receives every chunk of command output as it's read, on a reactor thread
+    using OutputSink = std::function<void(std::span<const char>)>;
+
+    // Channels open at the same time, servers limit the channels of a session
+    static constexpr std::size_t MaxChannels = 4;
+    // Seconds of silence before the session sends a keepalive
+    static constexpr int KeepaliveInterval = 15;
+
+    // Uses the default reactor if reactor is null
+    MikrotikDevice(std::string address, u16 port_ = 22, SshReactor* reactor_ = nullptr);
     ~MikrotikDevice();
 
-    bool Connect(std::string username, std::string password);
+    // Blocking operations fail after milliseconds without progress, zero waits forever. Must be
+    // set before Connect
+    void SetTimeout(u32 milliseconds);
+
+    bool Connect(std::string username_, std::string password_);
     bool Disconnect();
 
     bool Execute(std::string commandline, std::string* output = nullptr);
-
-    void DownloadDatabase();
-    void UploadDatabase();
+    bool Execute(std::string commandline, OutputSink output, OutputSink error = {});
+
+    Common::Task<bool> ConnectAsync(std::string username_, std::string password_);
+    Common::Task<bool> DisconnectAsync();
+    // Fails if the command fails or times out. output must stay valid until the task finishes
+    Common::Task<bool> ExecuteAsync(std::string commandline, std::string* output = nullptr);
+    // Streams standard output and standard error into their sinks, empty sinks discard them. A
+    // command that couldn't reach the device because the session was lost runs again on a new
+    // session
+    Common::Task<bool> ExecuteAsync(std::string commandline, OutputSink output,
+                                    OutputSink error = {});
+
+    // Sends a keepalive if the session was quiet for KeepaliveInterval, which keeps idle sessions
+    // from being dropped. Returns the seconds until the next keepalive, negative if the session
+    // is lost and couldn't be opened again
+    int SendKeepalive();
+    Common::Task<int> SendKeepaliveAsync();
+
+    CommandStatistics GetCommandStatistics() const;
+
+    // Reads the size and modification time of the live dude database with one command, which
+    // is much cheaper than exporting it. Fails if the device doesn't report both
+    bool GetDatabaseFingerprint(DatabaseFingerprint& fingerprint);
+
+    // Exports the dude database and reads it over sftp into memory, already decompressed and
+    // without the dude header. The file is fetched in ranges on parallel sftp sessions. With a
+    // partial path the ranges are also saved to disk, and a download that fails is resumed by
+    // the next call with the same path. Only a download of the same live database is resumed,
+    // without a fingerprint the database is always exported again
+    bool DownloadDatabase(std::vector<u8>& database,
+                          const std::filesystem::path& partial_path = {},
+                          const DatabaseFingerprint& fingerprint = {});
+
+    // Restores database into the dude. The dude header and database are compressed into a backup
+    // while it's written over sftp under a temporary name, which is renamed once complete so the
+    // import never sees a partial file. Without a header the one of a new export is used
+    bool UploadDatabase(std::span<const u8> database, std::span<const u8> header = {});
 
 private:
     int InitializeSSH();
-    int ConnectSSH(std::string username, std::string password);
-
-    int ExecuteSSH(std::string commandline, std::string* output = nullptr);
-
-    int DisconnectSSH();
-
+    Common::Task<int> ConnectSSH();
+
+    // is_started tells if the command may have reached the device
+    Common::Task<int> ExecuteSSH(const std::string& commandline, const OutputSink& output,
+                                 const OutputSink& error, bool& is_started);
+
+    // Takes a channel unit, tells if the session can be used. The unit must be released anyway
+    Common::Task<bool> AcquireChannel();
+
+    // Opens a new session unless another command already did since failed_generation
+    Common::Task<bool> ReconnectSSH(u64 failed_generation);
+
+    // is_write creates the file or truncates it
+    Common::Task<int> OpenSFTP(const std::string& remote_file, LIBSSH2_SFTP*& sftp,
+                               LIBSSH2_SFTP_HANDLE*& handle, bool is_write = false);
+    Common::Task<int> CloseSFTP(LIBSSH2_SFTP* sftp, LIBSSH2_SFTP_HANDLE* handle);
+    // Reads the size and modification time of a remote file
+    Common::Task<int> StatSFTP(std::string remote_file, u64& size, u64& modified);
+    // Fetches ranges on its own sftp session until none is left or the session fails
+    Common::Task<int> DownloadRanges(std::string remote_file, RangeDownload& download);
+    // Reads the dude header at the start of an exported database
+    Common::Task<int> ReadHeaderSFTP(std::string remote_file, std::vector<u8>& header);
+    // Writes header and database compressed into temporary_file and renames it to remote_file.
+    // written receives the compressed size
+    Common::Task<int> UploadSFTP(std::string temporary_file, std::string remote_file,
+                                 std::span<const u8> header, std::span<const u8> database,
+                                 u64& written);
+
+    // Shared steps let the other channels of the session run while they wait
+    SshReactor::StepAwaiter AwaitSSH(SshReactor::Step step, bool is_shared = false);
+
+    // Closes the connection and replaces the session, libssh2 can't reuse a closed one
+    Common::Task<int> DisconnectSSH();
+
+    void RecordCommand(s64 elapsed_us, bool is_success);
+
+    // Connect succeeded and Disconnect wasn't called
     bool is_connected{};
+    // The connection failed and couldn't be opened again
+    bool is_session_lost{};
 
     std::string hostname{};
     u16 port{};
+    u32 timeout_ms{};
+
+    // Kept to open the session again
+    std::string username{};
+    std::string password{};
+
+    // Each command holds one unit. Connecting and reconnecting hold all of them, which waits for
+    // the running commands and keeps new ones out
+    Common::AsyncSemaphore channels{MaxChannels};
+    // Number of times the session was opened
+    u64 session_generation{};
+
+    mutable std::mutex statistics_mutex;
+    CommandStatistics statistics{};
 
 private:
     static inline std::atomic_int lib_refcount = 0;
+    // Devices may be created from several threads, libssh2_init isn't thread safe
+    static inline std::mutex lib_mutex;
 
-    s32 sock{};
+    s32 sock{-1};
     LIBSSH2_SESSION* session = nullptr;
-    std::mutex session_mutex;
+    SshReactor* reactor = nullptr;
 };
 
 } // namespace Mikrotik
@@ -0,0 +1,513 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <regex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "common/task.h"
+#include "common/thread_pool.h"
+#include "the_dude_to_human/mikrotik/database_cache.h"
+#include "the_dude_to_human/mikrotik/mikrotik_device.h"
+#include "the_dude_to_human/mikrotik/mikrotik_fleet.h"
+#include "the_dude_to_human/mikrotik/routeros_api.h"
+
+namespace Mikrotik {
+namespace {
+
+struct FleetResult {
+    const char* status{"ok"};
+    std::size_t database_size{};
+    std::uintmax_t output_size{};
+    s64 download_ms{};
+    s64 export_ms{};
+};
+
+bool IsFailed(const FleetResult& result) {
+    const std::string_view status{result.status};
+    return status != "ok" && status != "unchanged";
+}
+
+// Persistent session of a host while it runs commands, either ssh or api
+struct CommandHost {
+    std::unique_ptr<MikrotikDevice> device{};
+    std::unique_ptr<RouterOsApi> api{};
+    const char* status{"ok"};
+    // One file per command when the output is saved
+    std::vector<std::ofstream> out_files{};
+    // Output of the last round of each command when it's printed
+    std::vector<std::string> outputs{};
+    std::vector<std::string> errors{};
+    std::vector<std::size_t> output_sizes{};
+};
+
+s64 GetElapsedMs(std::chrono::steady_clock::time_point start_time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start_time)
+        .count();
+}
+
+const char* GetExportExtension(Database::ExportFormat format) {
+    switch (format) {
+    case Database::ExportFormat::Json:
+        return ".json";
+    case Database::ExportFormat::Msgpack:
+        return ".msgpack";
+    case Database::ExportFormat::Sqlite:
+        return ".sqlite";
+    case Database::ExportFormat::Arrow:
+        return ".arrow";
+    case Database::ExportFormat::Csv:
+        // Csv output is a directory
+        return "";
+    case Database::ExportFormat::OpenMetrics:
+        return ".om";
+    }
+    return "";
+}
+
+std::uintmax_t GetOutputSize(const std::filesystem::path& path) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(path, ec)) {
+        const auto size = std::filesystem::file_size(path, ec);
+        return ec ? 0 : size;
+    }
+
+    std::uintmax_t size = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+        if (entry.is_regular_file(ec)) {
+            size += entry.file_size(ec);
+        }
+    }
+    return size;
+}
+
+// Tells if the export of a previous run is at least as recent as the cached database
+bool IsOutputCurrent(const std::filesystem::path& out_path, const DatabaseCache& cache) {
+    std::error_code ec;
+    const auto output_time = std::filesystem::last_write_time(out_path, ec);
+    if (ec) {
+        return false;
+    }
+    const auto cache_time = std::filesystem::last_write_time(cache.GetManifestPath(), ec);
+    return !ec && output_time >= cache_time;
+}
+
+FleetResult PullHost(const DeviceAddress& host, const FleetOptions& options) {
+    FleetResult result{};
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const std::string name = GetHostName(host);
+    const std::filesystem::path out_path =
+        options.out_dir.empty() ? std::filesystem::path{}
+                                : std::filesystem::path{options.out_dir} /
+                                      (name + GetExportExtension(options.export_options.format));
+
+    std::vector<u8> database_data{};
+    bool is_loaded = true;
+    {
+        MikrotikDevice device{host.address, host.port};
+        device.SetTimeout(options.timeout_ms);
+        if (!device.Connect(host.user, host.password)) {
+            result.status = "connect failed";
+        } else if (options.cache_dir.empty()) {
+            if (!device.DownloadDatabase(database_data)) {
+                result.status = "download failed";
+            }
+        } else {
+            // An unchanged database is only exported again if the last output is missing
+            const DatabaseCache cache{std::filesystem::path{options.cache_dir} / (name + ".db")};
+            const bool load_unchanged = !out_path.empty() && !IsOutputCurrent(out_path, cache);
+            switch (SyncDatabase(device, cache, database_data, load_unchanged)) {
+            case SyncResult::Failed:
+                result.status = "download failed";
+                break;
+            case SyncResult::Unchanged:
+                result.status = "unchanged";
+                is_loaded = load_unchanged;
+                break;
+            case SyncResult::Downloaded:
+                break;
+            }
+        }
+        device.Disconnect();
+    }
+    result.database_size = database_data.size();
+    result.download_ms = GetElapsedMs(start_time);
+    if (IsFailed(result) || out_path.empty()) {
+        return result;
+    }
+    if (!is_loaded) {
+        result.output_size = GetOutputSize(out_path);
+        return result;
+    }
+
+    const auto export_time = std::chrono::steady_clock::now();
+    Database::DudeDatabase db{name + ".db", std::move(database_data)};
+    if (db.SaveDatabase(out_path.string(), options.has_credentials, options.export_options) !=
+        0) {
+        result.status = "export failed";
+    }
+    result.export_ms = GetElapsedMs(export_time);
+    result.output_size = GetOutputSize(out_path);
+    return result;
+}
+
+Common::Task<bool> ConnectCommandHost(CommandHost& host, const DeviceAddress& address) {
+    if (std::string_view{host.status} != "ok") {
+        co_return false;
+    }
+    bool is_connected = false;
+    if (host.api != nullptr) {
+        is_connected = co_await host.api->ConnectAsync(address.user, address.password);
+    } else {
+        is_connected = co_await host.device->ConnectAsync(address.user, address.password);
+    }
+    if (!is_connected) {
+        host.status = "connect failed";
+    }
+    co_return is_connected;
+}
+
+MikrotikDevice::OutputSink MakeOutputSink(CommandHost& host, std::size_t command) {
+    return [&host, command](std::span<const char> data) {
+        host.output_sizes[command] += data.size();
+        if (host.out_files[command].is_open()) {
+            host.out_files[command].write(data.data(), static_cast<std::streamsize>(data.size()));
+            return;
+        }
+        host.outputs[command].append(data.data(), data.size());
+    };
+}
+
+// Writes each row of the reply as a line of name=value pairs
+Common::Task<bool> RunApiCommand(CommandHost& host, std::size_t command,
+                                 const std::string& text) {
+    std::vector<std::string> words{};
+    std::size_t start = text.find_first_not_of(' ');
+    while (start != std::string::npos) {
+        const std::size_t end = text.find(' ', start);
+        words.push_back(text.substr(start, end - start));
+        start = text.find_first_not_of(' ', end);
+    }
+
+    const ApiReply reply = co_await host.api->ExecuteAsync(std::move(words));
+    const MikrotikDevice::OutputSink output_sink = MakeOutputSink(host, command);
+    std::vector<const ApiAttributes*> rows{};
+    for (const ApiAttributes& row : reply.rows) {
+        rows.push_back(&row);
+    }
+    if (!reply.done.empty()) {
+        rows.push_back(&reply.done);
+    }
+    for (const ApiAttributes* row : rows) {
+        std::string line{};
+        for (const auto& [name, value] : *row) {
+            line += line.empty() ? "" : " ";
+            line += name + "=" + value;
+        }
+        line += '\n';
+        output_sink(line);
+    }
+
+    if (!reply.is_success) {
+        host.errors[command] = reply.error + "\n";
+    }
+    co_return reply.is_success;
+}
+
+// Runs every command at the same time on the session of the host
+Common::Task<bool> RunHostCommands(CommandHost& host, const FleetCommandOptions& options) {
+    if (std::string_view{host.status} != "ok") {
+        co_return false;
+    }
+
+    std::vector<Common::Task<bool>> tasks{};
+    for (std::size_t i = 0; i < options.commands.size(); ++i) {
+        host.outputs[i].clear();
+        host.errors[i].clear();
+        host.output_sizes[i] = 0;
+        if (host.api != nullptr) {
+            tasks.push_back(RunApiCommand(host, i, options.commands[i]));
+            continue;
+        }
+        MikrotikDevice::OutputSink error_sink = [&host, i](std::span<const char> data) {
+            host.errors[i].append(data.data(), data.size());
+        };
+        tasks.push_back(host.device->ExecuteAsync(options.commands[i], MakeOutputSink(host, i),
+                                                  std::move(error_sink)));
+    }
+
+    const std::vector<bool> results = co_await Common::WhenAll(std::move(tasks));
+    co_return std::ranges::all_of(results, [](bool result) { return result; });
+}
+
+void PrintHostOutput(const std::string& name, const CommandHost& host,
+                     const FleetCommandOptions& options) {
+    for (std::size_t i = 0; i < options.commands.size(); ++i) {
+        printf("--- %s %s %zu bytes\n", name.c_str(), options.commands[i].c_str(),
+               host.output_sizes[i]);
+        for (const std::string* text : {&host.outputs[i], &host.errors[i]}) {
+            fwrite(text->data(), 1, text->size(), stdout);
+            if (!text->empty() && text->back() != '\n') {
+                printf("\n");
+            }
+        }
+    }
+}
+
+// Sends keepalives on the sessions until round_time
+void WaitForRound(std::vector<CommandHost>& hosts,
+                  std::chrono::steady_clock::time_point round_time) {
+    for (;;) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= round_time) {
+            return;
+        }
+
+        std::vector<Common::Task<int>> tasks{};
+        for (CommandHost& host : hosts) {
+            // Api connections have no keepalive, RouterOS keeps them while the login is valid
+            if (host.device != nullptr && std::string_view{host.status} == "ok") {
+                tasks.push_back(host.device->SendKeepaliveAsync());
+            }
+        }
+        int seconds_to_next = MikrotikDevice::KeepaliveInterval;
+        for (const int seconds : Common::SyncWait(Common::WhenAll(std::move(tasks)))) {
+            // Lost sessions open again on the next command
+            if (seconds >= 0) {
+                seconds_to_next = std::min(seconds_to_next, seconds);
+            }
+        }
+
+        const auto keepalive_time =
+            std::chrono::steady_clock::now() + std::chrono::seconds{std::max(seconds_to_next, 1)};
+        std::this_thread::sleep_until(std::min(keepalive_time, round_time));
+    }
+}
+
+} // Anonymous namespace
+
+std::string GetHostName(const DeviceAddress& host) {
+    if (host.port == 22) {
+        return host.address;
+    }
+    return host.address + "_" + std::to_string(host.port);
+}
+
+bool ParseDeviceAddress(const std::string& text, DeviceAddress& device) {
+    // regex to check if the format is user:password@ip:port
+    // with optional :password :port
+    const std::regex re("^([^:]+)(:(.+)?)?@([^:]+)(?::([0-9]+))?$");
+
+    std::smatch match;
+    if (!std::regex_match(text, match, re) || match.size() != 6) {
+        return false;
+    }
+
+    device.user = match[1];
+    device.password = match[3];
+    device.address = match[4];
+    device.port = 22;
+    if (!match[5].str().empty()) {
+        device.port = static_cast<u16>(std::strtoul(match[5].str().c_str(), nullptr, 0));
+    }
+    device.has_hidden_password = match[2].length() != 0 && device.password.empty();
+    return !device.address.empty();
+}
+
+int ReadFleetHosts(const std::string& file, std::vector<DeviceAddress>& hosts) {
+    std::ifstream host_file{file};
+    if (!host_file.is_open()) {
+        return 1;
+    }
+
+    std::string line{};
+    for (std::size_t line_number = 1; std::getline(host_file, line); ++line_number) {
+        // Tolerate files saved with windows line endings
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        DeviceAddress host{};
+        if (!ParseDeviceAddress(line, host)) {
+            printf("Wrong host format at %s:%zu\n", file.c_str(), line_number);
+            return 2;
+        }
+        hosts.push_back(std::move(host));
+    }
+
+    return 0;
+}
+
+int RunFleet(const std::vector<DeviceAddress>& hosts, const FleetOptions& options) {
+    if (!options.out_dir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(options.out_dir, ec);
+        if (ec) {
+            printf("Unable to create directory '%s'\n", options.out_dir.c_str());
+            return static_cast<int>(hosts.size());
+        }
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    std::vector<FleetResult> results(hosts.size());
+    {
+        Common::ThreadPool pool{options.jobs};
+        std::vector<std::future<FleetResult>> pending{};
+        pending.reserve(hosts.size());
+        for (const DeviceAddress& host : hosts) {
+            pending.push_back(pool.Submit([&host, &options] { return PullHost(host, options); }));
+        }
+
+        // Exceptions stay in their own host
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            try {
+                results[i] = pending[i].get();
+            } catch (const std::exception& e) {
+                printf("Host %s failed: %s\n", hosts[i].address.c_str(), e.what());
+                results[i].status = "error";
+            }
+        }
+    }
+
+    int failed_hosts = 0;
+    std::size_t total_size = 0;
+    printf("\n%-24s %-16s %12s %12s %10s %10s\n", "host", "status", "database", "output",
+           "download", "export");
+    for (std::size_t i = 0; i < hosts.size(); ++i) {
+        const FleetResult& result = results[i];
+        const std::string name = GetHostName(hosts[i]);
+        printf("%-24s %-16s %12zu %12llu %8lldms %8lldms\n", name.c_str(), result.status,
+               result.database_size, static_cast<unsigned long long>(result.output_size),
+               static_cast<long long>(result.download_ms),
+               static_cast<long long>(result.export_ms));
+        failed_hosts += IsFailed(result) ? 1 : 0;
+        total_size += result.database_size;
+    }
+    printf("%zu hosts, %d failed, %zu database bytes in %lld ms\n", hosts.size(), failed_hosts,
+           total_size, static_cast<long long>(GetElapsedMs(start_time)));
+
+    return failed_hosts;
+}
+
+int RunFleetCommand(const std::vector<DeviceAddress>& hosts,
+                    const FleetCommandOptions& options) {
+    if (!options.out_dir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(options.out_dir, ec);
+        if (ec) {
+            printf("Unable to create directory '%s'\n", options.out_dir.c_str());
+            return static_cast<int>(hosts.size());
+        }
+    }
+
+    const std::size_t command_count = options.commands.size();
+    std::vector<CommandHost> command_hosts(hosts.size());
+    for (std::size_t i = 0; i < hosts.size(); ++i) {
+        CommandHost& host = command_hosts[i];
+        if (options.use_api) {
+            const u16 port = hosts[i].port == 22 ? RouterOsApi::DefaultPort : hosts[i].port;
+            host.api = std::make_unique<RouterOsApi>(hosts[i].address, port);
+            host.api->SetTimeout(options.timeout_ms);
+        } else {
+            host.device = std::make_unique<MikrotikDevice>(hosts[i].address, hosts[i].port);
+            host.device->SetTimeout(options.timeout_ms);
+        }
+        host.out_files.resize(command_count);
+        host.outputs.resize(command_count);
+        host.errors.resize(command_count);
+        host.output_sizes.resize(command_count);
+        if (options.out_dir.empty()) {
+            continue;
+        }
+
+        for (std::size_t command = 0; command < command_count; ++command) {
+            std::string name = GetHostName(hosts[i]);
+            if (command_count > 1) {
+                name += "_" + std::to_string(command + 1);
+            }
+            host.out_files[command].open(std::filesystem::path{options.out_dir} / (name + ".txt"),
+                                         std::ios::binary);
+            if (!host.out_files[command].is_open()) {
+                host.status = "open failed";
+            }
+        }
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    try {
+        std::vector<Common::Task<bool>> tasks{};
+        for (std::size_t i = 0; i < hosts.size(); ++i) {
+            tasks.push_back(ConnectCommandHost(command_hosts[i], hosts[i]));
+        }
+        Common::SyncWait(Common::WhenAll(std::move(tasks)));
+
+        for (std::size_t round = 0; round < options.rounds; ++round) {
+            const std::chrono::seconds round_offset{static_cast<s64>(round) * options.interval_s};
+            WaitForRound(command_hosts, start_time + round_offset);
+
+            tasks.clear();
+            for (CommandHost& host : command_hosts) {
+                tasks.push_back(RunHostCommands(host, options));
+            }
+            Common::SyncWait(Common::WhenAll(std::move(tasks)));
+
+            for (std::size_t i = 0; i < hosts.size() && options.out_dir.empty(); ++i) {
+                PrintHostOutput(GetHostName(hosts[i]), command_hosts[i], options);
+            }
+        }
+
+        std::vector<Common::Task<bool>> disconnect_tasks{};
+        for (CommandHost& host : command_hosts) {
+            disconnect_tasks.push_back(host.api != nullptr ? host.api->DisconnectAsync()
+                                                           : host.device->DisconnectAsync());
+        }
+        Common::SyncWait(Common::WhenAll(std::move(disconnect_tasks)));
+    } catch (const std::exception& e) {
+        printf("Command failed: %s\n", e.what());
+        return static_cast<int>(hosts.size());
+    }
+
+    int failed_hosts = 0;
+    printf("\n%-24s %-16s %9s %7s %10s %10s %10s %10s\n", "host", "status", "commands",
+           "failed", "reconnects", "min", "avg", "max");
+    for (std::size_t i = 0; i < hosts.size(); ++i) {
+        const CommandHost& host = command_hosts[i];
+        const CommandStatistics stats = host.api != nullptr
+                                            ? host.api->GetCommandStatistics()
+                                            : host.device->GetCommandStatistics();
+        const std::string name = GetHostName(hosts[i]);
+        const double average_us =
+            stats.commands == 0 ? 0.0
+                                : static_cast<double>(stats.total_us) /
+                                      static_cast<double>(stats.commands);
+        printf("%-24s %-16s %9zu %7zu %10zu %8.2fms %8.2fms %8.2fms\n", name.c_str(),
+               host.status, stats.commands, stats.failed_commands, stats.reconnects,
+               static_cast<double>(stats.min_us) / 1000.0, average_us / 1000.0,
+               static_cast<double>(stats.max_us) / 1000.0);
+        const bool is_failed =
+            std::string_view{host.status} != "ok" || stats.failed_commands != 0;
+        failed_hosts += is_failed ? 1 : 0;
+    }
+    printf("%zu hosts, %d failed in %lld ms\n", hosts.size(), failed_hosts,
+           static_cast<long long>(GetElapsedMs(start_time)));
+
+    return failed_hosts;
+}
+
+} // namespace Mikrotik
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+#include "the_dude_to_human/database/dude_database.h"
+
+namespace Mikrotik {
+
+struct DeviceAddress {
+    std::string user{};
+    std::string password{};
+    std::string address{};
+    u16 port{22};
+    // Written as user:@address, the password should be asked
+    bool has_hidden_password{};
+};
+
+// Parses user:password@address:port, password and port are optional
+bool ParseDeviceAddress(const std::string& text, DeviceAddress& device);
+
+// Name of the files of a host, the address followed by the port unless it's 22
+std::string GetHostName(const DeviceAddress& host);
+
+// Reads one device address per line. Empty lines and lines starting with # are skipped
+int ReadFleetHosts(const std::string& file, std::vector<DeviceAddress>& hosts);
+
+struct FleetOptions {
+    // Each host is saved as <address>.<format> in this directory, nothing is saved if empty
+    std::string out_dir{};
+    bool has_credentials{};
+    Database::ExportOptions export_options{};
+    // Hosts processed at the same time
+    std::size_t jobs{4};
+    // Time without progress before a host is abandoned, zero waits forever
+    u32 timeout_ms{};
+    // Each host database is kept as <address>.db in this directory and only downloaded again
+    // once it changes on the device. No cache is used if empty
+    std::string cache_dir{};
+};
+
+// Downloads and exports every host on a shared pool. A failing host doesn't stop the others,
+// prints a summary of every host at the end. Returns the number of failed hosts
+int RunFleet(const std::vector<DeviceAddress>& hosts, const FleetOptions& options);
+
+struct FleetCommandOptions {
+    // Run at the same time on the session of each host
+    std::vector<std::string> commands{};
+    // Each command output is saved as <address>.txt, or <address>_<n>.txt with several commands
+    // where n is the position of the command starting at 1, in this directory. Outputs are printed
+    // if empty
+    std::string out_dir{};
+    // Time without progress before a command is abandoned, zero waits forever
+    u32 timeout_ms{};
+    // Times the commands run, the sessions stay open between them
+    std::size_t rounds{1};
+    // Seconds between the start of each round
+    u32 interval_s{};
+    // Runs the commands through the RouterOS api instead of ssh. Each command is split on spaces
+    // into api words, port 22 is replaced by the api port
+    bool use_api{};
+};
+
+// Runs the commands on every host at the same time. Each host is a coroutine on the ssh reactor,
+// no thread is used per host. Idle sessions get keepalives between rounds and lost sessions are
+// opened again. Prints the command latency of each host at the end. Returns the number of hosts
+// with failures
+int RunFleetCommand(const std::vector<DeviceAddress>& hosts, const FleetCommandOptions& options);
+
+} // namespace Mikrotik
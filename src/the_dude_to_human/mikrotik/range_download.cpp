@@ -0,0 +1,302 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "the_dude_to_human/gzip/gzip.h"
+#include "the_dude_to_human/mikrotik/range_download.h"
+
+namespace Mikrotik {
+
+RangeDownload::RangeDownload(std::filesystem::path partial_path_, Sink sink_)
+    : partial_path{std::move(partial_path_)}, sink{std::move(sink_)} {
+    if (!partial_path.empty()) {
+        journal_path = partial_path;
+        journal_path += ".journal";
+    }
+}
+
+bool RangeDownload::HasJournal() const {
+    std::error_code ec;
+    return !journal_path.empty() && std::filesystem::exists(journal_path, ec);
+}
+
+bool RangeDownload::Resume(u64 file_size_, u64 modified_, const std::string& source_) {
+    std::ifstream journal{journal_path};
+    if (journal_path.empty() || !journal.is_open()) {
+        return false;
+    }
+
+    // The journal starts with the file it belongs to, followed by a line per completed range
+    u64 journal_size = 0;
+    u64 journal_modified = 0;
+    u64 journal_range_size = 0;
+    std::string journal_source{};
+    std::vector<std::pair<std::size_t, u32>> completed{};
+    std::string line{};
+    while (std::getline(journal, line)) {
+        const std::size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        const std::string_view name{line.data(), separator};
+        const char* value = line.c_str() + separator + 1;
+        char* end = nullptr;
+        if (name == "size") {
+            journal_size = std::strtoull(value, nullptr, 10);
+        } else if (name == "modified") {
+            journal_modified = std::strtoull(value, nullptr, 10);
+        } else if (name == "source") {
+            journal_source = value;
+        } else if (name == "range_size") {
+            journal_range_size = std::strtoull(value, nullptr, 10);
+        } else if (name == "range") {
+            const std::size_t range = std::strtoull(value, &end, 10);
+            // A line cut by a crash has no checksum
+            if (*end == ' ') {
+                completed.emplace_back(range, static_cast<u32>(std::strtoul(end, nullptr, 16)));
+            }
+        }
+    }
+    journal.close();
+
+    if (journal_size != file_size_ || journal_modified != modified_ ||
+        journal_range_size != RangeSize || journal_source != source_) {
+        return false;
+    }
+    Reset(file_size_, modified_, source_);
+
+    // Only checked here, the sink reads them again once it reaches them
+    std::ifstream partial{partial_path, std::ios::binary};
+    std::vector<u8> buffer{};
+    for (const auto& [range, checksum] : completed) {
+        if (range >= ranges.size() || ranges[range] == RangeState::Completed) {
+            continue;
+        }
+        buffer.resize(static_cast<std::size_t>(GetRangeSize(range)));
+        partial.clear();
+        partial.seekg(static_cast<std::streamoff>(GetRangeOffset(range)));
+        if (!partial.read(reinterpret_cast<char*>(buffer.data()),
+                          static_cast<std::streamsize>(buffer.size())) ||
+            Gzip::Checksum(buffer) != checksum) {
+            continue;
+        }
+        ranges[range] = RangeState::Completed;
+        checksums[range] = checksum;
+        --pending_ranges;
+        completed_bytes += buffer.size();
+    }
+    partial.close();
+
+    // The files are written again from the ranges still valid
+    if (!OpenFiles(false)) {
+        return false;
+    }
+    std::scoped_lock lock{mutex};
+    ConsumeRanges();
+    return true;
+}
+
+bool RangeDownload::Start(u64 file_size_, u64 modified_, const std::string& source_) {
+    Reset(file_size_, modified_, source_);
+    return partial_path.empty() || OpenFiles(true);
+}
+
+bool RangeDownload::TakeRange(std::size_t& range) {
+    std::scoped_lock lock{mutex};
+    if (is_failed) {
+        return false;
+    }
+    const auto it = std::find(ranges.begin() + static_cast<std::ptrdiff_t>(next_consumed),
+                              ranges.end(), RangeState::Pending);
+    if (it == ranges.end()) {
+        return false;
+    }
+
+    range = static_cast<std::size_t>(it - ranges.begin());
+    ranges[range] = RangeState::Fetching;
+    buffers[range].resize(static_cast<std::size_t>(GetRangeSize(range)));
+    return true;
+}
+
+bool RangeDownload::IsPending(std::size_t range) const {
+    std::scoped_lock lock{mutex};
+    return range < ranges.size() && ranges[range] == RangeState::Pending;
+}
+
+void RangeDownload::ReturnRange(std::size_t range) {
+    std::scoped_lock lock{mutex};
+    ranges[range] = RangeState::Pending;
+    std::vector<u8>{}.swap(buffers[range]);
+}
+
+bool RangeDownload::CompleteRange(std::size_t range) {
+    std::scoped_lock lock{mutex};
+    std::vector<u8>& buffer = buffers[range];
+    const u32 checksum = Gzip::Checksum(buffer);
+    if (!partial_path.empty()) {
+        partial_file.seekp(static_cast<std::streamoff>(GetRangeOffset(range)));
+        partial_file.write(reinterpret_cast<const char*>(buffer.data()),
+                           static_cast<std::streamsize>(buffer.size()));
+        partial_file.flush();
+
+        // The range is only recorded once its data is on disk
+        char checksum_text[9]{};
+        snprintf(checksum_text, sizeof(checksum_text), "%08x", checksum);
+        journal_file << "range=" << range << ' ' << checksum_text << '\n';
+        journal_file.flush();
+        if (!partial_file || !journal_file) {
+            ranges[range] = RangeState::Pending;
+            std::vector<u8>{}.swap(buffer);
+            return false;
+        }
+    }
+
+    ranges[range] = RangeState::Completed;
+    checksums[range] = checksum;
+    --pending_ranges;
+    completed_bytes += buffer.size();
+    // A range ahead of the sink is read back from disk when its turn comes
+    if (!partial_path.empty() && range != next_consumed) {
+        std::vector<u8>{}.swap(buffer);
+    }
+    ConsumeRanges();
+    return true;
+}
+
+u64 RangeDownload::GetRangeOffset(std::size_t range) const {
+    return static_cast<u64>(range) * RangeSize;
+}
+
+std::span<u8> RangeDownload::GetRangeBuffer(std::size_t range) {
+    std::scoped_lock lock{mutex};
+    return buffers[range];
+}
+
+std::size_t RangeDownload::GetPendingRanges() const {
+    std::scoped_lock lock{mutex};
+    return pending_ranges;
+}
+
+u64 RangeDownload::GetCompletedBytes() const {
+    std::scoped_lock lock{mutex};
+    return completed_bytes;
+}
+
+u64 RangeDownload::GetBufferedBytes() const {
+    std::scoped_lock lock{mutex};
+    u64 size = 0;
+    for (const std::vector<u8>& buffer : buffers) {
+        size += buffer.size();
+    }
+    return size;
+}
+
+bool RangeDownload::IsComplete() const {
+    return GetPendingRanges() == 0;
+}
+
+bool RangeDownload::IsFailed() const {
+    std::scoped_lock lock{mutex};
+    return is_failed;
+}
+
+void RangeDownload::Discard() {
+    partial_file.close();
+    journal_file.close();
+    if (partial_path.empty()) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(journal_path, ec);
+    std::filesystem::remove(partial_path, ec);
+}
+
+void RangeDownload::Reset(u64 file_size_, u64 modified_, const std::string& source_) {
+    file_size = file_size_;
+    modified = modified_;
+    source = source_;
+    const auto range_count = static_cast<std::size_t>((file_size + RangeSize - 1) / RangeSize);
+    ranges.assign(range_count, RangeState::Pending);
+    buffers.assign(range_count, {});
+    checksums.assign(range_count, 0);
+    pending_ranges = range_count;
+    next_consumed = 0;
+    completed_bytes = 0;
+    is_failed = false;
+}
+
+u64 RangeDownload::GetRangeSize(std::size_t range) const {
+    return std::min(RangeSize, file_size - GetRangeOffset(range));
+}
+
+bool RangeDownload::OpenFiles(bool is_new) {
+    partial_file.close();
+    journal_file.close();
+
+    std::error_code ec;
+    if (partial_path.has_parent_path()) {
+        std::filesystem::create_directories(partial_path.parent_path(), ec);
+    }
+    if (is_new) {
+        std::filesystem::remove(journal_path, ec);
+        std::ofstream{partial_path, std::ios::binary | std::ios::trunc};
+    }
+
+    partial_file.open(partial_path, std::ios::binary | std::ios::in | std::ios::out);
+    journal_file.open(journal_path, std::ios::trunc);
+    if (!partial_file.is_open() || !journal_file.is_open()) {
+        fprintf(stderr, "Unable to open download journal '%s'\n", journal_path.string().c_str());
+        return false;
+    }
+
+    journal_file << "size=" << file_size << "\nmodified=" << modified << "\nsource=" << source
+                 << "\nrange_size=" << RangeSize << '\n';
+    for (std::size_t range = 0; range < ranges.size(); ++range) {
+        if (ranges[range] != RangeState::Completed) {
+            continue;
+        }
+        char checksum[9]{};
+        snprintf(checksum, sizeof(checksum), "%08x", checksums[range]);
+        journal_file << "range=" << range << ' ' << checksum << '\n';
+    }
+    journal_file.flush();
+    return static_cast<bool>(journal_file);
+}
+
+bool RangeDownload::ReadRange(std::size_t range, std::vector<u8>& buffer) {
+    buffer.resize(static_cast<std::size_t>(GetRangeSize(range)));
+    partial_file.seekg(static_cast<std::streamoff>(GetRangeOffset(range)));
+    partial_file.read(reinterpret_cast<char*>(buffer.data()),
+                      static_cast<std::streamsize>(buffer.size()));
+    if (!partial_file || Gzip::Checksum(buffer) != checksums[range]) {
+        fprintf(stderr, "Unable to read range %zu of '%s'\n", range,
+                partial_path.string().c_str());
+        partial_file.clear();
+        return false;
+    }
+    return true;
+}
+
+void RangeDownload::ConsumeRanges() {
+    while (!is_failed && next_consumed < ranges.size() &&
+           ranges[next_consumed] == RangeState::Completed) {
+        std::vector<u8>& buffer = buffers[next_consumed];
+        if (buffer.empty() && !ReadRange(next_consumed, buffer)) {
+            is_failed = true;
+            break;
+        }
+        is_failed = !sink(buffer);
+        std::vector<u8>{}.swap(buffer);
+        ++next_consumed;
+    }
+}
+
+} // namespace Mikrotik
@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Mikrotik {
+
+// Remote file fetched in fixed size ranges that complete in any order. Each range is handed to
+// the sink as soon as the ranges before it are, and its memory is freed, so the file is never
+// held whole. With a partial path every completed range is also written to that file and
+// recorded with its checksum in a journal next to it, so a download interrupted by a lost
+// connection or a crash continues on the next run
+class RangeDownload {
+public:
+    static constexpr u64 RangeSize = 0x400000;
+
+    // Receives the file in order, a range at a time. Returning false fails the download
+    using Sink = std::function<bool(std::span<const u8> data)>;
+
+    // No file is written if partial_path is empty
+    RangeDownload(std::filesystem::path partial_path_, Sink sink_);
+
+    // True if an earlier run left ranges to resume
+    bool HasJournal() const;
+
+    // Loads the ranges of an earlier run of the same remote file, which must still have this size
+    // and modification time and have been made from the same source. Ranges that don't match
+    // their checksum are fetched again, the valid ones at the start of the file are handed to the
+    // sink. Returns false if there is nothing to resume
+    bool Resume(u64 file_size_, u64 modified_, const std::string& source_);
+
+    // Starts over, discarding the ranges of an earlier run. The source names what the remote file
+    // was made from, it's kept in the journal
+    bool Start(u64 file_size_, u64 modified_, const std::string& source_);
+
+    // Hands out the first range nobody is fetching, so ranges complete close to the order the
+    // sink needs them. Returns false once none is left or the download failed
+    bool TakeRange(std::size_t& range);
+    // True if nobody took the range yet
+    bool IsPending(std::size_t range) const;
+    // Gives back a range that failed so the next attempt fetches it
+    void ReturnRange(std::size_t range);
+    // Records a range whose buffer was filled and hands the ranges now in order to the sink.
+    // Fails if the range can't be saved, a failed sink is told by IsFailed
+    bool CompleteRange(std::size_t range);
+
+    u64 GetRangeOffset(std::size_t range) const;
+    // Memory the range is received into, only valid while the range is taken
+    std::span<u8> GetRangeBuffer(std::size_t range);
+
+    std::size_t GetPendingRanges() const;
+    u64 GetCompletedBytes() const;
+    // Memory held by ranges that are being fetched or wait for the ranges before them
+    u64 GetBufferedBytes() const;
+    bool IsComplete() const;
+    // True once the sink rejected the data or a range couldn't be read back
+    bool IsFailed() const;
+
+    // Removes the partial file and its journal
+    void Discard();
+
+private:
+    enum class RangeState {
+        Pending,
+        Fetching,
+        Completed,
+    };
+
+    void Reset(u64 file_size_, u64 modified_, const std::string& source_);
+    u64 GetRangeSize(std::size_t range) const;
+    // Writes the journal of the completed ranges, is_new truncates the partial file
+    bool OpenFiles(bool is_new);
+    // Reads a completed range that was only kept in the partial file
+    bool ReadRange(std::size_t range, std::vector<u8>& buffer);
+    // Hands the completed ranges that follow the last consumed one to the sink
+    void ConsumeRanges();
+
+    std::filesystem::path partial_path{};
+    std::filesystem::path journal_path{};
+    std::fstream partial_file{};
+    std::ofstream journal_file{};
+    Sink sink;
+
+    u64 file_size{};
+    u64 modified{};
+    std::string source{};
+    std::vector<RangeState> ranges{};
+    // Empty once consumed, or while a completed range is only kept in the partial file
+    std::vector<std::vector<u8>> buffers{};
+    std::vector<u32> checksums{};
+    std::size_t pending_ranges{};
+    // Ranges before it were handed to the sink
+    std::size_t next_consumed{};
+    u64 completed_bytes{};
+    bool is_failed{};
+    mutable std::mutex mutex;
+};
+
+} // namespace Mikrotik
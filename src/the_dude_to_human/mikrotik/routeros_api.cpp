@@ -0,0 +1,441 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#include "libssh2.h"
+#include "the_dude_to_human/mikrotik/routeros_api.h"
+
+#ifdef _WIN32
+constexpr int SendFlags = 0;
+#else
+// A closed connection must fail the send instead of raising SIGPIPE
+constexpr int SendFlags = MSG_NOSIGNAL;
+#endif
+
+// Bytes requested per socket read
+constexpr std::size_t ReceiveSize = 0x10000;
+
+static bool IsWouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+static s64 GetElapsedUs(std::chrono::steady_clock::time_point start_time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start_time)
+        .count();
+}
+
+namespace Mikrotik {
+
+void EncodeLength(std::string& out, std::size_t length) {
+    if (length < 0x80) {
+        out += static_cast<char>(length);
+    } else if (length < 0x4000) {
+        out += static_cast<char>((length >> 8) | 0x80);
+        out += static_cast<char>(length & 0xFF);
+    } else if (length < 0x200000) {
+        out += static_cast<char>((length >> 16) | 0xC0);
+        out += static_cast<char>((length >> 8) & 0xFF);
+        out += static_cast<char>(length & 0xFF);
+    } else if (length < 0x10000000) {
+        out += static_cast<char>((length >> 24) | 0xE0);
+        out += static_cast<char>((length >> 16) & 0xFF);
+        out += static_cast<char>((length >> 8) & 0xFF);
+        out += static_cast<char>(length & 0xFF);
+    } else {
+        out += static_cast<char>(0xF0);
+        out += static_cast<char>((length >> 24) & 0xFF);
+        out += static_cast<char>((length >> 16) & 0xFF);
+        out += static_cast<char>((length >> 8) & 0xFF);
+        out += static_cast<char>(length & 0xFF);
+    }
+}
+
+int DecodeLength(std::string_view data, std::size_t offset, std::size_t& length) {
+    if (offset >= data.size()) {
+        return 0;
+    }
+
+    const u8 first = static_cast<u8>(data[offset]);
+    int header_size = 0;
+    if ((first & 0x80) == 0) {
+        header_size = 1;
+        length = first;
+    } else if ((first & 0xC0) == 0x80) {
+        header_size = 2;
+        length = first & 0x3F;
+    } else if ((first & 0xE0) == 0xC0) {
+        header_size = 3;
+        length = first & 0x1F;
+    } else if ((first & 0xF0) == 0xE0) {
+        header_size = 4;
+        length = first & 0x0F;
+    } else if (first == 0xF0) {
+        header_size = 5;
+        length = 0;
+    } else {
+        return -1;
+    }
+
+    if (data.size() - offset < static_cast<std::size_t>(header_size)) {
+        return 0;
+    }
+    for (int i = 1; i < header_size; ++i) {
+        length = (length << 8) | static_cast<u8>(data[offset + static_cast<std::size_t>(i)]);
+    }
+    return header_size;
+}
+
+static void EncodeWord(std::string& out, std::string_view word) {
+    EncodeLength(out, word.size());
+    out += word;
+}
+
+const std::string* FindAttribute(const ApiAttributes& attributes, std::string_view key) {
+    for (const auto& [name, value] : attributes) {
+        if (name == key) {
+            return &value;
+        }
+    }
+    return nullptr;
+}
+
+RouterOsApi::RouterOsApi(std::string address_, u16 port_, SshReactor* reactor_)
+    : hostname{std::move(address_)}, port{port_},
+      reactor{reactor_ != nullptr ? reactor_ : &SshReactor::GetDefault()} {}
+
+RouterOsApi::~RouterOsApi() {
+    if (is_connected) {
+        Disconnect();
+    }
+}
+
+void RouterOsApi::SetTimeout(u32 milliseconds) {
+    timeout_ms = milliseconds;
+}
+
+bool RouterOsApi::Connect(std::string username, std::string password) {
+    return Common::SyncWait(ConnectAsync(std::move(username), std::move(password)));
+}
+
+bool RouterOsApi::Disconnect() {
+    return Common::SyncWait(DisconnectAsync());
+}
+
+ApiReply RouterOsApi::Execute(std::vector<std::string> words) {
+    return Common::SyncWait(ExecuteAsync(std::move(words)));
+}
+
+Common::Task<bool> RouterOsApi::ConnectAsync(std::string username, std::string password) {
+    if (is_connected) {
+        co_return true;
+    }
+
+    // Api-ssl wraps the same sentences in TLS, the login would wait for a handshake that never
+    // comes
+    if (port == SslPort) {
+        fprintf(stderr, "Api-ssl on port %u isn't supported, enable the api service on %u\n",
+                SslPort, DefaultPort);
+        co_return false;
+    }
+
+#ifdef _WIN32
+    WSADATA wsadata;
+    if (WSAStartup(MAKEWORD(2, 0), &wsadata) != 0) {
+        co_return false;
+    }
+#endif
+
+    output.clear();
+    input.clear();
+    sentence_words.clear();
+    pending.clear();
+    connection_error.clear();
+
+    const int result = co_await reactor->ConnectSocket(hostname, port, timeout_ms, sock);
+    if (result != 0) {
+        CloseSocket();
+        co_return false;
+    }
+
+    // Sentences are small, waiting to merge them only delays the replies
+    int no_delay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&no_delay),
+               sizeof(no_delay));
+
+    is_connected = true;
+    std::vector<std::string> login{"/login", "=name=" + username, "=password=" + password};
+    const ApiReply reply = co_await SendSentence(std::move(login));
+    if (!reply.is_success) {
+        fprintf(stderr, "Api login failed: %s\n", reply.error.c_str());
+    } else if (FindAttribute(reply.done, "ret") != nullptr) {
+        // Older versions answer with a challenge for an md5 login
+        fprintf(stderr, "Api login needs RouterOS 6.43 or later\n");
+    } else {
+        co_return true;
+    }
+
+    is_connected = false;
+    CloseSocket();
+    co_return false;
+}
+
+Common::Task<bool> RouterOsApi::DisconnectAsync() {
+    if (is_connected) {
+        is_connected = false;
+        CloseSocket();
+    }
+    co_return true;
+}
+
+Common::Task<ApiReply> RouterOsApi::ExecuteAsync(std::vector<std::string> words) {
+    const auto start_time = std::chrono::steady_clock::now();
+    ApiReply reply = co_await SendSentence(std::move(words));
+
+    std::scoped_lock lock{statistics_mutex};
+    statistics.Record(GetElapsedUs(start_time), reply.is_success);
+    co_return reply;
+}
+
+CommandStatistics RouterOsApi::GetCommandStatistics() const {
+    std::scoped_lock lock{statistics_mutex};
+    return statistics;
+}
+
+Common::Task<ApiReply> RouterOsApi::SendSentence(std::vector<std::string> words) {
+    ApiReply reply{};
+    if (!is_connected) {
+        reply.error = "not connected";
+        co_return reply;
+    }
+
+    const u32 tag = ++next_tag;
+    std::string sentence{};
+    for (const std::string& word : words) {
+        EncodeWord(sentence, word);
+    }
+    EncodeWord(sentence, ".tag=" + std::to_string(tag));
+    EncodeWord(sentence, "");
+
+    // The sentence is queued from the step, only the reactor thread touches the connection
+    bool is_queued = false;
+    const auto step = [this, tag, &sentence, &is_queued] {
+        if (!is_queued) {
+            output += sentence;
+            pending[tag] = {};
+            is_queued = true;
+        }
+        return Pump(tag);
+    };
+    const int result = co_await reactor->Await(sock, nullptr, timeout_ms, step, true);
+
+    // Resumed by the reactor thread of the socket
+    const auto it = pending.find(tag);
+    if (it != pending.end()) {
+        reply = std::move(it->second.reply);
+        pending.erase(it);
+    }
+    if (result == LIBSSH2_ERROR_TIMEOUT) {
+        reply.is_success = false;
+        reply.error = "timeout";
+    } else if (result != 0) {
+        reply.is_success = false;
+        if (reply.error.empty()) {
+            reply.error = connection_error.empty() ? "connection failed" : connection_error;
+        }
+    }
+    co_return reply;
+}
+
+int RouterOsApi::Pump(u32 tag) {
+    const u64 last_sentence_count = sentence_count;
+    if (connection_error.empty()) {
+        const int flush_result = Flush();
+        const int receive_result = flush_result >= 0 || flush_result == SshReactor::WaitWrite
+                                       ? Receive()
+                                       : flush_result;
+        if (receive_result < 0 && receive_result != SshReactor::WaitRead) {
+            fprintf(stderr, "Api connection to '%s' failed: %s\n", hostname.c_str(),
+                    connection_error.c_str());
+        }
+    }
+
+    // A reply that completed before the connection failed is still valid
+    const auto it = pending.find(tag);
+    if (it != pending.end() && it->second.is_done) {
+        return 0;
+    }
+    if (!connection_error.empty()) {
+        return LIBSSH2_ERROR_SOCKET_DISCONNECT;
+    }
+    // The sentences may have completed other steps, which already waited on this socket
+    if (sentence_count != last_sentence_count) {
+        return SshReactor::Yield;
+    }
+    return output.empty() ? SshReactor::WaitRead : SshReactor::WaitWrite;
+}
+
+int RouterOsApi::Flush() {
+    while (!output.empty()) {
+        const auto sent = send(sock, output.data(), static_cast<int>(output.size()), SendFlags);
+        if (sent < 0) {
+            if (IsWouldBlock()) {
+                return SshReactor::WaitWrite;
+            }
+            connection_error = "send failed";
+            return LIBSSH2_ERROR_SOCKET_SEND;
+        }
+        output.erase(0, static_cast<std::size_t>(sent));
+    }
+    return 0;
+}
+
+int RouterOsApi::Receive() {
+    std::array<char, ReceiveSize> buffer{};
+    for (;;) {
+        const auto received = recv(sock, buffer.data(), static_cast<int>(buffer.size()), 0);
+        if (received < 0) {
+            if (IsWouldBlock()) {
+                return SshReactor::WaitRead;
+            }
+            connection_error = "receive failed";
+            return LIBSSH2_ERROR_SOCKET_RECV;
+        }
+
+        input.append(buffer.data(), static_cast<std::size_t>(received));
+        if (!ParseSentences()) {
+            connection_error = "invalid reply";
+            return LIBSSH2_ERROR_SOCKET_RECV;
+        }
+        if (received == 0) {
+            if (connection_error.empty()) {
+                connection_error = "connection closed";
+            }
+            return LIBSSH2_ERROR_SOCKET_DISCONNECT;
+        }
+    }
+}
+
+bool RouterOsApi::ParseSentences() {
+    std::size_t offset = 0;
+    for (;;) {
+        std::size_t length = 0;
+        const int header_size = DecodeLength(input, offset, length);
+        if (header_size < 0) {
+            return false;
+        }
+        if (header_size == 0 || input.size() - offset - static_cast<std::size_t>(header_size) <
+                                    length) {
+            break;
+        }
+
+        offset += static_cast<std::size_t>(header_size);
+        if (length == 0) {
+            DispatchSentence(std::move(sentence_words));
+            sentence_words.clear();
+            continue;
+        }
+        sentence_words.emplace_back(input, offset, length);
+        offset += length;
+    }
+
+    input.erase(0, offset);
+    return true;
+}
+
+void RouterOsApi::DispatchSentence(std::vector<std::string> words) {
+    if (words.empty()) {
+        return;
+    }
+    ++sentence_count;
+
+    ApiAttributes attributes{};
+    bool has_tag = false;
+    u32 tag = 0;
+    for (std::size_t i = 1; i < words.size(); ++i) {
+        std::string_view word = words[i];
+        if (word.starts_with(".tag=")) {
+            has_tag = true;
+            tag = static_cast<u32>(std::strtoul(words[i].c_str() + 5, nullptr, 10));
+            continue;
+        }
+
+        // =name=value, the value may contain more '='
+        if (word.starts_with('=')) {
+            word.remove_prefix(1);
+        }
+        const std::size_t separator = word.find('=');
+        if (separator == std::string_view::npos) {
+            attributes.emplace_back(std::string{word}, std::string{});
+            continue;
+        }
+        attributes.emplace_back(std::string{word.substr(0, separator)},
+                                std::string{word.substr(separator + 1)});
+    }
+
+    const std::string& type = words[0];
+    const std::string* message = FindAttribute(attributes, "message");
+    // The reason of !fatal is a plain word instead of an attribute
+    if (type == "!fatal" && message == nullptr && words.size() > 1 &&
+        !words[1].starts_with('=') && !words[1].starts_with('.')) {
+        message = &words[1];
+    }
+    if (type == "!fatal") {
+        // The router closes the connection after it
+        connection_error = message != nullptr ? *message : "fatal error";
+    }
+
+    const auto it = has_tag ? pending.find(tag) : pending.end();
+    if (it == pending.end()) {
+        // Replies of commands that timed out are dropped
+        return;
+    }
+
+    PendingReply& entry = it->second;
+    if (type == "!re") {
+        entry.reply.rows.push_back(std::move(attributes));
+    } else if (type == "!trap" || type == "!fatal") {
+        entry.reply.error = message != nullptr ? *message : type;
+        entry.is_done = type == "!fatal";
+    } else if (type == "!done") {
+        entry.reply.done = std::move(attributes);
+        entry.reply.is_success = entry.reply.error.empty();
+        entry.is_done = true;
+    }
+}
+
+void RouterOsApi::CloseSocket() {
+    if (sock == -1) {
+        return;
+    }
+
+#ifdef _WIN32
+    closesocket(sock);
+    WSACleanup();
+#else
+    shutdown(sock, SHUT_RDWR);
+    close(sock);
+#endif
+    sock = -1;
+}
+
+} // namespace Mikrotik
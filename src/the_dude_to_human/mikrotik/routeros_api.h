@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/task.h"
+#include "the_dude_to_human/mikrotik/command_statistics.h"
+#include "the_dude_to_human/mikrotik/ssh_reactor.h"
+
+namespace Mikrotik {
+
+// Attributes of an api sentence in the order they were received
+using ApiAttributes = std::vector<std::pair<std::string, std::string>>;
+
+// Appends the length of an api word, the high bits of the first byte tell how many bytes the
+// length takes
+void EncodeLength(std::string& out, std::size_t length);
+
+// Returns the bytes used by the length of the word at offset, zero if they didn't arrive yet and
+// -1 on control bytes, which aren't valid in a reply
+int DecodeLength(std::string_view data, std::size_t offset, std::size_t& length);
+
+// Returns the value of key, null if the sentence doesn't have it
+const std::string* FindAttribute(const ApiAttributes& attributes, std::string_view key);
+
+struct ApiReply {
+    // Attributes of every !re sentence
+    std::vector<ApiAttributes> rows{};
+    // Attributes of the !done sentence, some commands return their result there
+    ApiAttributes done{};
+    // Message of the !trap or !fatal sentence, or why the reply didn't arrive
+    std::string error{};
+    bool is_success{};
+};
+
+// Client of the RouterOS api, a binary protocol that answers with attributes instead of text.
+// Every sentence is sent with a tag and replies are matched by it, so many commands can be in
+// flight on one connection. The connection is driven by the reactor threads like the ssh
+// sessions of MikrotikDevice, the Async functions resume there
+class RouterOsApi {
+public:
+    static constexpr u16 DefaultPort = 8728;
+    // Port of api-ssl, connections to it are refused since there is no TLS support
+    static constexpr u16 SslPort = 8729;
+
+    // Uses the default reactor if reactor is null
+    RouterOsApi(std::string address, u16 port_ = DefaultPort, SshReactor* reactor_ = nullptr);
+    ~RouterOsApi();
+
+    RouterOsApi(const RouterOsApi&) = delete;
+    RouterOsApi& operator=(const RouterOsApi&) = delete;
+
+    // Commands fail after milliseconds without progress, zero waits forever. Must be set before
+    // Connect
+    void SetTimeout(u32 milliseconds);
+
+    // Logs in with the method of RouterOS 6.43 and later. Fails without connecting on SslPort.
+    // Connect and Disconnect must not run while commands are in flight
+    bool Connect(std::string username, std::string password);
+    bool Disconnect();
+
+    // words holds the command followed by its =attribute=value and ?query words
+    ApiReply Execute(std::vector<std::string> words);
+
+    Common::Task<bool> ConnectAsync(std::string username, std::string password);
+    Common::Task<bool> DisconnectAsync();
+    Common::Task<ApiReply> ExecuteAsync(std::vector<std::string> words);
+
+    CommandStatistics GetCommandStatistics() const;
+
+private:
+    struct PendingReply {
+        ApiReply reply{};
+        bool is_done{};
+    };
+
+    Common::Task<ApiReply> SendSentence(std::vector<std::string> words);
+
+    // Sends the queued sentences and reads the replies that arrived. Returns 0 once the reply of
+    // tag is done
+    int Pump(u32 tag);
+    int Flush();
+    int Receive();
+    // Returns false if the data isn't an api sentence
+    bool ParseSentences();
+    void DispatchSentence(std::vector<std::string> words);
+
+    void CloseSocket();
+
+    std::string hostname{};
+    u16 port{};
+    u32 timeout_ms{};
+    SshReactor* reactor = nullptr;
+
+    s32 sock{-1};
+    bool is_connected{};
+    std::atomic<u32> next_tag{};
+
+    // Only used by steps, which run on the reactor thread of the socket
+    std::string output{};
+    std::string input{};
+    std::vector<std::string> sentence_words{};
+    std::unordered_map<u32, PendingReply> pending{};
+    u64 sentence_count{};
+    // Set once the connection can't be used anymore, every command fails with it
+    std::string connection_error{};
+
+    mutable std::mutex statistics_mutex;
+    CommandStatistics statistics{};
+};
+
+} // namespace Mikrotik
@@ -0,0 +1,534 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <poll.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "libssh2.h"
+#include "the_dude_to_human/mikrotik/ssh_reactor.h"
+
+namespace Mikrotik {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+#ifndef __linux__
+// Without an event to wake up poll, new steps are noticed after at most this time
+constexpr int PollIntervalMs = 20;
+#endif
+
+bool SetNonBlocking(s32 socket_fd) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket_fd, FIONBIO, &mode) == 0;
+#else
+    const int flags = fcntl(socket_fd, F_GETFL, 0);
+    return flags != -1 && fcntl(socket_fd, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// Calling connect again on a non blocking socket tells if the connection finished
+int GetConnectResult(int result) {
+    if (result == 0) {
+        return 0;
+    }
+#ifdef _WIN32
+    const int error = WSAGetLastError();
+    if (error == WSAEISCONN) {
+        return 0;
+    }
+    if (error == WSAEWOULDBLOCK || error == WSAEALREADY || error == WSAEINVAL) {
+        return LIBSSH2_ERROR_EAGAIN;
+    }
+#else
+    const int error = errno;
+    if (error == EISCONN) {
+        return 0;
+    }
+    if (error == EINPROGRESS || error == EALREADY || error == EINTR) {
+        return LIBSSH2_ERROR_EAGAIN;
+    }
+#endif
+    return error;
+}
+
+} // Anonymous namespace
+
+class SshReactor::Loop {
+public:
+    Loop() {
+#ifdef __linux__
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event{.events = EPOLLIN, .data = {.fd = wake_fd}};
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+#endif
+        thread = std::thread([this] { Run(); });
+    }
+
+    ~Loop() {
+        {
+            std::scoped_lock lock{mutex};
+            is_stopping = true;
+        }
+        Wake();
+        thread.join();
+#ifdef __linux__
+        close(wake_fd);
+        close(epoll_fd);
+#endif
+    }
+
+    void Submit(s32 socket_fd, LIBSSH2_SESSION* session, u32 timeout_ms, Step step,
+                Completion completion, bool is_shared) {
+        {
+            std::scoped_lock lock{mutex};
+            if (!is_stopping) {
+                submitted.push_back({
+                    .socket_fd = socket_fd,
+                    .session = session,
+                    .timeout_ms = timeout_ms,
+                    .step = std::move(step),
+                    .completion = std::move(completion),
+                    .is_shared = is_shared,
+                });
+                completion = nullptr;
+            }
+        }
+        // Completions may submit again, they can't run with the lock held
+        if (completion) {
+            completion(LIBSSH2_ERROR_SOCKET_DISCONNECT);
+            return;
+        }
+        Wake();
+    }
+
+private:
+    struct Operation {
+        s32 socket_fd{};
+        LIBSSH2_SESSION* session{};
+        u32 timeout_ms{};
+        Step step{};
+        Completion completion{};
+        bool is_shared{};
+    };
+
+    struct SocketState {
+        std::deque<Operation> operations{};
+        // Events the socket is registered for, zero while not waiting
+        u32 events{};
+        bool is_registered{};
+        // Identifies the timer of the current wait, zero without timer
+        u64 timer_id{};
+    };
+
+    struct Timer {
+        Clock::time_point deadline{};
+        s32 socket_fd{};
+        u64 id{};
+
+        bool operator>(const Timer& other) const {
+            return deadline > other.deadline;
+        }
+    };
+
+    void Wake() {
+#ifdef __linux__
+        const u64 value = 1;
+        [[maybe_unused]] const auto written = write(wake_fd, &value, sizeof(value));
+#endif
+    }
+
+    void Run() {
+        std::vector<Operation> incoming{};
+        std::vector<s32> ready_sockets{};
+
+        for (;;) {
+            {
+                std::scoped_lock lock{mutex};
+                if (is_stopping) {
+                    break;
+                }
+                incoming.swap(submitted);
+            }
+
+            for (Operation& operation : incoming) {
+                SocketState& state = sockets[operation.socket_fd];
+                // A waiting shared step doesn't hold back the new one
+                if (state.operations.empty() || state.operations.front().is_shared) {
+                    ready_sockets.push_back(operation.socket_fd);
+                }
+                state.operations.push_back(std::move(operation));
+            }
+            incoming.clear();
+
+            for (const s32 socket_fd : ready_sockets) {
+                Process(socket_fd);
+            }
+            ready_sockets.clear();
+
+            // Yielded steps continue once pending events are handled
+            WaitEvents(yielded_sockets.empty() ? GetWaitTime() : 0, ready_sockets);
+            ExpireTimers(ready_sockets);
+            ready_sockets.insert(ready_sockets.end(), yielded_sockets.begin(),
+                                 yielded_sockets.end());
+            yielded_sockets.clear();
+        }
+
+        // Nobody is going to wait for the sockets anymore
+        for (auto& [socket_fd, state] : sockets) {
+            for (Operation& operation : state.operations) {
+                operation.completion(LIBSSH2_ERROR_SOCKET_DISCONNECT);
+            }
+        }
+        {
+            std::scoped_lock lock{mutex};
+            incoming.swap(submitted);
+        }
+        for (Operation& operation : incoming) {
+            operation.completion(LIBSSH2_ERROR_SOCKET_DISCONNECT);
+        }
+    }
+
+    // Runs the steps of the socket until one has to wait
+    void Process(s32 socket_fd) {
+        const auto it = sockets.find(socket_fd);
+        if (it == sockets.end()) {
+            return;
+        }
+
+        SocketState& state = it->second;
+        // Any timer of the last wait is obsolete
+        state.timer_id = 0;
+        // Shared steps that are waiting since the last completion
+        std::size_t waiting_steps = 0;
+        while (!state.operations.empty()) {
+            const int result = state.operations.front().step();
+            if (result == LIBSSH2_ERROR_EAGAIN || result == WaitRead || result == WaitWrite) {
+                if (RotateShared(state) && ++waiting_steps < state.operations.size()) {
+                    continue;
+                }
+                Arm(socket_fd, state, result);
+                return;
+            }
+            if (result == Yield) {
+                RotateShared(state);
+                yielded_sockets.push_back(socket_fd);
+                return;
+            }
+            Complete(socket_fd, state, result);
+            waiting_steps = 0;
+        }
+
+        sockets.erase(it);
+    }
+
+    // Moves a shared step behind the other steps of its socket. A step blocked while sending
+    // keeps its place, libssh2 requires the same call to finish the partial packet
+    bool RotateShared(SocketState& state) {
+        const Operation& operation = state.operations.front();
+        if (!operation.is_shared || state.operations.size() < 2) {
+            return false;
+        }
+        if (operation.session != nullptr &&
+            (libssh2_session_block_directions(operation.session) &
+             LIBSSH2_SESSION_BLOCK_OUTBOUND) != 0) {
+            return false;
+        }
+        state.operations.push_back(std::move(state.operations.front()));
+        state.operations.pop_front();
+        return true;
+    }
+
+    void Complete(s32 socket_fd, SocketState& state, int result) {
+        Operation operation = std::move(state.operations.front());
+        state.operations.pop_front();
+        state.timer_id = 0;
+        // The owner may close the socket as soon as its last step completes
+        if (state.operations.empty()) {
+            Disarm(socket_fd, state);
+        }
+        operation.completion(result);
+    }
+
+    void Arm(s32 socket_fd, SocketState& state, int result) {
+        const Operation& operation = state.operations.front();
+
+        // libssh2 tells which direction it was blocked on
+        int directions = LIBSSH2_SESSION_BLOCK_OUTBOUND;
+        if (result == WaitRead) {
+            directions = LIBSSH2_SESSION_BLOCK_INBOUND;
+        } else if (result == WaitWrite) {
+            directions = LIBSSH2_SESSION_BLOCK_INBOUND | LIBSSH2_SESSION_BLOCK_OUTBOUND;
+        } else if (operation.session != nullptr) {
+            directions = libssh2_session_block_directions(operation.session);
+        }
+        u32 events = 0;
+        if ((directions & LIBSSH2_SESSION_BLOCK_INBOUND) != 0) {
+            events |= ReadEvent;
+        }
+        if ((directions & LIBSSH2_SESSION_BLOCK_OUTBOUND) != 0) {
+            events |= WriteEvent;
+        }
+        if (events == 0) {
+            events = ReadEvent;
+        }
+
+#ifdef __linux__
+        if (events != state.events || !state.is_registered) {
+            epoll_event event{.events = events, .data = {.fd = socket_fd}};
+            // A closed and reused descriptor is no longer in the epoll set
+            if (!state.is_registered ||
+                epoll_ctl(epoll_fd, EPOLL_CTL_MOD, socket_fd, &event) != 0) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &event);
+            }
+        }
+#endif
+        state.events = events;
+        state.is_registered = true;
+
+        state.timer_id = 0;
+        if (operation.timeout_ms != 0) {
+            state.timer_id = ++next_timer_id;
+            timers.push({
+                .deadline = Clock::now() + std::chrono::milliseconds{operation.timeout_ms},
+                .socket_fd = socket_fd,
+                .id = state.timer_id,
+            });
+        }
+    }
+
+    void Disarm(s32 socket_fd, SocketState& state) {
+#ifdef __linux__
+        if (state.is_registered) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, socket_fd, nullptr);
+        }
+#endif
+        state.events = 0;
+        state.is_registered = false;
+    }
+
+    // Milliseconds until the next timer, -1 without timers
+    int GetWaitTime() {
+        while (!timers.empty() && !IsTimerActive(timers.top())) {
+            timers.pop();
+        }
+
+        int wait_time = -1;
+        if (!timers.empty()) {
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+                timers.top().deadline - Clock::now());
+            wait_time = static_cast<int>(std::max<s64>(remaining.count(), 0));
+        }
+#ifndef __linux__
+        wait_time = wait_time < 0 ? PollIntervalMs : std::min(wait_time, PollIntervalMs);
+#endif
+        return wait_time;
+    }
+
+    bool IsTimerActive(const Timer& timer) const {
+        const auto it = sockets.find(timer.socket_fd);
+        return it != sockets.end() && it->second.timer_id == timer.id;
+    }
+
+    void ExpireTimers(std::vector<s32>& ready_sockets) {
+        const auto now = Clock::now();
+        while (!timers.empty() && timers.top().deadline <= now) {
+            const Timer timer = timers.top();
+            timers.pop();
+            if (!IsTimerActive(timer)) {
+                continue;
+            }
+
+            // The next step of the socket starts right away
+            Complete(timer.socket_fd, sockets[timer.socket_fd], LIBSSH2_ERROR_TIMEOUT);
+            ready_sockets.push_back(timer.socket_fd);
+        }
+    }
+
+#ifdef __linux__
+    static constexpr u32 ReadEvent = EPOLLIN;
+    static constexpr u32 WriteEvent = EPOLLOUT;
+
+    void WaitEvents(int wait_time, std::vector<s32>& ready_sockets) {
+        std::array<epoll_event, 64> events{};
+        const int count = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()),
+                                     wait_time);
+        for (int i = 0; i < count; ++i) {
+            const s32 socket_fd = events[static_cast<std::size_t>(i)].data.fd;
+            if (socket_fd == wake_fd) {
+                u64 value{};
+                [[maybe_unused]] const auto bytes_read = read(wake_fd, &value, sizeof(value));
+                continue;
+            }
+            ready_sockets.push_back(socket_fd);
+        }
+    }
+
+    int epoll_fd{-1};
+    int wake_fd{-1};
+#else
+    static constexpr u32 ReadEvent = POLLIN;
+    static constexpr u32 WriteEvent = POLLOUT;
+
+    void WaitEvents(int wait_time, std::vector<s32>& ready_sockets) {
+#ifdef _WIN32
+        std::vector<WSAPOLLFD> poll_fds{};
+#else
+        std::vector<pollfd> poll_fds{};
+#endif
+        for (const auto& [socket_fd, state] : sockets) {
+            if (state.events != 0) {
+                poll_fds.push_back({});
+                poll_fds.back().fd = socket_fd;
+                poll_fds.back().events = static_cast<short>(state.events);
+            }
+        }
+        if (poll_fds.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{wait_time});
+            return;
+        }
+
+#ifdef _WIN32
+        const int count = WSAPoll(poll_fds.data(), static_cast<ULONG>(poll_fds.size()), wait_time);
+#else
+        const int count = poll(poll_fds.data(), poll_fds.size(), wait_time);
+#endif
+        if (count <= 0) {
+            return;
+        }
+        for (const auto& poll_fd : poll_fds) {
+            if (poll_fd.revents != 0) {
+                ready_sockets.push_back(static_cast<s32>(poll_fd.fd));
+            }
+        }
+    }
+#endif
+
+    std::mutex mutex;
+    std::vector<Operation> submitted{};
+    bool is_stopping{};
+
+    // Only used by the loop thread
+    std::unordered_map<s32, SocketState> sockets{};
+    std::vector<s32> yielded_sockets{};
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers{};
+    u64 next_timer_id{};
+
+    std::thread thread;
+};
+
+SshReactor::SshReactor(std::size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        loops.push_back(std::make_unique<Loop>());
+    }
+}
+
+SshReactor::~SshReactor() = default;
+
+void SshReactor::Submit(s32 socket_fd, LIBSSH2_SESSION* session, u32 timeout_ms, Step step,
+                        Completion completion, bool is_shared) {
+    // A socket always goes to the same loop, which keeps its steps in order
+    const std::size_t loop_index = static_cast<std::size_t>(socket_fd) % loops.size();
+    loops[loop_index]->Submit(socket_fd, session, timeout_ms, std::move(step),
+                              std::move(completion), is_shared);
+}
+
+int SshReactor::Run(s32 socket_fd, LIBSSH2_SESSION* session, u32 timeout_ms, Step step,
+                    bool is_shared) {
+    std::promise<int> result{};
+    std::future<int> future = result.get_future();
+    Submit(
+        socket_fd, session, timeout_ms, std::move(step),
+        [&result](int value) { result.set_value(value); }, is_shared);
+    return future.get();
+}
+
+SshReactor::StepAwaiter::StepAwaiter(SshReactor& reactor_, s32 socket_fd_,
+                                     LIBSSH2_SESSION* session_, u32 timeout_ms_, Step step_,
+                                     bool is_shared_)
+    : reactor{reactor_}, socket_fd{socket_fd_}, session{session_}, timeout_ms{timeout_ms_},
+      step{std::move(step_)}, is_shared{is_shared_} {}
+
+void SshReactor::StepAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    // The coroutine may resume on the reactor thread before Submit returns, nothing after it may
+    // touch this awaiter
+    reactor.Submit(
+        socket_fd, session, timeout_ms, std::move(step),
+        [this, handle](int value) {
+            result = value;
+            handle.resume();
+        },
+        is_shared);
+}
+
+SshReactor::StepAwaiter SshReactor::Await(s32 socket_fd, LIBSSH2_SESSION* session,
+                                          u32 timeout_ms, Step step, bool is_shared) {
+    return StepAwaiter{*this, socket_fd, session, timeout_ms, std::move(step), is_shared};
+}
+
+Common::Task<int> SshReactor::ConnectSocket(std::string address, u16 port, u32 timeout_ms,
+                                            s32& socket_fd) {
+    const auto hostaddr = inet_addr(address.c_str());
+
+    socket_fd = static_cast<s32>(socket(AF_INET, SOCK_STREAM, 0));
+    if (socket_fd == static_cast<s32>(LIBSSH2_INVALID_SOCKET)) {
+        fprintf(stderr, "failed to create socket.\n");
+        co_return errno;
+    }
+    if (!SetNonBlocking(socket_fd)) {
+        fprintf(stderr, "failed to make socket non blocking.\n");
+        co_return 1;
+    }
+
+    sockaddr_in sin = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr = {},
+    };
+    sin.sin_addr.s_addr = hostaddr;
+
+    // Without a session the reactor waits until the socket is writable, which is when the
+    // connection finished
+    const s32 connecting_fd = socket_fd;
+    co_return co_await Await(connecting_fd, nullptr, timeout_ms, [connecting_fd, &sin] {
+        return GetConnectResult(
+            connect(connecting_fd, reinterpret_cast<sockaddr*>(&sin), sizeof(sockaddr_in)));
+    });
+}
+
+SshReactor& SshReactor::GetDefault() {
+    static SshReactor reactor{};
+    return reactor;
+}
+
+} // namespace Mikrotik
@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/task.h"
+
+struct _LIBSSH2_SESSION;
+typedef struct _LIBSSH2_SESSION LIBSSH2_SESSION;
+
+namespace Mikrotik {
+
+// Drives non blocking libssh2 calls of many sessions from a few threads. Each thread waits on
+// epoll (poll on other platforms) for the sockets of its sessions and retries the pending call of
+// a session once its socket is ready. Plain sockets without libssh2 are driven the same way
+class SshReactor {
+public:
+    // Called again every time the socket is ready until it returns anything but
+    // LIBSSH2_ERROR_EAGAIN, Yield, WaitRead or WaitWrite
+    using Step = std::function<int()>;
+    // Returned by steps that can continue without waiting, other sockets run before the step is
+    // called again
+    static constexpr int Yield = std::numeric_limits<int>::min();
+    // Returned by steps of plain sockets, there is no session to tell what they wait for.
+    // WaitWrite waits until the socket is readable or writable
+    static constexpr int WaitRead = Yield + 1;
+    static constexpr int WaitWrite = Yield + 2;
+    // Receives the last value returned by the step, or LIBSSH2_ERROR_TIMEOUT
+    using Completion = std::function<void(int)>;
+
+    // Creates thread_count reactor threads, defaults to the number of hardware threads
+    explicit SshReactor(std::size_t thread_count = 0);
+
+    // Pending steps complete with LIBSSH2_ERROR_SOCKET_DISCONNECT
+    ~SshReactor();
+
+    SshReactor(const SshReactor&) = delete;
+    SshReactor& operator=(const SshReactor&) = delete;
+
+    // Queues step of socket_fd. Steps of the same socket run one after another in submission
+    // order. A step fails with timeout after timeout_ms without the socket getting ready, zero
+    // waits forever. Without a session the step waits until the socket is writable, which is
+    // used while connecting.
+    // A shared step lets the next steps of its socket run while it waits for incoming data, this
+    // way the channels of one session progress together. Only steps that keep their state in
+    // their own channel may be shared, libssh2 can't interleave session wide calls
+    void Submit(s32 socket_fd, LIBSSH2_SESSION* session, u32 timeout_ms, Step step,
+                Completion completion, bool is_shared = false);
+
+    // Submits step and waits for its result. Must not be called from a step, a completion or a
+    // coroutine resumed by the reactor
+    int Run(s32 socket_fd, LIBSSH2_SESSION* session, u32 timeout_ms, Step step,
+            bool is_shared = false);
+
+    // Awaitable version of Run, the awaiting coroutine resumes on a reactor thread
+    class StepAwaiter {
+    public:
+        StepAwaiter(SshReactor& reactor_, s32 socket_fd_, LIBSSH2_SESSION* session_,
+                    u32 timeout_ms_, Step step_, bool is_shared_);
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> handle);
+        int await_resume() const noexcept {
+            return result;
+        }
+
+    private:
+        SshReactor& reactor;
+        s32 socket_fd;
+        LIBSSH2_SESSION* session;
+        u32 timeout_ms;
+        Step step;
+        bool is_shared;
+        int result{};
+    };
+
+    StepAwaiter Await(s32 socket_fd, LIBSSH2_SESSION* session, u32 timeout_ms, Step step,
+                      bool is_shared = false);
+
+    // Opens a non blocking tcp connection to address, socket_fd is set even if it fails and must
+    // be closed by the caller
+    Common::Task<int> ConnectSocket(std::string address, u16 port, u32 timeout_ms,
+                                    s32& socket_fd);
+
+    // Reactor used by devices created without one
+    static SshReactor& GetDefault();
+
+private:
+    class Loop;
+
+    std::vector<std::unique_ptr<Loop>> loops;
+};
+
+} // namespace Mikrotik
@@ -0,0 +1,230 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <utility>
+
+#include "the_dude_to_human/sketch/t_digest.h"
+
+namespace Sketch {
+namespace {
+
+// Header of the serialized digest, followed by centroid_count mean and weight pairs
+struct DigestHeader {
+    f64 compression;
+    f64 min;
+    f64 max;
+    u64 centroid_count;
+};
+
+// k1 scale function, limits the centroid size to q(1 - q) / compression
+f64 ScaleQuantile(f64 q, f64 compression) {
+    return compression / (2 * std::numbers::pi) * std::asin(2 * q - 1);
+}
+
+f64 ScaleInverse(f64 k, f64 compression) {
+    return (std::sin(k * 2 * std::numbers::pi / compression) + 1) / 2;
+}
+
+// Quantile a centroid starting at q may grow to. k + 1 is clamped to the top of the scale, past
+// it the sine folds back and the tail would never merge
+f64 ComputeQuantileLimit(f64 q, f64 compression) {
+    const f64 k = std::min(ScaleQuantile(q, compression) + 1, ScaleQuantile(1, compression));
+    return ScaleInverse(k, compression);
+}
+
+} // Anonymous namespace
+
+TDigest::TDigest(f64 compression_value) : compression{compression_value} {}
+
+void TDigest::Add(f64 value, f64 weight) {
+    if (std::isnan(value) || weight <= 0) {
+        return;
+    }
+
+    if (total_weight == 0) {
+        min = value;
+        max = value;
+    }
+    min = std::min(min, value);
+    max = std::max(max, value);
+    total_weight += weight;
+    buffer.push_back({value, weight});
+
+    // Sorting the buffer dominates, larger buffers amortize it over more values
+    if (buffer.size() >= static_cast<std::size_t>(compression) * 8) {
+        Compress();
+    }
+}
+
+void TDigest::Merge(const TDigest& other) {
+    if (other.total_weight == 0) {
+        return;
+    }
+
+    if (total_weight == 0) {
+        min = other.min;
+        max = other.max;
+    }
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    total_weight += other.total_weight;
+    buffer.insert(buffer.end(), other.centroids.begin(), other.centroids.end());
+    buffer.insert(buffer.end(), other.buffer.begin(), other.buffer.end());
+    Compress();
+}
+
+void TDigest::Compress() {
+    if (buffer.empty()) {
+        return;
+    }
+
+    buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+    std::sort(buffer.begin(), buffer.end(),
+              [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    centroids.clear();
+    Centroid current = buffer.front();
+    f64 weight_so_far = 0;
+    f64 weight_limit = total_weight * ComputeQuantileLimit(0, compression);
+
+    for (std::size_t i = 1; i < buffer.size(); ++i) {
+        const Centroid& next = buffer[i];
+        if (weight_so_far + current.weight + next.weight <= weight_limit) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+            continue;
+        }
+
+        weight_so_far += current.weight;
+        centroids.push_back(current);
+        current = next;
+        const f64 q = weight_so_far / total_weight;
+        weight_limit = total_weight * ComputeQuantileLimit(q, compression);
+    }
+    centroids.push_back(current);
+    buffer.clear();
+}
+
+f64 TDigest::Quantile(f64 q) const {
+    if (buffer.empty()) {
+        return ComputeQuantile(q);
+    }
+    TDigest digest = *this;
+    digest.Compress();
+    return digest.ComputeQuantile(q);
+}
+
+f64 TDigest::ComputeQuantile(f64 q) const {
+    if (centroids.empty()) {
+        return std::numeric_limits<f64>::quiet_NaN();
+    }
+    if (centroids.size() == 1) {
+        return centroids.front().mean;
+    }
+
+    const f64 index = std::clamp(q, 0.0, 1.0) * total_weight;
+    const Centroid& first = centroids.front();
+    const Centroid& last = centroids.back();
+
+    // Between the minimum and the center of the first centroid
+    if (index < first.weight / 2) {
+        return min + (first.mean - min) * index / (first.weight / 2);
+    }
+
+    // Centroid centers are interpolated linearly
+    f64 weight_so_far = first.weight / 2;
+    for (std::size_t i = 0; i + 1 < centroids.size(); ++i) {
+        const Centroid& left = centroids[i];
+        const Centroid& right = centroids[i + 1];
+        const f64 step = (left.weight + right.weight) / 2;
+        if (weight_so_far + step > index) {
+            const f64 t = (index - weight_so_far) / step;
+            return left.mean + (right.mean - left.mean) * t;
+        }
+        weight_so_far += step;
+    }
+
+    // Between the center of the last centroid and the maximum
+    const f64 t = std::min(1.0, (index - weight_so_far) / (last.weight / 2));
+    return last.mean + (max - last.mean) * t;
+}
+
+f64 TDigest::GetCount() const {
+    return total_weight;
+}
+
+f64 TDigest::GetMin() const {
+    return min;
+}
+
+f64 TDigest::GetMax() const {
+    return max;
+}
+
+std::size_t TDigest::GetCentroidCount() const {
+    return centroids.size() + buffer.size();
+}
+
+std::vector<u8> TDigest::Serialize() const {
+    TDigest digest = *this;
+    digest.Compress();
+
+    const DigestHeader header{
+        .compression = compression,
+        .min = min,
+        .max = max,
+        .centroid_count = digest.centroids.size(),
+    };
+    const std::size_t centroid_size = digest.centroids.size() * sizeof(Centroid);
+    std::vector<u8> data(sizeof(header) + centroid_size);
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), digest.centroids.data(), centroid_size);
+    return data;
+}
+
+bool TDigest::Deserialize(std::span<const u8> data) {
+    DigestHeader header{};
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    // The count is checked before it's multiplied, a corrupted one would overflow the size
+    const std::size_t centroid_bytes = data.size() - sizeof(header);
+    if (header.centroid_count > centroid_bytes / sizeof(Centroid) ||
+        centroid_bytes != header.centroid_count * sizeof(Centroid)) {
+        return false;
+    }
+    if (!std::isfinite(header.compression) || header.compression <= 0 ||
+        !std::isfinite(header.min) || !std::isfinite(header.max)) {
+        return false;
+    }
+
+    // Merges and quantiles expect positive weights and sorted means
+    std::vector<Centroid> new_centroids(header.centroid_count);
+    std::memcpy(new_centroids.data(), data.data() + sizeof(header),
+                new_centroids.size() * sizeof(Centroid));
+    f64 new_total_weight = 0;
+    for (std::size_t i = 0; i < new_centroids.size(); ++i) {
+        const Centroid& centroid = new_centroids[i];
+        if (!std::isfinite(centroid.mean) || !std::isfinite(centroid.weight) ||
+            centroid.weight <= 0 || (i > 0 && centroid.mean < new_centroids[i - 1].mean)) {
+            return false;
+        }
+        new_total_weight += centroid.weight;
+    }
+
+    compression = header.compression;
+    min = header.min;
+    max = header.max;
+    total_weight = new_total_weight;
+    buffer.clear();
+    centroids = std::move(new_centroids);
+    return true;
+}
+
+} // namespace Sketch
@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: Copyright 2025 Narr the Reg
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Sketch {
+
+// Merging t-digest described in "Computing Extremely Accurate Quantiles Using t-Digests".
+// Values are summarized by centroids that are smaller near the tails, so extreme percentiles
+// stay accurate with a few hundred centroids. Digests of disjoint data can be merged
+class TDigest {
+public:
+    static constexpr f64 DefaultCompression = 100;
+
+    explicit TDigest(f64 compression_value = DefaultCompression);
+
+    // NaN values are ignored
+    void Add(f64 value, f64 weight = 1);
+    void Merge(const TDigest& other);
+
+    // Estimates the value at quantile q in [0, 1]. Returns NaN if the digest is empty
+    f64 Quantile(f64 q) const;
+
+    f64 GetCount() const;
+    f64 GetMin() const;
+    f64 GetMax() const;
+    std::size_t GetCentroidCount() const;
+
+    std::vector<u8> Serialize() const;
+    bool Deserialize(std::span<const u8> data);
+
+private:
+    struct Centroid {
+        f64 mean;
+        f64 weight;
+    };
+
+    void Compress();
+    f64 ComputeQuantile(f64 q) const;
+
+    f64 compression{};
+    f64 min{};
+    f64 max{};
+    f64 total_weight{};
+    std::vector<Centroid> centroids{};
+    std::vector<Centroid> buffer{};
+};
+
+} // namespace Sketch
@@ -1,8 +1,10 @@
 // SPDX-FileCopyrightText: Copyright 2024 Narr the Reg
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <array>
 #include <cstdio>
 #include <cstring>
+#include <utility>
 
 #include "the_dude_to_human/gzip/gzip.h"
 #include "the_dude_to_human/sqlite/sqlite_reader.h"
@@ -13,11 +15,18 @@ SqliteReader::SqliteReader(const std::string& db_file) {
     db_filename = db_file;
 }
 
+SqliteReader::SqliteReader(const std::string& name, std::vector<u8> data)
+    : is_memory_db{true}, db_filename{name}, memory_data{std::move(data)} {}
+
 int SqliteReader::OpenDatabase() {
     if (is_open) {
         return SQLITE_OK;
     }
 
+    if (is_memory_db) {
+        return OpenMemoryDatabase();
+    }
+
     Gzip::Gzip gzip{db_filename};
 
     // Sqlite can't read compressed databases
@@ -41,6 +50,29 @@ int SqliteReader::OpenDatabase() {
     return SQLITE_OK;
 }
 
+int SqliteReader::OpenMemoryDatabase() {
+    int result = sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE, 0);
+    if (result != SQLITE_OK) {
+        // A failed open may still allocate the handle
+        sqlite3_close(db);
+        db = nullptr;
+        return result;
+    }
+
+    // Sqlite reads the buffer in place, memory_data must outlive the connection
+    const auto size = static_cast<sqlite3_int64>(memory_data.size());
+    result = sqlite3_deserialize(db, "main", memory_data.data(), size, size,
+                                 SQLITE_DESERIALIZE_READONLY);
+    if (result != SQLITE_OK) {
+        sqlite3_close(db);
+        db = nullptr;
+        return result;
+    }
+
+    is_open = true;
+    return SQLITE_OK;
+}
+
 void SqliteReader::CloseDatabase() {
     if (!is_open) {
         return;
@@ -66,6 +98,218 @@ int SqliteReader::GetTableData(SqlData& data, const std::string& table_name) con
     return ExecStatement(data, "SELECT * FROM '" + table_name + "'");
 }
 
+int SqliteReader::StreamKeyValueData(const std::string& table_name, std::size_t batch_size,
+                                     const KeyValueCallback& callback) const {
+    // Tables keyed by rowid are already in key order, others are sorted by sqlite
+    return StreamKeyValueQuery("SELECT rowid, * FROM '" + table_name + "' ORDER BY 2", batch_size,
+                               callback);
+}
+
+int SqliteReader::StreamKeyValueDataByRowid(const std::string& table_name,
+                                            std::size_t batch_size,
+                                            const KeyValueCallback& callback) const {
+    return StreamKeyValueQuery("SELECT rowid, * FROM '" + table_name + "' ORDER BY rowid",
+                               batch_size, callback);
+}
+
+int SqliteReader::StreamKeyValueQuery(const std::string& sql, std::size_t batch_size,
+                                      const KeyValueCallback& callback) const {
+    sqlite3_stmt* statement{nullptr};
+    int rc = PrepareStatement(&statement, sql);
+
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    std::vector<SqlKeyValue> rows{};
+    rows.reserve(batch_size);
+
+    while (true) {
+        rc = sqlite3_step(statement);
+        if (rc == SQLITE_BUSY) {
+            continue;
+        }
+        if (rc != SQLITE_ROW) {
+            break;
+        }
+
+        rows.push_back(ReadKeyValueRow(statement));
+        if (rows.size() < batch_size) {
+            continue;
+        }
+
+        rc = callback(rows);
+        rows.clear();
+        if (rc != 0) {
+            sqlite3_finalize(statement);
+            return rc;
+        }
+    }
+
+    sqlite3_finalize(statement);
+    if (rc != SQLITE_DONE) {
+        printf("Can't execute query: %s\n%s\n", sql.c_str(), sqlite3_errmsg(db));
+        return rc;
+    }
+
+    return rows.empty() ? SQLITE_OK : callback(rows);
+}
+
+int SqliteReader::StreamIntegerRows(const std::string& table_name,
+                                    std::span<const std::string_view> columns,
+                                    const IntegerRowCallback& callback) const {
+    std::string sql = "SELECT ";
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        sql += i == 0 ? "\"" : ", \"";
+        sql.append(columns[i]);
+        sql += "\"";
+    }
+    sql += " FROM '" + table_name + "' ORDER BY rowid";
+
+    sqlite3_stmt* statement{nullptr};
+    int rc = PrepareStatement(&statement, sql);
+
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    std::vector<s64> row(columns.size());
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW || rc == SQLITE_BUSY) {
+        if (rc == SQLITE_BUSY) {
+            continue;
+        }
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            row[i] = sqlite3_column_int64(statement, static_cast<int>(i));
+        }
+        rc = callback(row);
+        if (rc != 0) {
+            sqlite3_finalize(statement);
+            return rc;
+        }
+    }
+
+    sqlite3_finalize(statement);
+    if (rc != SQLITE_DONE) {
+        printf("Can't execute query: %s\n%s\n", sql.c_str(), sqlite3_errmsg(db));
+        return rc;
+    }
+    return SQLITE_OK;
+}
+
+int SqliteReader::GetKeyValueRange(std::vector<SqlKeyValue>& rows, const std::string& table_name,
+                                   s64 first_rowid, s64 last_rowid) const {
+    const std::string sql =
+        "SELECT rowid, * FROM '" + table_name + "' WHERE rowid BETWEEN ?1 AND ?2 ORDER BY rowid";
+    sqlite3_stmt* statement{nullptr};
+    int rc = PrepareStatement(&statement, sql);
+
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    sqlite3_bind_int64(statement, 1, first_rowid);
+    sqlite3_bind_int64(statement, 2, last_rowid);
+
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW || rc == SQLITE_BUSY) {
+        if (rc == SQLITE_ROW) {
+            rows.push_back(ReadKeyValueRow(statement));
+        }
+    }
+
+    sqlite3_finalize(statement);
+    if (rc != SQLITE_DONE) {
+        printf("Can't execute query: %s\n%s\n", sql.c_str(), sqlite3_errmsg(db));
+        return rc;
+    }
+    return SQLITE_OK;
+}
+
+int SqliteReader::IsRowidKey(bool& is_rowid_key, const std::string& table_name) const {
+    const std::string sql = "PRAGMA table_info('" + table_name + "')";
+    sqlite3_stmt* statement{nullptr};
+    int rc = PrepareStatement(&statement, sql);
+
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    // Only a single "INTEGER PRIMARY KEY" column aliases the rowid
+    int key_columns = 0;
+    bool is_first_column_integer_key = false;
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        const int column_id = sqlite3_column_int(statement, 0);
+        const char* type = reinterpret_cast<const char*>(sqlite3_column_text(statement, 2));
+        const int primary_key = sqlite3_column_int(statement, 5);
+        if (primary_key == 0) {
+            continue;
+        }
+        key_columns++;
+        if (column_id == 0 && type != nullptr && sqlite3_stricmp(type, "integer") == 0) {
+            is_first_column_integer_key = true;
+        }
+    }
+
+    sqlite3_finalize(statement);
+    if (rc != SQLITE_DONE) {
+        printf("Can't execute query: %s\n%s\n", sql.c_str(), sqlite3_errmsg(db));
+        return rc;
+    }
+
+    is_rowid_key = key_columns == 1 && is_first_column_integer_key;
+    return SQLITE_OK;
+}
+
+int SqliteReader::GetRowidRange(s64& min_rowid, s64& max_rowid,
+                                const std::string& table_name) const {
+    // Sqlite only resolves MIN and MAX with a single index lookup when they are queried alone
+    const std::array<std::string, 2> queries{
+        "SELECT MIN(rowid) FROM '" + table_name + "'",
+        "SELECT MAX(rowid) FROM '" + table_name + "'",
+    };
+    const std::array<s64*, 2> results{&min_rowid, &max_rowid};
+
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        sqlite3_stmt* statement{nullptr};
+        int rc = PrepareStatement(&statement, queries[i]);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+
+        rc = sqlite3_step(statement);
+        if (rc == SQLITE_ROW) {
+            *results[i] = sqlite3_column_int64(statement, 0);
+        }
+        sqlite3_finalize(statement);
+        if (rc != SQLITE_ROW) {
+            return rc;
+        }
+    }
+    return SQLITE_OK;
+}
+
+int SqliteReader::GetMaxRowidBelow(s64& rowid, const std::string& table_name, s64 limit) const {
+    const std::string sql = "SELECT MAX(rowid) FROM '" + table_name + "' WHERE rowid <= ?1";
+    sqlite3_stmt* statement{nullptr};
+    int rc = PrepareStatement(&statement, sql);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    sqlite3_bind_int64(statement, 1, limit);
+    rc = sqlite3_step(statement);
+    if (rc == SQLITE_ROW) {
+        if (sqlite3_column_type(statement, 0) == SQLITE_NULL) {
+            rc = SQLITE_NOTFOUND;
+        } else {
+            rowid = sqlite3_column_int64(statement, 0);
+            rc = SQLITE_OK;
+        }
+    }
+
+    sqlite3_finalize(statement);
+    return rc;
+}
+
 int SqliteReader::ExecStatement(SqlData& data, const std::string& sql) const {
     sqlite3_stmt* statement{nullptr};
 
@@ -115,6 +359,36 @@ SqlRow SqliteReader::ReadRow(sqlite3_stmt* statement) const {
     return {id, blob_data};
 }
 
+SqlKeyValue SqliteReader::ReadKeyValueRow(sqlite3_stmt* statement) const {
+    return {
+        .rowid = sqlite3_column_int64(statement, 0),
+        .key = sqlite3_column_int64(statement, 1),
+        .value = sqlite3_column_double(statement, 2),
+    };
+}
+
+int SqliteReader::PrepareStatement(sqlite3_stmt** statement, const std::string& sql) const {
+    if (!is_open) {
+        return SQLITE_CANTOPEN;
+    }
+
+    const int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, statement, 0);
+    if (rc != SQLITE_OK) {
+        sqlite3_finalize(*statement);
+        *statement = nullptr;
+        printf("Can't create query \"%s\": %s\n", sql.c_str(), sqlite3_errmsg(db));
+    }
+    return rc;
+}
+
+const std::string& SqliteReader::GetFilename() const {
+    return db_filename;
+}
+
+bool SqliteReader::IsMemoryDatabase() const {
+    return is_memory_db;
+}
+
 const char* SqliteReader::GetError() const {
     return sqlite3_errmsg(db);
 }
@@ -3,7 +3,11 @@
 
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "common/common_types.h"
@@ -15,20 +19,62 @@ namespace Sqlite {
 class SqliteReader {
 public:
     SqliteReader(const std::string& db_file);
+    // Opens an uncompressed database image already in memory, name is only used in messages
+    SqliteReader(const std::string& name, std::vector<u8> data);
 
     int OpenDatabase();
     void CloseDatabase();
 
     int GetTableData(SqlData& data, const std::string& table_name) const;
 
+    using KeyValueCallback = std::function<int(std::span<const SqlKeyValue>)>;
+
+    // Reads a key value table in key order. Callback is called every batch_size rows so memory
+    // usage doesn't depend on the table size, a non zero return value stops the read
+    int StreamKeyValueData(const std::string& table_name, std::size_t batch_size,
+                           const KeyValueCallback& callback) const;
+
+    // Same as StreamKeyValueData but in rowid order, which never needs sorting
+    int StreamKeyValueDataByRowid(const std::string& table_name, std::size_t batch_size,
+                                  const KeyValueCallback& callback) const;
+
+    using IntegerRowCallback = std::function<int(std::span<const s64>)>;
+
+    // Reads the given integer columns of every row in rowid order. Callback receives one value per
+    // column, a non zero return value stops the read
+    int StreamIntegerRows(const std::string& table_name, std::span<const std::string_view> columns,
+                          const IntegerRowCallback& callback) const;
+
+    // Reads the key value rows with first_rowid <= rowid <= last_rowid
+    int GetKeyValueRange(std::vector<SqlKeyValue>& rows, const std::string& table_name,
+                         s64 first_rowid, s64 last_rowid) const;
+
+    // Checks if the first column of the table is an alias of the rowid, in that case rowid
+    // lookups are key lookups
+    int IsRowidKey(bool& is_rowid_key, const std::string& table_name) const;
+
+    int GetRowidRange(s64& min_rowid, s64& max_rowid, const std::string& table_name) const;
+
+    // Finds the largest rowid lower or equal than limit. Returns SQLITE_NOTFOUND if there is none
+    int GetMaxRowidBelow(s64& rowid, const std::string& table_name, s64 limit) const;
+
+    const std::string& GetFilename() const;
+    bool IsMemoryDatabase() const;
     const char* GetError() const;
 
 private:
+    int OpenMemoryDatabase();
     int ExecStatement(SqlData& data, const std::string& sql) const;
+    int PrepareStatement(sqlite3_stmt** statement, const std::string& sql) const;
+    int StreamKeyValueQuery(const std::string& sql, std::size_t batch_size,
+                            const KeyValueCallback& callback) const;
+    SqlKeyValue ReadKeyValueRow(sqlite3_stmt* statement) const;
     SqlRow ReadRow(sqlite3_stmt* statement) const;
 
     bool is_open{};
+    bool is_memory_db{};
     std::string db_filename{};
+    std::vector<u8> memory_data{};
     sqlite3* db{NULL};
 };
 } // namespace Sqlite
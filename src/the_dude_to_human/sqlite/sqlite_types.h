@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <string>
+#include <variant>
 #include <vector>
 
 #include "common/common_types.h"
@@ -12,4 +14,27 @@ namespace Sqlite {
 using SqlRow = std::pair<u32, std::vector<u8>>;
 using SqlData = std::vector<SqlRow>;
 
+enum class SqlType {
+    Integer,
+    Real,
+    Text,
+    Blob,
+};
+
+struct SqlColumn {
+    std::string name{};
+    SqlType type{};
+    bool is_primary_key{};
+};
+
+// Row of a table with an integer key and a single numeric value
+struct SqlKeyValue {
+    s64 rowid{};
+    s64 key{};
+    f64 value{};
+};
+
+// Value bound to a statement parameter. std::monostate is bound as NULL
+using SqlValue = std::variant<std::monostate, s64, f64, std::string, std::vector<u8>>;
+
 } // namespace Sqlite
@@ -4,14 +4,37 @@
 #include <cstdio>
 #include <cstring>
 
+#include "common/string_util.h"
 #include "the_dude_to_human/sqlite/sqlite_writer.h"
 
+static std::string QuoteIdentifier(const std::string& name) {
+    return "\"" + Common::ReplaceAll(name, "\"", "\"\"") + "\"";
+}
+
+static const char* GetTypeName(Sqlite::SqlType type) {
+    switch (type) {
+    case Sqlite::SqlType::Integer:
+        return "INTEGER";
+    case Sqlite::SqlType::Real:
+        return "REAL";
+    case Sqlite::SqlType::Text:
+        return "TEXT";
+    case Sqlite::SqlType::Blob:
+        return "BLOB";
+    }
+    return "";
+}
+
 namespace Sqlite {
 SqliteWriter::SqliteWriter(const std::string& db_file) {
     is_open = false;
     db_filename = db_file;
 }
 
+SqliteWriter::~SqliteWriter() {
+    CloseDatabase();
+}
+
 int SqliteWriter::OpenDatabase() {
     if (is_open) {
         return SQLITE_OK;
@@ -32,44 +55,159 @@ void SqliteWriter::CloseDatabase() {
         return;
     }
 
+    for (auto& [sql, statement] : statement_cache) {
+        sqlite3_finalize(statement);
+    }
+    statement_cache.clear();
+    insert_queries.clear();
+
     is_open = false;
     sqlite3_close(db);
 }
 
-int SqliteWriter::CreateTable() {
-    return 0;
+int SqliteWriter::SetBulkLoad(bool enable) {
+    if (enable) {
+        return ExecStatement("PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF;");
+    }
+    return ExecStatement("PRAGMA journal_mode=DELETE; PRAGMA synchronous=FULL;");
 }
 
-int SqliteWriter::ExecStatement(SqlData& data, const std::string& sql) const {
-    sqlite3_stmt* statement{nullptr};
+int SqliteWriter::BeginTransaction() {
+    return ExecStatement("BEGIN TRANSACTION");
+}
 
-    int rc = sqlite3_prepare(db, sql.c_str(), -1, &statement, 0);
+int SqliteWriter::CommitTransaction() {
+    return ExecStatement("COMMIT TRANSACTION");
+}
 
-    if (rc != SQLITE_OK) {
-        sqlite3_finalize(statement);
-        printf("Can't create query \"%s\": %s\n", sql.c_str(), sqlite3_errmsg(db));
+int SqliteWriter::CreateTable(const std::string& table_name, std::span<const SqlColumn> columns) {
+    std::string sql = "CREATE TABLE " + QuoteIdentifier(table_name) + " (";
+
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        sql += QuoteIdentifier(columns[i].name) + " " + GetTypeName(columns[i].type);
+        if (columns[i].is_primary_key) {
+            sql += " PRIMARY KEY";
+        }
+        if (i + 1 != columns.size()) {
+            sql += ", ";
+        }
+    }
+    sql += ")";
+
+    return ExecStatement(sql);
+}
+
+int SqliteWriter::CreateIndex(const std::string& table_name, const std::string& column_name) {
+    return ExecStatement("CREATE INDEX " + QuoteIdentifier(table_name + "_idx_" + column_name) +
+                         " ON " + QuoteIdentifier(table_name) + " (" +
+                         QuoteIdentifier(column_name) + ")");
+}
+
+int SqliteWriter::InsertRow(const std::string& table_name, std::span<const SqlValue> values) {
+    auto it = insert_queries.find(table_name);
+
+    if (it == insert_queries.end()) {
+        std::string sql = "INSERT INTO " + QuoteIdentifier(table_name) + " VALUES (";
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            sql += i == 0 ? "?" : ", ?";
+        }
+        sql += ")";
+        it = insert_queries.emplace(table_name, sql).first;
+    }
+
+    return ExecStatement(it->second, values);
+}
+
+int SqliteWriter::ExecStatement(const std::string& sql, std::span<const SqlValue> values) {
+    if (!is_open) {
+        return SQLITE_CANTOPEN;
+    }
+
+    // Statements without parameters are usually one-off queries
+    if (values.empty()) {
+        char* error_message = nullptr;
+        const int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error_message);
+        if (rc != SQLITE_OK) {
+            printf("Can't execute query: %s\n%s\n", sql.c_str(), error_message);
+            sqlite3_free(error_message);
+        }
         return rc;
     }
 
-    bool done = false;
+    sqlite3_stmt* statement = GetStatement(sql);
+
+    if (statement == nullptr) {
+        return sqlite3_errcode(db);
+    }
+
+    int rc = SQLITE_OK;
+    for (std::size_t i = 0; i < values.size() && rc == SQLITE_OK; ++i) {
+        rc = BindValue(statement, static_cast<int>(i + 1), values[i]);
+    }
+
+    bool done = rc != SQLITE_OK;
 
     while (!done) {
         rc = sqlite3_step(statement);
         switch (rc) {
+        case SQLITE_ROW:
+            break;
         case SQLITE_DONE:
+            rc = SQLITE_OK;
             done = true;
             break;
         case SQLITE_BUSY:
             break;
         default:
-            sqlite3_finalize(statement);
             printf("Can't execute query: %s\n%s\n", sql.c_str(), sqlite3_errmsg(db));
-            return rc;
+            done = true;
+            break;
         }
     }
 
-    sqlite3_finalize(statement);
-    return SQLITE_OK;
+    sqlite3_reset(statement);
+    sqlite3_clear_bindings(statement);
+    return rc;
+}
+
+sqlite3_stmt* SqliteWriter::GetStatement(const std::string& sql) {
+    const auto it = statement_cache.find(sql);
+    if (it != statement_cache.end()) {
+        return it->second;
+    }
+
+    sqlite3_stmt* statement{nullptr};
+    const int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, 0);
+
+    if (rc != SQLITE_OK) {
+        sqlite3_finalize(statement);
+        printf("Can't create query \"%s\": %s\n", sql.c_str(), sqlite3_errmsg(db));
+        return nullptr;
+    }
+
+    statement_cache.emplace(sql, statement);
+    return statement;
+}
+
+int SqliteWriter::BindValue(sqlite3_stmt* statement, int index, const SqlValue& value) const {
+    if (const auto* integer = std::get_if<s64>(&value)) {
+        return sqlite3_bind_int64(statement, index, *integer);
+    }
+    if (const auto* real = std::get_if<f64>(&value)) {
+        return sqlite3_bind_double(statement, index, *real);
+    }
+    if (const auto* text = std::get_if<std::string>(&value)) {
+        return sqlite3_bind_text(statement, index, text->data(), static_cast<int>(text->size()),
+                                 SQLITE_STATIC);
+    }
+    if (const auto* blob = std::get_if<std::vector<u8>>(&value)) {
+        if (blob->empty()) {
+            return sqlite3_bind_zeroblob(statement, index, 0);
+        }
+        return sqlite3_bind_blob(statement, index, blob->data(), static_cast<int>(blob->size()),
+                                 SQLITE_STATIC);
+    }
+    return sqlite3_bind_null(statement, index);
 }
 
 const char* SqliteWriter::GetError() const {
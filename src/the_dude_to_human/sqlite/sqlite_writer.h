@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <span>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/common_types.h"
@@ -15,19 +17,34 @@ namespace Sqlite {
 class SqliteWriter {
 public:
     SqliteWriter(const std::string& db_file);
+    ~SqliteWriter();
 
     int OpenDatabase();
     void CloseDatabase();
 
-    int CreateTable();
+    // Disables journaling and syncing while loading large amounts of data
+    int SetBulkLoad(bool enable);
+
+    int BeginTransaction();
+    int CommitTransaction();
+
+    int CreateTable(const std::string& table_name, std::span<const SqlColumn> columns);
+    int CreateIndex(const std::string& table_name, const std::string& column_name);
+
+    // Inserts a row with one value per column. Statements are prepared once and reused
+    int InsertRow(const std::string& table_name, std::span<const SqlValue> values);
 
     const char* GetError() const;
 
 private:
-    int ExecStatement(SqlData& data, const std::string& sql) const;
+    int ExecStatement(const std::string& sql, std::span<const SqlValue> values = {});
+    sqlite3_stmt* GetStatement(const std::string& sql);
+    int BindValue(sqlite3_stmt* statement, int index, const SqlValue& value) const;
 
     bool is_open{};
     std::string db_filename{};
     sqlite3* db{NULL};
+    std::unordered_map<std::string, sqlite3_stmt*> statement_cache{};
+    std::unordered_map<std::string, std::string> insert_queries{};
 };
 } // namespace Sqlite